@@ -0,0 +1,173 @@
+#pragma once
+
+#include "driver/gpio.h"
+#include "driver/i2c.h"
+#include "hal/adc_types.h"
+
+namespace Config
+{
+    // ──────────────────────────────
+    // Application Info
+    // ──────────────────────────────
+    static constexpr const char *APP_NAME = "IoT Test"; // Application name
+    static constexpr const char *APP_VERSION = "1.0.0"; // Application version
+
+    // ──────────────────────────────
+    // Ultrasonic Sensor (HC-SR04)
+    // ──────────────────────────────
+    constexpr gpio_num_t HCSR04_TRIGGER_PIN = GPIO_NUM_5;       // Trigger pin (output)
+    constexpr gpio_num_t HCSR04_ECHO_PIN = GPIO_NUM_18;         // Echo pin (input)
+    constexpr uint32_t DISTANCE_MEASUREMENT_INTERVAL_MS = 1000; // Measurement interval (ms)
+    constexpr uint32_t TRIGGER_PULSE_uS = 10;                   // Trigger pulse duration (µs)
+    constexpr float DISTANCE_THRESHOLD_CM = 400.0f;             // Max valid distance (cm)
+    constexpr uint32_t ECHO_TIMEOUT_US = 35000;                 // Echo timeout (µs)
+    constexpr bool ECHO_CAPTURE_IRAM = true;                    // Time the echo from IRAM with interrupts masked (false: flash-resident loop)
+    constexpr uint32_t ECHO_MASK_MAX_US = 6000;                 // Longest interrupt mask per measurement (µs) - echoes up to ~100 cm
+    constexpr uint32_t ECHO_JITTER_BENCH_SAMPLES = 0;           // Fresh boot runs the echo jitter benchmark, this many pulses per case (0: off)
+
+    // ──────────────────────────────
+    // Mailbox Detection Logic
+    // ──────────────────────────────
+    static constexpr float BASELINE_CM = 40.0f;     // Empty mailbox baseline (cm)
+    static constexpr float TRIGGER_DELTA_CM = 2.0f; // Min change to detect occlusion (cm)
+    static constexpr uint32_t HOLD_MS = 200;        // Occlusion hold time (ms)
+    static constexpr uint32_t REFRACTORY_MS = 8000; // Refractory period after detection (ms)
+
+    // ──────────────────────────────
+    // Sensor Obstruction
+    // ──────────────────────────────
+    static constexpr uint32_t OBSTRUCTED_AFTER_READINGS = 24; // Consecutive invalid readings before the sensor counts as obstructed (2 min at 5 s)
+    static constexpr uint32_t OBSTRUCTED_CLEAR_READINGS = 3;  // Consecutive valid readings that end an obstruction
+    static constexpr uint32_t OBSTRUCTED_MAX_SLEEP_SEC = 900; // Probe interval cap while obstructed (s) - doubles up to this
+
+    // ──────────────────────────────
+    // Flap Damping
+    // ──────────────────────────────
+    static constexpr bool FLAP_DAMPING_ENABLED = true;      // Hold back events of a mailbox oscillating between states
+    static constexpr float FLAP_PENALTY = 1000.0f;          // Penalty added per drop or collection
+    static constexpr uint32_t FLAP_HALF_LIFE_SEC = 900;     // Penalty halves every 15 min
+    static constexpr float FLAP_SUPPRESS_PENALTY = 2500.0f; // Suppress events above this (the third transition in a few minutes)
+    static constexpr float FLAP_REUSE_PENALTY = 750.0f;     // Report events again once decayed below this
+    static constexpr float FLAP_MAX_PENALTY = 6000.0f;      // Cap: suppression ends at most ~45 min after the last transition
+
+    // ──────────────────────────────
+    // Filtering
+    // ──────────────────────────────
+    static constexpr uint8_t FILTER_WINDOW = 3; // Median filter window size
+
+    // ──────────────────────────────
+    // MQTT Settings
+    // ──────────────────────────────
+    static constexpr const char *MQTT_BROKER_URIS[] = {"mqtt://10.178.116.70:1883"}; // Broker URIs in order of preference (up to 4)
+    static constexpr const char *MQTT_BASE_TOPIC = "home/mailbox";                    // Base topic
+    static constexpr const char *MQTT_CLIENT_ID = "mailbox-sensor-001";               // Client ID
+    static constexpr int MQTT_BUFFER_SIZE = 2560;                                     // Receive buffer (bytes) - holds one OTA chunk
+    static constexpr uint32_t MQTT_CONNECT_DEADLINE_MS = 2500;                        // Fail over to the next broker without CONNACK after this (ms)
+    static constexpr uint32_t MQTT_RECONNECT_TIMEOUT_MS = 1000;                       // Retry a failed connect after this; stopping the client waits up to half (ms)
+    static constexpr uint32_t MQTT_ENDPOINT_HOLDDOWN_SEC = 600;                       // A broker that failed is tried last for this long (s)
+    static constexpr uint32_t MQTT_DNS_CACHE_SEC = 21600;                             // Resolved broker addresses are reused for this long (s)
+
+    // ──────────────────────────────
+    // MQTT TLS (used for mqtts:// brokers)
+    // ──────────────────────────────
+    static constexpr const char *MQTT_BROKER_CA_PEM = nullptr; // Broker CA certificate (PEM), nullptr skips verification
+    static constexpr uint64_t TLS_SESSION_MAX_AGE_SEC = 86400; // Max age of a cached TLS session (s) - keep <= broker ticket lifetime
+    static constexpr uint32_t TLS_BENCH_HANDSHAKES = 0;        // Fresh boot times this many full and resumed handshakes with the first broker (0: off)
+
+    // ──────────────────────────────
+    // Wi-Fi Settings
+    // ──────────────────────────────
+    static constexpr const char *CONN_SSID = "teaofthehe"; // Wi-Fi SSID
+    static constexpr const char *PASSWORD = "11235813";    // Wi-Fi password
+
+    // ──────────────────────────────
+    // Power Management
+    // ──────────────────────────────
+    static constexpr uint64_t DEEP_SLEEP_US = 5000000;          // Deep sleep duration (µs) - 5 seconds
+    static constexpr uint64_t HEARTBEAT_INTERVAL_SEC = 3600;    // Heartbeat interval (s) - 1 hours
+    static constexpr uint32_t HEARTBEAT_KEYFRAME_INTERVAL = 24; // Full status every N heartbeats, deltas in between
+    static constexpr bool PM_DFS_ENABLED = true;                // Drop the CPU to the XTAL clock while waiting (needs CONFIG_PM_ENABLE)
+    static constexpr bool PM_LIGHT_SLEEP_ENABLED = true;        // Light-sleep in waits as well (needs PM_DFS_ENABLED and tickless idle)
+    static constexpr int PM_MAX_CPU_FREQ_MHZ = 160;             // CPU clock while computing or holding a PM lock
+    static constexpr int PM_MIN_CPU_FREQ_MHZ = 40;              // CPU clock in waits with DFS (XTAL)
+
+    // ──────────────────────────────
+    // Charge Model (ESP32-C3 datasheet typicals - measure your board)
+    // ──────────────────────────────
+    static constexpr float CHARGE_ACTIVE_MA = 23.0f;      // CPU busy at PM_MAX_CPU_FREQ_MHZ
+    static constexpr float CHARGE_IDLE_MAX_MA = 17.0f;    // Waiting at PM_MAX_CPU_FREQ_MHZ (no DFS)
+    static constexpr float CHARGE_IDLE_XTAL_MA = 9.0f;    // Waiting at PM_MIN_CPU_FREQ_MHZ
+    static constexpr float CHARGE_LIGHT_SLEEP_MA = 0.13f; // Waiting in light sleep
+    static constexpr float CHARGE_RADIO_MA = 60.0f;       // Added while Wi-Fi is on: association, DHCP, TX/RX and beacons, averaged
+
+    // ──────────────────────────────
+    // Daily Digest
+    // ──────────────────────────────
+    static constexpr int32_t DIGEST_AT_MIN = -1;             // Digest mode: one report a day at this minute after midnight UTC (-1: report every event)
+    static constexpr uint32_t DIGEST_RETRY_SEC = 900;        // Retry an undelivered digest after this (s)
+    static constexpr float DIGEST_ALARM_SUCCESS_RATE = 0.5f; // Sensor alarm below this measurement success rate
+
+    // ──────────────────────────────
+    // Fleet Load Spreading
+    // ──────────────────────────────
+    static constexpr bool HEARTBEAT_PHASE_SPREAD = true;        // First heartbeat after boot at an offset hashed from MQTT_CLIENT_ID (false: one interval after boot)
+    static constexpr uint32_t DIGEST_SPREAD_SEC = 1800;         // Digests go out within this after DIGEST_AT_MIN, by the same hash (s)
+    static constexpr uint32_t RECONNECT_BACKOFF_BASE_SEC = 30;  // Heartbeat retry window after a failed session (s), doubled per failure
+    static constexpr uint32_t RECONNECT_BACKOFF_MAX_SEC = 1800; // Retry window cap (s); the wait is drawn from its upper half
+
+    // ──────────────────────────────
+    // Battery Monitoring
+    // ──────────────────────────────
+    static constexpr adc_unit_t BATTERY_ADC_UNIT = ADC_UNIT_1;          // ADC unit of the battery sense pin
+    static constexpr adc_channel_t BATTERY_ADC_CHANNEL = ADC_CHANNEL_2; // ADC1 channel 2 = GPIO2 on the ESP32-C3
+    static constexpr float BATTERY_DIVIDER_RATIO = 2.0f;                // Battery voltage / pin voltage (2 x 100k divider)
+    static constexpr uint32_t BATTERY_SAMPLE_EVERY_N_WAKES = 60;        // Read the ADC every N wakes (5 min at 5 s sleep)
+    static constexpr uint32_t BATTERY_ADC_READS = 8;                    // Raw conversions averaged per sample
+    static constexpr float BATTERY_FILTER_ALPHA = 0.3f;                 // Weight of a new sample in the smoothed voltage
+    static constexpr uint32_t BATTERY_LOW_MV = 3550;                    // Below: LOW power level (mV)
+    static constexpr uint32_t BATTERY_CRITICAL_MV = 3400;               // Below: CRITICAL power level (mV)
+    static constexpr uint32_t BATTERY_HYSTERESIS_MV = 50;               // Recovery needs threshold + this (mV)
+    static constexpr uint32_t BATTERY_LOW_SLEEP_FACTOR = 2;             // Deep sleep multiplier at LOW
+    static constexpr uint32_t BATTERY_LOW_HEARTBEAT_FACTOR = 4;         // Heartbeat interval multiplier at LOW
+    static constexpr uint32_t BATTERY_CRITICAL_SLEEP_FACTOR = 6;        // Deep sleep multiplier at CRITICAL
+    static constexpr uint32_t BATTERY_CRITICAL_HEARTBEAT_FACTOR = 12;   // Heartbeat interval multiplier at CRITICAL
+
+    // ──────────────────────────────
+    // State Checkpoints
+    // ──────────────────────────────
+    static constexpr uint64_t CHECKPOINT_INTERVAL_SEC = 6 * 3600;  // Refresh the checkpoint without a state change (s)
+    static constexpr uint32_t CHECKPOINT_MAX_WRITES_PER_DAY = 12; // NVS write budget per day; further changes wait
+
+    // ──────────────────────────────
+    // Message Sequencing
+    // ──────────────────────────────
+    static constexpr uint32_t SEQUENCE_NVS_BLOCK = 256; // Sequence numbers reserved per NVS write (skipped after power loss)
+
+    // ──────────────────────────────
+    // Firmware Updates (delta OTA)
+    // ──────────────────────────────
+    static constexpr uint32_t OTA_CHUNK_BYTES = 2048;        // Delta bytes requested per message (< MQTT_BUFFER_SIZE)
+    static constexpr uint32_t OTA_CHUNKS_PER_SESSION = 32;   // Max chunks downloaded per reporting session (64 KB)
+    static constexpr uint32_t OTA_SESSION_BUDGET_MS = 15000; // Max extra radio time spent downloading per session (ms)
+    static constexpr uint32_t OTA_CHUNK_TIMEOUT_MS = 3000;   // Wait for one chunk before leaving the rest for later (ms)
+
+    // ──────────────────────────────
+    // Diagnostic Log
+    // ──────────────────────────────
+    static constexpr bool DIAG_LOG_ENABLED = true;               // Append a record of every wake to the flash ring log
+    static constexpr const char *DIAG_LOG_PARTITION = "diaglog"; // Label of the raw data partition (partitions.csv)
+    static constexpr uint32_t DIAG_LOG_ERASE_SLACK_MS = 100;     // Start an erase-ahead only with this much wait left (ms)
+
+    // ──────────────────────────────
+    // Diagnostic Log Upload
+    // ──────────────────────────────
+    static constexpr uint32_t DIAG_UPLOAD_CHUNK_BYTES = 2048;        // Log bytes per dump chunk before compression (< MQTT_BUFFER_SIZE)
+    static constexpr uint32_t DIAG_UPLOAD_WINDOW = 4;                // Dump chunks in flight before waiting for an acknowledgement
+    static constexpr uint32_t DIAG_UPLOAD_ACK_TIMEOUT_MS = 3000;     // Go back to the last acknowledged record after this (ms)
+    static constexpr uint32_t DIAG_UPLOAD_SESSION_BUDGET_MS = 10000; // Max extra radio time spent on a dump per session (ms)
+
+    // ──────────────────────────────
+    // Allocation Check
+    // ──────────────────────────────
+    static constexpr bool ALLOC_CHECK_ABORT = false; // Abort (and reboot) when a wake allocated outside driver code
+}
\ No newline at end of file
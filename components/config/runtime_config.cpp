@@ -0,0 +1,170 @@
+#include "runtime_config.hpp"
+
+#include "cJSON.h"
+#include "nvs.h"
+
+namespace Config
+{
+    namespace
+    {
+        // Accepted ranges; anything outside is rejected as a whole
+        constexpr uint64_t MIN_DEEP_SLEEP_US = 1000000ULL;        // 1 s
+        constexpr uint64_t MAX_DEEP_SLEEP_US = 3600ULL * 1000000; // 1 hour
+        constexpr uint64_t MIN_HEARTBEAT_INTERVAL_SEC = 60;       // 1 minute
+        constexpr uint64_t MAX_HEARTBEAT_INTERVAL_SEC = 604800;   // 1 week
+        constexpr float MIN_TRIGGER_DELTA_CM = 0.5f;
+        constexpr float MAX_TRIGGER_DELTA_CM = BASELINE_CM / 4.0f; // Full threshold stays well above 0
+        constexpr uint32_t MIN_HOLD_MS = 10;
+        constexpr uint32_t MAX_HOLD_MS = REFRACTORY_MS;
+        constexpr int32_t MAX_DIGEST_AT_MIN = 24 * 60 - 1;
+
+        // Blobs of firmware before the digest mode end here; the fields after it keep their defaults
+        constexpr size_t MIN_STORED_LEN = offsetof(RuntimeConfig, digest_at_min);
+
+        // Read an optional numeric key; false if present but not a number or not in [min, max]
+        bool readNumber(const cJSON *root, const char *key, double min, double max, double *value)
+        {
+            const cJSON *item = cJSON_GetObjectItemCaseSensitive(root, key);
+            if (!item)
+                return true;
+            if (!cJSON_IsNumber(item) || item->valuedouble < min || item->valuedouble > max)
+                return false;
+            *value = item->valuedouble;
+            return true;
+        }
+    }
+
+    bool IsValid(const RuntimeConfig &config)
+    {
+        return config.deep_sleep_us >= MIN_DEEP_SLEEP_US && config.deep_sleep_us <= MAX_DEEP_SLEEP_US &&
+               config.heartbeat_interval_sec >= MIN_HEARTBEAT_INTERVAL_SEC &&
+               config.heartbeat_interval_sec <= MAX_HEARTBEAT_INTERVAL_SEC &&
+               config.trigger_delta_cm >= MIN_TRIGGER_DELTA_CM && config.trigger_delta_cm <= MAX_TRIGGER_DELTA_CM &&
+               config.hold_ms >= MIN_HOLD_MS && config.hold_ms <= MAX_HOLD_MS &&
+               config.digest_at_min >= -1 && config.digest_at_min <= MAX_DIGEST_AT_MIN;
+    }
+
+    RuntimeConfigStore::RuntimeConfigStore(RuntimeConfig *rtc_mirror)
+        : config_(rtc_mirror)
+    {
+    }
+
+    esp_err_t RuntimeConfigStore::Load()
+    {
+        *config_ = DEFAULT_RUNTIME_CONFIG;
+
+        nvs_handle_t handle;
+        esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle);
+        if (err != ESP_OK)
+        {
+            // The namespace does not exist until the first update was saved
+            if (err != ESP_ERR_NVS_NOT_FOUND)
+                ESP_LOGW(LOG_TAG, "Failed to open NVS: %s", esp_err_to_name(err));
+            return err == ESP_ERR_NVS_NOT_FOUND ? ESP_OK : err;
+        }
+
+        RuntimeConfig stored = DEFAULT_RUNTIME_CONFIG;
+        size_t len = sizeof(stored);
+        err = nvs_get_blob(handle, NVS_KEY, &stored, &len);
+        nvs_close(handle);
+
+        if (err == ESP_ERR_NVS_NOT_FOUND)
+            return ESP_OK;
+        if (err != ESP_OK || len < MIN_STORED_LEN || len > sizeof(stored) || !IsValid(stored))
+        {
+            // Unreadable, or written by a firmware with a different layout
+            ESP_LOGW(LOG_TAG, "Ignoring stored config (%s), using defaults", esp_err_to_name(err));
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        *config_ = stored;
+        ESP_LOGI(LOG_TAG, "Loaded config version %lu", static_cast<unsigned long>(stored.version));
+        return ESP_OK;
+    }
+
+    esp_err_t RuntimeConfigStore::Apply(const char *json, size_t len)
+    {
+        cJSON *root = cJSON_ParseWithLength(json, len);
+        if (!root || !cJSON_IsObject(root))
+        {
+            cJSON_Delete(root);
+            ESP_LOGW(LOG_TAG, "Rejected config: not a JSON object");
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        double version = 0;
+        const cJSON *version_item = cJSON_GetObjectItemCaseSensitive(root, "version");
+        if (!cJSON_IsNumber(version_item) || !readNumber(root, "version", 1, UINT32_MAX, &version))
+        {
+            cJSON_Delete(root);
+            ESP_LOGW(LOG_TAG, "Rejected config: missing or invalid version");
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (static_cast<uint32_t>(version) <= config_->version)
+        {
+            cJSON_Delete(root);
+            ESP_LOGD(LOG_TAG, "Config version %.0f already applied", version);
+            return ESP_ERR_INVALID_VERSION;
+        }
+
+        // Bounded before the casts below: converting an out-of-range double to an integer is undefined
+        double deep_sleep_us = static_cast<double>(config_->deep_sleep_us);
+        double heartbeat_interval_sec = static_cast<double>(config_->heartbeat_interval_sec);
+        double trigger_delta_cm = config_->trigger_delta_cm;
+        double hold_ms = config_->hold_ms;
+        double digest_at_min = config_->digest_at_min;
+        const bool parsed = readNumber(root, "deep_sleep_us", MIN_DEEP_SLEEP_US, MAX_DEEP_SLEEP_US, &deep_sleep_us) &&
+                            readNumber(root, "heartbeat_interval_sec", MIN_HEARTBEAT_INTERVAL_SEC,
+                                       MAX_HEARTBEAT_INTERVAL_SEC, &heartbeat_interval_sec) &&
+                            readNumber(root, "trigger_delta_cm", MIN_TRIGGER_DELTA_CM, MAX_TRIGGER_DELTA_CM, &trigger_delta_cm) &&
+                            readNumber(root, "hold_ms", MIN_HOLD_MS, MAX_HOLD_MS, &hold_ms) &&
+                            readNumber(root, "digest_at_min", -1, MAX_DIGEST_AT_MIN, &digest_at_min);
+        cJSON_Delete(root);
+
+        const RuntimeConfig candidate = {
+            .version = static_cast<uint32_t>(version),
+            .deep_sleep_us = static_cast<uint64_t>(deep_sleep_us),
+            .heartbeat_interval_sec = static_cast<uint64_t>(heartbeat_interval_sec),
+            .trigger_delta_cm = static_cast<float>(trigger_delta_cm),
+            .hold_ms = static_cast<uint32_t>(hold_ms),
+            .digest_at_min = static_cast<int32_t>(digest_at_min)};
+
+        if (!parsed || !IsValid(candidate))
+        {
+            ESP_LOGW(LOG_TAG, "Rejected config version %lu: value out of range",
+                     static_cast<unsigned long>(candidate.version));
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        // Persist first: the mirror only changes once the update survives a power loss
+        const esp_err_t err = save(candidate);
+        if (err != ESP_OK)
+            return err;
+
+        *config_ = candidate;
+        ESP_LOGI(LOG_TAG, "Applied config version %lu: sleep=%llu us heartbeat=%llu s delta=%.2f cm hold=%lu ms digest=%ld min",
+                 static_cast<unsigned long>(candidate.version),
+                 static_cast<unsigned long long>(candidate.deep_sleep_us),
+                 static_cast<unsigned long long>(candidate.heartbeat_interval_sec),
+                 candidate.trigger_delta_cm, static_cast<unsigned long>(candidate.hold_ms),
+                 static_cast<long>(candidate.digest_at_min));
+        return ESP_OK;
+    }
+
+    esp_err_t RuntimeConfigStore::save(const RuntimeConfig &config)
+    {
+        nvs_handle_t handle;
+        esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+        if (err == ESP_OK)
+        {
+            err = nvs_set_blob(handle, NVS_KEY, &config, sizeof(config));
+            if (err == ESP_OK)
+                err = nvs_commit(handle);
+            nvs_close(handle);
+        }
+
+        if (err != ESP_OK)
+            ESP_LOGE(LOG_TAG, "Failed to save config: %s", esp_err_to_name(err));
+        return err;
+    }
+}
\ No newline at end of file
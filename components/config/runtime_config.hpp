@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+#include "esp_log.h"
+
+#include "config.hpp"
+
+namespace Config
+{
+    // Settings that can be changed in the field through the retained {base}/config message
+    struct RuntimeConfig
+    {
+        uint32_t version;                ///< Version of the applied config (0: built-in defaults)
+        uint64_t deep_sleep_us;          ///< Deep sleep duration (µs)
+        uint64_t heartbeat_interval_sec; ///< Heartbeat interval (s)
+        float trigger_delta_cm;          ///< Min change to detect occlusion (cm)
+        uint32_t hold_ms;                ///< Occlusion hold time (ms)
+        int32_t digest_at_min;           ///< Digest mode: minute after midnight UTC of the daily report (-1: off)
+    };
+
+    // Built-in values from config.hpp
+    constexpr RuntimeConfig DEFAULT_RUNTIME_CONFIG = {
+        .version = 0,
+        .deep_sleep_us = DEEP_SLEEP_US,
+        .heartbeat_interval_sec = HEARTBEAT_INTERVAL_SEC,
+        .trigger_delta_cm = TRIGGER_DELTA_CM,
+        .hold_ms = HOLD_MS,
+        .digest_at_min = DIGEST_AT_MIN};
+
+    // Check that every value is within the range the firmware can run with
+    bool IsValid(const RuntimeConfig &config);
+
+    /**
+     * Runtime configuration stored in NVS and mirrored in RTC memory
+     *
+     * The mirror is what the firmware reads on every wake, so quiet wakes
+     * never touch flash. After power loss Load() refills it from NVS. Updates
+     * arrive as a JSON object on {base}/config:
+     *
+     *   {"version":3,"deep_sleep_us":10000000,"hold_ms":300,"digest_at_min":420}
+     *
+     * "version" is required and must be higher than the applied one; other
+     * keys are optional and keep their current value when absent. An update
+     * is applied as a whole or not at all: it is validated first, written to
+     * NVS, and only then copied into the mirror.
+     */
+    class RuntimeConfigStore
+    {
+    public:
+        // Store over the RTC mirror (must be initialized with Load() after power loss)
+        explicit RuntimeConfigStore(RuntimeConfig *rtc_mirror);
+
+        // Fill the mirror from NVS, falling back to the defaults (NVS must be initialized)
+        esp_err_t Load();
+
+        // Currently applied configuration
+        const RuntimeConfig &Get() const { return *config_; }
+
+        /**
+         * Validate and apply a {base}/config payload
+         *
+         * Returns ESP_OK if applied, ESP_ERR_INVALID_VERSION if the version is
+         * not newer (the retained message arrives on every session) and
+         * ESP_ERR_INVALID_ARG if the payload is malformed or out of range.
+         */
+        esp_err_t Apply(const char *json, size_t len);
+
+    private:
+        static constexpr const char *LOG_TAG = "RUNTIME_CONFIG";
+        static constexpr const char *NVS_NAMESPACE = "config";
+        static constexpr const char *NVS_KEY = "runtime";
+
+        RuntimeConfig *config_; ///< RTC mirror
+
+        // Write a validated configuration to NVS
+        esp_err_t save(const RuntimeConfig &config);
+    };
+}
\ No newline at end of file
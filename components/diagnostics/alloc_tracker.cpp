@@ -0,0 +1,87 @@
+#include "alloc_tracker.hpp"
+
+#ifdef ESP_PLATFORM
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "sdkconfig.h"
+
+#include <cstdarg>
+#include <cstdio>
+
+// Allocations can happen while the flash cache is disabled
+#define ALLOC_HOOK_ATTR IRAM_ATTR
+#else
+#define ALLOC_HOOK_ATTR
+#endif
+
+namespace Diagnostics
+{
+    namespace
+    {
+        struct TrackerState
+        {
+            bool active;           ///< Counting for this task
+            uint32_t exempt_depth; ///< Nested Exempt scopes
+            uint32_t count;        ///< Allocations counted
+            size_t bytes;          ///< Bytes requested by the counted allocations
+        };
+
+        thread_local TrackerState t_state = {};
+
+#ifdef ESP_PLATFORM
+        // Log output is not part of the path: newlib allocates its stdout buffer and float conversion state on first use
+        int exemptVprintf(const char *format, va_list args)
+        {
+            AllocTracker::Exempt exempt;
+            return vprintf(format, args);
+        }
+#endif
+    }
+
+    void AllocTracker::Begin()
+    {
+#ifdef ESP_PLATFORM
+        static bool log_hooked = false;
+        if (!log_hooked)
+        {
+            esp_log_set_vprintf(exemptVprintf);
+            log_hooked = true;
+        }
+#endif
+        t_state = {};
+        t_state.active = true;
+    }
+
+    uint32_t AllocTracker::End()
+    {
+        t_state.active = false;
+        return t_state.count;
+    }
+
+    uint32_t AllocTracker::Count() { return t_state.count; }
+
+    size_t AllocTracker::Bytes() { return t_state.bytes; }
+
+    ALLOC_HOOK_ATTR void AllocTracker::OnAlloc(size_t size)
+    {
+        TrackerState &state = t_state;
+        if (state.active && state.exempt_depth == 0)
+        {
+            state.count++;
+            state.bytes += size;
+        }
+    }
+
+    AllocTracker::Exempt::Exempt() { t_state.exempt_depth++; }
+
+    AllocTracker::Exempt::~Exempt() { t_state.exempt_depth--; }
+}
+
+#if defined(ESP_PLATFORM) && CONFIG_HEAP_USE_HOOKS
+// Weak hook of the ESP-IDF heap, called for every successful allocation
+extern "C" ALLOC_HOOK_ATTR void esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps)
+{
+    Diagnostics::AllocTracker::OnAlloc(size);
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Diagnostics
+{
+    /**
+     * Counts the heap allocations of one wake
+     *
+     * Begin() arms counting for the calling task (thread on the host), so
+     * allocations of the Wi-Fi, MQTT and timer tasks never count. Calls into
+     * ESP-IDF drivers and stacks that allocate internally run inside an
+     * Exempt scope, which leaves exactly the code of this firmware: the
+     * measure-process-report path is expected to end a wake with zero.
+     *
+     * The platform reports allocations through OnAlloc(): heap hooks on the
+     * device (CONFIG_HEAP_USE_HOOKS), malloc interposition in the host
+     * harness (tools/alloc_check).
+     */
+    class AllocTracker
+    {
+    public:
+        // Start counting allocations of the calling task from zero
+        static void Begin();
+
+        // Stop counting; returns the number of allocations since Begin()
+        static uint32_t End();
+
+        // Allocations and bytes counted so far
+        static uint32_t Count();
+        static size_t Bytes();
+
+        // Called by the platform allocator for every allocation (any task, must not allocate)
+        static void OnAlloc(size_t size);
+
+        // Allocations inside this scope are not counted (driver and network stack internals)
+        class Exempt
+        {
+        public:
+            Exempt();
+            ~Exempt();
+
+            Exempt(const Exempt &) = delete;
+            Exempt &operator=(const Exempt &) = delete;
+        };
+    };
+}
\ No newline at end of file
@@ -0,0 +1,176 @@
+#include "lz4_block.hpp"
+
+#include <cstring>
+
+namespace Diagnostics
+{
+    namespace Lz4
+    {
+        namespace
+        {
+            constexpr size_t MIN_MATCH = 4;
+            constexpr size_t LAST_LITERALS = 5; // The block always ends with this many literals
+            constexpr size_t MF_LIMIT = 12;     // No match starts closer than this to the end
+            constexpr size_t MAX_OFFSET = 65535;
+
+            uint32_t read32(const uint8_t *p)
+            {
+                uint32_t value;
+                memcpy(&value, p, sizeof(value));
+                return value;
+            }
+
+            uint32_t hash(const uint8_t *p)
+            {
+                return (read32(p) * 2654435761u) >> (32 - HASH_LOG);
+            }
+
+            // Append a length continuation (after the 15 in the token); false if out of room
+            bool putLength(size_t value, uint8_t *dst, size_t capacity, size_t *op)
+            {
+                for (; value >= 255; value -= 255)
+                {
+                    if (*op >= capacity)
+                        return false;
+                    dst[(*op)++] = 255;
+                }
+                if (*op >= capacity)
+                    return false;
+                dst[(*op)++] = static_cast<uint8_t>(value);
+                return true;
+            }
+
+            // One sequence: literals, then a match (match_len 0: the final literals-only sequence)
+            bool putSequence(const uint8_t *literals, size_t literal_len, size_t offset, size_t match_len, uint8_t *dst,
+                             size_t capacity, size_t *op)
+            {
+                if (*op >= capacity)
+                    return false;
+                const size_t match_code = match_len > 0 ? match_len - MIN_MATCH : 0;
+                dst[(*op)++] = static_cast<uint8_t>(((literal_len < 15 ? literal_len : 15) << 4) |
+                                                    (match_code < 15 ? match_code : 15));
+                if (literal_len >= 15 && !putLength(literal_len - 15, dst, capacity, op))
+                    return false;
+
+                if (capacity - *op < literal_len)
+                    return false;
+                memcpy(dst + *op, literals, literal_len);
+                *op += literal_len;
+                if (match_len == 0)
+                    return true;
+
+                if (capacity - *op < 2)
+                    return false;
+                dst[(*op)++] = static_cast<uint8_t>(offset);
+                dst[(*op)++] = static_cast<uint8_t>(offset >> 8);
+                return match_code < 15 || putLength(match_code - 15, dst, capacity, op);
+            }
+        }
+
+        size_t Compress(const uint8_t *src, size_t len, uint8_t *dst, size_t capacity, uint16_t *table)
+        {
+            if (len > MAX_INPUT)
+                return 0;
+
+            size_t op = 0;
+            size_t anchor = 0;
+            if (len > MF_LIMIT)
+            {
+                memset(table, 0, HASH_ENTRIES * sizeof(*table));
+                const size_t match_start_limit = len - MF_LIMIT;
+                const size_t match_end_limit = len - LAST_LITERALS;
+
+                size_t ip = 1;
+                while (ip < match_start_limit)
+                {
+                    const uint32_t h = hash(src + ip);
+                    size_t ref = table[h];
+                    table[h] = static_cast<uint16_t>(ip);
+                    if (ref >= ip || ip - ref > MAX_OFFSET || read32(src + ref) != read32(src + ip))
+                    {
+                        ip++;
+                        continue;
+                    }
+
+                    // Extend backwards into the pending literals, then forwards
+                    while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1])
+                    {
+                        ip--;
+                        ref--;
+                    }
+                    size_t match_len = MIN_MATCH;
+                    while (ip + match_len < match_end_limit && src[ref + match_len] == src[ip + match_len])
+                        match_len++;
+
+                    if (!putSequence(src + anchor, ip - anchor, ip - ref, match_len, dst, capacity, &op))
+                        return 0;
+                    ip += match_len;
+                    anchor = ip;
+                    if (ip < match_start_limit)
+                        table[hash(src + ip - 2)] = static_cast<uint16_t>(ip - 2);
+                }
+            }
+
+            return putSequence(src + anchor, len - anchor, 0, 0, dst, capacity, &op) ? op : 0;
+        }
+
+        int Decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t capacity)
+        {
+            size_t ip = 0;
+            size_t op = 0;
+            while (ip < len)
+            {
+                const uint8_t token = src[ip++];
+
+                size_t literal_len = token >> 4;
+                if (literal_len == 15)
+                {
+                    uint8_t b;
+                    do
+                    {
+                        if (ip >= len)
+                            return -1;
+                        b = src[ip++];
+                        literal_len += b;
+                    } while (b == 255);
+                }
+                if (len - ip < literal_len || capacity - op < literal_len)
+                    return -1;
+                memcpy(dst + op, src + ip, literal_len);
+                ip += literal_len;
+                op += literal_len;
+
+                // The last sequence has no match
+                if (ip == len)
+                    break;
+
+                if (len - ip < 2)
+                    return -1;
+                const size_t offset = src[ip] | (src[ip + 1] << 8);
+                ip += 2;
+                if (offset == 0 || offset > op)
+                    return -1;
+
+                size_t match_len = (token & 15) + MIN_MATCH;
+                if ((token & 15) == 15)
+                {
+                    uint8_t b;
+                    do
+                    {
+                        if (ip >= len)
+                            return -1;
+                        b = src[ip++];
+                        match_len += b;
+                    } while (b == 255);
+                }
+                if (capacity - op < match_len)
+                    return -1;
+
+                // Byte by byte: the match may overlap what it produces
+                for (size_t i = 0; i < match_len; ++i, ++op)
+                    dst[op] = dst[op - offset];
+            }
+            return static_cast<int>(op);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Diagnostics
+{
+    /**
+     * LZ4 block format (no frame), small enough for a wake
+     *
+     * Compress() is a greedy single-pass matcher over a hash table the
+     * caller provides (HASH_ENTRIES x 2 bytes), so inputs are limited to
+     * MAX_INPUT bytes. Any LZ4 decoder reads its output (lz4.block in
+     * Python, LZ4_decompress_safe in C). Decompress() is the matching
+     * bounds-checked decoder for the host tools.
+     */
+    namespace Lz4
+    {
+        static constexpr uint32_t HASH_LOG = 10;
+        static constexpr size_t HASH_ENTRIES = 1u << HASH_LOG;
+        static constexpr size_t MAX_INPUT = 65535;
+
+        // Worst-case output size for len input bytes
+        constexpr size_t CompressBound(size_t len) { return len + len / 255 + 16; }
+
+        // Compress len bytes of src into dst; returns the block size, 0 if it does not fit in capacity
+        size_t Compress(const uint8_t *src, size_t len, uint8_t *dst, size_t capacity, uint16_t *table);
+
+        // Decode a block into dst; returns the decoded size, -1 if the block is malformed or does not fit
+        int Decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t capacity);
+    }
+}
\ No newline at end of file
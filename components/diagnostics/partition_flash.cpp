@@ -0,0 +1,56 @@
+#include "partition_flash.hpp"
+
+#include "alloc_tracker.hpp"
+
+namespace Diagnostics
+{
+    PartitionFlash::PartitionFlash(const char *label)
+        : partition_(nullptr),
+          mapped_(nullptr),
+          mmap_(0)
+    {
+        // The lookup allocates an iterator; reads and writes below do not
+        AllocTracker::Exempt exempt;
+        partition_ = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    }
+
+    PartitionFlash::~PartitionFlash()
+    {
+        if (mapped_)
+            esp_partition_munmap(mmap_);
+    }
+
+    uint32_t PartitionFlash::Size() const
+    {
+        return partition_ ? (partition_->size / SECTOR_SIZE) * SECTOR_SIZE : 0;
+    }
+
+    esp_err_t PartitionFlash::Read(uint32_t offset, void *buf, size_t len)
+    {
+        return partition_ ? esp_partition_read(partition_, offset, buf, len) : ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t PartitionFlash::Write(uint32_t offset, const void *data, size_t len)
+    {
+        return partition_ ? esp_partition_write(partition_, offset, data, len) : ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t PartitionFlash::EraseSector(uint32_t offset)
+    {
+        return partition_ ? esp_partition_erase_range(partition_, offset, SECTOR_SIZE) : ESP_ERR_NOT_FOUND;
+    }
+
+    const uint8_t *PartitionFlash::Data()
+    {
+        if (!mapped_ && partition_)
+        {
+            const esp_err_t err = esp_partition_mmap(partition_, 0, Size(), ESP_PARTITION_MMAP_DATA, &mapped_, &mmap_);
+            if (err != ESP_OK)
+            {
+                ESP_LOGW(LOG_TAG, "Failed to map %s: %s", partition_->label, esp_err_to_name(err));
+                mapped_ = nullptr;
+            }
+        }
+        return static_cast<const uint8_t *>(mapped_);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "esp_partition.h"
+
+#include "ring_log.hpp"
+
+namespace Diagnostics
+{
+    // FlashIo over a raw data partition (Size() is 0 if the partition table has none)
+    class PartitionFlash : public FlashIo
+    {
+    public:
+        // Look up the partition by label
+        explicit PartitionFlash(const char *label);
+
+        ~PartitionFlash();
+
+        uint32_t Size() const override;
+        esp_err_t Read(uint32_t offset, void *buf, size_t len) override;
+        esp_err_t Write(uint32_t offset, const void *data, size_t len) override;
+        esp_err_t EraseSector(uint32_t offset) override;
+
+        // Maps the partition on first use (through the flash cache, which writes and erases keep coherent)
+        const uint8_t *Data() override;
+
+    private:
+        static constexpr const char *LOG_TAG = "PARTITION_FLASH";
+
+        const esp_partition_t *partition_; ///< NULL if not found
+        const void *mapped_;               ///< Mapped partition (NULL until Data())
+        esp_partition_mmap_handle_t mmap_; ///< Handle of the mapping
+    };
+}
\ No newline at end of file
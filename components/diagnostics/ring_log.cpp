@@ -0,0 +1,379 @@
+#include "ring_log.hpp"
+
+#include "esp_timer.h"
+
+#include <cstring>
+
+namespace Diagnostics
+{
+    namespace
+    {
+        constexpr uint32_t FNV_OFFSET = 2166136261u;
+        constexpr uint32_t FNV_PRIME = 16777619u;
+
+        uint32_t fnv1a(uint32_t hash, const void *data, size_t len)
+        {
+            const uint8_t *bytes = static_cast<const uint8_t *>(data);
+            for (size_t i = 0; i < len; ++i)
+                hash = (hash ^ bytes[i]) * FNV_PRIME;
+            return hash;
+        }
+    }
+
+    RingLog::RingLog(FlashIo *flash, RingLogState *state)
+        : flash_(flash),
+          state_(state),
+          sectors_(flash ? flash->Size() / FlashIo::SECTOR_SIZE : 0)
+    {
+    }
+
+    bool RingLog::Available() const
+    {
+        // The head sector and the erased sectors ahead of it must leave room for old records
+        return sectors_ >= ERASE_AHEAD_SECTORS + 2;
+    }
+
+    esp_err_t RingLog::Recover()
+    {
+        const int64_t start_us = esp_timer_get_time();
+        *state_ = {};
+        if (!Available())
+            return ESP_ERR_INVALID_STATE;
+
+        // 1. The newest valid sector header is the head (one small read per sector)
+        uint32_t head = 0;
+        SectorHeader head_header = {};
+        const bool found = findNewest(&head, &head_header);
+
+        if (!found)
+        {
+            // Blank or foreign flash: the first append erases sector 0
+            state_->head_sector = sectors_ - 1;
+            state_->head_offset = FlashIo::SECTOR_SIZE;
+        }
+        else
+        {
+            // 2. Valid records of the head sector (at most one sector read)
+            uint32_t offset = sizeof(SectorHeader);
+            uint32_t next = head_header.first_record;
+            RecordHeader record;
+            uint8_t payload[MAX_PAYLOAD];
+            while (offset + sizeof(RecordHeader) <= FlashIo::SECTOR_SIZE && readRecord(head, offset, &record, payload) &&
+                   record.seq == next)
+            {
+                offset += RecordSize(record.len);
+                next++;
+            }
+
+            // A torn record leaves programmed bytes behind that cannot be written again: go on in the next sector
+            if (offset < FlashIo::SECTOR_SIZE &&
+                !isBlank(head * FlashIo::SECTOR_SIZE + offset, FlashIo::SECTOR_SIZE - offset))
+                offset = FlashIo::SECTOR_SIZE;
+
+            state_->head_sector = head;
+            state_->head_offset = offset;
+            state_->head_seq = head_header.seq;
+            state_->next_record = next;
+        }
+
+        // 3. Sectors after the head that are still erased (a torn erase is not)
+        while (state_->erased_ahead < ERASE_AHEAD_SECTORS &&
+               isBlank(((state_->head_sector + 1 + state_->erased_ahead) % sectors_) * FlashIo::SECTOR_SIZE,
+                       FlashIo::SECTOR_SIZE))
+            state_->erased_ahead++;
+
+        state_->valid = true;
+        state_->recover_us = static_cast<uint32_t>(esp_timer_get_time() - start_us);
+        ESP_LOGI(LOG_TAG, "Recovered head at sector %lu + %lu, next record %lu, %lu erased ahead, in %lu us",
+                 static_cast<unsigned long>(state_->head_sector), static_cast<unsigned long>(state_->head_offset),
+                 static_cast<unsigned long>(state_->next_record), static_cast<unsigned long>(state_->erased_ahead),
+                 static_cast<unsigned long>(state_->recover_us));
+        return ESP_OK;
+    }
+
+    esp_err_t RingLog::Append(uint8_t type, const void *data, size_t len)
+    {
+        if (!Available() || !state_->valid)
+            return ESP_ERR_INVALID_STATE;
+        if (len > MAX_PAYLOAD)
+            return ESP_ERR_INVALID_SIZE;
+
+        const uint32_t size = RecordSize(len);
+        if (state_->head_offset + size > FlashIo::SECTOR_SIZE)
+        {
+            const esp_err_t err = advance();
+            if (err != ESP_OK)
+                return err;
+        }
+
+        // Header and payload go out in a single program operation
+        uint32_t buf[(sizeof(RecordHeader) + MAX_PAYLOAD + 3) / 4];
+        uint8_t *bytes = reinterpret_cast<uint8_t *>(buf);
+        RecordHeader header = {};
+        header.len = static_cast<uint16_t>(len);
+        header.type = type;
+        header.seq = state_->next_record;
+        header.checksum = RecordChecksum(header, static_cast<const uint8_t *>(data));
+        memcpy(bytes, &header, sizeof(header));
+        memcpy(bytes + sizeof(header), data, len);
+        memset(bytes + sizeof(header) + len, 0xFF, size - sizeof(header) - len);
+
+        const esp_err_t err = flash_->Write(state_->head_sector * FlashIo::SECTOR_SIZE + state_->head_offset, bytes, size);
+        if (err != ESP_OK)
+        {
+            // Part of the record may be programmed; the next append starts a new sector
+            state_->head_offset = FlashIo::SECTOR_SIZE;
+            return err;
+        }
+
+        state_->head_offset += size;
+        state_->next_record++;
+        return ESP_OK;
+    }
+
+    uint32_t RingLog::EraseAhead(uint32_t max_sectors)
+    {
+        if (!Available() || !state_->valid)
+            return 0;
+
+        uint32_t erased = 0;
+        while (erased < max_sectors && state_->erased_ahead < ERASE_AHEAD_SECTORS)
+        {
+            // The ring is full once this reaches old records: they are dropped oldest first
+            const uint32_t sector = (state_->head_sector + 1 + state_->erased_ahead) % sectors_;
+            if (flash_->EraseSector(sector * FlashIo::SECTOR_SIZE) != ESP_OK)
+                break;
+            state_->erased_ahead++;
+            erased++;
+        }
+        return erased;
+    }
+
+    uint32_t RingLog::ForEach(RecordVisitor visitor, void *arg)
+    {
+        uint32_t head = 0;
+        SectorHeader header = {};
+        if (!Available() || !findNewest(&head, &header))
+            return 0;
+
+        // Sectors are used in ring order, so the one after the head holds the oldest records
+        uint32_t visited = 0;
+        RecordHeader record;
+        uint8_t payload[MAX_PAYLOAD];
+        for (uint32_t i = 1; i <= sectors_; ++i)
+        {
+            const uint32_t sector = (head + i) % sectors_;
+            if (!readSectorHeader(sector, &header))
+                continue;
+
+            uint32_t offset = sizeof(SectorHeader);
+            while (offset + sizeof(RecordHeader) <= FlashIo::SECTOR_SIZE && readRecord(sector, offset, &record, payload))
+            {
+                visitor(record, payload, arg);
+                offset += RecordSize(record.len);
+                visited++;
+            }
+        }
+        return visited;
+    }
+
+    bool RingLog::FindRun(uint32_t from_record, uint32_t end_record, uint32_t max_len, RecordRun *run)
+    {
+        if (!Available() || static_cast<int32_t>(end_record - from_record) <= 0)
+            return false;
+        // Runs are found on every chunk of an upload: scan through the mapping rather than copy records out
+        const uint8_t *mapped = flash_->Data();
+
+        // Start in the sector with the last first_record at or before from_record, else in the oldest one
+        bool found = false;
+        bool found_oldest = false;
+        uint32_t start = 0;
+        uint32_t oldest = 0;
+        SectorHeader best = {};
+        SectorHeader oldest_header = {};
+        SectorHeader header;
+        for (uint32_t s = 0; s < sectors_; ++s)
+        {
+            if (!peekSectorHeader(mapped, s, &header))
+                continue;
+            if (static_cast<int32_t>(header.first_record - from_record) <= 0 &&
+                (!found || static_cast<int32_t>(header.seq - best.seq) > 0))
+            {
+                start = s;
+                best = header;
+                found = true;
+            }
+            if (!found_oldest || static_cast<int32_t>(header.seq - oldest_header.seq) < 0)
+            {
+                oldest = s;
+                oldest_header = header;
+                found_oldest = true;
+            }
+        }
+        if (!found_oldest)
+            return false;
+        if (!found)
+            start = oldest;
+
+        // Usually the first sector holds from_record; a torn end moves it into the next one
+        *run = {};
+        RecordHeader record;
+        for (uint32_t i = 0; i < sectors_; ++i)
+        {
+            const uint32_t sector = (start + i) % sectors_;
+            if (!peekSectorHeader(mapped, sector, &header))
+                continue;
+            if (i > 0 && static_cast<int32_t>(header.seq - best.seq) <= 0 && found)
+                break; // Wrapped around to older sectors
+
+            uint32_t offset = sizeof(SectorHeader);
+            while (offset + sizeof(RecordHeader) <= FlashIo::SECTOR_SIZE && peekRecord(mapped, sector, offset, &record))
+            {
+                const uint32_t size = RecordSize(record.len);
+                if (static_cast<int32_t>(record.seq - end_record) >= 0 || (run->records > 0 && run->len + size > max_len))
+                    return run->records > 0;
+                if (static_cast<int32_t>(record.seq - from_record) >= 0)
+                {
+                    if (run->records == 0)
+                    {
+                        run->offset = sector * FlashIo::SECTOR_SIZE + offset;
+                        run->first_record = record.seq;
+                    }
+                    run->len += size;
+                    run->records++;
+                }
+                offset += size;
+            }
+            if (run->records > 0)
+                return true;
+            best = header;
+            found = true;
+        }
+        return false;
+    }
+
+    esp_err_t RingLog::advance()
+    {
+        const uint32_t next = (state_->head_sector + 1) % sectors_;
+        if (state_->erased_ahead > 0)
+        {
+            state_->erased_ahead--;
+        }
+        else
+        {
+            state_->inline_erases++;
+            const esp_err_t err = flash_->EraseSector(next * FlashIo::SECTOR_SIZE);
+            if (err != ESP_OK)
+                return err;
+        }
+
+        SectorHeader header = {};
+        header.magic = SECTOR_MAGIC;
+        header.seq = state_->head_seq + 1;
+        header.first_record = state_->next_record;
+        header.checksum = sectorChecksum(header);
+        const esp_err_t err = flash_->Write(next * FlashIo::SECTOR_SIZE, &header, sizeof(header));
+
+        // Even a failed header leaves the sector programmed; never write into it again before an erase
+        state_->head_sector = next;
+        state_->head_seq = header.seq;
+        state_->head_offset = err == ESP_OK ? sizeof(SectorHeader) : FlashIo::SECTOR_SIZE;
+        return err;
+    }
+
+    bool RingLog::findNewest(uint32_t *sector, SectorHeader *newest)
+    {
+        bool found = false;
+        SectorHeader header;
+        for (uint32_t s = 0; s < sectors_; ++s)
+        {
+            if (!readSectorHeader(s, &header))
+                continue;
+            // Wrap-safe comparison of the sector sequence numbers
+            if (!found || static_cast<int32_t>(header.seq - newest->seq) > 0)
+            {
+                *sector = s;
+                *newest = header;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    bool RingLog::readSectorHeader(uint32_t sector, SectorHeader *header)
+    {
+        if (flash_->Read(sector * FlashIo::SECTOR_SIZE, header, sizeof(*header)) != ESP_OK)
+            return false;
+        return header->magic == SECTOR_MAGIC && header->checksum == sectorChecksum(*header);
+    }
+
+    bool RingLog::readRecord(uint32_t sector, uint32_t offset, RecordHeader *header, uint8_t *payload)
+    {
+        const uint32_t base = sector * FlashIo::SECTOR_SIZE + offset;
+        if (flash_->Read(base, header, sizeof(*header)) != ESP_OK)
+            return false;
+
+        // Erased space reads as len 0xFFFF, which fails here
+        if (header->len > MAX_PAYLOAD || offset + RecordSize(header->len) > FlashIo::SECTOR_SIZE)
+            return false;
+        if (flash_->Read(base + sizeof(*header), payload, header->len) != ESP_OK)
+            return false;
+        return header->checksum == RecordChecksum(*header, payload);
+    }
+
+    bool RingLog::peekSectorHeader(const uint8_t *mapped, uint32_t sector, SectorHeader *header)
+    {
+        if (!mapped)
+            return readSectorHeader(sector, header);
+        memcpy(header, mapped + sector * FlashIo::SECTOR_SIZE, sizeof(*header));
+        return header->magic == SECTOR_MAGIC && header->checksum == sectorChecksum(*header);
+    }
+
+    bool RingLog::peekRecord(const uint8_t *mapped, uint32_t sector, uint32_t offset, RecordHeader *header)
+    {
+        if (!mapped)
+        {
+            uint8_t payload[MAX_PAYLOAD];
+            return readRecord(sector, offset, header, payload);
+        }
+
+        const uint8_t *base = mapped + sector * FlashIo::SECTOR_SIZE + offset;
+        memcpy(header, base, sizeof(*header));
+        if (header->len > MAX_PAYLOAD || offset + RecordSize(header->len) > FlashIo::SECTOR_SIZE)
+            return false;
+        return header->checksum == RecordChecksum(*header, base + sizeof(*header));
+    }
+
+    bool RingLog::isBlank(uint32_t offset, uint32_t len)
+    {
+        uint32_t chunk[64];
+        while (len > 0)
+        {
+            const uint32_t n = len < sizeof(chunk) ? len : sizeof(chunk);
+            if (flash_->Read(offset, chunk, n) != ESP_OK)
+                return false;
+
+            const uint8_t *bytes = reinterpret_cast<const uint8_t *>(chunk);
+            for (uint32_t i = 0; i < n; ++i)
+            {
+                if (bytes[i] != 0xFF)
+                    return false;
+            }
+            offset += n;
+            len -= n;
+        }
+        return true;
+    }
+
+    uint32_t RingLog::sectorChecksum(const SectorHeader &header)
+    {
+        uint32_t hash = fnv1a(FNV_OFFSET, &header, offsetof(SectorHeader, checksum));
+        return fnv1a(hash, &LAYOUT, sizeof(LAYOUT));
+    }
+
+    uint32_t RingLog::RecordChecksum(const RecordHeader &header, const uint8_t *payload)
+    {
+        const uint32_t hash = fnv1a(FNV_OFFSET, &header, offsetof(RecordHeader, checksum));
+        return fnv1a(hash, payload, header.len);
+    }
+}
\ No newline at end of file
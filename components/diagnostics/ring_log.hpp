@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+#include "esp_log.h"
+
+namespace Diagnostics
+{
+    // Raw flash the log lives on (a partition on the device, an image file on the host)
+    class FlashIo
+    {
+    public:
+        virtual ~FlashIo() = default;
+
+        // Usable bytes (a multiple of SECTOR_SIZE; 0 if there is no flash)
+        virtual uint32_t Size() const = 0;
+
+        virtual esp_err_t Read(uint32_t offset, void *buf, size_t len) = 0;
+
+        // Program bytes; like NOR flash this can only clear bits of erased (0xFF) bytes
+        virtual esp_err_t Write(uint32_t offset, const void *data, size_t len) = 0;
+
+        // Erase one SECTOR_SIZE sector to 0xFF (offset is sector aligned)
+        virtual esp_err_t EraseSector(uint32_t offset) = 0;
+
+        // The whole area mapped into the address space for reading (NULL if it cannot be mapped)
+        virtual const uint8_t *Data() { return nullptr; }
+
+        static constexpr uint32_t SECTOR_SIZE = 4096;
+    };
+
+    // Head of the log, kept in RTC memory between deep sleep cycles
+    struct RingLogState
+    {
+        bool valid;             ///< Fields below match the flash (false after power loss: Recover())
+        uint32_t head_sector;   ///< Sector records are appended to
+        uint32_t head_offset;   ///< Next free byte in the head sector (SECTOR_SIZE: full)
+        uint32_t head_seq;      ///< Sequence number of the head sector
+        uint32_t next_record;   ///< Sequence number of the next record
+        uint32_t erased_ahead;  ///< Sectors after the head known to be erased
+        uint32_t inline_erases; ///< Appends that had to wait for an erase (since power-up)
+        uint32_t recover_us;    ///< Duration of the last recovery scan (µs)
+    };
+
+    // Stored records from one sector, contiguous on flash
+    struct RecordRun
+    {
+        uint32_t offset;       ///< Flash offset of the first record header
+        uint32_t len;          ///< Bytes of the records, padding included
+        uint32_t first_record; ///< Sequence number of the first record
+        uint32_t records;      ///< Records in the run
+    };
+
+    // One record as stored (payload follows, padded to 4 bytes)
+    struct RecordHeader
+    {
+        uint16_t len;      ///< Payload bytes
+        uint8_t type;      ///< Record type, defined by the writer
+        uint8_t reserved;  ///< 0
+        uint32_t seq;      ///< Record sequence number, +1 per record
+        uint32_t checksum; ///< FNV-1a over len, type, seq and the payload
+    };
+
+    /**
+     * Append-only diagnostic log on a dedicated raw flash area
+     *
+     * The area is used as a ring of 4 KB sectors. Each sector starts with a
+     * header carrying an increasing sector sequence number; records never
+     * cross a sector boundary. When the ring is full the oldest sector is
+     * erased and reused.
+     *
+     * Appends are one flash program each: ERASE_AHEAD_SECTORS sectors after
+     * the head are kept erased by EraseAhead(), which the caller runs when
+     * the CPU would otherwise wait (for the broker, for acknowledgements).
+     * Only when an append catches up with the erased sectors does it have
+     * to erase inline (counted in RingLogState::inline_erases).
+     *
+     * After power loss Recover() finds the head with bounded cost: one
+     * sector header read per sector, a scan of the head sector, and a blank
+     * check of the sectors after it. A record torn by the power cut fails
+     * its checksum and ends the head sector; appends continue in the next
+     * one. Erasing or writing a sector header is torn the same way and
+     * detected by its checksum.
+     *
+     * Nothing is allocated; records are limited to MAX_PAYLOAD bytes.
+     */
+    class RingLog
+    {
+    public:
+        // Log on flash with its head in RTC state (cleared after power loss, then filled by Recover())
+        RingLog(FlashIo *flash, RingLogState *state);
+
+        // False if the flash is missing or too small for a ring
+        bool Available() const;
+
+        // Find the head after power loss
+        esp_err_t Recover();
+
+        // Append one record; ESP_ERR_INVALID_SIZE if longer than MAX_PAYLOAD
+        esp_err_t Append(uint8_t type, const void *data, size_t len);
+
+        // Erase up to max_sectors sectors ahead of the head; returns the number erased
+        uint32_t EraseAhead(uint32_t max_sectors);
+
+        // Called for every record, oldest first
+        using RecordVisitor = void (*)(const RecordHeader &header, const uint8_t *payload, void *arg);
+
+        // Read back all records still in the ring; returns the number visited
+        uint32_t ForEach(RecordVisitor visitor, void *arg);
+
+        /**
+         * Find the stored records from from_record on
+         *
+         * Fills run with whole records of one sector, at most max_len bytes,
+         * all before end_record. If from_record was overwritten (or torn),
+         * the run starts at the next record still stored. Returns false if
+         * there is none before end_record.
+         */
+        bool FindRun(uint32_t from_record, uint32_t end_record, uint32_t max_len, RecordRun *run);
+
+        // Sequence number the next record will get
+        uint32_t NextRecord() const { return state_->next_record; }
+
+        // Checksum a stored record must carry (for readers of uploaded records)
+        static uint32_t RecordChecksum(const RecordHeader &header, const uint8_t *payload);
+
+        // Bytes a record with len payload bytes takes on flash
+        static uint32_t RecordSize(size_t len) { return (sizeof(RecordHeader) + len + 3) & ~3u; }
+
+        static constexpr size_t MAX_PAYLOAD = 240;
+        static constexpr uint32_t ERASE_AHEAD_SECTORS = 8;
+
+    private:
+        static constexpr const char *LOG_TAG = "RING_LOG";
+        static constexpr uint32_t SECTOR_MAGIC = 0x474F4C52; // "RLOG"
+        static constexpr uint32_t LAYOUT = 1;
+
+        struct SectorHeader
+        {
+            uint32_t magic;        ///< SECTOR_MAGIC
+            uint32_t seq;          ///< Sector sequence number, +1 per sector used
+            uint32_t first_record; ///< Sequence number of the first record in the sector
+            uint32_t checksum;     ///< FNV-1a over the fields above and LAYOUT
+        };
+
+        FlashIo *flash_;
+        RingLogState *state_;
+        uint32_t sectors_; ///< Sectors in the ring
+
+        // Move the head to the next sector, erasing it unless it was erased ahead
+        esp_err_t advance();
+
+        // Find the sector with the newest valid header; false if there is none
+        bool findNewest(uint32_t *sector, SectorHeader *newest);
+
+        // Read a sector header; false if it is not a valid one
+        bool readSectorHeader(uint32_t sector, SectorHeader *header);
+
+        // Read and check the record at offset of sector; false at the end of the valid records
+        bool readRecord(uint32_t sector, uint32_t offset, RecordHeader *header, uint8_t *payload);
+
+        // readSectorHeader() / readRecord() in place through mapped (the flash mapping), with a copy if it is NULL
+        bool peekSectorHeader(const uint8_t *mapped, uint32_t sector, SectorHeader *header);
+        bool peekRecord(const uint8_t *mapped, uint32_t sector, uint32_t offset, RecordHeader *header);
+
+        // True if len bytes from offset are all erased
+        bool isBlank(uint32_t offset, uint32_t len);
+
+        static uint32_t sectorChecksum(const SectorHeader &header);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Diagnostics
+{
+    // Record types of the diagnostic log
+    enum class RecordType : uint8_t
+    {
+        WAKE = 1, ///< WakeRecord, one per wake
+    };
+
+    // Bits of WakeRecord::flags
+    enum WakeFlags : uint8_t
+    {
+        WAKE_FRESH_BOOT = 1 << 0,     ///< First wake after power-up or reset
+        WAKE_MAIL_DETECTED = 1 << 1,  ///< A mail drop was detected
+        WAKE_MAIL_COLLECTED = 1 << 2, ///< A collection was detected
+        WAKE_SESSION = 1 << 3,        ///< The radio was turned on
+        WAKE_CONNECTED = 1 << 4,      ///< Wi-Fi came up and telemetry was published
+        WAKE_SUPPRESSED = 1 << 5,     ///< The drop or collection was held back by flap damping
+    };
+
+    // What one wake did, for field debugging
+    struct WakeRecord
+    {
+        uint32_t wake;           ///< Wake counter
+        uint32_t virtual_time_s; ///< Virtual time at the measurement (s)
+        uint16_t awake_ms;       ///< Time awake until the record was written (ms)
+        uint16_t battery_mv;     ///< Smoothed battery voltage (0: no reading yet)
+        int16_t raw_mm;          ///< Raw echo distance (mm, negative: timeout)
+        int16_t filtered_mm;     ///< Median-filtered distance (mm, negative: no valid samples)
+        uint8_t state;           ///< Processor::MailboxState after the wake
+        uint8_t flags;           ///< WakeFlags
+        uint16_t boot_10us;      ///< Timer wake to app_main (10 µs units, 0: fresh boot or not measured)
+    };
+}
\ No newline at end of file
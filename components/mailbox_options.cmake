@@ -0,0 +1,17 @@
+# Compile options shared by the firmware components and main
+function(mailbox_component_options)
+    target_compile_options(${COMPONENT_LIB} PRIVATE
+        -Wno-unused-function
+        -fno-exceptions
+        -fno-rtti
+        -fmerge-all-constants
+        -Os
+        -ffunction-sections
+        -fdata-sections
+        -Wno-array-bounds
+    )
+
+    if(CMAKE_BUILD_TYPE STREQUAL "Release")
+        target_compile_options(${COMPONENT_LIB} PRIVATE -g0)
+    endif()
+endfunction()
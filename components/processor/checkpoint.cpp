@@ -0,0 +1,121 @@
+#include "checkpoint.hpp"
+
+#include "nvs.h"
+
+namespace Processor
+{
+    CheckpointStore::CheckpointStore(CheckpointState *state)
+        : state_(state)
+    {
+    }
+
+    esp_err_t CheckpointStore::Restore(StateContext *ctx, uint32_t *wake_count)
+    {
+        const int64_t start_us = esp_timer_get_time();
+        *state_ = {};
+
+        nvs_handle_t handle;
+        esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle);
+        if (err != ESP_OK)
+        {
+            // The namespace does not exist until the first checkpoint was saved
+            if (err != ESP_ERR_NVS_NOT_FOUND)
+                ESP_LOGW(LOG_TAG, "Failed to open NVS: %s", esp_err_to_name(err));
+            return ESP_ERR_NOT_FOUND;
+        }
+
+        Checkpoint stored;
+        size_t len = sizeof(stored);
+        err = nvs_get_blob(handle, NVS_KEY, &stored, &len);
+        nvs_close(handle);
+
+        if (err == ESP_ERR_NVS_NOT_FOUND)
+            return ESP_ERR_NOT_FOUND;
+
+        const bool known_state = stored.mailbox_state == MailboxState::EMPTY ||
+                                 stored.mailbox_state == MailboxState::HAS_MAIL ||
+                                 stored.mailbox_state == MailboxState::FULL;
+        if (err != ESP_OK || len != sizeof(stored) || stored.layout != LAYOUT || !known_state)
+        {
+            // Unreadable, or written by a firmware with a different layout
+            ESP_LOGW(LOG_TAG, "Ignoring stored checkpoint (%s)", esp_err_to_name(err));
+            return ESP_ERR_NOT_FOUND;
+        }
+
+        ctx->current_state = stored.mailbox_state;
+        *wake_count = stored.wake_count;
+
+        state_->valid = true;
+        state_->stored = stored;
+        state_->restore_us = static_cast<uint32_t>(esp_timer_get_time() - start_us);
+
+        ESP_LOGI(LOG_TAG, "Restored state %d at wake %lu in %lu us (%lu checkpoints written)",
+                 static_cast<int>(stored.mailbox_state), static_cast<unsigned long>(stored.wake_count),
+                 static_cast<unsigned long>(state_->restore_us), static_cast<unsigned long>(stored.writes));
+        return ESP_OK;
+    }
+
+    bool CheckpointStore::Due(const StateContext &ctx, uint64_t now_us) const
+    {
+        const bool changed = !state_->valid || stableState(ctx) != state_->stored.mailbox_state;
+        const bool refresh = now_us - state_->last_write_us >= Config::CHECKPOINT_INTERVAL_SEC * 1000000ULL;
+        if (!changed && !refresh)
+            return false;
+
+        // Changes held back by the budget go out with the first write of the next window
+        const bool new_window = now_us - state_->window_start_us >= BUDGET_WINDOW_US;
+        return new_window || state_->window_writes < Config::CHECKPOINT_MAX_WRITES_PER_DAY;
+    }
+
+    esp_err_t CheckpointStore::Save(const StateContext &ctx, uint32_t wake_count, uint64_t now_us)
+    {
+        Checkpoint checkpoint = {};
+        checkpoint.layout = LAYOUT;
+        checkpoint.mailbox_state = stableState(ctx);
+        checkpoint.wake_count = wake_count;
+        checkpoint.writes = state_->stored.writes + 1;
+
+        nvs_handle_t handle;
+        esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+        if (err == ESP_OK)
+        {
+            err = nvs_set_blob(handle, NVS_KEY, &checkpoint, sizeof(checkpoint));
+            if (err == ESP_OK)
+                err = nvs_commit(handle);
+            nvs_close(handle);
+        }
+
+        if (now_us - state_->window_start_us >= BUDGET_WINDOW_US)
+        {
+            state_->window_start_us = now_us;
+            state_->window_writes = 0;
+        }
+        // A failed write may still have reached the flash; it counts against the budget either way
+        state_->window_writes++;
+        state_->last_write_us = now_us;
+        if (state_->window_writes == Config::CHECKPOINT_MAX_WRITES_PER_DAY)
+            ESP_LOGW(LOG_TAG, "Write budget of %lu per day used up, further changes wait up to %llu s",
+                     static_cast<unsigned long>(Config::CHECKPOINT_MAX_WRITES_PER_DAY),
+                     (state_->window_start_us + BUDGET_WINDOW_US - now_us) / 1000000ULL);
+
+        if (err != ESP_OK)
+        {
+            ESP_LOGE(LOG_TAG, "Failed to save checkpoint: %s", esp_err_to_name(err));
+            return err;
+        }
+
+        state_->valid = true;
+        state_->stored = checkpoint;
+        ESP_LOGI(LOG_TAG, "Saved state %d at wake %lu (%lu today, %lu total)",
+                 static_cast<int>(checkpoint.mailbox_state), static_cast<unsigned long>(wake_count),
+                 static_cast<unsigned long>(state_->window_writes), static_cast<unsigned long>(checkpoint.writes));
+        return ESP_OK;
+    }
+
+    MailboxState CheckpointStore::stableState(const StateContext &ctx)
+    {
+        if (ctx.current_state == MailboxState::OBSTRUCTED)
+            return ctx.resume_state;
+        return ctx.current_state == MailboxState::EMPTIED ? MailboxState::EMPTY : ctx.current_state;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+
+#include "esp_err.h"
+#include "esp_log.h"
+
+#include "processor.hpp"
+
+namespace Processor
+{
+    // What a checkpoint stores in NVS
+    struct Checkpoint
+    {
+        uint32_t layout;            ///< CheckpointStore::LAYOUT of the firmware that wrote it
+        MailboxState mailbox_state; ///< Stable mailbox state (EMPTIED is stored as EMPTY, OBSTRUCTED as the state before it)
+        uint32_t wake_count;        ///< Wake counter at the time of the checkpoint
+        uint32_t writes;            ///< Checkpoints written over the device lifetime, this one included
+    };
+
+    // Checkpoint bookkeeping kept in RTC memory between deep sleep cycles
+    struct CheckpointState
+    {
+        bool valid;               ///< stored is what NVS holds
+        Checkpoint stored;        ///< Last checkpoint written or restored
+        uint64_t last_write_us;   ///< Virtual time of the last write
+        uint64_t window_start_us; ///< Start of the current write budget window (virtual time)
+        uint32_t window_writes;   ///< Writes within the budget window
+        uint32_t restore_us;      ///< Time the restore after the last power loss took (µs)
+    };
+
+    /**
+     * Crash-consistent checkpoint of the processor state in NVS
+     *
+     * RTC memory survives deep sleep but not a battery swap or a brownout.
+     * After one, Restore() puts the mailbox state (and roughly the wake
+     * counter) back, so mail that was already reported is neither reported
+     * again nor forgotten.
+     *
+     * Flash is written only when the stable mailbox state changed, or every
+     * Config::CHECKPOINT_INTERVAL_SEC to refresh the wake counter. On top of
+     * that, at most Config::CHECKPOINT_MAX_WRITES_PER_DAY writes happen per
+     * day of virtual time: a flapping sensor cannot wear out the flash, and
+     * a change held back by the budget is written once the next day starts.
+     * A checkpoint is a single NVS blob, which NVS replaces atomically, so a
+     * power cut during a write leaves the previous checkpoint.
+     *
+     * NVS must be initialized before Restore() and Save().
+     */
+    class CheckpointStore
+    {
+    public:
+        // Store over the RTC state (cleared after power loss, then filled by Restore())
+        explicit CheckpointStore(CheckpointState *state);
+
+        /**
+         * Load the last checkpoint after power loss
+         *
+         * On success the mailbox state in ctx and wake_count are replaced with
+         * the stored ones. Returns ESP_ERR_NOT_FOUND if there is no usable
+         * checkpoint; ctx and wake_count are left alone then.
+         */
+        esp_err_t Restore(StateContext *ctx, uint32_t *wake_count);
+
+        // True if this wake should write a checkpoint (state changed or interval elapsed, within the budget)
+        bool Due(const StateContext &ctx, uint64_t now_us) const;
+
+        // Write a checkpoint of ctx
+        esp_err_t Save(const StateContext &ctx, uint32_t wake_count, uint64_t now_us);
+
+        // Checkpoints written in the current budget window, and over the device lifetime
+        uint32_t WritesToday() const { return state_->window_writes; }
+        uint32_t WritesTotal() const { return state_->stored.writes; }
+
+    private:
+        static constexpr const char *LOG_TAG = "CHECKPOINT";
+        static constexpr const char *NVS_NAMESPACE = "processor";
+        static constexpr const char *NVS_KEY = "checkpoint";
+        static constexpr uint32_t LAYOUT = 1;
+        static constexpr uint64_t BUDGET_WINDOW_US = 86400ULL * 1000000ULL;
+
+        CheckpointState *state_; ///< RTC-backed state
+
+        // State as stored: the transitional EMPTIED state is stored as where it leads, OBSTRUCTED as the state before it
+        static MailboxState stableState(const StateContext &ctx);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "digest.hpp"
+
+#include <algorithm>
+
+namespace Processor
+{
+    DigestAggregator::DigestAggregator(DigestState *state)
+        : state_(state)
+    {
+    }
+
+    void DigestAggregator::Record(const DistanceData &data, bool battery_critical, uint64_t now_us, int64_t wall_s)
+    {
+        if (!state_->valid)
+        {
+            *state_ = {};
+            startPeriod(now_us, wall_s);
+            state_->valid = true;
+        }
+        else if (state_->last_state == MailboxState::FULL)
+        {
+            state_->full_us += now_us - state_->last_wake_us;
+        }
+        if (state_->period_start_wall_s == 0 && ClockSet(wall_s))
+        {
+            // The first session after power loss set the clock: date the period back to its start
+            state_->period_start_wall_s = wall_s - static_cast<int64_t>((now_us - state_->period_start_us) / 1000000ULL);
+        }
+
+        state_->wakes++;
+        if (data.mail_detected)
+        {
+            if (state_->drops == 0)
+                state_->first_drop_us = now_us;
+            state_->last_drop_us = now_us;
+            state_->drops++;
+        }
+        if (data.mail_collected)
+            state_->collections++;
+        state_->min_success_rate = std::min(state_->min_success_rate, data.success_rate);
+        state_->last_state = data.state;
+        state_->last_wake_us = now_us;
+
+        uint8_t active = 0;
+        if (data.state == MailboxState::FULL)
+            active |= ALARM_FULL;
+        if (data.success_rate < Config::DIGEST_ALARM_SUCCESS_RATE || data.state == MailboxState::OBSTRUCTED)
+            active |= ALARM_SENSOR;
+        if (battery_critical)
+            active |= ALARM_BATTERY;
+        state_->active_alarms = active;
+        state_->latched_alarms &= active;
+    }
+
+    uint8_t DigestAggregator::PendingAlarms(uint64_t now_us) const
+    {
+        if (now_us < state_->retry_after_us)
+            return 0;
+        return state_->active_alarms & ~(state_->latched_alarms | state_->period_alarms);
+    }
+
+    void DigestAggregator::AlarmsSent(uint8_t alarms)
+    {
+        state_->latched_alarms |= alarms;
+        state_->period_alarms |= alarms;
+        state_->retry_after_us = 0;
+    }
+
+    bool DigestAggregator::Due(int32_t at_min, uint32_t offset_sec, uint64_t now_us, int64_t wall_s) const
+    {
+        if (at_min < 0 || !state_->valid || now_us < state_->retry_after_us)
+            return false;
+        if (!ClockSet(wall_s) || state_->period_start_wall_s == 0)
+        {
+            // Without a clock: one session after the offset to set it, then one a day
+            if (state_->digests == 0)
+                return now_us - state_->period_start_us >= offset_sec * 1000000ULL;
+            return now_us - state_->period_start_us >= FALLBACK_PERIOD_US;
+        }
+
+        // The first report minute after the start of the period
+        const int64_t start = state_->period_start_wall_s;
+        int64_t due = start - start % 86400 + static_cast<int64_t>(at_min) * 60 + offset_sec;
+        if (due <= start)
+            due += 86400;
+        return wall_s >= due;
+    }
+
+    void DigestAggregator::Sent(uint64_t now_us, int64_t wall_s)
+    {
+        ESP_LOGI(LOG_TAG, "Digest %lu delivered: %lu drops, %lu collections over %llu s",
+                 static_cast<unsigned long>(state_->digests + 1), static_cast<unsigned long>(state_->drops),
+                 static_cast<unsigned long>(state_->collections),
+                 static_cast<unsigned long long>((now_us - state_->period_start_us) / 1000000ULL));
+        state_->digests++;
+        startPeriod(now_us, wall_s);
+    }
+
+    void DigestAggregator::Failed(uint64_t now_us)
+    {
+        state_->retry_after_us = now_us + Config::DIGEST_RETRY_SEC * 1000000ULL;
+        ESP_LOGW(LOG_TAG, "Digest or alarm not delivered, retrying in %lu s",
+                 static_cast<unsigned long>(Config::DIGEST_RETRY_SEC));
+    }
+
+    void DigestAggregator::startPeriod(uint64_t now_us, int64_t wall_s)
+    {
+        state_->period_start_us = now_us;
+        state_->period_start_wall_s = ClockSet(wall_s) ? wall_s : 0;
+        state_->last_wake_us = now_us;
+        state_->retry_after_us = 0;
+        state_->wakes = 0;
+        state_->drops = 0;
+        state_->collections = 0;
+        state_->first_drop_us = 0;
+        state_->last_drop_us = 0;
+        state_->full_us = 0;
+        state_->min_success_rate = 1.0f;
+        state_->period_alarms = 0;
+    }
+}
\ No newline at end of file
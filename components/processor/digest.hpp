@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+
+#include "esp_log.h"
+
+#include "processor.hpp"
+
+namespace Processor
+{
+    // Conditions that still open a session right away in digest mode
+    enum DigestAlarm : uint8_t
+    {
+        ALARM_FULL = 1 << 0,    ///< The mailbox is full
+        ALARM_SENSOR = 1 << 1,  ///< Success rate below Config::DIGEST_ALARM_SUCCESS_RATE
+        ALARM_BATTERY = 1 << 2, ///< The battery is at the CRITICAL power level
+    };
+
+    // Events of the current digest period, kept in RTC memory between deep sleep cycles
+    struct DigestState
+    {
+        bool valid;                  ///< False until the first wake after power loss started a period
+        uint32_t digests;            ///< Digests delivered since power-up
+        uint64_t period_start_us;    ///< Virtual time the period started
+        int64_t period_start_wall_s; ///< Wall clock at the start of the period (0: not set yet)
+        uint64_t last_wake_us;       ///< Virtual time of the last wake recorded
+        uint64_t retry_after_us;     ///< No new digest attempt before this virtual time (after a failed one)
+        uint32_t wakes;              ///< Wakes recorded
+        uint32_t drops;              ///< Mail drops detected
+        uint32_t collections;        ///< Collections detected
+        uint64_t first_drop_us;      ///< Virtual time of the first drop (valid if drops > 0)
+        uint64_t last_drop_us;       ///< Virtual time of the last drop (valid if drops > 0)
+        uint64_t full_us;            ///< Time spent in FULL
+        float min_success_rate;      ///< Lowest measurement success rate seen
+        MailboxState last_state;     ///< Mailbox state after the last wake
+        uint8_t active_alarms;       ///< DigestAlarm conditions at the last wake
+        uint8_t latched_alarms;      ///< Reported and still active: not reported again until they clear
+        uint8_t period_alarms;       ///< Reported during the period (at most once each)
+    };
+
+    /**
+     * On-device aggregation of mailbox events for the daily digest mode
+     *
+     * In digest mode (Config::RuntimeConfig::digest_at_min >= 0) drops and
+     * collections no longer open a session each, and there are no hourly
+     * heartbeats. Every wake is folded into the period: counts, first and
+     * last drop, time in FULL, the lowest success rate. Once a day, at the
+     * configured minute after midnight UTC, the period goes out as one
+     * digest together with the regular status, and a new period starts.
+     *
+     * Alarms are the exception: the mailbox filling up, the sensor failing
+     * and a critical battery open a session at once. Each alarm is reported
+     * at most once per period, and again only after its condition cleared.
+     *
+     * The wall clock comes from SNTP and runs on through deep sleep. Until a
+     * session set it (after power loss), a digest is due right away, and
+     * then every 24 h of virtual time.
+     */
+    class DigestAggregator
+    {
+    public:
+        // Aggregator over the RTC state (cleared after power loss, a period starts on the first Record())
+        explicit DigestAggregator(DigestState *state);
+
+        // Fold one processed wake into the period (wall_s: time(), 0 or earlier if the clock is not set)
+        void Record(const DistanceData &data, bool battery_critical, uint64_t now_us, int64_t wall_s);
+
+        // Alarms active at the last wake and not reported yet (none while a failed session waits for its retry)
+        uint8_t PendingAlarms(uint64_t now_us) const;
+
+        // The alarms were delivered
+        void AlarmsSent(uint8_t alarms);
+
+        // True if the digest for the report minute at_min is due, offset_sec later (spreads a fleet with the same minute)
+        bool Due(int32_t at_min, uint32_t offset_sec, uint64_t now_us, int64_t wall_s) const;
+
+        // The digest was delivered: start a new period
+        void Sent(uint64_t now_us, int64_t wall_s);
+
+        // A session for the digest or alarms did not deliver them: retry after Config::DIGEST_RETRY_SEC
+        void Failed(uint64_t now_us);
+
+        const DigestState &State() const { return *state_; }
+
+        // True if wall_s is a time set by SNTP rather than the count since boot
+        static bool ClockSet(int64_t wall_s) { return wall_s >= MIN_WALL_S; }
+
+    private:
+        static constexpr const char *LOG_TAG = "DIGEST";
+        static constexpr int64_t MIN_WALL_S = 1700000000;            // 2023-11-14, before any build of this firmware
+        static constexpr uint64_t FALLBACK_PERIOD_US = 86400000000ULL; // Digest interval while the clock is not set
+
+        DigestState *state_; ///< RTC-backed state
+
+        // Clear the counters for a period starting at now_us
+        void startPeriod(uint64_t now_us, int64_t wall_s);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include "flap_damper.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Processor
+{
+    FlapDamper::FlapDamper(FlapState *state)
+        : state_(state)
+    {
+    }
+
+    bool FlapDamper::Record(DistanceData &data, uint64_t now_us)
+    {
+        if (now_us > state_->updated_us)
+        {
+            const float elapsed_s = static_cast<float>(now_us - state_->updated_us) / 1e6f;
+            state_->penalty *= exp2f(-elapsed_s / static_cast<float>(Config::FLAP_HALF_LIFE_SEC));
+            state_->updated_us = now_us;
+        }
+
+        if (state_->suppressed && state_->penalty < Config::FLAP_REUSE_PENALTY)
+        {
+            state_->suppressed = false;
+            state_->report_pending = true;
+            ESP_LOGI(LOG_TAG, "Mailbox stable again, %lu transitions were suppressed",
+                     static_cast<unsigned long>(state_->suppressed_events));
+        }
+
+        if (!data.mail_detected && !data.mail_collected)
+            return false;
+
+        state_->penalty = std::min(state_->penalty + Config::FLAP_PENALTY, Config::FLAP_MAX_PENALTY);
+        if (!state_->suppressed && state_->penalty >= Config::FLAP_SUPPRESS_PENALTY)
+        {
+            state_->suppressed = true;
+            state_->report_pending = true;
+            state_->suppressed_events = 0;
+            state_->suppressions++;
+            ESP_LOGW(LOG_TAG, "Mailbox state flapping (penalty %.0f), suppressing events", state_->penalty);
+        }
+        if (!state_->suppressed)
+            return false;
+
+        data.mail_detected = false;
+        data.mail_collected = false;
+        state_->suppressed_events++;
+        state_->suppressed_total++;
+        return true;
+    }
+
+    void FlapDamper::Reported()
+    {
+        state_->report_pending = false;
+        if (!state_->suppressed)
+            state_->suppressed_events = 0;
+    }
+}
\ No newline at end of file
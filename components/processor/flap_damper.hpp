@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+
+#include "esp_log.h"
+
+#include "processor.hpp"
+#include "config.hpp"
+
+namespace Processor
+{
+    // Flap damping state kept in RTC memory between deep sleep cycles
+    struct FlapState
+    {
+        float penalty;              ///< Transition penalties, decayed to updated_us
+        uint64_t updated_us;        ///< Virtual time the penalty was last decayed to
+        bool suppressed;            ///< Events are held back
+        bool report_pending;        ///< Suppression started or ended, and no status told the backend yet
+        uint32_t suppressed_events; ///< Transitions held back in the current (or last unreported) suppression
+        uint32_t suppressed_total;  ///< Transitions held back since power-up
+        uint32_t suppressions;      ///< Suppressions started since power-up
+    };
+
+    /**
+     * Flap damping of mailbox events, in the manner of BGP route flap damping
+     *
+     * A curled envelope right at the trigger threshold makes the processor
+     * go EMPTY -> HAS_MAIL -> EMPTIED -> EMPTY over and over, and every drop
+     * and collection opens the radio. Each transition adds
+     * Config::FLAP_PENALTY to a penalty that halves every
+     * Config::FLAP_HALF_LIFE_SEC of virtual time. Above
+     * Config::FLAP_SUPPRESS_PENALTY the events are suppressed: they are
+     * counted, but no longer reported. Once the penalty decayed below
+     * Config::FLAP_REUSE_PENALTY they are reported again. The penalty is
+     * capped at Config::FLAP_MAX_PENALTY, which bounds how long suppression
+     * outlasts the flapping.
+     *
+     * The start and the end of a suppression are reported once each, in the
+     * status: "unstable" while suppressed, and the suppressed count with the
+     * settled mailbox state afterwards. The processor state machine itself
+     * is left alone, so the state reported afterwards is the real one.
+     */
+    class FlapDamper
+    {
+    public:
+        // Damper over the RTC state (cleared after power loss)
+        explicit FlapDamper(FlapState *state);
+
+        /**
+         * Apply one processed wake
+         *
+         * Decays the penalty to now_us, adds the penalty of a drop or
+         * collection in data and updates the suppression. A transition that is
+         * held back is cleared from data (mail_detected/mail_collected), so
+         * nothing downstream reports it. Returns true if one was held back.
+         */
+        bool Record(DistanceData &data, uint64_t now_us);
+
+        // True while events are suppressed
+        bool Suppressed() const { return state_->suppressed; }
+
+        // True if a status should tell the backend that suppression started or ended
+        bool ReportDue() const { return state_->report_pending; }
+
+        // A status carrying the suppression was delivered
+        void Reported();
+
+        const FlapState &State() const { return *state_; }
+
+    private:
+        static constexpr const char *LOG_TAG = "FLAP";
+
+        FlapState *state_; ///< RTC-backed state
+    };
+}
\ No newline at end of file
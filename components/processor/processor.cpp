@@ -2,26 +2,29 @@
 
 namespace Processor
 {
-    Processor::Processor()
+    Processor::Processor(const Config::RuntimeConfig &config)
         : baseline_cm_(Config::BASELINE_CM),
-          trigger_thresh_cm_(Config::BASELINE_CM - Config::TRIGGER_DELTA_CM),
-          full_thresh_cm_(Config::BASELINE_CM - (2.0f * Config::TRIGGER_DELTA_CM)),
-          empty_thresh_cm_(Config::BASELINE_CM - (Config::TRIGGER_DELTA_CM * 0.5f))
+          trigger_thresh_cm_(Config::BASELINE_CM - config.trigger_delta_cm),
+          full_thresh_cm_(Config::BASELINE_CM - (2.0f * config.trigger_delta_cm)),
+          empty_thresh_cm_(Config::BASELINE_CM - (config.trigger_delta_cm * 0.5f)),
+          hold_ms_(config.hold_ms)
     {
         ctx_ = {};
         ctx_.current_state = MailboxState::EMPTY;
         ctx_.filtered_cm = -1.0f;
+        ctx_.success_rate = 1.0f; // No failures seen yet; a 0 before the first update would read as a dead sensor
 
         ESP_LOGI(LOG_TAG, "Processor initialized. baseline=%.2f cm, trigger=%.2f cm, full=%.2f cm, empty=%.2f cm",
                  baseline_cm_, trigger_thresh_cm_, full_thresh_cm_, empty_thresh_cm_);
     }
 
-    Processor::Processor(const StateContext &ctx)
+    Processor::Processor(const StateContext &ctx, const Config::RuntimeConfig &config)
         : ctx_(ctx),
           baseline_cm_(Config::BASELINE_CM),
-          trigger_thresh_cm_(Config::BASELINE_CM - Config::TRIGGER_DELTA_CM),
-          full_thresh_cm_(Config::BASELINE_CM - (2.0f * Config::TRIGGER_DELTA_CM)),
-          empty_thresh_cm_(Config::BASELINE_CM - (Config::TRIGGER_DELTA_CM * 0.5f))
+          trigger_thresh_cm_(Config::BASELINE_CM - config.trigger_delta_cm),
+          full_thresh_cm_(Config::BASELINE_CM - (2.0f * config.trigger_delta_cm)),
+          empty_thresh_cm_(Config::BASELINE_CM - (config.trigger_delta_cm * 0.5f)),
+          hold_ms_(config.hold_ms)
     {
         ESP_LOGI(LOG_TAG, "Processor initialized. baseline=%.2f cm, trigger=%.2f cm, full=%.2f cm, empty=%.2f cm",
                  baseline_cm_, trigger_thresh_cm_, full_thresh_cm_, empty_thresh_cm_);
@@ -34,12 +37,27 @@ namespace Processor
         data.mail_detected = false;
         data.mail_collected = false;
         data.state = ctx_.current_state;
+        data.obstruction_changed = false;
 
         // Track success rate
         ctx_.total_count++;
         if (raw_distance_cm > 0)
             ctx_.ok_count++;
 
+        // Track runs of invalid readings; while obstructed every failed probe doubles the sleep
+        if (raw_distance_cm > 0)
+        {
+            ctx_.valid_streak++;
+            ctx_.invalid_streak = 0;
+        }
+        else
+        {
+            ctx_.invalid_streak++;
+            ctx_.valid_streak = 0;
+        }
+        if (ctx_.current_state == MailboxState::OBSTRUCTED)
+            ctx_.probe_backoff = raw_distance_cm > 0 ? 0 : std::min<uint8_t>(ctx_.probe_backoff + 1, MAX_PROBE_BACKOFF);
+
         // Filter the measurement
         addToFilter(raw_distance_cm);
         data.filtered_cm = ctx_.filtered_cm;
@@ -59,6 +77,14 @@ namespace Processor
         return data;
     }
 
+    uint64_t SleepUs(const StateContext &ctx, uint64_t sleep_us)
+    {
+        if (ctx.current_state != MailboxState::OBSTRUCTED)
+            return sleep_us;
+        const uint64_t cap_us = std::max<uint64_t>(sleep_us, Config::OBSTRUCTED_MAX_SLEEP_SEC * 1000000ULL);
+        return std::min(sleep_us << ctx.probe_backoff, cap_us);
+    }
+
     StateContext Processor::GetContext() const { return ctx_; }
     float Processor::GetBaseline() const { return baseline_cm_; }
     float Processor::GetThreshold() const { return trigger_thresh_cm_; }
@@ -80,7 +106,9 @@ namespace Processor
     {
         float tmp[Config::FILTER_WINDOW];
         size_t n = 0;
-        for (size_t i = 0; i < ctx_.w_count; ++i)
+        // w_count comes from RTC memory; never read or sort past the window
+        const size_t count = std::min<size_t>(ctx_.w_count, Config::FILTER_WINDOW);
+        for (size_t i = 0; i < count; ++i)
         {
             const float v = ctx_.window[i];
             if (v > 0)
@@ -89,7 +117,15 @@ namespace Processor
         if (n == 0)
             return -1.0f;
 
-        std::sort(tmp, tmp + n);
+        // Insertion sort over a few values; std::sort's introsort path for > 16 elements trips -Warray-bounds
+        for (size_t i = 1; i < n; ++i)
+        {
+            const float v = tmp[i];
+            size_t j = i;
+            for (; j > 0 && tmp[j - 1] > v; --j)
+                tmp[j] = tmp[j - 1];
+            tmp[j] = v;
+        }
         return (n & 1) ? tmp[n / 2] : 0.5f * (tmp[n / 2 - 1] + tmp[n / 2]);
     }
 
@@ -110,6 +146,21 @@ namespace Processor
 
     void Processor::updateStateMachine(DistanceData &data, const uint64_t now_us)
     {
+        // A sensor that sees nothing for long is blocked or blinded, not waiting for mail
+        if (ctx_.current_state != MailboxState::OBSTRUCTED && ctx_.invalid_streak >= Config::OBSTRUCTED_AFTER_READINGS)
+        {
+            ctx_.resume_state = ctx_.current_state == MailboxState::EMPTIED ? MailboxState::EMPTY : ctx_.current_state;
+            ctx_.current_state = MailboxState::OBSTRUCTED;
+            ctx_.state_change_us = now_us;
+            ctx_.occluding = false;
+            ctx_.probe_backoff = 1;
+            data.obstruction_changed = true;
+            data.state = ctx_.current_state;
+            ESP_LOGW(LOG_TAG, "No valid reading in %lu measurements, state: OBSTRUCTED",
+                     static_cast<unsigned long>(ctx_.invalid_streak));
+            return;
+        }
+
         // Invalid reading - maintain current state
         if (ctx_.filtered_cm <= 0)
             return;
@@ -130,7 +181,7 @@ namespace Processor
                 }
 
                 const uint32_t held_ms = static_cast<uint32_t>((now_us - ctx_.occlusion_start_us) / 1000ULL);
-                if (held_ms >= Config::HOLD_MS)
+                if (held_ms >= hold_ms_)
                 {
                     // NEW MAIL DETECTED!
                     data.mail_detected = true;
@@ -170,7 +221,7 @@ namespace Processor
                 }
 
                 const uint32_t held_ms = static_cast<uint32_t>((now_us - ctx_.occlusion_start_us) / 1000ULL);
-                if (held_ms >= Config::HOLD_MS)
+                if (held_ms >= hold_ms_)
                 {
                     // MAIL COLLECTED!
                     data.mail_collected = true;
@@ -202,7 +253,7 @@ namespace Processor
                 }
 
                 const uint32_t held_ms = static_cast<uint32_t>((now_us - ctx_.occlusion_start_us) / 1000ULL);
-                if (held_ms >= Config::HOLD_MS)
+                if (held_ms >= hold_ms_)
                 {
                     // MAIL COLLECTED!
                     data.mail_collected = true;
@@ -225,7 +276,7 @@ namespace Processor
 
         case MailboxState::EMPTIED:
             // Wait briefly in EMPTIED state, then transition to EMPTY
-            if (time_in_state_ms >= Config::HOLD_MS)
+            if (time_in_state_ms >= hold_ms_)
             {
                 ctx_.current_state = MailboxState::EMPTY;
                 ctx_.state_change_us = now_us;
@@ -233,6 +284,26 @@ namespace Processor
                 ESP_LOGI(LOG_TAG, "Ready for new mail, state: EMPTIED->EMPTY");
             }
             break;
+
+        case MailboxState::OBSTRUCTED:
+            // The sensor sees again: take the state from the distance, the mailbox may have changed meanwhile
+            if (ctx_.valid_streak >= Config::OBSTRUCTED_CLEAR_READINGS)
+            {
+                if (ctx_.filtered_cm < full_thresh_cm_)
+                    ctx_.current_state = MailboxState::FULL;
+                else if (ctx_.filtered_cm < trigger_thresh_cm_)
+                    ctx_.current_state = MailboxState::HAS_MAIL;
+                else
+                    ctx_.current_state = MailboxState::EMPTY;
+                ctx_.state_change_us = now_us;
+                ctx_.refractory_until_us = now_us + static_cast<uint64_t>(Config::REFRACTORY_MS) * 1000ULL;
+                ctx_.probe_backoff = 0;
+                data.obstruction_changed = true;
+
+                ESP_LOGI(LOG_TAG, "Sensor clear again at %.2f cm, state: OBSTRUCTED->%d", ctx_.filtered_cm,
+                         static_cast<int>(ctx_.current_state));
+            }
+            break;
         }
 
         data.state = ctx_.current_state;
@@ -7,28 +7,31 @@
 #include "esp_timer.h"
 #include "esp_log.h"
 
-#include "../config/config.hpp"
+#include "config.hpp"
+#include "runtime_config.hpp"
 
 namespace Processor
 {
     enum class MailboxState
     {
-        EMPTY,    ///< Mailbox is empty (distance near baseline)
-        HAS_MAIL, ///< Mailbox contains mail (distance below threshold, stable)
-        FULL,     ///< Mailbox is full (distance significantly below threshold)
-        EMPTIED   ///< Mailbox was just emptied (transitional state)
+        EMPTY,     ///< Mailbox is empty (distance near baseline)
+        HAS_MAIL,  ///< Mailbox contains mail (distance below threshold, stable)
+        FULL,      ///< Mailbox is full (distance significantly below threshold)
+        EMPTIED,   ///< Mailbox was just emptied (transitional state)
+        OBSTRUCTED ///< Sensor sees nothing but invalid readings (blocked or blinded); probed with backoff
     };
 
     struct DistanceData
     {
-        float raw_cm;         ///< Raw distance measurement from sensor in centimeters (negative if invalid/timeout)
-        float filtered_cm;    ///< Median-filtered distance in centimeters (negative if insufficient valid samples)
-        float success_rate;   ///< Current measurement success rate (0.0 to 1.0, where 1.0 = 100% success)
-        bool mail_detected;   ///< True if a NEW mail drop event was detected during this processing cycle
-        bool mail_collected;  ///< True if mail collection (emptying) was detected during this processing cycle
-        float delta_cm;       ///< Distance change from baseline that triggered detection (centimeters)
-        uint32_t duration_ms; ///< Duration the occlusion was held before triggering event (milliseconds)
-        MailboxState state;   ///< Current mailbox state
+        float raw_cm;             ///< Raw distance measurement from sensor in centimeters (negative if invalid/timeout)
+        float filtered_cm;        ///< Median-filtered distance in centimeters (negative if insufficient valid samples)
+        float success_rate;       ///< Current measurement success rate (0.0 to 1.0, where 1.0 = 100% success)
+        bool mail_detected;       ///< True if a NEW mail drop event was detected during this processing cycle
+        bool mail_collected;      ///< True if mail collection (emptying) was detected during this processing cycle
+        float delta_cm;           ///< Distance change from baseline that triggered detection (centimeters)
+        uint32_t duration_ms;     ///< Duration the occlusion was held before triggering event (milliseconds)
+        MailboxState state;       ///< Current mailbox state
+        bool obstruction_changed; ///< True if the sensor became obstructed or recovered during this processing cycle
     };
 
     struct StateContext
@@ -49,16 +52,25 @@ namespace Processor
         uint64_t occlusion_start_us;
         uint64_t state_change_us;
         uint64_t refractory_until_us;
+
+        uint32_t invalid_streak;   ///< Consecutive invalid raw readings
+        uint32_t valid_streak;     ///< Consecutive valid raw readings
+        MailboxState resume_state; ///< Stable state before the obstruction (what a checkpoint stores meanwhile)
+        uint8_t probe_backoff;     ///< Sleep is doubled this many times while obstructed
     };
 
+    // Sleep until the next measurement: sleep_us, doubled per failed probe while obstructed (up to Config::OBSTRUCTED_MAX_SLEEP_SEC)
+    uint64_t SleepUs(const StateContext &ctx, uint64_t sleep_us);
+
     class Processor
     {
     public:
         // Construct a new Processor (First Boot)
-        Processor();
+        explicit Processor(const Config::RuntimeConfig &config = Config::DEFAULT_RUNTIME_CONFIG);
 
-        // Restore constructor (Wake from sleep)
-        explicit Processor(const StateContext &ctx);
+        // Restore constructor (Wake from sleep); thresholds follow the configuration applied at this wake
+        explicit Processor(const StateContext &ctx,
+                           const Config::RuntimeConfig &config = Config::DEFAULT_RUNTIME_CONFIG);
 
         /**
          * Process a raw distance measurement through the complete pipeline
@@ -92,6 +104,7 @@ namespace Processor
 
     private:
         static constexpr const char *LOG_TAG = "PROCESSOR";
+        static constexpr uint8_t MAX_PROBE_BACKOFF = 16; ///< Doublings beyond any sensible sleep cap
 
         StateContext ctx_;
 
@@ -100,6 +113,7 @@ namespace Processor
         const float trigger_thresh_cm_; ///< Computed trigger threshold (baseline - delta) in centimeters
         const float full_thresh_cm_;    ///< Threshold for considering mailbox full (baseline - 2*delta) in centimeters
         const float empty_thresh_cm_;   ///< Threshold for considering mailbox empty (baseline - delta/2) in centimeters
+        const uint32_t hold_ms_;        ///< Occlusion hold time before an event triggers (milliseconds)
 
         // Add a measurement to the median filter window
         void addToFilter(const float &distance_cm);
@@ -125,6 +139,9 @@ namespace Processor
          * - HAS_MAIL -> FULL: When distance drops significantly further
          * - HAS_MAIL/FULL -> EMPTIED: When distance returns near baseline
          * - EMPTIED -> EMPTY: After brief hold period
+         * - any -> OBSTRUCTED: After Config::OBSTRUCTED_AFTER_READINGS invalid readings in a row
+         * - OBSTRUCTED -> EMPTY/HAS_MAIL/FULL: After Config::OBSTRUCTED_CLEAR_READINGS valid
+         *   readings in a row, as the distance says (no drop or collection event)
          */
         void updateStateMachine(DistanceData &data, const uint64_t now_us);
     };
@@ -0,0 +1,114 @@
+#include "battery_monitor.hpp"
+
+#include "config.hpp"
+#include "alloc_tracker.hpp"
+
+#include "esp_adc/adc_oneshot.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "esp_log.h"
+
+namespace Hardware
+{
+    namespace Battery
+    {
+        BatteryMonitor::BatteryMonitor(BatteryState *state)
+            : state_(state)
+        {
+        }
+
+        esp_err_t BatteryMonitor::Update(bool force)
+        {
+            state_->wakes_since_sample++;
+            if (!force && state_->valid && state_->wakes_since_sample < Config::BATTERY_SAMPLE_EVERY_N_WAKES)
+                return ESP_OK;
+
+            float battery_mv = 0.0f;
+            const esp_err_t err = sample(&battery_mv);
+            if (err != ESP_OK)
+            {
+                ESP_LOGW(LOG_TAG, "Battery sample failed: %s", esp_err_to_name(err));
+                return err;
+            }
+            state_->wakes_since_sample = 0;
+
+            // The first sample seeds the filter
+            state_->filtered_mv = state_->valid
+                                      ? state_->filtered_mv + Config::BATTERY_FILTER_ALPHA * (battery_mv - state_->filtered_mv)
+                                      : battery_mv;
+            state_->valid = true;
+
+            const PowerLevel level = NextLevel(state_->level, state_->filtered_mv);
+            if (level != state_->level)
+                ESP_LOGW(LOG_TAG, "Power level %s -> %s at %.0f mV", LevelToString(state_->level),
+                         LevelToString(level), state_->filtered_mv);
+            state_->level = level;
+
+            ESP_LOGI(LOG_TAG, "Battery %.0f mV (sample %.0f mV, %u%%)", state_->filtered_mv, battery_mv,
+                     Percent());
+            return ESP_OK;
+        }
+
+        uint32_t BatteryMonitor::Millivolts() const
+        {
+            return state_->valid ? static_cast<uint32_t>(state_->filtered_mv + 0.5f) : 0;
+        }
+
+        uint8_t BatteryMonitor::Percent() const
+        {
+            return state_->valid ? EstimatePercent(state_->filtered_mv) : 0;
+        }
+
+        esp_err_t BatteryMonitor::sample(float *battery_mv)
+        {
+            // The ADC driver allocates its unit and calibration handles
+            Diagnostics::AllocTracker::Exempt exempt;
+
+            adc_oneshot_unit_handle_t unit = nullptr;
+            const adc_oneshot_unit_init_cfg_t unit_cfg = {
+                .unit_id = Config::BATTERY_ADC_UNIT,
+                .ulp_mode = ADC_ULP_MODE_DISABLE};
+            esp_err_t err = adc_oneshot_new_unit(&unit_cfg, &unit);
+            if (err != ESP_OK)
+                return err;
+
+            const adc_oneshot_chan_cfg_t chan_cfg = {
+                .atten = ADC_ATTEN_DB_12,
+                .bitwidth = ADC_BITWIDTH_DEFAULT};
+            err = adc_oneshot_config_channel(unit, Config::BATTERY_ADC_CHANNEL, &chan_cfg);
+
+            // Uncalibrated readings are off by up to ~100 mV, too much for the thresholds
+            adc_cali_handle_t cali = nullptr;
+            if (err == ESP_OK)
+            {
+                const adc_cali_curve_fitting_config_t cali_cfg = {
+                    .unit_id = Config::BATTERY_ADC_UNIT,
+                    .chan = Config::BATTERY_ADC_CHANNEL,
+                    .atten = ADC_ATTEN_DB_12,
+                    .bitwidth = ADC_BITWIDTH_DEFAULT};
+                err = adc_cali_create_scheme_curve_fitting(&cali_cfg, &cali);
+            }
+
+            int sum_mv = 0;
+            for (uint32_t i = 0; err == ESP_OK && i < Config::BATTERY_ADC_READS; ++i)
+            {
+                int raw = 0;
+                int pin_mv = 0;
+                err = adc_oneshot_read(unit, Config::BATTERY_ADC_CHANNEL, &raw);
+                if (err == ESP_OK)
+                    err = adc_cali_raw_to_voltage(cali, raw, &pin_mv);
+                sum_mv += pin_mv;
+            }
+
+            if (cali)
+                adc_cali_delete_scheme_curve_fitting(cali);
+            adc_oneshot_del_unit(unit);
+
+            if (err != ESP_OK)
+                return err;
+
+            *battery_mv = static_cast<float>(sum_mv) / Config::BATTERY_ADC_READS * Config::BATTERY_DIVIDER_RATIO;
+            return ESP_OK;
+        }
+    }
+}
\ No newline at end of file
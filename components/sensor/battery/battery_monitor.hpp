@@ -0,0 +1,51 @@
+#pragma once
+
+#include "battery_policy.hpp"
+
+#include "esp_err.h"
+
+#include <cstdint>
+
+namespace Hardware
+{
+    namespace Battery
+    {
+        /**
+         * Battery voltage through a resistor divider on an ADC pin
+         *
+         * The ADC is only powered up on the wakes that sample, once every
+         * BATTERY_SAMPLE_EVERY_N_WAKES. Each sample averages a few calibrated
+         * conversions and is blended into the smoothed voltage kept in RTC
+         * memory, which also decides the power level.
+         */
+        class BatteryMonitor
+        {
+        public:
+            // Monitor over the RTC state (zeroed after power loss)
+            explicit BatteryMonitor(BatteryState *state);
+
+            // Count this wake and sample if due (force: sample now, e.g. on a fresh boot)
+            esp_err_t Update(bool force = false);
+
+            // True once a sample has been taken since the last power loss
+            bool HasReading() const { return state_->valid; }
+
+            // Smoothed battery voltage (millivolts, 0 without a reading)
+            uint32_t Millivolts() const;
+
+            // Estimated remaining capacity (%, 0 without a reading)
+            uint8_t Percent() const;
+
+            // Current power level (NORMAL without a reading)
+            PowerLevel Level() const { return state_->level; }
+
+        private:
+            static constexpr const char *LOG_TAG = "BATTERY";
+
+            BatteryState *state_; ///< RTC-backed filter and level
+
+            // Read the divider output with calibration and return the battery voltage
+            esp_err_t sample(float *battery_mv);
+        };
+    }
+}
\ No newline at end of file
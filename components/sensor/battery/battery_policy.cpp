@@ -0,0 +1,110 @@
+#include "battery_policy.hpp"
+
+namespace Hardware
+{
+    namespace Battery
+    {
+        namespace
+        {
+            struct CurvePoint
+            {
+                float millivolts;
+                float percent;
+            };
+
+            // Typical open-circuit discharge curve of a Li-ion/LiPo cell at room temperature
+            constexpr CurvePoint DISCHARGE_CURVE[] = {
+                {4200.0f, 100.0f},
+                {4100.0f, 90.0f},
+                {4000.0f, 78.0f},
+                {3900.0f, 65.0f},
+                {3800.0f, 52.0f},
+                {3700.0f, 38.0f},
+                {3600.0f, 20.0f},
+                {3500.0f, 10.0f},
+                {3400.0f, 5.0f},
+                {3300.0f, 2.0f},
+                {3200.0f, 0.0f}};
+        }
+
+        uint8_t EstimatePercent(float millivolts)
+        {
+            constexpr size_t points = sizeof(DISCHARGE_CURVE) / sizeof(DISCHARGE_CURVE[0]);
+            if (millivolts >= DISCHARGE_CURVE[0].millivolts)
+                return 100;
+
+            // Linear interpolation between the two surrounding points
+            for (size_t i = 1; i < points; ++i)
+            {
+                const CurvePoint &hi = DISCHARGE_CURVE[i - 1];
+                const CurvePoint &lo = DISCHARGE_CURVE[i];
+                if (millivolts >= lo.millivolts)
+                {
+                    const float t = (millivolts - lo.millivolts) / (hi.millivolts - lo.millivolts);
+                    return static_cast<uint8_t>(lo.percent + t * (hi.percent - lo.percent) + 0.5f);
+                }
+            }
+            return 0;
+        }
+
+        PowerLevel NextLevel(PowerLevel current, float millivolts)
+        {
+            const float low = static_cast<float>(Config::BATTERY_LOW_MV);
+            const float critical = static_cast<float>(Config::BATTERY_CRITICAL_MV);
+            const float hysteresis = static_cast<float>(Config::BATTERY_HYSTERESIS_MV);
+
+            if (millivolts < critical)
+                return PowerLevel::CRITICAL;
+            if (current == PowerLevel::CRITICAL && millivolts < critical + hysteresis)
+                return PowerLevel::CRITICAL;
+
+            if (millivolts < low)
+                return PowerLevel::LOW;
+            if (current != PowerLevel::NORMAL && millivolts < low + hysteresis)
+                return PowerLevel::LOW;
+
+            return PowerLevel::NORMAL;
+        }
+
+        uint64_t SleepUs(PowerLevel level, const Config::RuntimeConfig &config)
+        {
+            switch (level)
+            {
+            case PowerLevel::LOW:
+                return config.deep_sleep_us * Config::BATTERY_LOW_SLEEP_FACTOR;
+            case PowerLevel::CRITICAL:
+                return config.deep_sleep_us * Config::BATTERY_CRITICAL_SLEEP_FACTOR;
+            default:
+                return config.deep_sleep_us;
+            }
+        }
+
+        uint64_t HeartbeatIntervalSec(PowerLevel level, const Config::RuntimeConfig &config)
+        {
+            switch (level)
+            {
+            case PowerLevel::LOW:
+                return config.heartbeat_interval_sec * Config::BATTERY_LOW_HEARTBEAT_FACTOR;
+            case PowerLevel::CRITICAL:
+                return config.heartbeat_interval_sec * Config::BATTERY_CRITICAL_HEARTBEAT_FACTOR;
+            default:
+                return config.heartbeat_interval_sec;
+            }
+        }
+
+        const char *LevelToString(PowerLevel level)
+        {
+            switch (level)
+            {
+            case PowerLevel::NORMAL:
+                return "normal";
+            case PowerLevel::LOW:
+                return "low";
+            case PowerLevel::CRITICAL:
+                return "critical";
+            default:
+                return "unknown";
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+#include "runtime_config.hpp"
+
+namespace Hardware
+{
+    namespace Battery
+    {
+        enum class PowerLevel : uint8_t
+        {
+            NORMAL,  ///< Configured sleep and heartbeat intervals
+            LOW,     ///< Below BATTERY_LOW_MV: longer intervals
+            CRITICAL ///< Below BATTERY_CRITICAL_MV: longest intervals, no firmware downloads
+        };
+
+        // Battery state that must survive deep sleep (lives in RtcStore)
+        struct BatteryState
+        {
+            bool valid;                  ///< False until the first sample
+            float filtered_mv;           ///< Smoothed battery voltage (millivolts)
+            uint32_t wakes_since_sample; ///< Wakes since the ADC was last read
+            PowerLevel level;            ///< Level the current sleep was scheduled with
+        };
+
+        // Remaining capacity (0-100 %) of a single Li-ion/LiPo cell from its resting voltage
+        uint8_t EstimatePercent(float millivolts);
+
+        /**
+         * Power level for a smoothed battery voltage
+         *
+         * Dropping a level happens as soon as the voltage is below its
+         * threshold; coming back needs BATTERY_HYSTERESIS_MV more, so a cell
+         * that recovers a little while resting does not flip between levels.
+         */
+        PowerLevel NextLevel(PowerLevel current, float millivolts);
+
+        // Deep sleep duration at a power level (µs)
+        uint64_t SleepUs(PowerLevel level, const Config::RuntimeConfig &config);
+
+        // Heartbeat interval at a power level (s)
+        uint64_t HeartbeatIntervalSec(PowerLevel level, const Config::RuntimeConfig &config);
+
+        // "normal", "low" or "critical"
+        const char *LevelToString(PowerLevel level);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#include "charge_model.hpp"
+
+#include "config.hpp"
+
+#include <algorithm>
+
+namespace Hardware
+{
+    namespace Power
+    {
+        const char *ModeToString(PmMode mode)
+        {
+            switch (mode)
+            {
+            case PmMode::OFF:
+                return "off";
+            case PmMode::DFS:
+                return "dfs";
+            case PmMode::LIGHT_SLEEP:
+                return "light_sleep";
+            default:
+                return "unknown";
+            }
+        }
+
+        float WakeChargeUc(const WakeTiming &timing, PmMode mode)
+        {
+            float idle_ma;
+            switch (mode)
+            {
+            case PmMode::DFS:
+                idle_ma = Config::CHARGE_IDLE_XTAL_MA;
+                break;
+            case PmMode::LIGHT_SLEEP:
+                idle_ma = Config::CHARGE_LIGHT_SLEEP_MA;
+                break;
+            default:
+                idle_ma = Config::CHARGE_IDLE_MAX_MA;
+                break;
+            }
+
+            // mA x ms = µC
+            const uint32_t wait_us = std::min(timing.wait_us, timing.awake_us);
+            const float busy_ms = (timing.awake_us - wait_us) / 1000.0f;
+            return busy_ms * Config::CHARGE_ACTIVE_MA + wait_us / 1000.0f * idle_ma +
+                   timing.radio_us / 1000.0f * Config::CHARGE_RADIO_MA;
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Hardware
+{
+    namespace Power
+    {
+        // Power management configurations the firmware can run with
+        enum class PmMode : uint8_t
+        {
+            OFF,         ///< Full clock for the whole wake (esp_pm not configured)
+            DFS,         ///< CPU at the XTAL clock while no lock holds it up
+            LIGHT_SLEEP, ///< DFS, and automatic light sleep while idle
+            COUNT
+        };
+
+        // Where the time of one wake went, from the firmware's own timers
+        struct WakeTiming
+        {
+            uint32_t awake_us; ///< From wake to deep sleep
+            uint32_t wait_us;  ///< In waits, with the wake lock released: the idle task runs
+            uint32_t radio_us; ///< From Wi-Fi start to stop
+        };
+
+        // "off", "dfs" or "light_sleep"
+        const char *ModeToString(PmMode mode);
+
+        /**
+         * Estimated charge of a wake under a power management mode (µC)
+         *
+         * The time outside waits runs at the full clock in every mode; waits
+         * cost the idle current of the mode, and the radio adds its average
+         * for as long as it is on. Only the waits differ between modes, so
+         * one measured wake gives the charge of all three. The Wi-Fi driver
+         * holds its own locks while it is busy, so the light sleep figure is
+         * a lower bound.
+         */
+        float WakeChargeUc(const WakeTiming &timing, PmMode mode);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+#include "power_manager.hpp"
+
+#include "config.hpp"
+#include "alloc_tracker.hpp"
+
+namespace Hardware
+{
+    namespace Power
+    {
+        PmMode ConfiguredMode()
+        {
+            if (!Config::PM_DFS_ENABLED)
+                return PmMode::OFF;
+            return Config::PM_LIGHT_SLEEP_ENABLED ? PmMode::LIGHT_SLEEP : PmMode::DFS;
+        }
+
+        esp_err_t Configure(PmMode mode)
+        {
+            if (mode == PmMode::OFF)
+                return ESP_OK;
+
+            esp_pm_config_t config = {};
+            config.max_freq_mhz = Config::PM_MAX_CPU_FREQ_MHZ;
+            config.min_freq_mhz = Config::PM_MIN_CPU_FREQ_MHZ;
+            config.light_sleep_enable = mode == PmMode::LIGHT_SLEEP;
+
+            return esp_pm_configure(&config);
+        }
+
+        PmLock::PmLock(esp_pm_lock_type_t type, const char *name) : handle_(nullptr)
+        {
+            // Driver allocation; without CONFIG_PM_ENABLE the handle stays NULL
+            Diagnostics::AllocTracker::Exempt exempt;
+            if (esp_pm_lock_create(type, 0, name, &handle_) != ESP_OK)
+                handle_ = nullptr;
+        }
+
+        PmLock::~PmLock()
+        {
+            if (handle_)
+            {
+                Diagnostics::AllocTracker::Exempt exempt;
+                esp_pm_lock_delete(handle_);
+            }
+        }
+
+        void PmLock::Acquire()
+        {
+            if (handle_)
+                esp_pm_lock_acquire(handle_);
+        }
+
+        void PmLock::Release()
+        {
+            if (handle_)
+                esp_pm_lock_release(handle_);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "charge_model.hpp"
+
+#include "esp_err.h"
+#include "esp_pm.h"
+
+#include <cstdint>
+
+namespace Hardware
+{
+    namespace Power
+    {
+        // Mode set by Config::PM_DFS_ENABLED and Config::PM_LIGHT_SLEEP_ENABLED
+        PmMode ConfiguredMode();
+
+        /**
+         * Configure esp_pm for a mode
+         *
+         * Needed on every wake: deep sleep resets it. DFS runs the CPU between
+         * PM_MIN_CPU_FREQ_MHZ and PM_MAX_CPU_FREQ_MHZ. Returns
+         * ESP_ERR_NOT_SUPPORTED without CONFIG_PM_ENABLE; the firmware then
+         * runs as in PmMode::OFF.
+         */
+        esp_err_t Configure(PmMode mode);
+
+        /**
+         * esp_pm lock, a no-op while power management is not enabled
+         *
+         * A ESP_PM_CPU_FREQ_MAX lock keeps the CPU at the full clock and also
+         * holds off light sleep. Creating the lock allocates in esp_pm (exempt
+         * from the allocation check); acquiring and releasing it does not.
+         */
+        class PmLock
+        {
+        public:
+            PmLock(esp_pm_lock_type_t type, const char *name);
+            ~PmLock();
+
+            PmLock(const PmLock &) = delete;
+            PmLock &operator=(const PmLock &) = delete;
+
+            void Acquire();
+            void Release();
+
+            // Holds the lock for a scope
+            class Hold
+            {
+            public:
+                explicit Hold(PmLock &lock) : lock_(lock) { lock_.Acquire(); }
+                ~Hold() { lock_.Release(); }
+
+            private:
+                PmLock &lock_;
+            };
+
+            // Lets go of a held lock for a scope (a wait), and takes it back after
+            class Released
+            {
+            public:
+                explicit Released(PmLock &lock) : lock_(lock) { lock_.Release(); }
+                ~Released() { lock_.Acquire(); }
+
+            private:
+                PmLock &lock_;
+            };
+
+        private:
+            esp_pm_lock_handle_t handle_; ///< NULL if power management is not enabled
+        };
+    }
+}
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include "echo_jitter.hpp"
+
+#include "config.hpp"
+
+#include "driver/gptimer.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Hardware
+{
+    namespace Ultrasonic
+    {
+        namespace
+        {
+            constexpr const char *LOG_TAG = "ECHO_JITTER";
+            constexpr uint32_t LOAD_PERIOD_US = 97;    // Interrupt load period, not a divisor of the polling loop
+            constexpr uint32_t PULSE_SPACING_MS = 60;  // HC-SR04 minimum cycle: the previous echo must have died out
+            constexpr float MM_PER_US = 0.343f / 2.0f; // Round trip at 343 m/s
+
+            // Twice the cache: the 16 KB cache of the ESP32-C3 serves code and read-only data alike
+            constexpr size_t EVICT_BYTES = 32 * 1024;
+            constexpr size_t CACHE_LINE_BYTES = 32;
+            const uint8_t evict_data[EVICT_BYTES] = {1};
+
+            // Replace every cached line with read-only data from flash
+            void evictCache()
+            {
+                const volatile uint8_t *data = evict_data;
+                uint32_t sum = 0;
+                for (size_t i = 0; i < EVICT_BYTES; i += CACHE_LINE_BYTES)
+                    sum += data[i];
+                (void)sum;
+            }
+
+            IRAM_ATTR bool onLoadAlarm(gptimer_handle_t timer, const gptimer_alarm_event_data_t *event, void *arg)
+            {
+                ++*static_cast<volatile uint32_t *>(arg);
+                return false;
+            }
+
+            // Periodic timer interrupt for the duration of a scope (none if the timer cannot be set up)
+            class InterruptLoad
+            {
+            public:
+                explicit InterruptLoad(bool enabled) : timer_(nullptr), count_(0)
+                {
+                    if (!enabled)
+                        return;
+
+                    const gptimer_config_t config = {
+                        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+                        .direction = GPTIMER_COUNT_UP,
+                        .resolution_hz = 1000000};
+                    if (gptimer_new_timer(&config, &timer_) != ESP_OK)
+                    {
+                        ESP_LOGE(LOG_TAG, "No timer for the interrupt load");
+                        timer_ = nullptr;
+                        return;
+                    }
+
+                    gptimer_alarm_config_t alarm = {};
+                    alarm.alarm_count = LOAD_PERIOD_US;
+                    alarm.reload_count = 0;
+                    alarm.flags.auto_reload_on_alarm = true;
+                    const gptimer_event_callbacks_t callbacks = {.on_alarm = onLoadAlarm};
+                    gptimer_set_alarm_action(timer_, &alarm);
+                    gptimer_register_event_callbacks(timer_, &callbacks, const_cast<uint32_t *>(&count_));
+                    gptimer_enable(timer_);
+                    gptimer_start(timer_);
+                }
+
+                ~InterruptLoad()
+                {
+                    if (!timer_)
+                        return;
+                    gptimer_stop(timer_);
+                    gptimer_disable(timer_);
+                    gptimer_del_timer(timer_);
+                }
+
+                InterruptLoad(const InterruptLoad &) = delete;
+                InterruptLoad &operator=(const InterruptLoad &) = delete;
+
+                uint32_t Count() const { return count_; }
+
+            private:
+                gptimer_handle_t timer_;
+                volatile uint32_t count_;
+            };
+        }
+
+        JitterStats MeasureJitter(HCSR04 &sensor, EchoCapture capture, uint32_t samples, bool interrupt_load)
+        {
+            JitterStats stats = {};
+            stats.samples = samples;
+            stats.min_us = UINT32_MAX;
+
+            // Welford's running mean and variance
+            double mean = 0.0;
+            double m2 = 0.0;
+
+            InterruptLoad load(interrupt_load);
+            for (uint32_t i = 0; i < samples; ++i)
+            {
+                vTaskDelay(pdMS_TO_TICKS(PULSE_SPACING_MS));
+                evictCache();
+
+                const EchoPulse pulse = sensor.MeasurePulse(Config::ECHO_TIMEOUT_US, capture);
+                if (pulse.status != CaptureStatus::OK)
+                    continue;
+
+                ++stats.valid;
+                if (pulse.masked)
+                    ++stats.masked;
+                stats.min_us = std::min(stats.min_us, pulse.width_us);
+                stats.max_us = std::max(stats.max_us, pulse.width_us);
+
+                const double delta = pulse.width_us - mean;
+                mean += delta / stats.valid;
+                m2 += delta * (pulse.width_us - mean);
+            }
+            if (interrupt_load)
+                ESP_LOGD(LOG_TAG, "%lu load interrupts", static_cast<unsigned long>(load.Count()));
+
+            if (stats.valid == 0)
+                stats.min_us = 0;
+            stats.mean_us = static_cast<float>(mean);
+            stats.stddev_us = stats.valid > 1 ? static_cast<float>(std::sqrt(m2 / (stats.valid - 1))) : 0.0f;
+            return stats;
+        }
+
+        void RunJitterBenchmark(HCSR04 &sensor, uint32_t samples)
+        {
+            ESP_LOGI(LOG_TAG, "%lu pulses per case; keep the target still", static_cast<unsigned long>(samples));
+            ESP_LOGI(LOG_TAG, "%-13s %-4s %7s %7s %9s %9s %9s", "capture", "load", "valid", "masked", "mean cm",
+                     "stddev mm", "range mm");
+
+            const EchoCapture captures[] = {EchoCapture::FLASH_POLLED, EchoCapture::IRAM_MASKED};
+            for (const EchoCapture capture : captures)
+            {
+                for (const bool load : {false, true})
+                {
+                    const JitterStats stats = MeasureJitter(sensor, capture, samples, load);
+                    ESP_LOGI(LOG_TAG, "%-13s %-4s %3lu/%-3lu %7lu %9.2f %9.2f %9.2f", CaptureToString(capture),
+                             load ? "on" : "off", static_cast<unsigned long>(stats.valid),
+                             static_cast<unsigned long>(stats.samples), static_cast<unsigned long>(stats.masked),
+                             stats.mean_us * MM_PER_US / 10.0f, stats.stddev_us * MM_PER_US,
+                             (stats.max_us - stats.min_us) * MM_PER_US);
+                }
+            }
+        }
+    }
+}
\ No newline at end of file
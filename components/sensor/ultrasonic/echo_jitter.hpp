@@ -0,0 +1,36 @@
+#pragma once
+
+#include "hcsr04.hpp"
+
+#include <cstdint>
+
+namespace Hardware
+{
+    namespace Ultrasonic
+    {
+        // Spread of repeated pulses against a fixed target
+        struct JitterStats
+        {
+            uint32_t samples; ///< Pulses triggered
+            uint32_t valid;   ///< Pulses timed without a timeout
+            uint32_t masked;  ///< Valid pulses with both edges inside the masked window
+            float mean_us;    ///< Mean pulse width
+            float stddev_us;  ///< Standard deviation of the pulse width
+            uint32_t min_us;  ///< Shortest pulse
+            uint32_t max_us;  ///< Longest pulse
+        };
+
+        /**
+         * Time `samples` pulses with one capture loop
+         *
+         * Before each pulse the shared instruction/data cache is flushed by
+         * reading flash, as after a deep sleep. With `interrupt_load`, a
+         * hardware timer interrupts the CPU every 97 µs, standing in for the
+         * tick, Wi-Fi and timer interrupts of a reporting wake.
+         */
+        JitterStats MeasureJitter(HCSR04 &sensor, EchoCapture capture, uint32_t samples, bool interrupt_load);
+
+        // Logs MeasureJitter for both capture loops, with and without interrupt load
+        void RunJitterBenchmark(HCSR04 &sensor, uint32_t samples);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,235 @@
+#include "hcsr04.hpp"
+
+#include "config.hpp"
+
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "hal/gpio_ll.h"
+#include "soc/gpio_struct.h"
+
+namespace Hardware
+{
+    namespace Ultrasonic
+    {
+        HCSR04::HCSR04(const gpio_num_t trigger_pin, const gpio_num_t echo_pin)
+            : trigger_pin_(trigger_pin), echo_pin_(echo_pin), pm_lock_(ESP_PM_CPU_FREQ_MAX, "hcsr04")
+        {
+            configureTriggerGpio();
+            configureEchoGpio();
+
+            ESP_LOGI(LOG_TAG, "HC-SR04 configured");
+        }
+
+        namespace
+        {
+            portMUX_TYPE echo_mux = portMUX_INITIALIZER_UNLOCKED;
+
+            // Previous capture loop: driver calls from flash, so a cache miss or an interrupt can fall between an edge and its timestamp
+            EchoPulse capturePolled(const gpio_num_t echo_pin, const uint32_t timeout_us)
+            {
+                uint64_t start_wait = esp_timer_get_time();
+                while (gpio_get_level(echo_pin) == 0)
+                {
+                    if ((esp_timer_get_time() - start_wait) > timeout_us)
+                        return {CaptureStatus::RISE_TIMEOUT, 0, false};
+                }
+
+                uint64_t echo_start = esp_timer_get_time();
+                while (gpio_get_level(echo_pin) == 1)
+                {
+                    if ((esp_timer_get_time() - echo_start) > timeout_us)
+                        return {CaptureStatus::FALL_TIMEOUT, 0, false};
+                }
+                uint64_t echo_end = esp_timer_get_time();
+
+                return {CaptureStatus::OK, static_cast<uint32_t>(echo_end - echo_start), false};
+            }
+
+            /**
+             * Poll the echo pin for a level; returns the time it was seen at, or -1 after deadline_us
+             *
+             * Unmasks interrupts once unmask_us has passed. The timestamp is
+             * read right before the level, both from IRAM.
+             */
+            IRAM_ATTR int64_t waitForLevel(const gpio_num_t echo_pin, const uint32_t level, const int64_t deadline_us,
+                                           const int64_t unmask_us, bool &masked)
+            {
+                while (true)
+                {
+                    const int64_t now = esp_timer_get_time();
+                    if (static_cast<uint32_t>(gpio_ll_get_level(&GPIO, echo_pin)) == level)
+                        return now;
+                    if (now > deadline_us)
+                        return -1;
+                    if (masked && now > unmask_us)
+                    {
+                        portEXIT_CRITICAL(&echo_mux);
+                        masked = false;
+                    }
+                }
+            }
+
+            /**
+             * Capture loop in IRAM, interrupts masked from the end of the trigger to the falling edge
+             *
+             * The mask is lifted after ECHO_MASK_MAX_US (about a meter of
+             * range, well past the mailbox): far echoes are timed with
+             * interrupts enabled rather than blocking them for up to the
+             * timeout.
+             */
+            IRAM_ATTR EchoPulse captureMasked(const gpio_num_t echo_pin, const uint32_t timeout_us)
+            {
+                bool masked = true;
+                portENTER_CRITICAL(&echo_mux);
+                const int64_t start_wait = esp_timer_get_time();
+                const int64_t unmask_us = start_wait + Config::ECHO_MASK_MAX_US;
+
+                EchoPulse pulse = {CaptureStatus::OK, 0, false};
+                const int64_t echo_start = waitForLevel(echo_pin, 1, start_wait + timeout_us, unmask_us, masked);
+                if (echo_start < 0)
+                {
+                    pulse.status = CaptureStatus::RISE_TIMEOUT;
+                }
+                else
+                {
+                    const int64_t echo_end = waitForLevel(echo_pin, 0, echo_start + timeout_us, unmask_us, masked);
+                    if (echo_end < 0)
+                        pulse.status = CaptureStatus::FALL_TIMEOUT;
+                    else
+                        pulse.width_us = static_cast<uint32_t>(echo_end - echo_start);
+                }
+
+                pulse.masked = masked;
+                if (masked)
+                    portEXIT_CRITICAL(&echo_mux);
+                return pulse;
+            }
+        }
+
+        const char *CaptureToString(EchoCapture capture)
+        {
+            switch (capture)
+            {
+            case EchoCapture::FLASH_POLLED:
+                return "flash_polled";
+            case EchoCapture::IRAM_MASKED:
+                return "iram_masked";
+            }
+            return "unknown";
+        }
+
+        float HCSR04::MeasureDistance(const uint32_t timeout_us)
+        {
+            const EchoPulse pulse = MeasurePulse(
+                timeout_us, Config::ECHO_CAPTURE_IRAM ? EchoCapture::IRAM_MASKED : EchoCapture::FLASH_POLLED);
+
+            switch (pulse.status)
+            {
+            case CaptureStatus::RISE_TIMEOUT:
+                ESP_LOGW(LOG_TAG, "Timed out waiting for echo");
+                return -1.0f;
+            case CaptureStatus::FALL_TIMEOUT:
+                ESP_LOGW(LOG_TAG, "Timed out measuring echo pulse width");
+                return -1.0f;
+            case CaptureStatus::OK:
+                break;
+            }
+
+            return calculateDistance(pulse.width_us);
+        }
+
+        EchoPulse HCSR04::MeasurePulse(const uint32_t timeout_us, const EchoCapture capture)
+        {
+            // The echo is timed by polling: at the XTAL clock each poll takes 4x longer, and a light sleep would miss the edge
+            Power::PmLock::Hold hold(pm_lock_);
+
+            // Send trigger pulse
+            setGpioLevel(trigger_pin_, 1);
+            esp_rom_delay_us(Config::TRIGGER_PULSE_uS);
+            setGpioLevel(trigger_pin_, 0);
+
+            // Small stabilization delay for sensor to process trigger
+            esp_rom_delay_us(2);
+
+            if (capture == EchoCapture::IRAM_MASKED)
+                return captureMasked(echo_pin_, timeout_us);
+            return capturePolled(echo_pin_, timeout_us);
+        }
+
+        float HCSR04::calculateDistance(const uint32_t pulse_us)
+        {
+            float pulse_duration = (float)pulse_us;
+            float distance = (pulse_duration * 0.0343f) / 2.0f;
+
+            // Validate reading range (HC-SR04 typical range: 2cm - 400cm)
+            if (distance < 2.0f)
+            {
+                ESP_LOGW(LOG_TAG, "Distance below minimum range: %.2f cm", distance);
+                return -1.0f;
+            }
+            else if (distance >= Config::DISTANCE_THRESHOLD_CM)
+            {
+                ESP_LOGW(LOG_TAG, "Distance threshold achieved or surpassed: %.2f cm over the threshold",
+                         (distance - Config::DISTANCE_THRESHOLD_CM));
+            }
+            else
+            {
+                ESP_LOGI(LOG_TAG, "Distance: %.2f cm", distance);
+            }
+
+            return distance;
+        }
+
+        void HCSR04::configureTriggerGpio()
+        {
+            gpio_config_t trigger_config = {
+                .pin_bit_mask = (1ULL << trigger_pin_),
+                .mode = GPIO_MODE_OUTPUT,
+                .pull_up_en = GPIO_PULLUP_DISABLE,
+                .pull_down_en = GPIO_PULLDOWN_DISABLE,
+                .intr_type = GPIO_INTR_DISABLE};
+
+            esp_err_t err = gpio_config(&trigger_config);
+            if (err != ESP_OK)
+            {
+                ESP_LOGE(LOG_TAG, "Failed to configure Trigger GPIO %d: %s", trigger_pin_, esp_err_to_name(err));
+                return;
+            }
+
+            ESP_LOGI(LOG_TAG, "Trigger GPIO %d configured", trigger_pin_);
+
+            setGpioLevel(trigger_pin_, 0);
+        }
+
+        void HCSR04::configureEchoGpio()
+        {
+            gpio_config_t echo_config = {
+                .pin_bit_mask = (1ULL << echo_pin_),
+                .mode = GPIO_MODE_INPUT,
+                .pull_up_en = GPIO_PULLUP_DISABLE,
+                .pull_down_en = GPIO_PULLDOWN_DISABLE,
+                .intr_type = GPIO_INTR_DISABLE};
+            esp_err_t err = gpio_config(&echo_config);
+            if (err != ESP_OK)
+            {
+                ESP_LOGE(LOG_TAG, "Failed to configure Echo GPIO %d: %s", echo_pin_, esp_err_to_name(err));
+                return;
+            }
+
+            ESP_LOGI(LOG_TAG, "Echo GPIO %d configured", echo_pin_);
+        }
+
+        void HCSR04::setGpioLevel(const gpio_num_t gpio_pin, const uint32_t level)
+        {
+            esp_err_t err = gpio_set_level(gpio_pin, level);
+            if (err != ESP_OK)
+            {
+                ESP_LOGE(LOG_TAG, "Failed to set GPIO %d level: %s", gpio_pin, esp_err_to_name(err));
+                return;
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "driver/gpio.h"
+
+#include "../power/power_manager.hpp"
+
+#include <cstdint>
+
+namespace Hardware
+{
+    namespace Ultrasonic
+    {
+        // How the echo pulse is timed
+        enum class EchoCapture : uint8_t
+        {
+            FLASH_POLLED, // Polling loop in flash through the GPIO driver, interrupts enabled
+            IRAM_MASKED   // Polling loop in IRAM on the GPIO registers, interrupts masked around the edges
+        };
+
+        enum class CaptureStatus : uint8_t
+        {
+            OK,
+            RISE_TIMEOUT, // Echo never went high
+            FALL_TIMEOUT  // Echo stayed high past the timeout
+        };
+
+        struct EchoPulse
+        {
+            CaptureStatus status;
+            uint32_t width_us; ///< Echo high time, valid with CaptureStatus::OK
+            bool masked;       ///< Both edges fell inside the masked window
+        };
+
+        const char *CaptureToString(EchoCapture capture);
+
+        class HCSR04
+        {
+        public:
+            HCSR04(const gpio_num_t trigger_pin, const gpio_num_t echo_pin);
+
+            // Distance in cm; kept out of line for tools/wake_bench, which returns scripted distances under QEMU
+            __attribute__((noinline)) float MeasureDistance(const uint32_t timeout_us);
+
+            /**
+             * Trigger once and time the echo pulse, without logging
+             *
+             * Warnings for a timeout are left to the caller: nothing that can
+             * miss the cache runs between an edge and its timestamp.
+             */
+            EchoPulse MeasurePulse(const uint32_t timeout_us, const EchoCapture capture);
+
+        private:
+            static constexpr const char *LOG_TAG = "HCSR04";
+
+            gpio_num_t trigger_pin_; ///< GPIO TRIGGER (Output) pin number
+            gpio_num_t echo_pin_;    ///< GPIO ECHO (Input) pin number
+            Power::PmLock pm_lock_;  ///< Full clock, no light sleep while measuring
+
+            // Configure the Trigger GPIO pin for HCSR04 control
+            void configureTriggerGpio();
+
+            // Configure the Echo GPIO pin for HCSR04 control
+            void configureEchoGpio();
+
+            /**
+             * Calculate distance (speed of sound: 343 m/s = 0.0343 cm/us)
+             *        Distance = (time * speed) / 2 (round trip)
+             */
+            float calculateDistance(const uint32_t pulse_us);
+
+            void setGpioLevel(const gpio_num_t gpio_pin, const uint32_t level);
+        };
+    }
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "json_writer.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace Telemetry
+{
+    JsonWriter::JsonWriter(char *buf, size_t size)
+        : buf_(buf), size_(size), len_(0), first_(true), overflow_(size < 2)
+    {
+        appendChar('{');
+    }
+
+    void JsonWriter::AddString(const char *key, const char *value)
+    {
+        appendKey(key);
+        appendString(value ? value : "");
+    }
+
+    void JsonWriter::AddInt(const char *key, int64_t value)
+    {
+        appendKey(key);
+
+        char text[24];
+        const int n = snprintf(text, sizeof(text), "%lld", static_cast<long long>(value));
+        append(text, static_cast<size_t>(n));
+    }
+
+    void JsonWriter::AddFloat(const char *key, float value)
+    {
+        appendKey(key);
+
+        if (!std::isfinite(value))
+        {
+            append("null", 4);
+            return;
+        }
+
+        // Fixed point with three decimals; integer formatting never touches the heap (newlib's dtoa does)
+        const double magnitude = std::fmin(std::fabs(static_cast<double>(value)), 1e15);
+        const unsigned long long scaled = static_cast<unsigned long long>(std::llround(magnitude * 1000.0));
+        const unsigned long long whole = scaled / 1000;
+        unsigned fraction = static_cast<unsigned>(scaled % 1000);
+
+        char text[32];
+        int n = snprintf(text, sizeof(text), "%s%llu", (value < 0.0f && scaled > 0) ? "-" : "", whole);
+        if (fraction > 0)
+        {
+            int digits = 3;
+            while (fraction % 10 == 0)
+            {
+                fraction /= 10;
+                --digits;
+            }
+            n += snprintf(text + n, sizeof(text) - n, ".%0*u", digits, fraction);
+        }
+        append(text, static_cast<size_t>(n));
+    }
+
+    const char *JsonWriter::Finish()
+    {
+        appendChar('}');
+        if (overflow_)
+            return nullptr;
+
+        buf_[len_] = '\0';
+        return buf_;
+    }
+
+    void JsonWriter::append(const char *text, size_t n)
+    {
+        // Always leave room for the NUL written by Finish()
+        if (overflow_ || n >= size_ - len_)
+        {
+            overflow_ = true;
+            return;
+        }
+        memcpy(buf_ + len_, text, n);
+        len_ += n;
+    }
+
+    void JsonWriter::appendString(const char *text)
+    {
+        appendChar('"');
+        for (const char *p = text; *p; ++p)
+        {
+            const unsigned char c = static_cast<unsigned char>(*p);
+            if (c == '"' || c == '\\')
+            {
+                const char escaped[2] = {'\\', static_cast<char>(c)};
+                append(escaped, 2);
+            }
+            else if (c < 0x20)
+            {
+                char escaped[8];
+                const int n = snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                append(escaped, static_cast<size_t>(n));
+            }
+            else
+            {
+                appendChar(static_cast<char>(c));
+            }
+        }
+        appendChar('"');
+    }
+
+    void JsonWriter::appendKey(const char *key)
+    {
+        if (!first_)
+            appendChar(',');
+        first_ = false;
+
+        appendString(key);
+        appendChar(':');
+    }
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Telemetry
+{
+    /**
+     * Flat JSON object written into a caller-provided buffer
+     *
+     * Replaces cJSON on the reporting path: nothing is allocated and keys
+     * come out in the order they were added. Floats are written with up to
+     * three decimals (trailing zeros dropped), NaN and infinity as null.
+     * Once the buffer is full every further call is ignored and Finish()
+     * returns NULL.
+     */
+    class JsonWriter
+    {
+    public:
+        JsonWriter(char *buf, size_t size);
+
+        void AddString(const char *key, const char *value);
+        void AddInt(const char *key, int64_t value);
+        void AddFloat(const char *key, float value);
+
+        // Close the object; returns the NUL-terminated text, or NULL if it did not fit
+        const char *Finish();
+
+        // Bytes written so far (without the NUL)
+        size_t Length() const { return len_; }
+
+    private:
+        char *buf_;     ///< Output buffer
+        size_t size_;   ///< Size of buf_ including room for the NUL
+        size_t len_;    ///< Bytes written
+        bool first_;    ///< No key written yet (no comma needed)
+        bool overflow_; ///< Output did not fit, stop writing
+
+        void append(const char *text, size_t n);
+        void appendChar(char c) { append(&c, 1); }
+
+        // Append text as a JSON string (quoted, escaped)
+        void appendString(const char *text);
+
+        // Separator and "key":
+        void appendKey(const char *key);
+    };
+}
\ No newline at end of file
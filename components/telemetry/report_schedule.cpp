@@ -0,0 +1,53 @@
+#include "report_schedule.hpp"
+
+#include <algorithm>
+
+#include "config.hpp"
+
+namespace Telemetry
+{
+    uint32_t PhaseOffsetSec(const char *client_id, uint64_t period_sec)
+    {
+        if (period_sec == 0)
+            return 0;
+
+        // FNV-1a, then a final mix so IDs that differ only in the last digit land far apart
+        uint32_t hash = 2166136261u;
+        for (const char *c = client_id; *c; ++c)
+            hash = (hash ^ static_cast<uint8_t>(*c)) * 16777619u;
+        hash ^= hash >> 16;
+        hash *= 0x45d9f3bu;
+        hash ^= hash >> 16;
+        return static_cast<uint32_t>(1 + hash % period_sec);
+    }
+
+    bool HeartbeatDue(uint64_t now_sec, uint64_t last_sec, uint64_t interval_sec, uint64_t phase_sec)
+    {
+        if (last_sec == 0)
+            return now_sec >= phase_sec;
+        return now_sec >= last_sec + interval_sec;
+    }
+
+    ReconnectBackoff::ReconnectBackoff(BackoffState *state)
+        : state_(state)
+    {
+    }
+
+    void ReconnectBackoff::Failed(uint64_t now_us, uint32_t random)
+    {
+        state_->failures++;
+        const uint32_t shift = std::min<uint32_t>(state_->failures - 1, 16);
+        const uint64_t window_sec = std::min<uint64_t>(static_cast<uint64_t>(Config::RECONNECT_BACKOFF_BASE_SEC) << shift,
+                                                       Config::RECONNECT_BACKOFF_MAX_SEC);
+        const uint64_t wait_sec = window_sec - window_sec / 2 + random % (window_sec / 2 + 1);
+        state_->retry_after_us = now_us + wait_sec * 1000000ULL;
+        ESP_LOGW(LOG_TAG, "Session failed (%lu in a row), next heartbeat attempt in %llu s",
+                 static_cast<unsigned long>(state_->failures), static_cast<unsigned long long>(wait_sec));
+    }
+
+    void ReconnectBackoff::Succeeded()
+    {
+        state_->failures = 0;
+        state_->retry_after_us = 0;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+
+#include "esp_log.h"
+
+namespace Telemetry
+{
+    // Reconnect backoff state kept in RTC memory between deep sleep cycles
+    struct BackoffState
+    {
+        uint32_t failures;       ///< Sessions in a row that did not reach the broker
+        uint64_t retry_after_us; ///< No heartbeat session before this virtual time
+    };
+
+    /**
+     * Offset of a device's reports within a period, from its client ID
+     *
+     * A hash of the client ID, so every device keeps the same offset across
+     * power cuts and reflashes, and a fleet that boots together spreads its
+     * reports evenly over the period. Returns 1..period_sec.
+     */
+    uint32_t PhaseOffsetSec(const char *client_id, uint64_t period_sec);
+
+    /**
+     * True if a heartbeat is due
+     *
+     * last_sec is the virtual time of the last heartbeat, 0 for none since
+     * boot: the first one goes out once now_sec reaches phase_sec
+     * (PhaseOffsetSec(), or interval_sec to wait one full interval), the
+     * following ones interval_sec after the previous one.
+     */
+    bool HeartbeatDue(uint64_t now_sec, uint64_t last_sec, uint64_t interval_sec, uint64_t phase_sec);
+
+    /**
+     * Jittered exponential backoff of failed sessions
+     *
+     * When the access point or the broker is down, every heartbeat that is
+     * due would retry on every wake, and all devices come back in the same
+     * second once it is up again. After a session that did not reach the
+     * broker (Wi-Fi or MQTT), heartbeats wait Config::RECONNECT_BACKOFF_BASE_SEC,
+     * doubled for each further failure up to Config::RECONNECT_BACKOFF_MAX_SEC.
+     * The actual wait is drawn from the upper half of that window, so
+     * retries of devices that failed together spread out. Mail events are
+     * not held back: they are rare and uncorrelated across the fleet.
+     */
+    class ReconnectBackoff
+    {
+    public:
+        // Backoff over the RTC state (cleared after power loss)
+        explicit ReconnectBackoff(BackoffState *state);
+
+        // True while heartbeats wait for the retry time
+        bool Waiting(uint64_t now_us) const { return now_us < state_->retry_after_us; }
+
+        // A session did not reach the broker; random picks the wait within the backoff window
+        void Failed(uint64_t now_us, uint32_t random);
+
+        // A session reached the broker: the next failure starts from the base delay again
+        void Succeeded();
+
+        const BackoffState &State() const { return *state_; }
+
+    private:
+        static constexpr const char *LOG_TAG = "BACKOFF";
+
+        BackoffState *state_; ///< RTC-backed state
+    };
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "sequence.hpp"
+
+#include "nvs.h"
+
+#include "config.hpp"
+#include "alloc_tracker.hpp"
+
+namespace Telemetry
+{
+    SequenceCounter::SequenceCounter(SequenceState *state)
+        : local_state_{},
+          state_(state ? state : &local_state_)
+    {
+    }
+
+    bool SequenceCounter::Next(uint32_t *seq)
+    {
+        // NVS allocates its handles; this happens once per boot and once every SEQUENCE_NVS_BLOCK messages
+        Diagnostics::AllocTracker::Exempt exempt;
+
+        if (!state_->valid && restore() == ESP_OK)
+            state_->valid = true;
+
+        // Until the mark is restored, next may be below numbers already sent (and reserving would lower the mark)
+        if (!state_->valid)
+            return false;
+
+        if (state_->next >= state_->reserved)
+        {
+            // Without a reservation a power cut would repeat numbers; retry on the next message
+            if (reserve(state_->next + Config::SEQUENCE_NVS_BLOCK) != ESP_OK)
+                return false;
+            state_->reserved = state_->next + Config::SEQUENCE_NVS_BLOCK;
+        }
+
+        *seq = state_->next++;
+        return true;
+    }
+
+    esp_err_t SequenceCounter::restore()
+    {
+        nvs_handle_t handle;
+        esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+        if (err != ESP_OK)
+        {
+            ESP_LOGE(LOG_TAG, "Failed to open NVS: %s", esp_err_to_name(err));
+            return err;
+        }
+
+        uint32_t high_water = 0;
+        err = nvs_get_u32(handle, NVS_KEY, &high_water);
+        nvs_close(handle);
+
+        if (err == ESP_ERR_NVS_NOT_FOUND)
+            err = ESP_OK; // First boot ever
+        if (err != ESP_OK)
+        {
+            ESP_LOGE(LOG_TAG, "Failed to read sequence high-water mark: %s", esp_err_to_name(err));
+            return err;
+        }
+
+        // Everything below the mark may have been sent before the power loss
+        state_->next = high_water;
+        state_->reserved = high_water;
+        ESP_LOGI(LOG_TAG, "Sequence restored at %lu", static_cast<unsigned long>(high_water));
+        return ESP_OK;
+    }
+
+    esp_err_t SequenceCounter::reserve(uint32_t high_water)
+    {
+        nvs_handle_t handle;
+        esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+        if (err == ESP_OK)
+        {
+            err = nvs_set_u32(handle, NVS_KEY, high_water);
+            if (err == ESP_OK)
+                err = nvs_commit(handle);
+            nvs_close(handle);
+        }
+
+        if (err != ESP_OK)
+            ESP_LOGW(LOG_TAG, "Failed to reserve sequence block: %s", esp_err_to_name(err));
+        return err;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+
+#include "esp_err.h"
+#include "esp_log.h"
+
+namespace Telemetry
+{
+    // Sequence counter state kept in RTC memory between deep sleep cycles
+    struct SequenceState
+    {
+        bool valid;        ///< False after power loss until restored from NVS
+        uint32_t next;     ///< Sequence number of the next message
+        uint32_t reserved; ///< Numbers below this are reserved in NVS (next <= reserved)
+    };
+
+    /**
+     * Device-unique, monotonic message sequence numbers
+     *
+     * Wakes from deep sleep continue from the RTC state. To survive power
+     * loss without writing flash for every message, numbers are reserved from
+     * NVS in blocks of Config::SEQUENCE_NVS_BLOCK: the high-water mark stored
+     * in NVS is always ahead of every number handed out, and a fresh boot
+     * continues from it. Numbers left in a block when power is lost are
+     * skipped, so the sequence has gaps but never repeats. A number is only
+     * handed out once a reservation covers it: while the mark cannot be
+     * read, or a new block cannot be stored, Next() has no number (the
+     * message goes out without one) and retries on the next message. The
+     * stored mark never goes down.
+     *
+     * NVS must be initialized (nvs_flash_init) before the first Next().
+     */
+    class SequenceCounter
+    {
+    public:
+        // Counter over RTC state (may be NULL: restored from NVS on every construction)
+        explicit SequenceCounter(SequenceState *state);
+
+        // Next sequence number in *seq; reserves a new block in NVS when the current one is used up.
+        // False, and nothing handed out, while no reservation covers the number
+        bool Next(uint32_t *seq);
+
+    private:
+        static constexpr const char *LOG_TAG = "SEQUENCE";
+        static constexpr const char *NVS_NAMESPACE = "telemetry";
+        static constexpr const char *NVS_KEY = "seq_hw";
+
+        SequenceState local_state_; ///< Used when no RTC state was given
+        SequenceState *state_;      ///< RTC-backed state
+
+        // Load the NVS high-water mark after power loss
+        esp_err_t restore();
+
+        // Store a new high-water mark in NVS
+        esp_err_t reserve(uint32_t high_water);
+    };
+}
\ No newline at end of file
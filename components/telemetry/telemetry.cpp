@@ -0,0 +1,429 @@
+#include "telemetry.hpp"
+
+#include "alloc_tracker.hpp"
+#include "sdkconfig.h"
+
+#include <sys/time.h>
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+namespace Telemetry
+{
+    Telemetry::Telemetry(PersistentState *persistent_state, uint32_t wake_count,
+                         Config::RuntimeConfigStore *config_store)
+        : persistent_state_(persistent_state),
+          pending_status_{},
+          pending_status_msg_id_(-1),
+          sequence_(persistent_state ? &persistent_state->sequence : nullptr),
+          wake_count_(wake_count),
+          battery_mv_(0),
+          battery_percent_(0),
+          power_level_(Hardware::Battery::PowerLevel::NORMAL),
+          unstable_(false),
+          suppressed_events_(0),
+          trace_{},
+          config_store_(config_store),
+          pending_config_len_(0)
+    {
+        base_topic_[0] = '\0';
+        message_[0] = '\0';
+        ESP_LOGI(LOG_TAG, "Telemetry initialized.");
+    }
+
+    esp_err_t Telemetry::InitMQTT(const char *broker_uri,
+                                  const char *base_topic,
+                                  const char *client_id,
+                                  const char *username,
+                                  const char *password,
+                                  const Publisher::TlsOptions *tls)
+    {
+        mqtt_publisher_.emplace();
+
+        strncpy(base_topic_, base_topic, sizeof(base_topic_) - 1);
+        base_topic_[sizeof(base_topic_) - 1] = '\0';
+
+        esp_err_t err = mqtt_publisher_->Init(broker_uri, client_id, username, password, tls);
+#if CONFIG_MAILBOX_REMOTE_CONFIG
+        if (err == ESP_OK && config_store_)
+            err = Subscribe("config", onConfigMessage, this);
+#endif
+        if (err != ESP_OK)
+        {
+            mqtt_publisher_.reset();
+            return err;
+        }
+
+        return mqtt_publisher_->Start();
+    }
+
+    void Telemetry::Publish(const Processor::DistanceData &data,
+                            const float baseline_cm, const float threshold_cm,
+                            const char *ip_addr)
+    {
+        // Emit event telemetry
+        if (data.mail_detected)
+            emitMailDropEvent(data, baseline_cm, ip_addr);
+
+        if (data.mail_collected)
+            emitMailCollectedEvent(data, baseline_cm, ip_addr);
+
+        // Emit periodic status telemetry
+        maybeEmitPeriodic(data, baseline_cm, threshold_cm, ip_addr);
+    }
+
+    int Telemetry::PublishDigest(const Processor::DigestState &digest, uint64_t now_us,
+                                 const Processor::DistanceData &data,
+                                 const float baseline_cm, const float threshold_cm,
+                                 const char *ip_addr)
+    {
+        char timestamp[32];
+        formatDateTime(timestamp, sizeof(timestamp));
+
+        // Reported alarms as "full,sensor"
+        char alarms[32] = "";
+        size_t alarms_len = 0;
+        for (uint8_t bit = 1; bit != 0; bit <<= 1)
+        {
+            if ((digest.period_alarms & bit) && alarms_len < sizeof(alarms))
+                alarms_len += snprintf(alarms + alarms_len, sizeof(alarms) - alarms_len, "%s%s", alarms_len ? "," : "",
+                                       alarmToString(static_cast<Processor::DigestAlarm>(bit)));
+        }
+
+        JsonWriter json = beginMessage(ip_addr, timestamp);
+        json.AddInt("period_s", static_cast<int64_t>((now_us - digest.period_start_us) / 1000000ULL));
+        json.AddInt("wakes", digest.wakes);
+        json.AddInt("drops", digest.drops);
+        json.AddInt("collections", digest.collections);
+        if (digest.drops > 0)
+        {
+            json.AddInt("first_drop_s", static_cast<int64_t>((digest.first_drop_us - digest.period_start_us) / 1000000ULL));
+            json.AddInt("last_drop_s", static_cast<int64_t>((digest.last_drop_us - digest.period_start_us) / 1000000ULL));
+        }
+        json.AddInt("full_s", static_cast<int64_t>(digest.full_us / 1000000ULL));
+        json.AddFloat("min_success_rate", digest.min_success_rate);
+        json.AddString("alarms", alarms);
+        json.AddString("mailbox_state", stateToString(data.state));
+        const int msg_id = publishJSON(json, "digest");
+
+        maybeEmitPeriodic(data, baseline_cm, threshold_cm, ip_addr);
+        return msg_id;
+    }
+
+    int Telemetry::PublishAlarms(uint8_t alarms, const Processor::DistanceData &data, const char *ip_addr)
+    {
+        char timestamp[32];
+        formatDateTime(timestamp, sizeof(timestamp));
+
+        int msg_id = -1;
+        for (uint8_t bit = 1; bit != 0; bit <<= 1)
+        {
+            if (!(alarms & bit))
+                continue;
+            JsonWriter json = beginMessage(ip_addr, timestamp);
+            json.AddString("alarm", alarmToString(static_cast<Processor::DigestAlarm>(bit)));
+            json.AddFloat("distance_cm", data.filtered_cm);
+            json.AddFloat("success_rate", data.success_rate);
+            json.AddString("mailbox_state", stateToString(data.state));
+            if (battery_mv_ > 0)
+                json.AddInt("batt_mv", battery_mv_);
+            msg_id = publishJSON(json, "events/alarm");
+        }
+        return msg_id;
+    }
+
+    bool Telemetry::IsAcknowledged(int msg_id) const
+    {
+        return mqtt_publisher_ && msg_id >= 0 && mqtt_publisher_->IsAcknowledged(msg_id);
+    }
+
+    void Telemetry::Stop()
+    {
+        if (mqtt_publisher_)
+        {
+            if (persistent_state_ && pending_status_msg_id_ >= 0 &&
+                mqtt_publisher_->IsAcknowledged(pending_status_msg_id_))
+            {
+                persistent_state_->status = pending_status_;
+            }
+            pending_status_msg_id_ = -1;
+
+            mqtt_publisher_->Stop();
+            mqtt_publisher_.reset();
+        }
+
+#if CONFIG_MAILBOX_REMOTE_CONFIG
+        const size_t config_len = pending_config_len_.exchange(0);
+        if (config_store_ && config_len > 0)
+        {
+            // Rare, and parsing and the NVS write allocate: not part of the reporting path
+            Diagnostics::AllocTracker::Exempt exempt;
+            const esp_err_t err = config_store_->Apply(pending_config_, config_len);
+            if (err != ESP_OK && err != ESP_ERR_INVALID_VERSION)
+                ESP_LOGW(LOG_TAG, "Config update not applied: %s", esp_err_to_name(err));
+        }
+#endif
+    }
+
+    void Telemetry::onConfigMessage(const char *data, int data_len, void *arg)
+    {
+        auto *telemetry = static_cast<Telemetry *>(arg);
+        if (data_len <= 0 || static_cast<size_t>(data_len) > sizeof(telemetry->pending_config_))
+        {
+            ESP_LOGW(LOG_TAG, "Ignoring config message of %d bytes", data_len);
+            return;
+        }
+
+        // Only the MQTT task writes, and Stop() reads after the task has stopped
+        memcpy(telemetry->pending_config_, data, data_len);
+        telemetry->pending_config_len_ = static_cast<size_t>(data_len);
+    }
+
+    void Telemetry::SetBattery(uint32_t millivolts, uint8_t percent, Hardware::Battery::PowerLevel level)
+    {
+        battery_mv_ = millivolts;
+        battery_percent_ = percent;
+        power_level_ = level;
+    }
+
+    void Telemetry::SetStability(bool unstable, uint32_t suppressed_events)
+    {
+        unstable_ = unstable;
+        suppressed_events_ = suppressed_events;
+    }
+
+    void Telemetry::SetTrace(const EventTrace &trace) { trace_ = trace; }
+
+    bool Telemetry::IsConnected() const { return mqtt_publisher_ && mqtt_publisher_->IsConnected(); }
+
+    esp_err_t Telemetry::Subscribe(const char *subtopic, Publisher::MessageHandler handler, void *arg)
+    {
+        if (!mqtt_publisher_)
+            return ESP_ERR_INVALID_STATE;
+
+        char topic[128];
+        snprintf(topic, sizeof(topic), "%s/%s", base_topic_, subtopic);
+        return mqtt_publisher_->Subscribe(topic, 1, handler, arg);
+    }
+
+    esp_err_t Telemetry::PublishRaw(const char *subtopic, const char *payload, int qos, int len)
+    {
+        if (!mqtt_publisher_ || !mqtt_publisher_->IsConnected())
+            return ESP_ERR_INVALID_STATE;
+
+        char topic[128];
+        snprintf(topic, sizeof(topic), "%s/%s", base_topic_, subtopic);
+        return mqtt_publisher_->Publish(topic, payload, qos, false, nullptr, len);
+    }
+
+    void Telemetry::formatDateTime(char *buf, size_t len)
+    {
+        // Get current time
+        std::time_t now = std::time(nullptr);
+        std::tm timeinfo;
+        localtime_r(&now, &timeinfo);
+
+        // Format as DD.MM.YYYY HH:MM:SS
+        std::strftime(buf, len, "%d.%m.%Y %H:%M:%S", &timeinfo);
+    }
+
+    JsonWriter Telemetry::beginMessage(const char *ip_addr, const char *timestamp)
+    {
+        JsonWriter json(message_, sizeof(message_));
+        json.AddString("device_ip", ip_addr ? ip_addr : "unknown");
+        json.AddString("timestamp", timestamp);
+        return json;
+    }
+
+    void Telemetry::addTrace(JsonWriter &json) const
+    {
+        if (trace_.detected_us <= 0)
+            return;
+
+        const int64_t now_us = esp_timer_get_time();
+        timeval tv;
+        gettimeofday(&tv, nullptr);
+        if (tv.tv_sec >= MIN_VALID_EPOCH_S)
+            json.AddInt("t_det", tv.tv_sec * 1000LL + tv.tv_usec / 1000 - (now_us - trace_.detected_us) / 1000);
+
+        json.AddInt("tr_win", trace_.window_ms);
+        if (trace_.wifi_us > 0)
+            json.AddInt("tr_wifi", (trace_.wifi_us - trace_.detected_us) / 1000);
+        if (trace_.time_sync_us > 0)
+            json.AddInt("tr_ntp", (trace_.time_sync_us - trace_.detected_us) / 1000);
+        if (trace_.mqtt_us > 0)
+            json.AddInt("tr_mqtt", (trace_.mqtt_us - trace_.detected_us) / 1000);
+        json.AddInt("tr_pub", (now_us - trace_.detected_us) / 1000);
+    }
+
+    void Telemetry::emitMailDropEvent(const Processor::DistanceData &data, const float &baseline_cm,
+                                      const char *ip_addr)
+    {
+        const float confidence = calculateConfidence(data);
+        char timestamp[32];
+        formatDateTime(timestamp, sizeof(timestamp));
+
+        JsonWriter json = beginMessage(ip_addr, timestamp);
+        json.AddFloat("distance_cm", data.filtered_cm);
+        json.AddFloat("baseline_cm", baseline_cm);
+        json.AddInt("duration_ms", data.duration_ms);
+        json.AddFloat("confidence", confidence);
+        json.AddFloat("success_rate", data.success_rate);
+        json.AddString("new_state", stateToString(data.state));
+        addTrace(json);
+
+        publishJSON(json, "events/mail_drop");
+    }
+
+    void Telemetry::emitMailCollectedEvent(const Processor::DistanceData &data, const float &baseline_cm,
+                                           const char *ip_addr)
+    {
+        char timestamp[32];
+        formatDateTime(timestamp, sizeof(timestamp));
+
+        JsonWriter json = beginMessage(ip_addr, timestamp);
+        json.AddFloat("before_cm", data.filtered_cm - data.delta_cm);
+        json.AddFloat("after_cm", data.filtered_cm);
+        json.AddFloat("baseline_cm", baseline_cm);
+        json.AddInt("duration_ms", data.duration_ms);
+        json.AddFloat("success_rate", data.success_rate);
+        json.AddString("new_state", stateToString(data.state));
+        addTrace(json);
+
+        publishJSON(json, "events/mail_collected");
+    }
+
+    void Telemetry::maybeEmitPeriodic(const Processor::DistanceData &data,
+                                      const float &baseline_cm, const float &threshold_cm,
+                                      const char *ip_addr)
+    {
+        const uint64_t now_us = esp_timer_get_time();
+        char timestamp[32];
+        formatDateTime(timestamp, sizeof(timestamp));
+
+        // Status as it will look once acknowledged
+        StatusSnapshot next = {};
+        next.valid = true;
+        next.baseline_cm = baseline_cm;
+        next.threshold_cm = threshold_cm;
+        strncpy(next.device_ip, ip_addr ? ip_addr : "unknown", sizeof(next.device_ip) - 1);
+        next.mailbox_state = data.state;
+        next.config_version = config_store_ ? config_store_->Get().version : 0;
+        next.power = power_level_;
+
+        const StatusSnapshot *last = persistent_state_ ? &persistent_state_->status : nullptr;
+        const bool keyframe = !last || !last->valid ||
+                              last->since_keyframe + 1 >= Config::HEARTBEAT_KEYFRAME_INTERVAL;
+        next.since_keyframe = keyframe ? 0 : last->since_keyframe + 1;
+
+        JsonWriter json(message_, sizeof(message_));
+        if (keyframe || strcmp(next.device_ip, last->device_ip) != 0)
+            json.AddString("device_ip", next.device_ip);
+        json.AddString("timestamp", timestamp);
+        json.AddInt("kf", keyframe ? 1 : 0);
+        json.AddFloat("distance_cm", data.filtered_cm);
+        if (keyframe || next.baseline_cm != last->baseline_cm)
+            json.AddFloat("baseline_cm", baseline_cm);
+        if (keyframe || next.threshold_cm != last->threshold_cm)
+            json.AddFloat("threshold_cm", threshold_cm);
+        json.AddFloat("success_rate", data.success_rate);
+        if (keyframe || next.mailbox_state != last->mailbox_state)
+            json.AddString("mailbox_state", stateToString(data.state));
+        if (keyframe || next.config_version != last->config_version)
+            json.AddInt("cfg", next.config_version);
+        if (battery_mv_ > 0)
+        {
+            json.AddInt("batt_mv", battery_mv_);
+            json.AddInt("batt_pct", battery_percent_);
+            if (keyframe || next.power != last->power)
+                json.AddString("power", Hardware::Battery::LevelToString(next.power));
+        }
+        if (unstable_ || suppressed_events_ > 0)
+        {
+            json.AddInt("unstable", unstable_ ? 1 : 0);
+            json.AddInt("suppressed", suppressed_events_);
+        }
+
+        // Keyframes are retained so a (re)starting backend always has a full state to apply deltas to
+        pending_status_ = next;
+        pending_status_msg_id_ = publishJSON(json, "status", keyframe);
+        last_telemetry_us_ = now_us;
+    }
+
+    float Telemetry::calculateConfidence(const Processor::DistanceData &data) const
+    {
+        const Config::RuntimeConfig &config = config_store_ ? config_store_->Get() : Config::DEFAULT_RUNTIME_CONFIG;
+        const float delta_component = 0.5f * (data.delta_cm / std::max(0.1f, config.trigger_delta_cm));
+        const float duration_component = 0.3f * (static_cast<float>(data.duration_ms) /
+                                                 std::max(1.0f, static_cast<float>(config.hold_ms)));
+        const float reliability_component = 0.2f * std::clamp(data.success_rate, 0.0f, 1.0f);
+
+        return std::min(1.0f, delta_component + duration_component + reliability_component);
+    }
+
+    const char *Telemetry::alarmToString(Processor::DigestAlarm alarm)
+    {
+        switch (alarm)
+        {
+        case Processor::ALARM_FULL:
+            return "full";
+        case Processor::ALARM_SENSOR:
+            return "sensor";
+        case Processor::ALARM_BATTERY:
+            return "battery";
+        default:
+            return "unknown";
+        }
+    }
+
+    const char *Telemetry::stateToString(const Processor::MailboxState state) const
+    {
+        switch (state)
+        {
+        case Processor::MailboxState::EMPTY:
+            return "empty";
+        case Processor::MailboxState::HAS_MAIL:
+            return "has_mail";
+        case Processor::MailboxState::FULL:
+            return "full";
+        case Processor::MailboxState::EMPTIED:
+            return "emptied";
+        case Processor::MailboxState::OBSTRUCTED:
+            return "obstructed";
+        default:
+            return "unknown";
+        }
+    }
+
+    int Telemetry::publishJSON(JsonWriter &json, const char *subtopic, bool retain)
+    {
+        int msg_id = -1;
+
+        // Lets the backend drop redelivered copies of this message; left out while NVS cannot back the number
+        uint32_t seq;
+        if (sequence_.Next(&seq))
+            json.AddInt("seq", seq);
+        json.AddInt("wake", wake_count_);
+
+        const char *text = json.Finish();
+        if (!text)
+        {
+            ESP_LOGE(LOG_TAG, "Message for %s does not fit in %u bytes", subtopic,
+                     static_cast<unsigned>(sizeof(message_)));
+            return msg_id;
+        }
+
+        ESP_LOGI(LOG_TAG, "%s", text);
+
+        // Publish via MQTT if connected
+        if (mqtt_publisher_ && mqtt_publisher_->IsConnected())
+        {
+            char topic[128];
+            snprintf(topic, sizeof(topic), "%s/%s", base_topic_, subtopic);
+            mqtt_publisher_->Publish(topic, text, 1, retain, &msg_id);
+        }
+
+        return msg_id;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+
+#include "esp_timer.h"
+#include "esp_log.h"
+
+#include "json_writer.hpp"
+#include "publisher.hpp"
+#include "sequence.hpp"
+#include "config.hpp"
+#include "runtime_config.hpp"
+#include "battery_policy.hpp"
+#include "digest.hpp"
+#include "processor.hpp"
+
+namespace Telemetry
+{
+    // Status fields the broker last acknowledged, used to send only what changed
+    struct StatusSnapshot
+    {
+        bool valid;                            ///< False until the first keyframe is acknowledged
+        float baseline_cm;                     ///< Acknowledged baseline distance (centimeters)
+        float threshold_cm;                    ///< Acknowledged trigger threshold (centimeters)
+        char device_ip[16];                    ///< Acknowledged device IP ("unknown" if none)
+        Processor::MailboxState mailbox_state; ///< Acknowledged mailbox state
+        uint32_t config_version;               ///< Acknowledged runtime config version
+        Hardware::Battery::PowerLevel power;   ///< Acknowledged battery power level
+        uint32_t since_keyframe;               ///< Heartbeats acknowledged since the last keyframe
+    };
+
+    // Timeline of the wake that reports an event (esp_timer microseconds of that wake, 0: not reached)
+    struct EventTrace
+    {
+        int64_t detected_us;  ///< Processing of the measurement that detected the event
+        int64_t wifi_us;      ///< Wi-Fi associated and an address assigned
+        int64_t time_sync_us; ///< SNTP synchronized, or gave up waiting
+        int64_t mqtt_us;      ///< Broker connected (CONNACK)
+        uint32_t window_ms;   ///< Sleep before the detecting measurement: the drop happened within it
+    };
+
+    // Telemetry state that must survive deep sleep (lives in RtcStore)
+    struct PersistentState
+    {
+        StatusSnapshot status;  ///< Last acknowledged status for delta heartbeats
+        SequenceState sequence; ///< Message sequence counter
+    };
+
+    class Telemetry
+    {
+    public:
+        /**
+         * Construct a new Distance Telemetry publisher
+         *
+         * Persistent state may be NULL: every status is a keyframe and sequence
+         * numbers continue from NVS. The wake counter (RtcStore boot_count) is
+         * sent with every message next to its sequence number. With a config
+         * store, the session also receives the retained {base}/config message.
+         */
+        explicit Telemetry(PersistentState *persistent_state = nullptr, uint32_t wake_count = 0,
+                           Config::RuntimeConfigStore *config_store = nullptr);
+
+        /**
+         * Initialize MQTT publishing for distance telemetry
+         *
+         * Sets up MQTT connection and configures the base topic for all telemetry messages.
+         * Messages will be published to subtopics under the base topic:
+         * - {base_topic}/events/mail_drop
+         * - {base_topic}/events/mail_collected
+         * - {base_topic}/status
+         * - {base_topic}/digest and {base_topic}/events/alarm (digest mode)
+         *
+         * With a config store, {base_topic}/config is subscribed as well.
+         *
+         * Pass TLS options to connect over mqtts:// with session resumption.
+         */
+        esp_err_t InitMQTT(const char *broker_uri,
+                           const char *base_topic,
+                           const char *client_id = nullptr,
+                           const char *username = nullptr,
+                           const char *password = nullptr,
+                           const Publisher::TlsOptions *tls = nullptr);
+
+        /**
+         * Publish telemetry based on processed distance data
+         *
+         * Determines what telemetry to emit:
+         * - If mail detected: Immediately publish mail_drop event
+         * - If mail collected: Immediately publish mail_collected event
+         * - If periodic interval elapsed: Publish status telemetry with current state
+         *
+         * ip_addr may be NULL ("unknown"). Messages are built in a fixed buffer;
+         * nothing on this path allocates.
+         */
+        void Publish(const Processor::DistanceData &data,
+                     const float baseline_cm, const float threshold_cm,
+                     const char *ip_addr);
+
+        /**
+         * Publish the digest of a period (digest mode), then the status
+         *
+         * {base_topic}/digest carries the counts of the period, the first and
+         * last drop as seconds after its start, the time spent in FULL, the
+         * lowest success rate and the alarms reported. Returns the MQTT
+         * message ID of the digest (-1 if not sent); the period is delivered
+         * once IsAcknowledged() says so.
+         */
+        int PublishDigest(const Processor::DigestState &digest, uint64_t now_us,
+                          const Processor::DistanceData &data,
+                          const float baseline_cm, const float threshold_cm,
+                          const char *ip_addr);
+
+        // Publish one {base_topic}/events/alarm per Processor::DigestAlarm in alarms; returns the ID of the last (-1 if not sent)
+        int PublishAlarms(uint8_t alarms, const Processor::DistanceData &data, const char *ip_addr);
+
+        // True once the broker acknowledged the message with this ID
+        bool IsAcknowledged(int msg_id) const;
+
+        /**
+         * Stop MQTT publishing
+         *
+         * Commits the pending status snapshot to persistent state if the broker
+         * acknowledged it, so the next heartbeat is encoded against it. A
+         * configuration received during the session is applied here, once the
+         * MQTT task has stopped, so it takes effect from the next wake on.
+         */
+        void Stop();
+
+        // Check if the MQTT session is connected to the broker
+        bool IsConnected() const;
+
+        // Battery reading for the next heartbeat ("batt_mv", "batt_pct" and "power"; left out if never set)
+        void SetBattery(uint32_t millivolts, uint8_t percent, Hardware::Battery::PowerLevel level);
+
+        // Flap damping for the next status ("unstable" and "suppressed"; left out while stable with nothing suppressed)
+        void SetStability(bool unstable, uint32_t suppressed_events);
+
+        // Wake timeline for the next events ("t_det" and "tr_*"; left out if never set)
+        void SetTrace(const EventTrace &trace);
+
+        // Subscribe to {base_topic}/{subtopic} for the rest of the session (after InitMQTT)
+        esp_err_t Subscribe(const char *subtopic, Publisher::MessageHandler handler, void *arg);
+
+        // Publish a payload to {base_topic}/{subtopic} as is: no "seq"/"wake" stamp, not logged (len 0: NUL-terminated)
+        esp_err_t PublishRaw(const char *subtopic, const char *payload, int qos = 0, int len = 0);
+
+    private:
+        static constexpr const char *LOG_TAG = "TELEMETRY";
+
+        uint64_t last_telemetry_us_ = 0;                         ///< Timestamp of last periodic telemetry emission (microseconds)
+        std::optional<Publisher::MQTTPublisher> mqtt_publisher_; ///< MQTT publisher, held in place (empty if not initialized)
+        char base_topic_[64];                                    ///< Base MQTT topic for all telemetry messages
+
+        static constexpr size_t MAX_MESSAGE_LEN = 384;
+        char message_[MAX_MESSAGE_LEN]; ///< JSON of the message being published
+
+        PersistentState *persistent_state_; ///< RTC-backed state (NULL if not persisted)
+        StatusSnapshot pending_status_;     ///< Status sent this session, committed once acknowledged
+        int pending_status_msg_id_;         ///< MQTT message ID of the pending status (-1 if none)
+        SequenceCounter sequence_;          ///< Per-message sequence numbers for backend dedupe
+        uint32_t wake_count_;               ///< Wakes since the last fresh boot
+
+        uint32_t battery_mv_;                       ///< Battery voltage for the heartbeat (0: unknown)
+        uint8_t battery_percent_;                   ///< Estimated remaining capacity (%)
+        Hardware::Battery::PowerLevel power_level_; ///< Power level the device runs at
+        bool unstable_;                             ///< Events are suppressed by flap damping
+        uint32_t suppressed_events_;                ///< Transitions suppressed in the current or just ended suppression
+        EventTrace trace_;                          ///< Timeline of this wake (detected_us 0: not traced)
+
+        static constexpr int64_t MIN_VALID_EPOCH_S = 1704067200; ///< 2024-01-01: the clock was never set before this
+
+        static constexpr size_t MAX_CONFIG_LEN = 256;
+
+        Config::RuntimeConfigStore *config_store_; ///< Runtime config (NULL: no remote configuration)
+        char pending_config_[MAX_CONFIG_LEN];      ///< Last {base}/config payload of this session
+        std::atomic<size_t> pending_config_len_;   ///< Valid bytes in pending_config_ (0 if none)
+
+        // Copy a {base}/config payload (MQTT task) for Stop() to apply
+        static void onConfigMessage(const char *data, int data_len, void *arg);
+
+        /**
+         * Emit mail drop event telemetry immediately
+         *
+         * Constructs JSON payload with:
+         * - Event type: "mail_drop"
+         * - Before/after distance measurements
+         * - Delta and duration of occlusion
+         * - Computed confidence score
+         * - Current success rate
+         * - New mailbox state (HAS_MAIL or FULL)
+         */
+        void emitMailDropEvent(const Processor::DistanceData &data, const float &baseline_cm,
+                               const char *ip_addr);
+
+        /**
+         * Emit mail collected event telemetry immediately
+         *
+         * Constructs JSON payload with:
+         * - Event type: "mail_collected"
+         * - Before/after distance measurements
+         * - Delta and duration of collection
+         * - Current success rate
+         * - New mailbox state (EMPTIED)
+         */
+        void emitMailCollectedEvent(const Processor::DistanceData &data, const float &baseline_cm,
+                                    const char *ip_addr);
+
+        /**
+         * Conditionally emit periodic status telemetry
+         *
+         * Publishes current system state at regular intervals for monitoring:
+         * - Raw and filtered distance readings
+         * - Baseline and threshold references
+         * - Measurement success rate
+         * - Current mailbox state (empty/has_mail/full/emptied)
+         *
+         * Battery voltage and capacity are sent with every heartbeat once known,
+         * and the flap damping fields while it suppresses or has just stopped.
+         * Baseline, threshold, device IP, mailbox state and power level are
+         * only included when they differ from the last acknowledged status
+         * ("kf":0). Every HEARTBEAT_KEYFRAME_INTERVAL heartbeats a full,
+         * retained keyframe ("kf":1) is sent instead, which is what the
+         * backend applies deltas to.
+         */
+        void maybeEmitPeriodic(const Processor::DistanceData &data,
+                               const float &baseline_cm, const float &threshold_cm,
+                               const char *ip_addr);
+
+        /**
+         * Calculate confidence score for mail drop detection
+         *
+         * Combines multiple factors into a single confidence metric [0.0, 1.0]:
+         * - 50% weight: Distance delta relative to trigger threshold
+         * - 30% weight: Occlusion duration relative to hold time
+         * - 20% weight: Recent measurement success rate
+         */
+        float calculateConfidence(const Processor::DistanceData &data) const;
+
+        // "full", "sensor" or "battery"
+        static const char *alarmToString(Processor::DigestAlarm alarm);
+
+        // Convert MailboxState enum to string representation
+        const char *stateToString(const Processor::MailboxState state) const;
+
+        // Stamp "seq" (when NVS backs one) and "wake", publish JSON object via MQTT and log to console, returns the MQTT message ID (-1 if not sent)
+        int publishJSON(JsonWriter &json, const char *subtopic = "telemetry", bool retain = false);
+
+        // Format the current date and time - timestamp
+        static void formatDateTime(char *buf, size_t len);
+
+        /**
+         * Add the event trace to a message
+         *
+         * "t_det" is the wall-clock time of the detection (ms since the
+         * epoch), left out until SNTP has set the clock once. "tr_wifi",
+         * "tr_ntp", "tr_mqtt" and "tr_pub" are the ms from the detection to
+         * the end of each phase, "tr_pub" being now; "tr_win" is the sleep
+         * before the detecting measurement. Together with the time the
+         * backend receives the message, they split the latency of the event
+         * into its stages.
+         */
+        void addTrace(JsonWriter &json) const;
+
+        // Start a message in message_ with the common fields
+        JsonWriter beginMessage(const char *ip_addr, const char *timestamp);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include "broker_endpoints.hpp"
+
+#include "config.hpp"
+#include "alloc_tracker.hpp"
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace Telemetry
+{
+    namespace Publisher
+    {
+        BrokerEndpoints::BrokerEndpoints(EndpointCache *cache, const char *const *uris, size_t count)
+            : cache_(cache),
+              uris_(uris),
+              count_(std::min(count, MAX_BROKER_ENDPOINTS)),
+              order_{},
+              uri_buf_{},
+              host_buf_{}
+        {
+            // FNV-1a over the list; a reflash with other brokers starts from scratch
+            uint32_t hash = 2166136261u;
+            for (size_t i = 0; i < count_; ++i)
+            {
+                for (const char *c = uris_[i]; *c; ++c)
+                    hash = (hash ^ static_cast<uint8_t>(*c)) * 16777619u;
+                hash = (hash ^ 0xFFu) * 16777619u;
+            }
+
+            if (!cache_->valid || cache_->list_hash != hash)
+            {
+                *cache_ = {};
+                cache_->valid = true;
+                cache_->list_hash = hash;
+                for (auto &endpoint : cache_->endpoints)
+                    endpoint.score = 50;
+            }
+
+            for (size_t i = 0; i < count_; ++i)
+                order_[i] = static_cast<uint8_t>(i);
+        }
+
+        void BrokerEndpoints::Begin(uint64_t now_us)
+        {
+            const uint64_t holddown_us = Config::MQTT_ENDPOINT_HOLDDOWN_SEC * 1000000ULL;
+            const auto rank = [&](size_t i)
+            {
+                const EndpointHealth &e = cache_->endpoints[i];
+                if (e.ok_us > e.failed_us)
+                    return 0; // Last attempt connected
+                if (e.failed_us != 0 && now_us - e.failed_us < holddown_us)
+                    return 2; // Failed recently
+                return 1;
+            };
+
+            // At most MAX_BROKER_ENDPOINTS entries: a stable insertion sort keeps the list order on ties
+            for (size_t i = 1; i < count_; ++i)
+            {
+                const uint8_t index = order_[i];
+                size_t j = i;
+                while (j > 0)
+                {
+                    const EndpointHealth &a = cache_->endpoints[index];
+                    const EndpointHealth &b = cache_->endpoints[order_[j - 1]];
+                    const int ra = rank(index), rb = rank(order_[j - 1]);
+                    bool before;
+                    if (ra != rb)
+                        before = ra < rb;
+                    else if (ra == 0)
+                        before = a.ok_us > b.ok_us; // Most recently healthy first
+                    else
+                        before = a.score > b.score;
+                    if (!before)
+                        break;
+                    order_[j] = order_[j - 1];
+                    --j;
+                }
+                order_[j] = index;
+            }
+        }
+
+        const char *BrokerEndpoints::Uri(size_t index, uint64_t now_us)
+        {
+            const char *uri = uris_[index];
+            size_t host_start, host_len;
+            if (!splitUri(uri, &host_start, &host_len))
+                return uri;
+
+            EndpointHealth &endpoint = cache_->endpoints[index];
+            const bool fresh = endpoint.ipv4 != 0 &&
+                               now_us - endpoint.resolved_us < Config::MQTT_DNS_CACHE_SEC * 1000000ULL;
+            if (!fresh && !resolve(index, Host(index), now_us))
+                return uri;
+
+            const uint8_t *ip = reinterpret_cast<const uint8_t *>(&endpoint.ipv4);
+            snprintf(uri_buf_, sizeof(uri_buf_), "%.*s%u.%u.%u.%u%s", static_cast<int>(host_start), uri,
+                     ip[0], ip[1], ip[2], ip[3], uri + host_start + host_len);
+            return uri_buf_;
+        }
+
+        const char *BrokerEndpoints::Host(size_t index)
+        {
+            size_t host_start, host_len;
+            if (!splitUri(uris_[index], &host_start, &host_len))
+                return nullptr;
+
+            const size_t len = std::min(host_len, sizeof(host_buf_) - 1);
+            memcpy(host_buf_, uris_[index] + host_start, len);
+            host_buf_[len] = '\0';
+            return host_buf_;
+        }
+
+        void BrokerEndpoints::Connected(size_t index, uint64_t now_us, uint32_t connect_ms)
+        {
+            EndpointHealth &endpoint = cache_->endpoints[index];
+            endpoint.score = static_cast<uint8_t>((3 * endpoint.score + 100) / 4);
+            endpoint.ok_us = std::max<uint64_t>(now_us, 1);
+            endpoint.connect_ms = connect_ms;
+        }
+
+        void BrokerEndpoints::Failed(size_t index, uint64_t now_us)
+        {
+            EndpointHealth &endpoint = cache_->endpoints[index];
+            endpoint.score = static_cast<uint8_t>(3 * endpoint.score / 4);
+            endpoint.failed_us = std::max<uint64_t>(now_us, 1);
+            endpoint.ipv4 = 0;
+            ESP_LOGW(LOG_TAG, "Broker %s missed the %lu ms connect deadline (score %u)", uris_[index],
+                     static_cast<unsigned long>(Config::MQTT_CONNECT_DEADLINE_MS), endpoint.score);
+        }
+
+        bool BrokerEndpoints::splitUri(const char *uri, size_t *host_start, size_t *host_len)
+        {
+            const char *scheme_end = strstr(uri, "://");
+            if (!scheme_end)
+                return false;
+
+            const char *host = scheme_end + 3;
+            const size_t len = strcspn(host, ":/");
+            if (len == 0)
+                return false;
+
+            *host_start = static_cast<size_t>(host - uri);
+            *host_len = len;
+            return true;
+        }
+
+        bool BrokerEndpoints::resolve(size_t index, const char *host, uint64_t now_us)
+        {
+            // An address needs no lookup, and keeps the URI as configured
+            if (!host || strspn(host, "0123456789.") == strlen(host))
+                return false;
+
+            // lwIP allocates the result list
+            Diagnostics::AllocTracker::Exempt exempt;
+
+            addrinfo hints = {};
+            hints.ai_family = AF_INET;
+            hints.ai_socktype = SOCK_STREAM;
+            addrinfo *result = nullptr;
+            const int err = getaddrinfo(host, nullptr, &hints, &result);
+            if (err != 0 || !result)
+            {
+                ESP_LOGW(LOG_TAG, "Cannot resolve %s (%d)", host, err);
+                return false;
+            }
+
+            EndpointHealth &endpoint = cache_->endpoints[index];
+            endpoint.ipv4 = reinterpret_cast<const sockaddr_in *>(result->ai_addr)->sin_addr.s_addr;
+            endpoint.resolved_us = now_us;
+            freeaddrinfo(result);
+            ESP_LOGI(LOG_TAG, "Resolved %s, cached for %lu s", host,
+                     static_cast<unsigned long>(Config::MQTT_DNS_CACHE_SEC));
+            return endpoint.ipv4 != 0;
+        }
+    }
+}
\ No newline at end of file
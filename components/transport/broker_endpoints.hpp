@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_log.h"
+
+namespace Telemetry
+{
+    namespace Publisher
+    {
+        static constexpr size_t MAX_BROKER_ENDPOINTS = 4;
+
+        // Health and cached address of one broker
+        struct EndpointHealth
+        {
+            uint8_t score;        ///< 0..100, moving average of connect outcomes (50: never tried)
+            uint32_t ipv4;        ///< Resolved address (network byte order), 0 if none cached
+            uint64_t resolved_us; ///< Virtual time ipv4 was resolved
+            uint64_t ok_us;       ///< Virtual time of the last CONNACK (0: never)
+            uint64_t failed_us;   ///< Virtual time of the last missed connect deadline (0: never)
+            uint32_t connect_ms;  ///< Time to CONNACK of the last successful connect
+        };
+
+        // Broker endpoint state kept in RTC memory between deep sleep cycles
+        struct EndpointCache
+        {
+            bool valid;                                     ///< False after power loss or a change of the endpoint list
+            uint32_t list_hash;                             ///< Hash of the URIs the entries belong to
+            EndpointHealth endpoints[MAX_BROKER_ENDPOINTS]; ///< In the order of the configured list
+        };
+
+        /**
+         * Ordered broker list with failover
+         *
+         * Begin() orders the configured brokers for this session: the one that
+         * connected most recently first, then by health score, then in list
+         * order. A broker that missed its connect deadline is tried last for
+         * Config::MQTT_ENDPOINT_HOLDDOWN_SEC. The caller tries them in that
+         * order, each for Config::MQTT_CONNECT_DEADLINE_MS, and reports every
+         * outcome, which moves the score.
+         *
+         * Host names are resolved once and kept for Config::MQTT_DNS_CACHE_SEC
+         * in RTC, so most sessions skip the DNS round trip: Uri() hands out the
+         * URI with the cached address instead of the name. A TLS connection to
+         * that address checks the certificate against Host(). A missed deadline
+         * drops the cached address, in case the broker moved.
+         */
+        class BrokerEndpoints
+        {
+        public:
+            // Endpoints over the RTC cache (uris: up to MAX_BROKER_ENDPOINTS, further ones are ignored)
+            BrokerEndpoints(EndpointCache *cache, const char *const *uris, size_t count);
+
+            // Order the endpoints for a session starting at now_us
+            void Begin(uint64_t now_us);
+
+            // Number of endpoints
+            size_t Count() const { return count_; }
+
+            // Endpoint to try as the given attempt of the session (0: first)
+            size_t Pick(size_t attempt) const { return order_[attempt < count_ ? attempt : 0]; }
+
+            /**
+             * URI to connect an endpoint with
+             *
+             * Resolves the host name if no fresh address is cached (the network
+             * must be up), and returns the URI with the address in place of the
+             * name. Without an address (resolution failed, or the host is an
+             * address already), returns the configured URI. Valid until the next
+             * call.
+             */
+            const char *Uri(size_t index, uint64_t now_us);
+
+            // Host name of an endpoint, for the TLS certificate check; valid until the next call
+            const char *Host(size_t index);
+
+            // The endpoint sent CONNACK after connect_ms
+            void Connected(size_t index, uint64_t now_us, uint32_t connect_ms);
+
+            // The endpoint missed its connect deadline
+            void Failed(size_t index, uint64_t now_us);
+
+            const EndpointHealth &Health(size_t index) const { return cache_->endpoints[index]; }
+
+        private:
+            static constexpr const char *LOG_TAG = "ENDPOINTS";
+
+            EndpointCache *cache_;                ///< RTC-backed state
+            const char *const *uris_;             ///< Configured broker URIs
+            size_t count_;                        ///< Endpoints in use
+            uint8_t order_[MAX_BROKER_ENDPOINTS]; ///< Endpoint indexes in the order of this session
+            char uri_buf_[128];                   ///< URI handed out by Uri()
+            char host_buf_[64];                   ///< Host name handed out by Host()
+
+            // Locate the host in scheme://host[:port][/path]; false if there is none
+            static bool splitUri(const char *uri, size_t *host_start, size_t *host_len);
+
+            // Resolve the host name of an endpoint into the cache
+            bool resolve(size_t index, const char *host, uint64_t now_us);
+        };
+    }
+}
\ No newline at end of file
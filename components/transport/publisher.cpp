@@ -0,0 +1,268 @@
+#include "publisher.hpp"
+
+#include "esp_log.h"
+
+#include "config.hpp"
+#include "alloc_tracker.hpp"
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#include "tls_transport.hpp"
+
+#include <new>
+#endif
+
+#include <cstring>
+
+namespace Telemetry
+{
+    namespace Publisher
+    {
+#if defined(ESP_PLATFORM) && CONFIG_MAILBOX_MQTT_TLS
+        // A device runs one publisher at a time, so its TLS transport has a fixed home
+        alignas(TlsTransport) static uint8_t s_tls_transport_storage[sizeof(TlsTransport)];
+#endif
+
+        MQTTPublisher::MQTTPublisher()
+            : client_(nullptr), tls_transport_(nullptr), connected_(false), acked_next_(0),
+              subscription_count_(0)
+        {
+            for (auto &id : acked_ids_)
+                id = -1;
+        }
+
+        MQTTPublisher::~MQTTPublisher()
+        {
+            Diagnostics::AllocTracker::Exempt exempt;
+            if (client_)
+                esp_mqtt_client_destroy(client_);
+
+#if defined(ESP_PLATFORM) && CONFIG_MAILBOX_MQTT_TLS
+            // The client destroyed the transport handle; what is left is the TLS state behind it
+            if (tls_transport_)
+                tls_transport_->~TlsTransport();
+#endif
+        }
+
+        esp_err_t MQTTPublisher::Init(const char *broker_uri, const char *client_id,
+                                      const char *username, const char *password,
+                                      const TlsOptions *tls)
+        {
+            // The MQTT client and its transport allocate their buffers and outbox
+            Diagnostics::AllocTracker::Exempt exempt;
+
+            esp_mqtt_client_config_t mqtt_cfg = {};
+            mqtt_cfg.broker.address.uri = broker_uri;
+
+#if defined(ESP_PLATFORM) && CONFIG_MAILBOX_MQTT_TLS
+            if (tls && strncmp(broker_uri, "mqtts://", 8) == 0)
+            {
+                tls_transport_ = new (s_tls_transport_storage) TlsTransport(*tls);
+                mqtt_cfg.network.transport = tls_transport_->Create();
+                if (!mqtt_cfg.network.transport)
+                {
+                    ESP_LOGE(LOG_TAG, "Failed to create TLS transport");
+                    return ESP_FAIL;
+                }
+            }
+#elif defined(ESP_PLATFORM)
+            // esp-mqtt's own SSL transport: full handshake on every connect, no session cache
+            if (tls && strncmp(broker_uri, "mqtts://", 8) == 0)
+            {
+                mqtt_cfg.broker.verification.certificate = tls->ca_cert_pem;
+                mqtt_cfg.broker.verification.common_name = tls->server_name;
+            }
+#endif
+
+            if (client_id)
+                mqtt_cfg.credentials.client_id = client_id;
+
+            if (username)
+                mqtt_cfg.credentials.username = username;
+
+            if (password)
+                mqtt_cfg.credentials.authentication.password = password;
+
+            // Configure connection parameters
+            mqtt_cfg.session.keepalive = 60;                 // Send keepalive ping every 60 seconds
+            // A connect stuck past the deadline would block the destroy at failover: give it no more
+            mqtt_cfg.network.timeout_ms = Config::MQTT_CONNECT_DEADLINE_MS;
+            mqtt_cfg.network.reconnect_timeout_ms = Config::MQTT_RECONNECT_TIMEOUT_MS;
+            mqtt_cfg.network.disable_auto_reconnect = false; // Enable automatic reconnection
+            mqtt_cfg.buffer.size = Config::MQTT_BUFFER_SIZE;  // Receive firmware update chunks in one piece
+
+            client_ = esp_mqtt_client_init(&mqtt_cfg);
+            if (!client_)
+            {
+                ESP_LOGE(LOG_TAG, "Failed to initialize MQTT client");
+                return ESP_FAIL;
+            }
+
+            esp_err_t err = esp_mqtt_client_register_event(client_,
+                                                           MQTT_EVENT_ANY,
+                                                           mqttEventHandler,
+                                                           this);
+            if (err != ESP_OK)
+            {
+                ESP_LOGE(LOG_TAG, "Failed to register MQTT event handler: %s",
+                         esp_err_to_name(err));
+                return err;
+            }
+
+            ESP_LOGI(LOG_TAG, "MQTT client initialized: %s", broker_uri);
+            return ESP_OK;
+        }
+
+        esp_err_t MQTTPublisher::Start()
+        {
+            if (!client_)
+            {
+                ESP_LOGE(LOG_TAG, "MQTT client not initialized");
+                return ESP_ERR_INVALID_STATE;
+            }
+
+            Diagnostics::AllocTracker::Exempt exempt;
+            esp_err_t err = esp_mqtt_client_start(client_);
+            if (err != ESP_OK)
+            {
+                ESP_LOGE(LOG_TAG, "Failed to start MQTT client: %s",
+                         esp_err_to_name(err));
+            }
+            return err;
+        }
+
+        esp_err_t MQTTPublisher::Stop()
+        {
+            if (!client_)
+                return ESP_ERR_INVALID_STATE;
+
+            Diagnostics::AllocTracker::Exempt exempt;
+            return esp_mqtt_client_stop(client_);
+        }
+
+        esp_err_t MQTTPublisher::Publish(const char *topic, const char *json, int qos,
+                                         bool retain, int *msg_id_out, int len)
+        {
+            if (!client_ || !connected_)
+            {
+                ESP_LOGW(LOG_TAG, "Cannot publish: not connected");
+                return ESP_ERR_INVALID_STATE;
+            }
+
+            // Publish message to MQTT broker (QoS 1 copies it into the client's outbox)
+            int msg_id;
+            {
+                Diagnostics::AllocTracker::Exempt exempt;
+                msg_id = esp_mqtt_client_publish(client_, topic, json, len, qos, retain ? 1 : 0);
+            }
+            if (msg_id < 0)
+            {
+                ESP_LOGE(LOG_TAG, "Failed to publish message");
+                return ESP_FAIL;
+            }
+
+            if (msg_id_out)
+                *msg_id_out = msg_id;
+
+            ESP_LOGD(LOG_TAG, "Published to %s, msg_id=%d", topic, msg_id);
+            return ESP_OK;
+        }
+
+        esp_err_t MQTTPublisher::Subscribe(const char *topic, int qos, MessageHandler handler, void *arg)
+        {
+            if (!client_ || !topic || !handler || strlen(topic) >= sizeof(Subscription::topic))
+                return ESP_ERR_INVALID_ARG;
+            if (subscription_count_ >= MAX_SUBSCRIPTIONS)
+                return ESP_ERR_NO_MEM;
+
+            Subscription &subscription = subscriptions_[subscription_count_];
+            strcpy(subscription.topic, topic);
+            subscription.qos = qos;
+            subscription.handler = handler;
+            subscription.arg = arg;
+            ++subscription_count_;
+
+            // Otherwise sent on MQTT_EVENT_CONNECTED
+            Diagnostics::AllocTracker::Exempt exempt;
+            if (connected_ && esp_mqtt_client_subscribe(client_, subscription.topic, subscription.qos) < 0)
+            {
+                ESP_LOGE(LOG_TAG, "Failed to subscribe to %s", subscription.topic);
+                return ESP_FAIL;
+            }
+            return ESP_OK;
+        }
+
+        bool MQTTPublisher::IsConnected() const { return connected_; }
+
+        bool MQTTPublisher::IsAcknowledged(int msg_id) const
+        {
+            for (const auto &id : acked_ids_)
+            {
+                if (id == msg_id)
+                    return true;
+            }
+            return false;
+        }
+
+        void MQTTPublisher::mqttEventHandler(void *handler_args, esp_event_base_t base,
+                                             int32_t event_id, void *event_data)
+        {
+            auto *publisher = static_cast<MQTTPublisher *>(handler_args);
+            auto *event = static_cast<esp_mqtt_event_handle_t>(event_data);
+            publisher->handleEvent(event);
+        }
+
+        void MQTTPublisher::handleEvent(esp_mqtt_event_handle_t event)
+        {
+            switch (event->event_id)
+            {
+            case MQTT_EVENT_CONNECTED:
+                ESP_LOGI(LOG_TAG, "Connected to MQTT broker");
+                connected_ = true;
+                for (size_t i = 0; i < subscription_count_; ++i)
+                    esp_mqtt_client_subscribe(client_, subscriptions_[i].topic, subscriptions_[i].qos);
+                break;
+
+            case MQTT_EVENT_DISCONNECTED:
+                ESP_LOGI(LOG_TAG, "Disconnected from MQTT broker");
+                connected_ = false;
+                break;
+
+            case MQTT_EVENT_PUBLISHED:
+                ESP_LOGD(LOG_TAG, "Message published, msg_id=%d", event->msg_id);
+                acked_ids_[acked_next_++ % ACKED_HISTORY] = event->msg_id;
+                break;
+
+            case MQTT_EVENT_DATA:
+                if (event->data_len != event->total_data_len)
+                {
+                    ESP_LOGW(LOG_TAG, "Dropping fragmented message (%d bytes)", event->total_data_len);
+                    break;
+                }
+                for (size_t i = 0; i < subscription_count_; ++i)
+                {
+                    const Subscription &subscription = subscriptions_[i];
+                    if (static_cast<size_t>(event->topic_len) == strlen(subscription.topic) &&
+                        memcmp(event->topic, subscription.topic, event->topic_len) == 0)
+                    {
+                        subscription.handler(event->data, event->data_len, subscription.arg);
+                        break;
+                    }
+                }
+                break;
+
+            case MQTT_EVENT_ERROR:
+                ESP_LOGE(LOG_TAG, "MQTT error occurred");
+                if (event->error_handle->error_type == MQTT_ERROR_TYPE_TCP_TRANSPORT)
+                {
+                    ESP_LOGE(LOG_TAG, "TCP transport error: 0x%x",
+                             event->error_handle->esp_tls_last_esp_err);
+                }
+                break;
+
+            default:
+                break;
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "mqtt_client.h"
+
+#include <array>
+#include <atomic>
+
+namespace Telemetry
+{
+    namespace Publisher
+    {
+        class TlsTransport;
+        struct TlsOptions;
+
+        // Receives messages on a subscribed topic (called from the MQTT task, data is not NUL-terminated)
+        using MessageHandler = void (*)(const char *data, int data_len, void *arg);
+
+        class MQTTPublisher
+        {
+        public:
+            MQTTPublisher();
+
+            ~MQTTPublisher();
+
+            /**
+             * Initialize MQTT client with broker configuration
+             *
+             * For mqtts:// URIs with TLS options, the connection runs over TlsTransport
+             * so the TLS session can be resumed from RTC memory on the next wake.
+             */
+            esp_err_t Init(const char *broker_uri,
+                           const char *client_id = nullptr,
+                           const char *username = nullptr,
+                           const char *password = nullptr,
+                           const TlsOptions *tls = nullptr);
+
+            // Start MQTT client and initiate connection to broker
+            esp_err_t Start();
+
+            // Stop MQTT client and disconnect from broker
+            esp_err_t Stop();
+
+            // Publish JSON string to specified MQTT topic (msg_id receives the MQTT message ID if not NULL)
+            // A binary payload passes its length; len 0 takes the string length
+            esp_err_t Publish(const char *topic, const char *json, int qos = 1,
+                              bool retain = false, int *msg_id = nullptr, int len = 0);
+
+            /**
+             * Subscribe to a topic for the lifetime of the client
+             *
+             * Up to MAX_SUBSCRIPTIONS topics, matched exactly (no wildcards).
+             * Subscriptions are (re)sent on every connect, so they may be set
+             * up before Start(). Messages split over several MQTT_EVENT_DATA
+             * events (larger than Config::MQTT_BUFFER_SIZE) are dropped.
+             */
+            esp_err_t Subscribe(const char *topic, int qos, MessageHandler handler, void *arg);
+
+            // Check if MQTT client is currently connected to broker
+            bool IsConnected() const;
+
+            // Check if the broker acknowledged (PUBACK) the message with the given ID
+            bool IsAcknowledged(int msg_id) const;
+
+        private:
+            static constexpr const char *LOG_TAG = "PUBLISHER";
+
+            esp_mqtt_client_handle_t client_; ///< Handle to ESP-IDF MQTT client
+            TlsTransport *tls_transport_;     ///< TLS transport with session resumption (NULL for plain MQTT)
+            std::atomic<bool> connected_;     ///< Connection status flag
+
+            static constexpr size_t ACKED_HISTORY = 8;
+            std::array<std::atomic<int>, ACKED_HISTORY> acked_ids_; ///< Recently acknowledged message IDs
+            std::atomic<size_t> acked_next_;                        ///< Next slot to overwrite in acked_ids_
+
+            struct Subscription
+            {
+                char topic[128];        ///< Topic subscribed on connect
+                int qos;                ///< QoS of the subscription
+                MessageHandler handler; ///< Receiver of messages on topic
+                void *arg;              ///< Passed to handler
+            };
+
+            static constexpr size_t MAX_SUBSCRIPTIONS = 6;
+            Subscription subscriptions_[MAX_SUBSCRIPTIONS]; ///< Topics subscribed on connect
+            size_t subscription_count_;                     ///< Valid entries in subscriptions_
+
+            // Static event handler callback for MQTT events
+            static void mqttEventHandler(void *handler_args, esp_event_base_t base,
+                                         int32_t event_id, void *event_data);
+
+            // Handle MQTT events (connected, disconnected, published, error)
+            void handleEvent(esp_mqtt_event_handle_t event);
+        };
+    }
+}
\ No newline at end of file
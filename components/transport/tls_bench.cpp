@@ -0,0 +1,124 @@
+#include "tls_bench.hpp"
+#include "tls_transport.hpp"
+
+#include "esp_log.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace Telemetry
+{
+    namespace Publisher
+    {
+        namespace
+        {
+            constexpr const char *LOG_TAG = "TLS_BENCH";
+            constexpr int CONNECT_TIMEOUT_MS = 10000;
+
+            // Handshakes of one kind
+            struct Series
+            {
+                int64_t *duration_us; ///< One per handshake, sorted before logging
+                uint32_t count;
+                uint64_t bytes_tx;
+                uint64_t bytes_rx;
+            };
+
+            void record(Series *series, const TlsHandshakeStats &stats)
+            {
+                series->duration_us[series->count++] = stats.duration_us;
+                series->bytes_tx += stats.bytes_tx;
+                series->bytes_rx += stats.bytes_rx;
+            }
+
+            void logSeries(const char *kind, Series *series)
+            {
+                if (series->count == 0)
+                {
+                    ESP_LOGW(LOG_TAG, "%s: no successful handshake", kind);
+                    return;
+                }
+                std::sort(series->duration_us, series->duration_us + series->count);
+                ESP_LOGI(LOG_TAG, "%s: %lu handshakes, median %.1f ms (%.1f..%.1f), tx %lu B, rx %lu B", kind,
+                         static_cast<unsigned long>(series->count), series->duration_us[series->count / 2] / 1000.0,
+                         series->duration_us[0] / 1000.0, series->duration_us[series->count - 1] / 1000.0,
+                         static_cast<unsigned long>(series->bytes_tx / series->count),
+                         static_cast<unsigned long>(series->bytes_rx / series->count));
+            }
+
+            // "mqtts://host[:port][/path]"; false if there is no host
+            bool splitUri(const char *uri, char *host, size_t host_size, int *port)
+            {
+                const char *start = strstr(uri, "://");
+                start = start ? start + 3 : uri;
+                const size_t len = strcspn(start, ":/");
+                if (len == 0 || len >= host_size)
+                    return false;
+                memcpy(host, start, len);
+                host[len] = '\0';
+                *port = start[len] == ':' ? atoi(start + len + 1) : 8883;
+                return true;
+            }
+        }
+
+        void RunHandshakeBenchmark(const char *uri, const char *ca_cert_pem, uint32_t rounds)
+        {
+            char host[64];
+            int port = 0;
+            if (!splitUri(uri, host, sizeof(host), &port))
+            {
+                ESP_LOGE(LOG_TAG, "No host in %s", uri);
+                return;
+            }
+
+            static TlsSessionCache cache;
+            const TlsOptions options = {.ca_cert_pem = ca_cert_pem,
+                                        .session_cache = &cache,
+                                        .now_us = 0,
+                                        .session_max_age_us = UINT64_MAX,
+                                        .server_name = nullptr};
+            TlsTransport *tls = new TlsTransport(options);
+            esp_transport_handle_t transport = tls->Create();
+            int64_t *durations = new int64_t[3 * rounds]; // A declined session counts as a second full handshake
+            if (!transport)
+            {
+                delete[] durations;
+                delete tls;
+                return;
+            }
+
+            ESP_LOGI(LOG_TAG, "Timing %lu full and resumed handshakes with %s:%d", static_cast<unsigned long>(rounds),
+                     host, port);
+            Series full = {durations, 0, 0, 0};
+            Series resumed = {durations + 2 * rounds, 0, 0, 0};
+            uint32_t offered = 0;
+            uint32_t accepted = 0;
+            for (uint32_t round = 0; round < rounds; ++round)
+            {
+                cache.len = 0;
+                if (esp_transport_connect(transport, host, port, CONNECT_TIMEOUT_MS) != 0)
+                    continue;
+                record(&full, tls->GetStats());
+                esp_transport_close(transport);
+
+                if (esp_transport_connect(transport, host, port, CONNECT_TIMEOUT_MS) != 0)
+                    continue;
+                const TlsHandshakeStats &stats = tls->GetStats();
+                offered += stats.offered_session;
+                accepted += stats.resumed;
+                record(stats.resumed ? &resumed : &full, stats);
+                esp_transport_close(transport);
+            }
+
+            logSeries("full", &full);
+            logSeries("resumed", &resumed);
+            ESP_LOGI(LOG_TAG, "Broker resumed %lu of %lu offered sessions", static_cast<unsigned long>(accepted),
+                     static_cast<unsigned long>(offered));
+
+            esp_transport_destroy(transport);
+            delete[] durations;
+            delete tls;
+        }
+    }
+}
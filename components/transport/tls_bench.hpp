@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Telemetry
+{
+    namespace Publisher
+    {
+        /**
+         * Time full against resumed TLS handshakes with one mqtts:// broker
+         *
+         * Each round connects twice through TlsTransport: once with an empty
+         * session cache (full handshake), once offering the session the first
+         * connect left (resumed, if the broker accepts it). Logs the median
+         * handshake time and the mean bytes on the wire of both kinds, and how
+         * many offered sessions the broker actually resumed. Needs Wi-Fi up and
+         * the clock set if the CA certificate is checked.
+         */
+        void RunHandshakeBenchmark(const char *uri, const char *ca_cert_pem, uint32_t rounds);
+    }
+}
@@ -0,0 +1,487 @@
+#include "tls_transport.hpp"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "mbedtls/error.h"
+#include "mbedtls/sha256.h"
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+namespace Telemetry
+{
+    namespace Publisher
+    {
+        TlsTransport::TlsTransport(const TlsOptions &options)
+            : ca_cert_pem_(options.ca_cert_pem),
+              session_cache_(options.session_cache),
+              now_us_(options.now_us),
+              session_max_age_us_(options.session_max_age_us),
+              server_name_(options.server_name),
+              config_ready_(false),
+              connected_(false),
+              stats_{},
+              io_timeout_ms_(0),
+              master_tag_{}
+        {
+            mbedtls_net_init(&net_);
+            mbedtls_ssl_init(&ssl_);
+            mbedtls_ssl_config_init(&conf_);
+            mbedtls_entropy_init(&entropy_);
+            mbedtls_ctr_drbg_init(&ctr_drbg_);
+            mbedtls_x509_crt_init(&ca_cert_);
+        }
+
+        TlsTransport::~TlsTransport()
+        {
+            closeConnection();
+            mbedtls_x509_crt_free(&ca_cert_);
+            mbedtls_ssl_config_free(&conf_);
+            mbedtls_ctr_drbg_free(&ctr_drbg_);
+            mbedtls_entropy_free(&entropy_);
+        }
+
+        esp_transport_handle_t TlsTransport::Create()
+        {
+            if (!config_ready_)
+            {
+                int ret = setupConfig();
+                if (ret != 0)
+                {
+                    ESP_LOGE(LOG_TAG, "Failed to set up TLS configuration: -0x%04x", -ret);
+                    return nullptr;
+                }
+                config_ready_ = true;
+            }
+
+            esp_transport_handle_t transport = esp_transport_init();
+            if (!transport)
+            {
+                ESP_LOGE(LOG_TAG, "Failed to allocate transport");
+                return nullptr;
+            }
+
+            esp_transport_set_context_data(transport, this);
+            esp_transport_set_func(transport, connectFunc, readFunc, writeFunc, closeFunc,
+                                   pollReadFunc, pollWriteFunc, destroyFunc);
+            esp_transport_set_default_port(transport, 8883);
+
+            return transport;
+        }
+
+        const TlsHandshakeStats &TlsTransport::GetStats() const { return stats_; }
+
+        int TlsTransport::setupConfig()
+        {
+            static constexpr const char *DRBG_PERS = "mailbox-tls";
+
+            int ret = mbedtls_ctr_drbg_seed(&ctr_drbg_, mbedtls_entropy_func, &entropy_,
+                                            reinterpret_cast<const unsigned char *>(DRBG_PERS),
+                                            strlen(DRBG_PERS));
+            if (ret != 0)
+                return ret;
+
+            ret = mbedtls_ssl_config_defaults(&conf_, MBEDTLS_SSL_IS_CLIENT,
+                                              MBEDTLS_SSL_TRANSPORT_STREAM,
+                                              MBEDTLS_SSL_PRESET_DEFAULT);
+            if (ret != 0)
+                return ret;
+
+            if (ca_cert_pem_)
+            {
+                ret = mbedtls_x509_crt_parse(&ca_cert_, reinterpret_cast<const unsigned char *>(ca_cert_pem_),
+                                             strlen(ca_cert_pem_) + 1);
+                if (ret != 0)
+                    return ret;
+
+                mbedtls_ssl_conf_ca_chain(&conf_, &ca_cert_, nullptr);
+                mbedtls_ssl_conf_authmode(&conf_, MBEDTLS_SSL_VERIFY_REQUIRED);
+            }
+            else
+            {
+                ESP_LOGW(LOG_TAG, "No CA certificate configured - broker identity is NOT verified");
+                mbedtls_ssl_conf_authmode(&conf_, MBEDTLS_SSL_VERIFY_NONE);
+            }
+
+            mbedtls_ssl_conf_rng(&conf_, mbedtls_ctr_drbg_random, &ctr_drbg_);
+
+            // TLS 1.3 delivers tickets after the handshake, which we would have to
+            // wait for before sleeping. TLS 1.2 hands us a resumable session as soon
+            // as the handshake completes.
+            mbedtls_ssl_conf_max_tls_version(&conf_, MBEDTLS_SSL_VERSION_TLS1_2);
+            mbedtls_ssl_conf_session_tickets(&conf_, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+
+            return 0;
+        }
+
+        void TlsTransport::restoreSession()
+        {
+            stats_.offered_session = false;
+
+            if (!session_cache_ || session_cache_->len == 0)
+                return;
+
+            if (now_us_ - session_cache_->saved_at_us > session_max_age_us_)
+            {
+                ESP_LOGI(LOG_TAG, "Cached TLS session expired, doing full handshake");
+                session_cache_->len = 0;
+                return;
+            }
+
+            mbedtls_ssl_session session;
+            mbedtls_ssl_session_init(&session);
+
+            int ret = mbedtls_ssl_session_load(&session, session_cache_->data, session_cache_->len);
+            if (ret == 0)
+                ret = mbedtls_ssl_set_session(&ssl_, &session);
+
+            if (ret == 0)
+            {
+                stats_.offered_session = true;
+            }
+            else
+            {
+                ESP_LOGW(LOG_TAG, "Discarding unusable cached TLS session: -0x%04x", -ret);
+                session_cache_->len = 0;
+            }
+
+            mbedtls_ssl_session_free(&session);
+        }
+
+        void TlsTransport::saveSession()
+        {
+            if (!session_cache_)
+                return;
+
+            mbedtls_ssl_session session;
+            mbedtls_ssl_session_init(&session);
+
+            size_t len = 0;
+            int ret = mbedtls_ssl_get_session(&ssl_, &session);
+            if (ret == 0)
+                ret = mbedtls_ssl_session_save(&session, session_cache_->data, sizeof(session_cache_->data), &len);
+
+            if (ret == 0)
+            {
+                // A resumed session keeps its original lifetime on the broker side
+                if (!stats_.resumed)
+                    session_cache_->saved_at_us = now_us_;
+                session_cache_->len = static_cast<uint16_t>(len);
+                memcpy(session_cache_->master_tag, master_tag_, sizeof(master_tag_));
+            }
+            else
+            {
+                ESP_LOGW(LOG_TAG, "Failed to cache TLS session (need %u bytes): -0x%04x",
+                         static_cast<unsigned>(len), -ret);
+                session_cache_->len = 0;
+            }
+
+            mbedtls_ssl_session_free(&session);
+        }
+
+        void TlsTransport::closeConnection()
+        {
+            if (connected_)
+                mbedtls_ssl_close_notify(&ssl_);
+
+            mbedtls_ssl_free(&ssl_);
+            mbedtls_net_free(&net_);
+            mbedtls_ssl_init(&ssl_);
+            mbedtls_net_init(&net_);
+            connected_ = false;
+        }
+
+        int TlsTransport::connectSocket(const char *host, int port, int timeout_ms)
+        {
+            char port_str[8];
+            snprintf(port_str, sizeof(port_str), "%d", port);
+
+            addrinfo hints = {};
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+            hints.ai_protocol = IPPROTO_TCP;
+            addrinfo *addrs = nullptr;
+            if (getaddrinfo(host, port_str, &hints, &addrs) != 0 || !addrs)
+                return -1;
+
+            const int64_t deadline_us = esp_timer_get_time() + static_cast<int64_t>(timeout_ms) * 1000;
+            int fd = -1;
+            for (const addrinfo *addr = addrs; addr && fd < 0; addr = addr->ai_next)
+            {
+                const int64_t left_us = deadline_us - esp_timer_get_time();
+                if (left_us <= 0)
+                    break;
+
+                fd = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+                if (fd < 0)
+                    continue;
+
+                // Non-blocking, so an unreachable broker costs timeout_ms and not the TCP retry limit
+                const int flags = fcntl(fd, F_GETFL, 0);
+                fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+                int ret = ::connect(fd, addr->ai_addr, addr->ai_addrlen);
+                if (ret != 0 && errno == EINPROGRESS)
+                {
+                    fd_set writeset;
+                    FD_ZERO(&writeset);
+                    FD_SET(fd, &writeset);
+                    struct timeval tv = {static_cast<long>(left_us / 1000000), static_cast<long>(left_us % 1000000)};
+                    int error = 0;
+                    socklen_t error_len = sizeof(error);
+                    ret = (select(fd + 1, nullptr, &writeset, nullptr, &tv) > 0 &&
+                           getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &error_len) == 0 && error == 0)
+                              ? 0
+                              : -1;
+                }
+
+                if (ret == 0)
+                {
+                    // Blocking again for the record layer; reads are bounded by select, writes by the send timeout
+                    fcntl(fd, F_SETFL, flags);
+                    struct timeval send_tv = {timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+                    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &send_tv, sizeof(send_tv));
+                }
+                else
+                {
+                    close(fd);
+                    fd = -1;
+                }
+            }
+            freeaddrinfo(addrs);
+            return fd;
+        }
+
+        int TlsTransport::connect(const char *host, int port, int timeout_ms)
+        {
+            closeConnection();
+            stats_ = {};
+            memset(master_tag_, 0, sizeof(master_tag_));
+
+            const int64_t start_us = esp_timer_get_time();
+            const int64_t deadline_us = start_us + static_cast<int64_t>(timeout_ms) * 1000;
+            net_.fd = connectSocket(host, port, timeout_ms);
+            if (net_.fd < 0)
+            {
+                ESP_LOGE(LOG_TAG, "TCP connect to %s:%d failed within %d ms", host, port, timeout_ms);
+                return -1;
+            }
+
+            int ret = mbedtls_ssl_setup(&ssl_, &conf_);
+            if (ret == 0)
+                ret = mbedtls_ssl_set_hostname(&ssl_, server_name_ ? server_name_ : host);
+            if (ret != 0)
+            {
+                ESP_LOGE(LOG_TAG, "TLS setup failed: -0x%04x", -ret);
+                closeConnection();
+                return -1;
+            }
+
+            mbedtls_ssl_set_bio(&ssl_, this, bioSend, nullptr, bioRecv);
+            mbedtls_ssl_set_export_keys_cb(&ssl_, exportKeys, this);
+            restoreSession();
+
+            // The handshake as a whole gets what is left of timeout_ms: every read waits at most until the deadline
+            const int64_t handshake_start_us = esp_timer_get_time();
+            ret = 0;
+            while (!mbedtls_ssl_is_handshake_over(&ssl_))
+            {
+                const int64_t left_us = deadline_us - esp_timer_get_time();
+                if (left_us <= 0)
+                {
+                    ret = MBEDTLS_ERR_SSL_TIMEOUT;
+                    break;
+                }
+                io_timeout_ms_ = static_cast<int>((left_us + 999) / 1000);
+
+                ret = mbedtls_ssl_handshake_step(&ssl_);
+                if (ret != 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
+                    break;
+                ret = 0;
+            }
+            stats_.duration_us = esp_timer_get_time() - handshake_start_us;
+
+            if (ret != 0)
+            {
+                ESP_LOGE(LOG_TAG, "TLS handshake with %s failed: -0x%04x", host, -ret);
+                // A rejected session must not poison the next attempt
+                if (session_cache_ && stats_.offered_session)
+                    session_cache_->len = 0;
+                closeConnection();
+                return -1;
+            }
+
+            // A resumed handshake keeps the master secret of the offered session, a full one derives a new one
+            stats_.resumed = stats_.offered_session &&
+                             memcmp(master_tag_, session_cache_->master_tag, sizeof(master_tag_)) == 0;
+            connected_ = true;
+
+            ESP_LOGI(LOG_TAG, "TLS handshake (%s): %lld ms, tx=%lu B, rx=%lu B",
+                     stats_.resumed ? "resumed" : "full",
+                     stats_.duration_us / 1000LL,
+                     static_cast<unsigned long>(stats_.bytes_tx),
+                     static_cast<unsigned long>(stats_.bytes_rx));
+
+            saveSession();
+            return 0;
+        }
+
+        int TlsTransport::read(char *buffer, int len, int timeout_ms)
+        {
+            if (!connected_)
+                return -1;
+
+            // As esp-tls: timeout 0 polls without waiting, so wait here and not inside mbedtls_ssl_read
+            if (timeout_ms >= 0 && mbedtls_ssl_get_bytes_avail(&ssl_) == 0 && pollRead(timeout_ms) <= 0)
+                return 0; // ERR_TCP_TRANSPORT_CONNECTION_TIMEOUT
+
+            io_timeout_ms_ = std::max(timeout_ms, RECORD_TAIL_TIMEOUT_MS);
+            int ret = mbedtls_ssl_read(&ssl_, reinterpret_cast<unsigned char *>(buffer), len);
+            if (ret == MBEDTLS_ERR_SSL_TIMEOUT || ret == MBEDTLS_ERR_SSL_WANT_READ)
+                return 0; // ERR_TCP_TRANSPORT_CONNECTION_TIMEOUT
+            if (ret == 0 || ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY)
+                return -1; // Connection closed by broker
+            return ret < 0 ? -1 : ret;
+        }
+
+        int TlsTransport::write(const char *buffer, int len, int timeout_ms)
+        {
+            if (!connected_)
+                return -1;
+
+            // A stalled socket makes mbedtls_net_send return WANT_WRITE once SO_SNDTIMEO expires: give up at the
+            // deadline so esp-mqtt drops the connection
+            const int64_t deadline_us = esp_timer_get_time() + static_cast<int64_t>(std::max(timeout_ms, 0)) * 1000;
+            io_timeout_ms_ = std::max(timeout_ms, RECORD_TAIL_TIMEOUT_MS);
+            int written = 0;
+            while (written < len)
+            {
+                int ret = mbedtls_ssl_write(&ssl_, reinterpret_cast<const unsigned char *>(buffer + written),
+                                            len - written);
+                if (ret == MBEDTLS_ERR_SSL_WANT_WRITE || ret == MBEDTLS_ERR_SSL_WANT_READ)
+                {
+                    const int64_t left_us = deadline_us - esp_timer_get_time();
+                    if (left_us <= 0)
+                    {
+                        ESP_LOGE(LOG_TAG, "TLS write timed out after %d ms (%d of %d bytes)", timeout_ms, written, len);
+                        return -1;
+                    }
+                    const int left_ms = static_cast<int>((left_us + 999) / 1000);
+                    if ((ret == MBEDTLS_ERR_SSL_WANT_WRITE ? pollWrite(left_ms) : pollRead(left_ms)) < 0)
+                        return -1;
+                    continue;
+                }
+                if (ret < 0)
+                {
+                    ESP_LOGE(LOG_TAG, "TLS write failed: -0x%04x", -ret);
+                    return -1;
+                }
+                written += ret;
+            }
+            return written;
+        }
+
+        int TlsTransport::pollRead(int timeout_ms)
+        {
+            if (!connected_)
+                return -1;
+
+            // Decrypted bytes may already be buffered inside mbedtls
+            if (mbedtls_ssl_get_bytes_avail(&ssl_) > 0)
+                return 1;
+
+            fd_set readset;
+            FD_ZERO(&readset);
+            FD_SET(net_.fd, &readset);
+            struct timeval tv = {timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+            return select(net_.fd + 1, &readset, nullptr, nullptr, &tv);
+        }
+
+        int TlsTransport::pollWrite(int timeout_ms)
+        {
+            if (!connected_)
+                return -1;
+
+            fd_set writeset;
+            FD_ZERO(&writeset);
+            FD_SET(net_.fd, &writeset);
+            struct timeval tv = {timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+            return select(net_.fd + 1, nullptr, &writeset, nullptr, &tv);
+        }
+
+        int TlsTransport::bioSend(void *ctx, const unsigned char *buf, size_t len)
+        {
+            auto *self = static_cast<TlsTransport *>(ctx);
+            int ret = mbedtls_net_send(&self->net_, buf, len);
+            if (ret > 0 && !self->connected_)
+                self->stats_.bytes_tx += ret;
+            return ret;
+        }
+
+        int TlsTransport::bioRecv(void *ctx, unsigned char *buf, size_t len, uint32_t timeout_ms)
+        {
+            auto *self = static_cast<TlsTransport *>(ctx);
+            int ret = mbedtls_net_recv_timeout(&self->net_, buf, len, self->io_timeout_ms_);
+            if (ret > 0 && !self->connected_)
+                self->stats_.bytes_rx += ret;
+            return ret;
+        }
+
+        void TlsTransport::exportKeys(void *ctx, mbedtls_ssl_key_export_type type, const unsigned char *secret,
+                                      size_t secret_len, const unsigned char client_random[32],
+                                      const unsigned char server_random[32], mbedtls_tls_prf_types tls_prf_type)
+        {
+            if (type != MBEDTLS_SSL_KEY_EXPORT_TLS12_MASTER_SECRET)
+                return;
+
+            auto *self = static_cast<TlsTransport *>(ctx);
+            uint8_t digest[32];
+            if (mbedtls_sha256(secret, secret_len, digest, 0) == 0)
+                memcpy(self->master_tag_, digest, sizeof(self->master_tag_));
+        }
+
+        int TlsTransport::connectFunc(esp_transport_handle_t t, const char *host, int port, int timeout_ms)
+        {
+            return static_cast<TlsTransport *>(esp_transport_get_context_data(t))->connect(host, port, timeout_ms);
+        }
+
+        int TlsTransport::readFunc(esp_transport_handle_t t, char *buffer, int len, int timeout_ms)
+        {
+            return static_cast<TlsTransport *>(esp_transport_get_context_data(t))->read(buffer, len, timeout_ms);
+        }
+
+        int TlsTransport::writeFunc(esp_transport_handle_t t, const char *buffer, int len, int timeout_ms)
+        {
+            return static_cast<TlsTransport *>(esp_transport_get_context_data(t))->write(buffer, len, timeout_ms);
+        }
+
+        int TlsTransport::closeFunc(esp_transport_handle_t t)
+        {
+            static_cast<TlsTransport *>(esp_transport_get_context_data(t))->closeConnection();
+            return 0;
+        }
+
+        int TlsTransport::pollReadFunc(esp_transport_handle_t t, int timeout_ms)
+        {
+            return static_cast<TlsTransport *>(esp_transport_get_context_data(t))->pollRead(timeout_ms);
+        }
+
+        int TlsTransport::pollWriteFunc(esp_transport_handle_t t, int timeout_ms)
+        {
+            return static_cast<TlsTransport *>(esp_transport_get_context_data(t))->pollWrite(timeout_ms);
+        }
+
+        int TlsTransport::destroyFunc(esp_transport_handle_t t)
+        {
+            // Called by esp_transport_destroy() before it frees the handle; the TlsTransport lives on
+            return 0;
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "esp_transport.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/net_sockets.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/x509_crt.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Telemetry
+{
+    namespace Publisher
+    {
+        /**
+         * Serialized TLS session kept in RTC memory between deep sleep cycles
+         *
+         * Holds the output of mbedtls_ssl_session_save() (session ID, master secret
+         * and - if the broker issued one - the session ticket). Offering it on the
+         * next connect lets the broker accept an abbreviated handshake, which skips
+         * the certificate exchange and the asymmetric key agreement.
+         */
+        struct TlsSessionCache
+        {
+            static constexpr size_t MAX_SESSION_LEN = 512;
+            static constexpr size_t MASTER_TAG_LEN = 8;
+
+            uint8_t data[MAX_SESSION_LEN];      ///< Serialized mbedtls session
+            uint16_t len;                       ///< Number of valid bytes in data (0 if empty)
+            uint64_t saved_at_us;               ///< Virtual time the session was stored (microseconds)
+            uint8_t master_tag[MASTER_TAG_LEN]; ///< Leading bytes of SHA-256 over the session's master secret
+        };
+
+        // TLS settings for MQTTPublisher::Init (only used with mqtts:// URIs)
+        struct TlsOptions
+        {
+            const char *ca_cert_pem;        ///< PEM CA certificate of the broker (NULL disables verification)
+            TlsSessionCache *session_cache; ///< RTC session cache (NULL disables resumption)
+            uint64_t now_us;                ///< Current virtual time (microseconds)
+            uint64_t session_max_age_us;    ///< Cached sessions older than this are not offered
+            const char *server_name;        ///< Name the certificate is checked against (NULL: the host connected to)
+        };
+
+        // Handshake cost of the last connection, for logging and benchmarking
+        struct TlsHandshakeStats
+        {
+            bool offered_session; ///< A cached session was offered to the broker
+            bool resumed;         ///< Broker accepted the cached session (abbreviated handshake)
+            int64_t duration_us;  ///< Time spent in the TLS handshake (microseconds)
+            uint32_t bytes_tx;    ///< Bytes written to the socket during the handshake
+            uint32_t bytes_rx;    ///< Bytes read from the socket during the handshake
+        };
+
+        /**
+         * MQTT transport running TLS 1.2 over mbedtls with session resumption
+         *
+         * The stock esp-mqtt SSL transport does not expose the mbedtls session,
+         * so this transport owns the TLS context and plugs into esp-mqtt through
+         * esp_transport_set_func(). The session is restored from the cache before
+         * the handshake and written back to it after every successful connect.
+         */
+        class TlsTransport
+        {
+        public:
+            explicit TlsTransport(const TlsOptions &options);
+
+            ~TlsTransport();
+
+            /**
+             * Create an esp_transport handle running over this object (NULL on failure)
+             *
+             * The handle belongs to the caller: the MQTT client frees it in
+             * esp_mqtt_client_destroy(), anyone else with esp_transport_destroy().
+             * Either must happen before this object is destroyed.
+             */
+            esp_transport_handle_t Create();
+
+            // Handshake statistics of the most recent connection
+            const TlsHandshakeStats &GetStats() const;
+
+        private:
+            static constexpr const char *LOG_TAG = "TLS";
+            static constexpr int RECORD_TAIL_TIMEOUT_MS = 100; ///< Receive bound for the rest of a record once it started arriving
+
+            const char *ca_cert_pem_;        ///< PEM CA certificate of the broker (NULL disables verification)
+            TlsSessionCache *session_cache_; ///< RTC session cache (NULL disables resumption)
+            uint64_t now_us_;                ///< Virtual time of this wake, used to age the cached session
+            uint64_t session_max_age_us_;    ///< Cached sessions older than this are not offered
+            const char *server_name_;        ///< SNI and certificate name when connecting to a cached address
+            bool config_ready_;              ///< setupConfig() succeeded
+
+            mbedtls_net_context net_;
+            mbedtls_ssl_context ssl_;
+            mbedtls_ssl_config conf_;
+            mbedtls_entropy_context entropy_;
+            mbedtls_ctr_drbg_context ctr_drbg_;
+            mbedtls_x509_crt ca_cert_;
+            bool connected_;
+
+            TlsHandshakeStats stats_;
+            int io_timeout_ms_; ///< Read timeout applied by the receive callback (never 0: mbedtls waits forever then)
+            uint8_t master_tag_[TlsSessionCache::MASTER_TAG_LEN]; ///< Tag of the master secret of this connection
+
+            // Set up mbedtls configuration (RNG, CA chain, TLS version, tickets)
+            int setupConfig();
+
+            // Offer the cached session to the broker, if present and fresh
+            void restoreSession();
+
+            // Serialize the negotiated session back into the cache
+            void saveSession();
+
+            // Release the TLS and socket state of the current connection
+            void closeConnection();
+
+            // TCP connect that gives up after timeout_ms; the socket fd, or -1
+            static int connectSocket(const char *host, int port, int timeout_ms);
+
+            int connect(const char *host, int port, int timeout_ms);
+            int read(char *buffer, int len, int timeout_ms);
+            int write(const char *buffer, int len, int timeout_ms);
+            int pollRead(int timeout_ms);
+            int pollWrite(int timeout_ms);
+
+            // Socket callbacks that count handshake bytes
+            static int bioSend(void *ctx, const unsigned char *buf, size_t len);
+            static int bioRecv(void *ctx, unsigned char *buf, size_t len, uint32_t timeout_ms);
+
+            // Key export callback: tags the master secret, which only a resumed handshake reuses
+            static void exportKeys(void *ctx, mbedtls_ssl_key_export_type type, const unsigned char *secret,
+                                   size_t secret_len, const unsigned char client_random[32],
+                                   const unsigned char server_random[32], mbedtls_tls_prf_types tls_prf_type);
+
+            // esp_transport trampolines
+            static int connectFunc(esp_transport_handle_t t, const char *host, int port, int timeout_ms);
+            static int readFunc(esp_transport_handle_t t, char *buffer, int len, int timeout_ms);
+            static int writeFunc(esp_transport_handle_t t, const char *buffer, int len, int timeout_ms);
+            static int closeFunc(esp_transport_handle_t t);
+            static int pollReadFunc(esp_transport_handle_t t, int timeout_ms);
+            static int pollWriteFunc(esp_transport_handle_t t, int timeout_ms);
+            static int destroyFunc(esp_transport_handle_t t);
+        };
+    }
+}
\ No newline at end of file
@@ -0,0 +1,260 @@
+#include "log_uploader.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "cJSON.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+namespace Diagnostics
+{
+    LogUploader::LogUploader(UploadProgress *rtc_progress, RingLog *log, FlashIo *flash)
+        : progress_(rtc_progress),
+          log_(log),
+          flash_(flash),
+          telemetry_(nullptr),
+          chunk_(nullptr),
+          hash_table_(nullptr),
+          request_len_(0),
+          ack_(0)
+    {
+    }
+
+    LogUploader::~LogUploader()
+    {
+        delete[] chunk_;
+        delete[] hash_table_;
+    }
+
+    esp_err_t LogUploader::Attach(Telemetry::Telemetry *telemetry)
+    {
+        telemetry_ = telemetry;
+        esp_err_t err = telemetry->Subscribe("diag/req", onRequestMessage, this);
+        if (err == ESP_OK)
+            err = telemetry->Subscribe("diag/ack", onAckMessage, this);
+        if (err != ESP_OK)
+            ESP_LOGW(LOG_TAG, "Failed to subscribe to dump topics: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    esp_err_t LogUploader::Run(uint32_t budget_ms)
+    {
+        uint32_t id = 0;
+        uint32_t from = 0;
+        if (!telemetry_ || !parseRequest(&id, &from) || id == progress_->finished_id)
+            return ESP_OK;
+        if (!log_->Available() || !flash_->Data())
+        {
+            ESP_LOGW(LOG_TAG, "Dump %lu requested, but there is no log to upload", static_cast<unsigned long>(id));
+            return ESP_ERR_NOT_FOUND;
+        }
+
+        if (id != progress_->request_id)
+        {
+            const uint32_t finished_id = progress_->finished_id;
+            *progress_ = {};
+            progress_->request_id = id;
+            progress_->acked_record = from;
+            progress_->end_record = log_->NextRecord();
+            progress_->finished_id = finished_id;
+            ESP_LOGI(LOG_TAG, "Dump %lu requested: records %lu to %lu", static_cast<unsigned long>(id),
+                     static_cast<unsigned long>(from), static_cast<unsigned long>(progress_->end_record));
+        }
+        // After power loss the backend knows better how far it got
+        if (static_cast<int32_t>(from - progress_->acked_record) > 0)
+            progress_->acked_record = from;
+
+        // Only dumps need the chunk buffer, so quiet wakes do not carry it on the main task stack
+        if (!chunk_)
+            chunk_ = new uint8_t[MAX_CHUNK_LEN];
+
+        const int64_t start_us = esp_timer_get_time();
+        int64_t last_ack_us = start_us;
+        uint32_t in_flight[Config::DIAG_UPLOAD_WINDOW]; // Record after each unacknowledged chunk, oldest first
+        uint32_t in_flight_count = 0;
+        uint32_t sent = progress_->acked_record;
+        uint64_t raw_bytes = 0;
+        uint64_t sent_bytes = 0;
+        uint32_t chunks = 0;
+
+        while (static_cast<int32_t>(progress_->end_record - progress_->acked_record) > 0 &&
+               (esp_timer_get_time() - start_us) / 1000 < budget_ms && telemetry_->IsConnected())
+        {
+            const uint64_t ack = ack_;
+            const uint32_t next = static_cast<uint32_t>(ack);
+            if ((ack >> 32) == id && static_cast<int32_t>(next - progress_->acked_record) > 0)
+            {
+                progress_->acked_record = static_cast<int32_t>(next - progress_->end_record) > 0 ? progress_->end_record : next;
+                last_ack_us = esp_timer_get_time();
+
+                uint32_t done = 0;
+                while (done < in_flight_count && static_cast<int32_t>(in_flight[done] - progress_->acked_record) <= 0)
+                    done++;
+                std::copy(in_flight + done, in_flight + in_flight_count, in_flight);
+                in_flight_count -= done;
+                if (static_cast<int32_t>(progress_->acked_record - sent) > 0)
+                    sent = progress_->acked_record;
+                continue;
+            }
+
+            if (in_flight_count < Config::DIAG_UPLOAD_WINDOW &&
+                static_cast<int32_t>(progress_->end_record - sent) > 0)
+            {
+                uint32_t chunk_end = 0;
+                const size_t len = BuildChunk(id, sent, progress_->end_record, chunk_, &chunk_end);
+                if (len == 0)
+                {
+                    // Nothing from here to the end of the dump is stored any more: the ring overwrote it
+                    ESP_LOGW(LOG_TAG, "Records %lu to %lu are gone", static_cast<unsigned long>(sent),
+                             static_cast<unsigned long>(progress_->end_record));
+                    sent = progress_->end_record;
+                    if (in_flight_count == 0)
+                        progress_->acked_record = progress_->end_record;
+                    continue;
+                }
+                if (telemetry_->PublishRaw("diag/data", reinterpret_cast<const char *>(chunk_), 0,
+                                           static_cast<int>(len)) != ESP_OK)
+                    break;
+
+                UploadChunkHeader header;
+                memcpy(&header, chunk_, sizeof(header));
+                raw_bytes += header.raw_len;
+                sent_bytes += len;
+                chunks++;
+                in_flight[in_flight_count++] = chunk_end;
+                sent = chunk_end;
+                continue;
+            }
+
+            if ((esp_timer_get_time() - last_ack_us) / 1000 >= Config::DIAG_UPLOAD_ACK_TIMEOUT_MS)
+            {
+                // A chunk or its acknowledgement was lost: go back to what the backend has
+                ESP_LOGW(LOG_TAG, "No acknowledgement past record %lu, resending",
+                         static_cast<unsigned long>(progress_->acked_record));
+                sent = progress_->acked_record;
+                in_flight_count = 0;
+                last_ack_us = esp_timer_get_time();
+                continue;
+            }
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+
+        const uint32_t elapsed_ms = static_cast<uint32_t>((esp_timer_get_time() - start_us) / 1000);
+        if (static_cast<int32_t>(progress_->end_record - progress_->acked_record) <= 0)
+        {
+            ESP_LOGI(LOG_TAG, "Dump %lu complete", static_cast<unsigned long>(id));
+            progress_->finished_id = id;
+            progress_->request_id = 0;
+        }
+        if (chunks > 0)
+        {
+            ESP_LOGI(LOG_TAG, "Uploaded %llu bytes as %llu in %lu chunks, %lu ms (%lu ms/KB), acknowledged up to %lu of %lu",
+                     static_cast<unsigned long long>(raw_bytes), static_cast<unsigned long long>(sent_bytes),
+                     static_cast<unsigned long>(chunks), static_cast<unsigned long>(elapsed_ms),
+                     static_cast<unsigned long>(raw_bytes > 0 ? elapsed_ms * 1024ULL / raw_bytes : 0),
+                     static_cast<unsigned long>(progress_->acked_record),
+                     static_cast<unsigned long>(progress_->end_record));
+            reportProgress(id, raw_bytes, sent_bytes, chunks, elapsed_ms);
+        }
+        return ESP_OK;
+    }
+
+    size_t LogUploader::BuildChunk(uint32_t request_id, uint32_t from_record, uint32_t end_record, uint8_t *out,
+                                   uint32_t *next_record)
+    {
+        RecordRun run;
+        const uint8_t *data = flash_->Data();
+        if (!data || !log_->FindRun(from_record, end_record, Config::DIAG_UPLOAD_CHUNK_BYTES, &run))
+            return 0;
+        if (!hash_table_)
+            hash_table_ = new uint16_t[Lz4::HASH_ENTRIES];
+
+        // Compressed straight out of the mapped flash
+        const size_t block_len = Lz4::Compress(data + run.offset, run.len, out + sizeof(UploadChunkHeader),
+                                               MAX_CHUNK_LEN - sizeof(UploadChunkHeader), hash_table_);
+        if (block_len == 0)
+            return 0;
+
+        UploadChunkHeader header = {};
+        header.request_id = request_id;
+        header.expected_record = from_record;
+        header.first_record = run.first_record;
+        header.records = static_cast<uint16_t>(run.records);
+        header.raw_len = static_cast<uint16_t>(run.len);
+        memcpy(out, &header, sizeof(header));
+
+        *next_record = run.first_record + run.records;
+        return sizeof(header) + block_len;
+    }
+
+    void LogUploader::onRequestMessage(const char *data, int data_len, void *arg)
+    {
+        auto *uploader = static_cast<LogUploader *>(arg);
+        if (data_len <= 0 || static_cast<size_t>(data_len) >= sizeof(uploader->request_))
+            return;
+
+        // Only the MQTT task writes, and Run() reads once the retained request had time to arrive
+        memcpy(uploader->request_, data, data_len);
+        uploader->request_len_ = static_cast<size_t>(data_len);
+    }
+
+    void LogUploader::onAckMessage(const char *data, int data_len, void *arg)
+    {
+        auto *uploader = static_cast<LogUploader *>(arg);
+        cJSON *root = cJSON_ParseWithLength(data, data_len);
+        const cJSON *id = cJSON_GetObjectItemCaseSensitive(root, "id");
+        const cJSON *next = cJSON_GetObjectItemCaseSensitive(root, "next");
+        if (cJSON_IsNumber(id) && cJSON_IsNumber(next) && id->valuedouble >= 1 && id->valuedouble <= UINT32_MAX &&
+            next->valuedouble >= 0 && next->valuedouble <= UINT32_MAX)
+        {
+            // One word, so Run() never sees the id of one acknowledgement with the record of another
+            uploader->ack_ = (static_cast<uint64_t>(id->valuedouble) << 32) | static_cast<uint32_t>(next->valuedouble);
+        }
+        cJSON_Delete(root);
+    }
+
+    bool LogUploader::parseRequest(uint32_t *id, uint32_t *from)
+    {
+        const size_t len = request_len_;
+        if (len == 0)
+            return false;
+
+        cJSON *root = cJSON_ParseWithLength(request_, len);
+        const cJSON *id_item = cJSON_GetObjectItemCaseSensitive(root, "id");
+        const cJSON *from_item = cJSON_GetObjectItemCaseSensitive(root, "from");
+        const bool valid = cJSON_IsNumber(id_item) && id_item->valuedouble >= 1 && id_item->valuedouble <= UINT32_MAX &&
+                           (!from_item || (cJSON_IsNumber(from_item) && from_item->valuedouble >= 0 &&
+                                           from_item->valuedouble <= UINT32_MAX));
+        if (valid)
+        {
+            *id = static_cast<uint32_t>(id_item->valuedouble);
+            *from = from_item ? static_cast<uint32_t>(from_item->valuedouble) : 0;
+        }
+        else
+        {
+            ESP_LOGW(LOG_TAG, "Ignoring malformed dump request");
+        }
+        cJSON_Delete(root);
+        return valid;
+    }
+
+    void LogUploader::reportProgress(uint32_t id, uint64_t raw_bytes, uint64_t sent_bytes, uint32_t chunks,
+                                     uint32_t elapsed_ms)
+    {
+        char message[192];
+        Telemetry::JsonWriter json(message, sizeof(message));
+        json.AddInt("id", id);
+        json.AddInt("acked", progress_->acked_record);
+        json.AddInt("end", progress_->end_record);
+        json.AddInt("raw_bytes", static_cast<int64_t>(raw_bytes));
+        json.AddInt("sent_bytes", static_cast<int64_t>(sent_bytes));
+        json.AddInt("chunks", chunks);
+        json.AddInt("ms", elapsed_ms);
+        json.AddFloat("kb_per_s", elapsed_ms > 0 ? raw_bytes / 1.024f / elapsed_ms : 0.0f);
+        json.AddFloat("ms_per_kb", raw_bytes > 0 ? elapsed_ms * 1024.0f / raw_bytes : 0.0f);
+        if (const char *payload = json.Finish())
+            telemetry_->PublishRaw("diag/progress", payload);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+#include "esp_log.h"
+
+#include "lz4_block.hpp"
+#include "ring_log.hpp"
+#include "config.hpp"
+#include "telemetry.hpp"
+
+namespace Diagnostics
+{
+    // Upload progress kept in RTC memory between deep sleep cycles
+    struct UploadProgress
+    {
+        uint32_t request_id;   ///< Dump being uploaded (0: none)
+        uint32_t end_record;   ///< The dump ends before this record (the head when the request arrived)
+        uint32_t acked_record; ///< The backend acknowledged every record before this one
+        uint32_t finished_id;  ///< Last dump completed, never uploaded again
+    };
+
+    // Prefix of every {base}/diag/data message, followed by the LZ4 block (little-endian)
+    struct UploadChunkHeader
+    {
+        uint32_t request_id;      ///< Dump the chunk belongs to
+        uint32_t expected_record; ///< Record the upload continued from (< first_record: the ones between were lost)
+        uint32_t first_record;    ///< Sequence number of the first record in the block
+        uint16_t records;         ///< Records in the block
+        uint16_t raw_len;         ///< Bytes of the decompressed block: the records as stored on flash
+    };
+
+    /**
+     * Bulk upload of the diagnostic log over the reporting sessions
+     *
+     * An operator publishes a retained request on {base}/diag/req:
+     *
+     *   {"id":7,"from":0}
+     *
+     * The device then uploads the records from "from" up to the head of the
+     * log at the time it first saw the request. Chunks go to
+     * {base}/diag/data as an UploadChunkHeader and an LZ4 block of whole
+     * records, exactly as stored (record headers and checksums included).
+     * The block is compressed straight from the memory-mapped partition,
+     * so the only staging buffer is one compressed chunk.
+     *
+     * The backend acknowledges on {base}/diag/ack with {"id":7,"next":N}:
+     * it has every record before N. Up to Config::DIAG_UPLOAD_WINDOW chunks
+     * are in flight. Without an acknowledgement for
+     * Config::DIAG_UPLOAD_ACK_TIMEOUT_MS the upload goes back to the last
+     * acknowledged record. That record is kept in RTC memory, so the next
+     * session resumes there; after power loss the backend's "from" does.
+     * Records the ring overwrote before they went out are skipped, which
+     * the chunk header shows the backend.
+     *
+     * Every session that uploads publishes its throughput and radio time
+     * per KB on {base}/diag/progress.
+     */
+    class LogUploader
+    {
+    public:
+        // Uploader of log over the RTC progress (cleared after power loss)
+        LogUploader(UploadProgress *rtc_progress, RingLog *log, FlashIo *flash);
+
+        ~LogUploader();
+
+        // Subscribe to requests and acknowledgements on an initialized telemetry session
+        esp_err_t Attach(Telemetry::Telemetry *telemetry);
+
+        // Continue a requested dump for at most budget_ms (nothing if there is none)
+        esp_err_t Run(uint32_t budget_ms);
+
+        /**
+         * Build the chunk that continues the dump at from_record
+         *
+         * Writes the header and the block to out (MAX_CHUNK_LEN bytes) and
+         * returns the length, or 0 if no record before end_record is left.
+         * *next_record receives the record after the last one in the chunk.
+         */
+        size_t BuildChunk(uint32_t request_id, uint32_t from_record, uint32_t end_record, uint8_t *out,
+                          uint32_t *next_record);
+
+        static constexpr size_t MAX_CHUNK_LEN =
+            sizeof(UploadChunkHeader) + Lz4::CompressBound(Config::DIAG_UPLOAD_CHUNK_BYTES);
+
+    private:
+        static constexpr const char *LOG_TAG = "LOG_UPLOAD";
+        static constexpr size_t MAX_REQUEST_LEN = 96;
+
+        UploadProgress *progress_;        ///< RTC state
+        RingLog *log_;                    ///< Log the records come from
+        FlashIo *flash_;                  ///< Flash under log, read through its mapping
+        Telemetry::Telemetry *telemetry_; ///< Session chunks go out on (NULL until attached)
+        uint8_t *chunk_;                  ///< Chunk being published (MAX_CHUNK_LEN, allocated when a dump runs)
+        uint16_t *hash_table_;            ///< LZ4 match table (allocated by the first BuildChunk())
+
+        char request_[MAX_REQUEST_LEN];   ///< Last {base}/diag/req payload
+        std::atomic<size_t> request_len_; ///< Valid bytes in request_ (0 if none)
+        std::atomic<uint64_t> ack_;       ///< Last acknowledgement: request id << 32 | next record (0: none)
+
+        // Copy a request / parse an acknowledgement (MQTT task) for Run()
+        static void onRequestMessage(const char *data, int data_len, void *arg);
+        static void onAckMessage(const char *data, int data_len, void *arg);
+
+        // Parse request_, false if there is none or it is malformed
+        bool parseRequest(uint32_t *id, uint32_t *from);
+
+        // Publish the session's figures on {base}/diag/progress
+        void reportProgress(uint32_t id, uint64_t raw_bytes, uint64_t sent_bytes, uint32_t chunks, uint32_t elapsed_ms);
+    };
+}
\ No newline at end of file
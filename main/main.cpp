@@ -1,18 +1,41 @@
-#include "config/config.hpp"
-#include "hardware/ultrasonic/hcsr04.hpp"
-#include "processor/processor.hpp"
-#include "telemetry/telemetry.hpp"
-
+#include "diagnostics/log_uploader.hpp"
+#include "ota/delta_updater.hpp"
+
+#include "alloc_tracker.hpp"
+#include "battery_monitor.hpp"
+#include "broker_endpoints.hpp"
+#include "checkpoint.hpp"
+#include "config.hpp"
+#include "digest.hpp"
+#include "echo_jitter.hpp"
+#include "flap_damper.hpp"
+#include "hcsr04.hpp"
+#include "partition_flash.hpp"
+#include "power_manager.hpp"
+#include "processor.hpp"
+#include "report_schedule.hpp"
+#include "ring_log.hpp"
+#include "runtime_config.hpp"
+#include "telemetry.hpp"
+#include "tls_bench.hpp"
+#include "tls_transport.hpp"
+#include "wake_record.hpp"
+
+#include "esp_random.h"
+#include "esp_rtc_time.h"
 #include "esp_sleep.h"
+#include "esp_system.h"
 #include "esp_log.h"
 #include "nvs_flash.h"
 #include "esp_wifi.h"
 #include "esp_netif.h"
 #include "esp_sntp.h"
+#include "sdkconfig.h"
 
-#include <string>
-#include <map>
-#include <optional>
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <ctime>
 
 static const char *LOG_TAG = "MAIN";
 
@@ -23,18 +46,54 @@ struct RtcStore
     Processor::StateContext processor_state;
     uint64_t last_telemetry_time_sec;
     uint64_t virtual_time_us;
+    Telemetry::Publisher::TlsSessionCache tls_session;
+    Telemetry::PersistentState telemetry_state;
+    Config::RuntimeConfig runtime_config;          // Mirror of the NVS config, read on every wake
+    Ota::UpdateProgress ota_progress;              // Mirror of the NVS firmware download progress
+    Hardware::Battery::BatteryState battery;       // Smoothed battery voltage and power level
+    Processor::CheckpointState checkpoint;         // What the NVS checkpoint holds, and its write budget
+    Diagnostics::RingLogState diag_log;            // Head of the diagnostic log on flash
+    Diagnostics::UploadProgress diag_upload;       // How far a requested log dump got
+    Processor::DigestState digest;                 // Events aggregated for the next daily digest
+    Processor::FlapState flap;                     // Flap damping penalty and suppressed transitions
+    Telemetry::BackoffState backoff;               // Failed sessions in a row and the next heartbeat retry
+    Telemetry::Publisher::EndpointCache endpoints; // Broker health scores and resolved addresses
+    uint64_t sleep_until_rtc_us;                   // RTC time the wake timer is due, for the boot time of the next wake
 };
 RTC_DATA_ATTR RtcStore rtc_store;
 
-std::pair<bool, std::optional<std::string>> connect_wifi_blocking()
+// Keeps the full clock while the wake computes; waits release it so DFS and light sleep can take over
+static Hardware::Power::PmLock *wake_lock = nullptr;
+static uint64_t waited_us = 0; // Time spent in waits this wake, for the charge estimate
+
+// vTaskDelay with the wake lock released: the idle task may lower the clock or light-sleep meanwhile
+void pm_delay(uint32_t ms)
 {
-    // Initialize NVS
+    const int64_t start_us = esp_timer_get_time();
+    {
+        Hardware::Power::PmLock::Released released(*wake_lock);
+        vTaskDelay(pdMS_TO_TICKS(ms));
+    }
+    waited_us += esp_timer_get_time() - start_us;
+}
+
+void init_nvs()
+{
+    // Safe to call again once initialized
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND)
     {
         ESP_ERROR_CHECK(nvs_flash_erase());
         ret = nvs_flash_init();
     }
+}
+
+// Bring up Wi-Fi and wait for an address; ip_str receives it in dotted form
+// (kept out of line: tools/wake_bench stops here under QEMU, which has no Wi-Fi)
+__attribute__((noinline)) bool connect_wifi_blocking(char (&ip_str)[16])
+{
+    // Initialize NVS
+    init_nvs();
 
     esp_netif_init();
     esp_event_loop_create_default();
@@ -48,6 +107,7 @@ std::pair<bool, std::optional<std::string>> connect_wifi_blocking()
 
     esp_wifi_set_mode(WIFI_MODE_STA);
     esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+    esp_wifi_set_ps(WIFI_PS_MIN_MODEM); // RF off between beacons, so waits can light-sleep
     esp_wifi_start();
 
     ESP_LOGI(LOG_TAG, "Connecting to Wi-Fi...");
@@ -66,124 +126,447 @@ std::pair<bool, std::optional<std::string>> connect_wifi_blocking()
                 if (ip_info.ip.addr != 0)
                 {
                     esp_ip4_addr_t ip = ip_info.ip;
-                    char ip_str[16]; // Enough for "xxx.xxx.xxx.xxx"
                     esp_ip4addr_ntoa(&ip, ip_str, sizeof(ip_str));
 
-                    std::string ipAddress(ip_str);
-                    ESP_LOGI(LOG_TAG, "Wi-Fi Connected! IP: %s", ipAddress.c_str());
+                    ESP_LOGI(LOG_TAG, "Wi-Fi Connected! IP: %s", ip_str);
 
-                    return {true, ipAddress};
+                    return true;
                 }
             }
         }
-        vTaskDelay(pdMS_TO_TICKS(100));
+        pm_delay(100);
         retries++;
     }
 
     ESP_LOGW(LOG_TAG, "Wi-Fi connection timeout");
-    return {false, std::nullopt};
+    return false;
+}
+
+// Wait like vTaskDelay, erasing diagnostic log sectors ahead while there is time for it
+void idle_wait(uint32_t ms, Diagnostics::RingLog &diag_log)
+{
+    const int64_t until_us = esp_timer_get_time() + static_cast<int64_t>(ms) * 1000;
+    while (Config::DIAG_LOG_ENABLED &&
+           until_us - esp_timer_get_time() > static_cast<int64_t>(Config::DIAG_LOG_ERASE_SLACK_MS) * 1000 &&
+           diag_log.EraseAhead(1) > 0)
+    {
+    }
+
+    const int64_t left_us = until_us - esp_timer_get_time();
+    if (left_us > 0)
+        pm_delay(left_us / 1000);
 }
 
 extern "C" void app_main(void)
 {
+    // First thing: on a timer wake the RTC counted on from the wake target through ROM, bootloader and startup
+    const uint64_t app_main_rtc_us = esp_rtc_get_time_us();
+
     ESP_LOGI(LOG_TAG, "%s v%s", Config::APP_NAME, Config::APP_VERSION);
 
     // Record wake time to calculate actual wake duration
     uint64_t wake_time_start = esp_timer_get_time();
 
+    // Everything below runs on RTC, static or stack storage; only driver internals may allocate
+    Diagnostics::AllocTracker::Begin();
+
+    // Frequency scaling and light sleep are reset by deep sleep; the wake itself runs at the full clock
+    const Hardware::Power::PmMode pm_mode = Hardware::Power::ConfiguredMode();
+    const esp_err_t pm_err = Hardware::Power::Configure(pm_mode);
+    if (pm_err != ESP_OK)
+        ESP_LOGW(LOG_TAG, "Power management (%s) not configured: %s", Hardware::Power::ModeToString(pm_mode),
+                 esp_err_to_name(pm_err));
+    Hardware::Power::PmLock cpu_lock(ESP_PM_CPU_FREQ_MAX, "wake");
+    Hardware::Power::PmLock::Hold hold_cpu(cpu_lock);
+    wake_lock = &cpu_lock;
+    int64_t radio_start_us = 0;
+    int64_t radio_stop_us = 0;
+
     // Determine Wakeup Cause & Update Virtual Clock
     bool is_fresh_boot = (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_TIMER);
+    uint64_t slept_us = 0;
+    uint64_t boot_us = 0;
+
+    // Runtime configuration lives in RTC; only a fresh boot has to read it from NVS
+    Config::RuntimeConfigStore config_store(&rtc_store.runtime_config);
+    const Config::RuntimeConfig &config = rtc_store.runtime_config;
+#if CONFIG_MAILBOX_DELTA_OTA
+    Ota::DeltaUpdater updater(&rtc_store.ota_progress);
+#endif
+    Processor::CheckpointStore checkpoint(&rtc_store.checkpoint);
+
+    // The first boot of an updated image has to report once, or the previous image comes back
+    const bool verify_image = Ota::DeltaUpdater::PendingVerify();
 
     if (is_fresh_boot)
     {
         ESP_LOGI(LOG_TAG, "Fresh Boot: Initializing State");
+        {
+            Diagnostics::AllocTracker::Exempt exempt; // NVS
+            init_nvs();
+            config_store.Load();
+#if CONFIG_MAILBOX_DELTA_OTA
+            updater.Load();
+#endif
+        }
         rtc_store.boot_count = 0;
-        Processor::Processor temp;
+        Processor::Processor temp(config);
         rtc_store.processor_state = temp.GetContext();
-        rtc_store.last_telemetry_time_sec = 0; // Will force immediate heartbeat
+        {
+            // A battery swap or brownout must not forget mail that is already in the box
+            Diagnostics::AllocTracker::Exempt exempt; // NVS
+            checkpoint.Restore(&rtc_store.processor_state, &rtc_store.boot_count);
+        }
+        rtc_store.last_telemetry_time_sec = 0; // First heartbeat at this device's phase offset
         rtc_store.virtual_time_us = 0;
+        rtc_store.tls_session.len = 0;
+        rtc_store.telemetry_state = {}; // First status will be a keyframe, sequence continues from NVS
+        rtc_store.battery = {};         // Sampled right below
+        rtc_store.diag_log = {};        // Head is found again by the recovery scan below
+        rtc_store.diag_upload = {};     // A pending dump resumes from the backend's "from"
+        rtc_store.digest = {};          // A new period starts with this wake
+        rtc_store.flap = {};            // No penalty after power loss
+        rtc_store.backoff = {};         // Try the broker again at the phase offset
+        rtc_store.endpoints = {};       // Brokers are tried in list order and resolved again
+        rtc_store.sleep_until_rtc_us = 0;
     }
     else
     {
         rtc_store.boot_count++;
-        // Advance virtual clock by the sleep duration
-        rtc_store.virtual_time_us += Config::DEEP_SLEEP_US;
-        ESP_LOGI(LOG_TAG, "Wakeup #%lu (Virtual Time: %llu s)",
+        // Advance virtual clock by the sleep duration (scheduled with the config, power level and processor state still in RTC)
+        slept_us = Processor::SleepUs(rtc_store.processor_state, Hardware::Battery::SleepUs(rtc_store.battery.level, config));
+        rtc_store.virtual_time_us += slept_us;
+        if (rtc_store.sleep_until_rtc_us != 0 && app_main_rtc_us > rtc_store.sleep_until_rtc_us)
+            boot_us = app_main_rtc_us - rtc_store.sleep_until_rtc_us;
+        ESP_LOGI(LOG_TAG, "Wakeup #%lu (Virtual Time: %llu s, boot %.2f ms)",
                  rtc_store.boot_count,
-                 rtc_store.virtual_time_us / 1000000ULL);
+                 rtc_store.virtual_time_us / 1000000ULL,
+                 boot_us / 1000.0);
     }
 
+    // Field debugging capture; after power loss the head is found by a bounded scan
+    Diagnostics::PartitionFlash diag_flash(Config::DIAG_LOG_PARTITION);
+    Diagnostics::RingLog diag_log(&diag_flash, &rtc_store.diag_log);
+    if (Config::DIAG_LOG_ENABLED && diag_log.Available() && !rtc_store.diag_log.valid)
+        diag_log.Recover();
+#if CONFIG_MAILBOX_LOG_UPLOAD
+    Diagnostics::LogUploader uploader(&rtc_store.diag_upload, &diag_log, &diag_flash);
+#endif
+    uint8_t wake_flags = is_fresh_boot ? Diagnostics::WAKE_FRESH_BOOT : 0;
+
+    // Battery is read every few wakes, before the radio can pull the voltage down
+    Hardware::Battery::BatteryMonitor battery(&rtc_store.battery);
+    battery.Update(is_fresh_boot);
+
     // Initialize Hardware - VL53L0X laser sensor
     Hardware::Ultrasonic::HCSR04 sensor(Config::HCSR04_TRIGGER_PIN, Config::HCSR04_ECHO_PIN);
 
+    // Bench builds compare the echo capture loops against a fixed target once per power-up
+    if (Config::ECHO_JITTER_BENCH_SAMPLES > 0 && is_fresh_boot)
+    {
+        Diagnostics::AllocTracker::Exempt exempt; // Timer driver
+        Hardware::Ultrasonic::RunJitterBenchmark(sensor, Config::ECHO_JITTER_BENCH_SAMPLES);
+    }
+
     // Restore Processor from RTC
-    Processor::Processor processor(rtc_store.processor_state);
+    Processor::Processor processor(rtc_store.processor_state, config);
 
     const float raw_dist = sensor.MeasureDistance(Config::ECHO_TIMEOUT_US);
 
     // Pass the virtual time to the processor
     Processor::DistanceData data = processor.Process(raw_dist, rtc_store.virtual_time_us);
 
+    // Events carry the timeline of their session, from here to the publish
+    Telemetry::EventTrace trace = {};
+    trace.detected_us = esp_timer_get_time();
+    trace.window_ms = static_cast<uint32_t>(slept_us / 1000ULL);
+
     ESP_LOGI(LOG_TAG, "Dist: %.1f cm | State: %d", data.filtered_cm, (int)data.state);
 
+    if (data.mail_detected)
+        wake_flags |= Diagnostics::WAKE_MAIL_DETECTED;
+    if (data.mail_collected)
+        wake_flags |= Diagnostics::WAKE_MAIL_COLLECTED;
+
+    // A mailbox flapping between states reports one "unstable" status instead of every transition
+    Processor::FlapDamper flap(&rtc_store.flap);
+    if (Config::FLAP_DAMPING_ENABLED && flap.Record(data, rtc_store.virtual_time_us))
+        wake_flags |= Diagnostics::WAKE_SUPPRESSED;
+
+    // Every wake counts towards the digest; in digest mode only alarms and the daily digest open a session
+    const bool digest_mode = config.digest_at_min >= 0;
+    Processor::DigestAggregator digest(&rtc_store.digest);
+    const int64_t wall_s = time(nullptr);
+    digest.Record(data, battery.Level() == Hardware::Battery::PowerLevel::CRITICAL, rtc_store.virtual_time_us, wall_s);
+    const uint8_t alarms = digest_mode ? digest.PendingAlarms(rtc_store.virtual_time_us) : 0;
+
     // Evaluate if radio must wake up
-    const bool crucial_event = data.mail_detected || data.mail_collected;
+    const bool crucial_event = digest_mode ? alarms != 0
+                                           : (data.mail_detected || data.mail_collected || data.obstruction_changed);
 
     // Check for periodic update using virtual time in seconds
+    // Devices that boot together (after a power cut) report at offsets hashed from their client IDs, not all at once
     const uint64_t virtual_time_sec = rtc_store.virtual_time_us / 1000000ULL;
-    const bool periodic_update = (virtual_time_sec >= (rtc_store.last_telemetry_time_sec + Config::HEARTBEAT_INTERVAL_SEC));
-
-    if (crucial_event || periodic_update)
+    const uint64_t heartbeat_interval_sec = Hardware::Battery::HeartbeatIntervalSec(battery.Level(), config);
+    const uint64_t heartbeat_phase_sec = Config::HEARTBEAT_PHASE_SPREAD
+                                             ? Telemetry::PhaseOffsetSec(Config::MQTT_CLIENT_ID, heartbeat_interval_sec)
+                                             : heartbeat_interval_sec;
+    const uint32_t digest_offset_sec = Telemetry::PhaseOffsetSec(Config::MQTT_CLIENT_ID, Config::DIGEST_SPREAD_SEC);
+
+    // After failed sessions, heartbeats back off instead of retrying on every wake
+    Telemetry::ReconnectBackoff backoff(&rtc_store.backoff);
+    const bool backing_off = backoff.Waiting(rtc_store.virtual_time_us);
+    const bool periodic_update =
+        !backing_off &&
+        (digest_mode ? digest.Due(config.digest_at_min, digest_offset_sec, rtc_store.virtual_time_us, wall_s)
+                     : Telemetry::HeartbeatDue(virtual_time_sec, rtc_store.last_telemetry_time_sec,
+                                               heartbeat_interval_sec, heartbeat_phase_sec));
+
+    // In digest mode the suppression goes out with the next digest
+    const bool flap_report = !digest_mode && !backing_off && flap.ReportDue();
+
+    if (crucial_event || periodic_update || flap_report || verify_image)
     {
-        ESP_LOGI(LOG_TAG, "Connecting to report event (Event=%d, Periodic=%d)...", crucial_event, periodic_update);
+        wake_flags |= Diagnostics::WAKE_SESSION;
+        ESP_LOGI(LOG_TAG, "Connecting to report event (Event=%d, Periodic=%d, Flap=%d, Verify=%d)...",
+                 crucial_event, periodic_update, flap_report, verify_image);
 
-        const auto connection_status = connect_wifi_blocking();
-        if (connection_status.first)
+        char ip_addr[16] = {};
+        bool connected;
         {
-            esp_sntp_setoperatingmode(SNTP_OPMODE_POLL);
-            esp_sntp_setservername(0, "pool.ntp.org");
-            esp_sntp_init();
+            Diagnostics::AllocTracker::Exempt exempt; // Wi-Fi and lwIP
+            radio_start_us = esp_timer_get_time();
+            connected = connect_wifi_blocking(ip_addr);
+            if (connected)
+            {
+                esp_sntp_setoperatingmode(SNTP_OPMODE_POLL);
+                esp_sntp_setservername(0, "pool.ntp.org");
+                esp_sntp_init();
+            }
+        }
 
+        if (connected)
+        {
+            wake_flags |= Diagnostics::WAKE_CONNECTED;
+            trace.wifi_us = esp_timer_get_time();
             int retry = 0;
             while (sntp_get_sync_status() == SNTP_SYNC_STATUS_RESET && ++retry < 100)
             {
-                vTaskDelay(pdMS_TO_TICKS(100));
+                pm_delay(100);
             }
+            trace.time_sync_us = esp_timer_get_time();
 
-            Telemetry::Telemetry telemetry;
-            telemetry.InitMQTT(Config::MQTT_BROKER_URI, Config::MQTT_BASE_TOPIC, Config::MQTT_CLIENT_ID, nullptr, nullptr);
+#if CONFIG_MAILBOX_MQTT_TLS
+            // Bench builds compare full and resumed handshakes once per power-up
+            if (Config::TLS_BENCH_HANDSHAKES > 0 && is_fresh_boot)
+            {
+                Diagnostics::AllocTracker::Exempt exempt; // TLS contexts
+                Telemetry::Publisher::RunHandshakeBenchmark(Config::MQTT_BROKER_URIS[0], Config::MQTT_BROKER_CA_PEM,
+                                                            Config::TLS_BENCH_HANDSHAKES);
+            }
+#endif
+
+            Telemetry::Publisher::TlsOptions tls_options = {
+                .ca_cert_pem = Config::MQTT_BROKER_CA_PEM,
+                .session_cache = &rtc_store.tls_session,
+                .now_us = rtc_store.virtual_time_us,
+                .session_max_age_us = Config::TLS_SESSION_MAX_AGE_SEC * 1000000ULL,
+                .server_name = nullptr};
+
+            // Most recently healthy broker first; the next one if it misses the connect deadline
+            Telemetry::Publisher::BrokerEndpoints endpoints(&rtc_store.endpoints, Config::MQTT_BROKER_URIS,
+                                                            std::size(Config::MQTT_BROKER_URIS));
+            endpoints.Begin(rtc_store.virtual_time_us);
+            Telemetry::Telemetry telemetry(&rtc_store.telemetry_state, rtc_store.boot_count, &config_store);
+            for (size_t attempt = 0; attempt < endpoints.Count() && !telemetry.IsConnected(); ++attempt)
+            {
+                const size_t endpoint = endpoints.Pick(attempt);
+                const int64_t connect_start_us = esp_timer_get_time();
+                const char *uri = endpoints.Uri(endpoint, rtc_store.virtual_time_us);
+                tls_options.server_name = endpoints.Host(endpoint);
+                telemetry.InitMQTT(uri, Config::MQTT_BASE_TOPIC, Config::MQTT_CLIENT_ID, nullptr, nullptr, &tls_options);
+                while (!telemetry.IsConnected() &&
+                       esp_timer_get_time() - connect_start_us < Config::MQTT_CONNECT_DEADLINE_MS * 1000LL)
+                    idle_wait(20, diag_log);
+
+                if (telemetry.IsConnected())
+                {
+                    trace.mqtt_us = esp_timer_get_time();
+                    endpoints.Connected(endpoint, rtc_store.virtual_time_us,
+                                        static_cast<uint32_t>((trace.mqtt_us - connect_start_us) / 1000));
+                }
+                else
+                {
+                    endpoints.Failed(endpoint, rtc_store.virtual_time_us);
+                }
+            }
+            {
+                Diagnostics::AllocTracker::Exempt exempt; // Firmware downloads and log dumps are not part of the reporting path
+#if CONFIG_MAILBOX_DELTA_OTA
+                updater.Attach(&telemetry);
+#endif
+#if CONFIG_MAILBOX_LOG_UPLOAD
+                uploader.Attach(&telemetry);
+#endif
+            }
 
-            vTaskDelay(pdMS_TO_TICKS(1000));
-            telemetry.Publish(data, processor.GetBaseline(), processor.GetThreshold(), connection_status.second);
-            vTaskDelay(pdMS_TO_TICKS(1000));
+            if (battery.HasReading())
+                telemetry.SetBattery(battery.Millivolts(), battery.Percent(), battery.Level());
+            telemetry.SetStability(flap.Suppressed(), flap.State().suppressed_events);
+            telemetry.SetTrace(trace);
+
+            idle_wait(1000, diag_log);
+            int alarm_msg_id = -1;
+            int digest_msg_id = -1;
+            if (!digest_mode)
+                telemetry.Publish(data, processor.GetBaseline(), processor.GetThreshold(), ip_addr);
+            if (alarms != 0)
+                alarm_msg_id = telemetry.PublishAlarms(alarms, data, ip_addr);
+            if (digest_mode && periodic_update)
+                digest_msg_id = telemetry.PublishDigest(digest.State(), rtc_store.virtual_time_us, data,
+                                                        processor.GetBaseline(), processor.GetThreshold(), ip_addr);
+            idle_wait(1000, diag_log);
+
+            // Download the next part of an offered firmware update while the radio is up anyway
+            if (battery.Level() != Hardware::Battery::PowerLevel::CRITICAL)
+            {
+                Diagnostics::AllocTracker::Exempt exempt;
+#if CONFIG_MAILBOX_DELTA_OTA
+                updater.Run(Config::OTA_SESSION_BUDGET_MS);
+#endif
+#if CONFIG_MAILBOX_LOG_UPLOAD
+                uploader.Run(Config::DIAG_UPLOAD_SESSION_BUDGET_MS);
+#endif
+            }
+            const bool reported = telemetry.IsConnected();
+
+            // Acknowledged by now, or a session after the retry delay tries again
+            const bool digest_due = digest_mode && periodic_update;
+            const bool alarms_delivered = alarms != 0 && telemetry.IsAcknowledged(alarm_msg_id);
+            const bool digest_delivered = digest_due && telemetry.IsAcknowledged(digest_msg_id);
+            if (alarms_delivered)
+                digest.AlarmsSent(alarms);
+            if (digest_delivered)
+                digest.Sent(rtc_store.virtual_time_us, time(nullptr));
+            if ((alarms != 0 && !alarms_delivered) || (digest_due && !digest_delivered))
+                digest.Failed(rtc_store.virtual_time_us);
+            if (reported && (!digest_mode || digest_delivered))
+                flap.Reported();
+            if (reported)
+                backoff.Succeeded();
+            else
+                backoff.Failed(rtc_store.virtual_time_us, esp_random());
 
             telemetry.Stop();
-            vTaskDelay(pdMS_TO_TICKS(100));
+            pm_delay(100);
 
-            esp_wifi_disconnect();
-            esp_wifi_stop();
+            {
+                Diagnostics::AllocTracker::Exempt exempt;
+                esp_wifi_disconnect();
+                esp_wifi_stop();
+            }
+            radio_stop_us = esp_timer_get_time();
 
             // Update last telemetry time after successful transmission
-            if (periodic_update)
+            if (periodic_update && reported)
                 rtc_store.last_telemetry_time_sec = virtual_time_sec;
+
+            if (verify_image)
+            {
+                Diagnostics::AllocTracker::Exempt exempt;
+                Ota::DeltaUpdater::ConfirmRunningImage(reported);
+            }
         }
         else
         {
             ESP_LOGW(LOG_TAG, "WiFi connection failed - telemetry skipped");
+            backoff.Failed(rtc_store.virtual_time_us, esp_random());
+            if (digest_mode)
+                digest.Failed(rtc_store.virtual_time_us);
+            if (verify_image)
+            {
+                Diagnostics::AllocTracker::Exempt exempt;
+                Ota::DeltaUpdater::ConfirmRunningImage(false);
+            }
         }
     }
 
     // Save State Back to RTC
     rtc_store.processor_state = processor.GetContext();
 
+    // ... and to NVS on state changes, within the flash write budget
+    if (checkpoint.Due(rtc_store.processor_state, rtc_store.virtual_time_us))
+    {
+        Diagnostics::AllocTracker::Exempt exempt; // NVS
+        init_nvs();
+        checkpoint.Save(rtc_store.processor_state, rtc_store.boot_count, rtc_store.virtual_time_us);
+    }
+
     // Calculate actual wake duration and add to virtual time
     const uint64_t wake_duration_us = esp_timer_get_time() - wake_time_start;
     rtc_store.virtual_time_us += wake_duration_us;
 
+    // Charge of this wake from its timers, and what the same wake costs under the other power management modes
+    // (a failed Wi-Fi connect leaves the radio on until deep sleep)
+    const Hardware::Power::WakeTiming timing = {
+        .awake_us = static_cast<uint32_t>(wake_duration_us),
+        .wait_us = static_cast<uint32_t>(waited_us),
+        .radio_us = static_cast<uint32_t>(radio_start_us == 0 ? 0
+                                          : (radio_stop_us ? radio_stop_us : esp_timer_get_time()) - radio_start_us)};
+    const Hardware::Power::PmMode active_mode = pm_err == ESP_OK ? pm_mode : Hardware::Power::PmMode::OFF;
+    ESP_LOGI(LOG_TAG, "Wake charge %.1f mC in %s (off %.1f, dfs %.1f, light_sleep %.1f): %lu ms awake, %lu ms waiting, %lu ms radio",
+             Hardware::Power::WakeChargeUc(timing, active_mode) / 1000.0f, Hardware::Power::ModeToString(active_mode),
+             Hardware::Power::WakeChargeUc(timing, Hardware::Power::PmMode::OFF) / 1000.0f,
+             Hardware::Power::WakeChargeUc(timing, Hardware::Power::PmMode::DFS) / 1000.0f,
+             Hardware::Power::WakeChargeUc(timing, Hardware::Power::PmMode::LIGHT_SLEEP) / 1000.0f,
+             static_cast<unsigned long>(timing.awake_us / 1000), static_cast<unsigned long>(timing.wait_us / 1000),
+             static_cast<unsigned long>(timing.radio_us / 1000));
+
+    if (Config::DIAG_LOG_ENABLED && diag_log.Available())
+    {
+        const Diagnostics::WakeRecord record = {
+            .wake = rtc_store.boot_count,
+            .virtual_time_s = static_cast<uint32_t>(virtual_time_sec),
+            .awake_ms = static_cast<uint16_t>(std::min<uint64_t>(wake_duration_us / 1000ULL, UINT16_MAX)),
+            .battery_mv = static_cast<uint16_t>(battery.Millivolts()),
+            .raw_mm = static_cast<int16_t>(std::clamp(raw_dist * 10.0f, -1.0f, 32767.0f)),
+            .filtered_mm = static_cast<int16_t>(std::clamp(data.filtered_cm * 10.0f, -1.0f, 32767.0f)),
+            .state = static_cast<uint8_t>(data.state),
+            .flags = wake_flags,
+            .boot_10us = static_cast<uint16_t>(std::min<uint64_t>(boot_us / 10ULL, UINT16_MAX))};
+        const int64_t append_start_us = esp_timer_get_time();
+        const esp_err_t err = diag_log.Append(static_cast<uint8_t>(Diagnostics::RecordType::WAKE), &record, sizeof(record));
+        ESP_LOGD(LOG_TAG, "Diagnostic record appended in %lld us (%s)", esp_timer_get_time() - append_start_us,
+                 esp_err_to_name(err));
+    }
+
+    // The heap is rebuilt on every wake, but an allocation here is one that would repeat on every wake
+    const uint32_t allocations = Diagnostics::AllocTracker::End();
+    if (allocations > 0)
+    {
+        ESP_LOGE(LOG_TAG, "Wake made %lu heap allocations (%u bytes) outside driver code",
+                 static_cast<unsigned long>(allocations), static_cast<unsigned>(Diagnostics::AllocTracker::Bytes()));
+        if (Config::ALLOC_CHECK_ABORT)
+            abort();
+    }
+
+#if CONFIG_MAILBOX_DELTA_OTA
+    // A verified update starts from a fresh boot; RTC state is reinitialized there
+    if (updater.ReadyToReboot())
+    {
+        ESP_LOGI(LOG_TAG, "Restarting into the updated firmware");
+        esp_restart();
+    }
+#endif
+
+    // A config applied during this wake's session takes effect here
+    // An obstructed sensor is probed less and less often
+    const uint64_t sleep_us = Processor::SleepUs(rtc_store.processor_state, Hardware::Battery::SleepUs(battery.Level(), config));
     ESP_LOGI(LOG_TAG, "Awake for %llu ms, entering deep sleep for %.1f s",
              wake_duration_us / 1000ULL,
-             Config::DEEP_SLEEP_US / 1000000.0);
+             sleep_us / 1000000.0);
 
-    esp_sleep_enable_timer_wakeup(Config::DEEP_SLEEP_US);
+    esp_sleep_enable_timer_wakeup(sleep_us);
+    rtc_store.sleep_until_rtc_us = esp_rtc_get_time_us() + sleep_us;
     esp_deep_sleep_start();
 }
\ No newline at end of file
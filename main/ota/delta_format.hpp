@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Ota
+{
+    /**
+     * Binary delta between two firmware images
+     *
+     *   header   HEADER_SIZE bytes, little-endian (see DeltaHeader)
+     *   windows  one per WINDOW_SIZE bytes of the target image (the last may be shorter)
+     *
+     * Each window is a varint byte count followed by ops that rebuild exactly
+     * its target bytes. Every op starts with the varint (len << 2) | opcode:
+     *
+     *   LITERAL      len raw bytes follow
+     *   COPY_BASE    zigzag varint offset of the source relative to the base
+     *                cursor, which starts at the window's own target offset and
+     *                ends up after each copy (unchanged code copies with 0)
+     *   COPY_TARGET  varint distance back from the current target position
+     *                (may overlap the output, so distance 1 is a byte run)
+     *
+     * Windows are independent of each other except for COPY_TARGET reading
+     * earlier target bytes, which an applier reads back from flash. A
+     * download can therefore resume at any window boundary, and a window
+     * maps onto exactly one flash sector.
+     */
+
+    constexpr uint32_t DELTA_MAGIC = 0x4458424D;                           // "MBXD"
+    constexpr uint16_t DELTA_FORMAT_VERSION = 1;                           // Bumped on incompatible changes
+    constexpr uint32_t WINDOW_SIZE = 4096;                                 // Target bytes per window (one flash sector)
+    constexpr uint32_t MAX_ENCODED_WINDOW = WINDOW_SIZE + WINDOW_SIZE / 8; // Largest encoded window an applier buffers
+    constexpr size_t HEADER_SIZE = 112;                                    // Serialized DeltaHeader (bytes)
+    constexpr size_t VERSION_LEN = 32;                                     // Version string field (bytes)
+
+    enum class DeltaOp : uint8_t
+    {
+        LITERAL = 0,
+        COPY_BASE = 1,
+        COPY_TARGET = 2
+    };
+
+    struct DeltaHeader
+    {
+        uint32_t base_size;               ///< Bytes of the running image the delta applies to
+        uint32_t target_size;             ///< Bytes of the rebuilt image
+        uint8_t base_sha256[32];          ///< SHA-256 of the base image
+        uint8_t target_sha256[32];        ///< SHA-256 of the rebuilt image
+        char target_version[VERSION_LEN]; ///< Version string of the new firmware (NUL-padded)
+    };
+
+    inline void PutU32(uint8_t *p, uint32_t v)
+    {
+        p[0] = static_cast<uint8_t>(v);
+        p[1] = static_cast<uint8_t>(v >> 8);
+        p[2] = static_cast<uint8_t>(v >> 16);
+        p[3] = static_cast<uint8_t>(v >> 24);
+    }
+
+    inline uint32_t GetU32(const uint8_t *p)
+    {
+        return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+               static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+    }
+
+    // Layout: magic, format version (u16), window size (u16), base size, target size, base hash, target hash, version
+    inline void SerializeHeader(const DeltaHeader &header, uint8_t *out)
+    {
+        PutU32(out, DELTA_MAGIC);
+        out[4] = static_cast<uint8_t>(DELTA_FORMAT_VERSION);
+        out[5] = static_cast<uint8_t>(DELTA_FORMAT_VERSION >> 8);
+        out[6] = static_cast<uint8_t>(WINDOW_SIZE);
+        out[7] = static_cast<uint8_t>(WINDOW_SIZE >> 8);
+        PutU32(out + 8, header.base_size);
+        PutU32(out + 12, header.target_size);
+        memcpy(out + 16, header.base_sha256, 32);
+        memcpy(out + 48, header.target_sha256, 32);
+        memcpy(out + 80, header.target_version, VERSION_LEN);
+    }
+
+    // False if the bytes are not a delta this firmware can apply
+    inline bool ParseHeader(const uint8_t *in, DeltaHeader *header)
+    {
+        if (GetU32(in) != DELTA_MAGIC || (in[4] | in[5] << 8) != DELTA_FORMAT_VERSION ||
+            (in[6] | in[7] << 8) != WINDOW_SIZE)
+            return false;
+
+        header->base_size = GetU32(in + 8);
+        header->target_size = GetU32(in + 12);
+        memcpy(header->base_sha256, in + 16, 32);
+        memcpy(header->target_sha256, in + 48, 32);
+        memcpy(header->target_version, in + 80, VERSION_LEN);
+        header->target_version[VERSION_LEN - 1] = '\0';
+        return header->target_size > 0;
+    }
+
+    // Append a LEB128 varint, returns the bytes written (at most 5)
+    inline size_t PutVarint(uint8_t *out, uint32_t v)
+    {
+        size_t n = 0;
+        while (v >= 0x80)
+        {
+            out[n++] = static_cast<uint8_t>(v | 0x80);
+            v >>= 7;
+        }
+        out[n++] = static_cast<uint8_t>(v);
+        return n;
+    }
+
+    // Read a LEB128 varint at *pos, false if it runs past end or overflows 32 bits
+    inline bool GetVarint(const uint8_t *data, size_t end, size_t *pos, uint32_t *v)
+    {
+        uint32_t result = 0;
+        for (int shift = 0; shift < 35; shift += 7)
+        {
+            if (*pos >= end)
+                return false;
+            const uint8_t byte = data[(*pos)++];
+            if (shift == 28 && byte > 0x0F)
+                return false;
+            result |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+            {
+                *v = result;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline uint32_t ZigZag(int32_t v) { return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31); }
+    inline int32_t UnZigZag(uint32_t v) { return static_cast<int32_t>(v >> 1) ^ -static_cast<int32_t>(v & 1); }
+}
\ No newline at end of file
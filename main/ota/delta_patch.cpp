@@ -0,0 +1,221 @@
+#include "delta_patch.hpp"
+
+#include <algorithm>
+
+namespace Ota
+{
+    DeltaPatcher::DeltaPatcher(ImageIo *io)
+        : io_(io)
+    {
+        Reset();
+    }
+
+    void DeltaPatcher::Reset()
+    {
+        header_ = {};
+        has_header_ = false;
+        failed_ = false;
+        committed_offset_ = 0;
+        target_offset_ = 0;
+        window_len_ = 0;
+        pending_len_ = 0;
+    }
+
+    void DeltaPatcher::Resume(const DeltaHeader &header, uint32_t delta_offset, uint32_t target_offset)
+    {
+        Reset();
+        header_ = header;
+        has_header_ = true;
+        committed_offset_ = delta_offset;
+        target_offset_ = target_offset;
+    }
+
+    esp_err_t DeltaPatcher::Feed(const uint8_t *data, size_t len)
+    {
+        if (failed_)
+            return ESP_ERR_INVALID_STATE;
+
+        while (len > 0)
+        {
+            if (!has_header_)
+            {
+                const size_t take = std::min(len, HEADER_SIZE - pending_len_);
+                memcpy(pending_ + pending_len_, data, take);
+                pending_len_ += take;
+                data += take;
+                len -= take;
+
+                if (pending_len_ < HEADER_SIZE)
+                    continue;
+                if (!ParseHeader(pending_, &header_))
+                {
+                    failed_ = true;
+                    return ESP_ERR_INVALID_VERSION;
+                }
+                has_header_ = true;
+                committed_offset_ += HEADER_SIZE;
+                pending_len_ = 0;
+                continue;
+            }
+
+            // Bytes past the last window
+            if (IsComplete())
+            {
+                failed_ = true;
+                return ESP_ERR_INVALID_SIZE;
+            }
+
+            // Length prefix, one byte at a time until the varint is complete
+            if (window_len_ == 0)
+            {
+                pending_[pending_len_++] = *data++;
+                --len;
+
+                size_t pos = 0;
+                uint32_t window_len = 0;
+                if (GetVarint(pending_, pending_len_, &pos, &window_len))
+                {
+                    if (window_len == 0 || window_len > MAX_ENCODED_WINDOW)
+                    {
+                        failed_ = true;
+                        return ESP_ERR_INVALID_SIZE;
+                    }
+                    window_len_ = window_len;
+                }
+                else if (pending_len_ >= 5)
+                {
+                    failed_ = true;
+                    return ESP_ERR_INVALID_SIZE;
+                }
+                continue;
+            }
+
+            size_t prefix_len = 0;
+            uint32_t unused = 0;
+            GetVarint(pending_, pending_len_, &prefix_len, &unused);
+
+            const size_t window_end = prefix_len + window_len_;
+            const size_t take = std::min(len, window_end - pending_len_);
+            memcpy(pending_ + pending_len_, data, take);
+            pending_len_ += take;
+            data += take;
+            len -= take;
+
+            if (pending_len_ < window_end)
+                continue;
+
+            const esp_err_t err = applyWindow(prefix_len);
+            if (err != ESP_OK)
+            {
+                failed_ = true;
+                return err;
+            }
+            committed_offset_ += static_cast<uint32_t>(pending_len_);
+            pending_len_ = 0;
+            window_len_ = 0;
+        }
+
+        return ESP_OK;
+    }
+
+    esp_err_t DeltaPatcher::applyWindow(size_t start)
+    {
+        const uint32_t expected = std::min(WINDOW_SIZE, header_.target_size - target_offset_);
+        const size_t end = pending_len_;
+        size_t pos = start;
+        uint32_t out = 0;
+        uint32_t base_cursor = target_offset_;
+
+        while (pos < end)
+        {
+            uint32_t tag = 0;
+            if (!GetVarint(pending_, end, &pos, &tag))
+                return ESP_ERR_INVALID_SIZE;
+
+            const uint32_t len = tag >> 2;
+            if (len == 0 || len > expected - out)
+                return ESP_ERR_INVALID_SIZE;
+
+            switch (static_cast<DeltaOp>(tag & 3))
+            {
+            case DeltaOp::LITERAL:
+                if (end - pos < len)
+                    return ESP_ERR_INVALID_SIZE;
+                memcpy(window_ + out, pending_ + pos, len);
+                pos += len;
+                break;
+
+            case DeltaOp::COPY_BASE:
+            {
+                uint32_t relative = 0;
+                if (!GetVarint(pending_, end, &pos, &relative))
+                    return ESP_ERR_INVALID_SIZE;
+                const int64_t source = static_cast<int64_t>(base_cursor) + UnZigZag(relative);
+                if (source < 0 || source + len > header_.base_size)
+                    return ESP_ERR_INVALID_SIZE;
+
+                const esp_err_t err = io_->ReadBase(static_cast<uint32_t>(source), window_ + out, len);
+                if (err != ESP_OK)
+                    return err;
+                base_cursor = static_cast<uint32_t>(source) + len;
+                break;
+            }
+
+            case DeltaOp::COPY_TARGET:
+            {
+                uint32_t distance = 0;
+                if (!GetVarint(pending_, end, &pos, &distance))
+                    return ESP_ERR_INVALID_SIZE;
+                const esp_err_t err = copyTarget(out, distance, len);
+                if (err != ESP_OK)
+                    return err;
+                break;
+            }
+
+            default:
+                return ESP_ERR_INVALID_SIZE;
+            }
+
+            out += len;
+        }
+
+        if (out != expected)
+            return ESP_ERR_INVALID_SIZE;
+
+        const esp_err_t err = io_->WriteWindow(target_offset_, window_, expected);
+        if (err != ESP_OK)
+            return err;
+        target_offset_ += expected;
+        return ESP_OK;
+    }
+
+    esp_err_t DeltaPatcher::copyTarget(uint32_t pos, uint32_t distance, uint32_t len)
+    {
+        const uint32_t absolute = target_offset_ + pos;
+        if (distance == 0 || distance > absolute)
+            return ESP_ERR_INVALID_SIZE;
+
+        uint32_t source = absolute - distance;
+        while (len > 0)
+        {
+            if (source < target_offset_)
+            {
+                // Earlier window: already in the target image
+                const uint32_t n = std::min(len, target_offset_ - source);
+                const esp_err_t err = io_->ReadTarget(source, window_ + pos, n);
+                if (err != ESP_OK)
+                    return err;
+                source += n;
+                pos += n;
+                len -= n;
+            }
+            else
+            {
+                // Byte by byte so an overlapping copy repeats the bytes it just produced
+                for (; len > 0; --len)
+                    window_[pos++] = window_[source++ - target_offset_];
+            }
+        }
+        return ESP_OK;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+
+#include "delta_format.hpp"
+
+namespace Ota
+{
+    // Storage a delta is applied between (flash partitions on the device, files on the host)
+    class ImageIo
+    {
+    public:
+        virtual ~ImageIo() = default;
+
+        // Read from the image the delta was built against
+        virtual esp_err_t ReadBase(uint32_t offset, void *buf, size_t len) = 0;
+
+        // Read back target bytes written by an earlier window
+        virtual esp_err_t ReadTarget(uint32_t offset, void *buf, size_t len) = 0;
+
+        // Store one complete window (offset is a multiple of WINDOW_SIZE)
+        virtual esp_err_t WriteWindow(uint32_t offset, const uint8_t *data, size_t len) = 0;
+    };
+
+    /**
+     * Streaming applier for the delta format in delta_format.hpp
+     *
+     * Delta bytes are fed in order in chunks of any size. The header is
+     * parsed from the first HEADER_SIZE bytes; after that each window is
+     * buffered until complete, rebuilt and handed to ImageIo::WriteWindow.
+     * Bytes of an incomplete window are lost when the patcher goes away, so
+     * a resumed download restarts at CommittedOffset().
+     */
+    class DeltaPatcher
+    {
+    public:
+        explicit DeltaPatcher(ImageIo *io);
+
+        // Start over at the beginning of a delta
+        void Reset();
+
+        // Continue after the windows before delta_offset (a CommittedOffset()) were written
+        void Resume(const DeltaHeader &header, uint32_t delta_offset, uint32_t target_offset);
+
+        /**
+         * Consume the next delta bytes
+         *
+         * Returns ESP_ERR_INVALID_VERSION for a header this firmware cannot
+         * apply, ESP_ERR_INVALID_SIZE for a malformed window and the ImageIo
+         * error if reading or writing failed. The patcher is unusable after
+         * an error until Reset() or Resume().
+         */
+        esp_err_t Feed(const uint8_t *data, size_t len);
+
+        bool HasHeader() const { return has_header_; }
+        const DeltaHeader &Header() const { return header_; }
+
+        // All target bytes written
+        bool IsComplete() const { return has_header_ && target_offset_ >= header_.target_size; }
+
+        // Delta offset of the next byte Feed() expects
+        uint32_t ReceivedOffset() const { return committed_offset_ + static_cast<uint32_t>(pending_len_); }
+
+        // Delta offset after the last complete window (where a later session resumes)
+        uint32_t CommittedOffset() const { return committed_offset_; }
+
+        // Target bytes written so far
+        uint32_t TargetOffset() const { return target_offset_; }
+
+    private:
+        ImageIo *io_;
+        DeltaHeader header_;
+        bool has_header_;
+        bool failed_;
+
+        uint32_t committed_offset_; ///< Delta bytes consumed by complete windows (and the header)
+        uint32_t target_offset_;    ///< Target bytes written
+        uint32_t window_len_;       ///< Encoded size of the window being received (0: size not yet known)
+
+        uint8_t pending_[MAX_ENCODED_WINDOW + 5]; ///< Header or encoded window being received, with its length prefix
+        size_t pending_len_;                      ///< Valid bytes in pending_
+        uint8_t window_[WINDOW_SIZE];             ///< Rebuilt target bytes of the current window
+
+        // Rebuild the window in pending_[start, pending_len_) and write it
+        esp_err_t applyWindow(size_t start);
+
+        // COPY_TARGET: copy len bytes from distance back, reading earlier windows from the target image
+        esp_err_t copyTarget(uint32_t pos, uint32_t distance, uint32_t len);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,393 @@
+#include "delta_updater.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "cJSON.h"
+#include "esp_ota_ops.h"
+#include "esp_timer.h"
+#include "mbedtls/sha256.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+namespace Ota
+{
+    DeltaUpdater::PartitionIo::PartitionIo(const esp_partition_t *base, const esp_partition_t *target)
+        : base_(base), target_(target)
+    {
+    }
+
+    esp_err_t DeltaUpdater::PartitionIo::ReadBase(uint32_t offset, void *buf, size_t len)
+    {
+        return esp_partition_read(base_, offset, buf, len);
+    }
+
+    esp_err_t DeltaUpdater::PartitionIo::ReadTarget(uint32_t offset, void *buf, size_t len)
+    {
+        return esp_partition_read(target_, offset, buf, len);
+    }
+
+    esp_err_t DeltaUpdater::PartitionIo::WriteWindow(uint32_t offset, const uint8_t *data, size_t len)
+    {
+        // A resumed download rewrites the window that was in flight, so always erase first
+        esp_err_t err = esp_partition_erase_range(target_, offset, WINDOW_SIZE);
+        if (err == ESP_OK)
+            err = esp_partition_write(target_, offset, data, len);
+        return err;
+    }
+
+    DeltaUpdater::DeltaUpdater(UpdateProgress *rtc_progress)
+        : progress_(rtc_progress),
+          telemetry_(nullptr),
+          io_(nullptr),
+          patcher_(nullptr),
+          ready_to_reboot_(false),
+          offer_len_(0),
+          chunk_(nullptr),
+          chunk_len_(0)
+    {
+    }
+
+    DeltaUpdater::~DeltaUpdater()
+    {
+        delete patcher_;
+        delete io_;
+        delete[] chunk_;
+    }
+
+    esp_err_t DeltaUpdater::Load()
+    {
+        *progress_ = {};
+
+        nvs_handle_t handle;
+        esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle);
+        if (err != ESP_OK)
+            return err == ESP_ERR_NVS_NOT_FOUND ? ESP_OK : err;
+
+        UpdateProgress stored;
+        size_t len = sizeof(stored);
+        err = nvs_get_blob(handle, NVS_KEY, &stored, &len);
+        nvs_close(handle);
+
+        if (err == ESP_ERR_NVS_NOT_FOUND)
+            return ESP_OK;
+        if (err != ESP_OK || len != sizeof(stored))
+        {
+            ESP_LOGW(LOG_TAG, "Ignoring stored update progress (%s)", esp_err_to_name(err));
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        *progress_ = stored;
+        if (stored.delta_id != 0)
+        {
+            ESP_LOGI(LOG_TAG, "Update %08lx resumes at %lu/%lu bytes", static_cast<unsigned long>(stored.delta_id),
+                     static_cast<unsigned long>(stored.delta_offset), static_cast<unsigned long>(stored.delta_size));
+        }
+        return ESP_OK;
+    }
+
+    esp_err_t DeltaUpdater::Attach(Telemetry::Telemetry *telemetry)
+    {
+        // Only sessions need the chunk buffer, so quiet wakes do not carry it on the main task stack
+        if (!chunk_)
+            chunk_ = new uint8_t[MAX_CHUNK_LEN];
+        telemetry_ = telemetry;
+        esp_err_t err = telemetry->Subscribe("ota/offer", onOfferMessage, this);
+        if (err == ESP_OK)
+            err = telemetry->Subscribe("ota/data", onChunkMessage, this);
+        if (err != ESP_OK)
+            ESP_LOGW(LOG_TAG, "Failed to subscribe to update topics: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    esp_err_t DeltaUpdater::Run(uint32_t budget_ms)
+    {
+        uint32_t id = 0;
+        uint32_t size = 0;
+        if (!telemetry_ || !parseOffer(&id, &size) || id == progress_->finished_id)
+            return ESP_OK;
+
+        const UpdateProgress before = *progress_;
+        if (id != progress_->delta_id)
+        {
+            ESP_LOGI(LOG_TAG, "New update %08lx offered (%lu bytes)", static_cast<unsigned long>(id),
+                     static_cast<unsigned long>(size));
+            const uint32_t finished_id = progress_->finished_id;
+            *progress_ = {};
+            progress_->delta_id = id;
+            progress_->delta_size = size;
+            progress_->finished_id = finished_id;
+        }
+
+        if (!patcher_)
+        {
+            io_ = new PartitionIo(esp_ota_get_running_partition(), esp_ota_get_next_update_partition(nullptr));
+            patcher_ = new DeltaPatcher(io_);
+        }
+        if (progress_->delta_offset > 0)
+            patcher_->Resume(progress_->header, progress_->delta_offset, progress_->target_offset);
+        else
+            patcher_->Reset();
+
+        const int64_t start_us = esp_timer_get_time();
+        esp_err_t err = ESP_OK;
+        for (uint32_t chunks = 0; chunks < Config::OTA_CHUNKS_PER_SESSION && !patcher_->IsComplete(); ++chunks)
+        {
+            if ((esp_timer_get_time() - start_us) / 1000 >= budget_ms)
+                break;
+
+            const uint32_t offset = patcher_->ReceivedOffset();
+            const uint32_t len = std::min(Config::OTA_CHUNK_BYTES, size - std::min(offset, size));
+            if (len == 0)
+            {
+                reject("delta ends before the image is complete");
+                err = ESP_ERR_INVALID_SIZE;
+                break;
+            }
+            if (!fetchChunk(id, offset, len, Config::OTA_CHUNK_TIMEOUT_MS))
+            {
+                ESP_LOGW(LOG_TAG, "No chunk at offset %lu, continuing next session", static_cast<unsigned long>(offset));
+                break;
+            }
+
+            const uint8_t *data = chunk_ + CHUNK_HEADER_LEN;
+            size_t data_len = chunk_len_ - CHUNK_HEADER_LEN;
+
+            // Nothing is written before the running image is known to be the delta's base
+            if (!patcher_->HasHeader())
+            {
+                const size_t header_len = std::min(data_len, HEADER_SIZE);
+                err = patcher_->Feed(data, header_len);
+                data += header_len;
+                data_len -= header_len;
+                if (err == ESP_OK && patcher_->HasHeader())
+                {
+                    err = checkHeader(patcher_->Header());
+                    progress_->header = patcher_->Header();
+                }
+            }
+            if (err == ESP_OK)
+                err = patcher_->Feed(data, data_len);
+            chunk_len_ = 0;
+
+            if (err != ESP_OK)
+            {
+                // A bad delta is never retried; flash errors leave the progress for the next session
+                if (err == ESP_ERR_INVALID_SIZE || err == ESP_ERR_INVALID_VERSION || err == ESP_ERR_INVALID_CRC ||
+                    err == ESP_ERR_NOT_FOUND)
+                    reject(esp_err_to_name(err));
+                else
+                    ESP_LOGW(LOG_TAG, "Update stopped: %s", esp_err_to_name(err));
+                break;
+            }
+
+            progress_->delta_offset = patcher_->CommittedOffset();
+            progress_->target_offset = patcher_->TargetOffset();
+        }
+
+        if (progress_->delta_id != 0 && patcher_->IsComplete())
+            err = install();
+
+        if (progress_->delta_id != 0)
+        {
+            ESP_LOGI(LOG_TAG, "Update %08lx at %lu/%lu bytes", static_cast<unsigned long>(id),
+                     static_cast<unsigned long>(progress_->delta_offset), static_cast<unsigned long>(size));
+        }
+
+        // Sessions without progress leave flash alone
+        if (memcmp(&before, progress_, sizeof(before)) != 0)
+            save();
+        return err;
+    }
+
+    bool DeltaUpdater::PendingVerify()
+    {
+        esp_ota_img_states_t state;
+        return esp_ota_get_state_partition(esp_ota_get_running_partition(), &state) == ESP_OK &&
+               state == ESP_OTA_IMG_PENDING_VERIFY;
+    }
+
+    void DeltaUpdater::ConfirmRunningImage(bool healthy)
+    {
+        if (healthy)
+        {
+            ESP_LOGI(LOG_TAG, "New firmware reported successfully, keeping it");
+            esp_ota_mark_app_valid_cancel_rollback();
+            return;
+        }
+
+        ESP_LOGE(LOG_TAG, "New firmware failed to report, rolling back");
+        esp_ota_mark_app_invalid_rollback_and_reboot();
+    }
+
+    void DeltaUpdater::onOfferMessage(const char *data, int data_len, void *arg)
+    {
+        auto *updater = static_cast<DeltaUpdater *>(arg);
+        if (data_len <= 0 || static_cast<size_t>(data_len) >= sizeof(updater->offer_))
+            return;
+
+        // Only the MQTT task writes, and Run() reads once the retained offer had time to arrive
+        memcpy(updater->offer_, data, data_len);
+        updater->offer_len_ = static_cast<size_t>(data_len);
+    }
+
+    void DeltaUpdater::onChunkMessage(const char *data, int data_len, void *arg)
+    {
+        auto *updater = static_cast<DeltaUpdater *>(arg);
+        if (data_len <= static_cast<int>(CHUNK_HEADER_LEN) || static_cast<size_t>(data_len) > MAX_CHUNK_LEN)
+            return;
+
+        // One request is in flight at a time; anything arriving while the slot is taken is a stale duplicate
+        if (updater->chunk_len_ != 0)
+            return;
+        memcpy(updater->chunk_, data, data_len);
+        updater->chunk_len_ = static_cast<size_t>(data_len);
+    }
+
+    bool DeltaUpdater::parseOffer(uint32_t *id, uint32_t *size)
+    {
+        const size_t len = offer_len_;
+        if (len == 0)
+            return false;
+
+        cJSON *root = cJSON_ParseWithLength(offer_, len);
+        const cJSON *id_item = cJSON_GetObjectItemCaseSensitive(root, "id");
+        const cJSON *size_item = cJSON_GetObjectItemCaseSensitive(root, "size");
+        const bool valid = cJSON_IsNumber(id_item) && cJSON_IsNumber(size_item) &&
+                           id_item->valuedouble >= 1 && id_item->valuedouble <= UINT32_MAX &&
+                           size_item->valuedouble > HEADER_SIZE && size_item->valuedouble <= UINT32_MAX;
+        if (valid)
+        {
+            *id = static_cast<uint32_t>(id_item->valuedouble);
+            *size = static_cast<uint32_t>(size_item->valuedouble);
+        }
+        else
+        {
+            ESP_LOGW(LOG_TAG, "Ignoring malformed update offer");
+        }
+        cJSON_Delete(root);
+        return valid;
+    }
+
+    bool DeltaUpdater::fetchChunk(uint32_t id, uint32_t offset, uint32_t len, uint32_t timeout_ms)
+    {
+        char request[80];
+        snprintf(request, sizeof(request), "{\"id\":%lu,\"offset\":%lu,\"len\":%lu}", static_cast<unsigned long>(id),
+                 static_cast<unsigned long>(offset), static_cast<unsigned long>(len));
+        chunk_len_ = 0;
+        if (telemetry_->PublishRaw("ota/req", request) != ESP_OK)
+            return false;
+
+        const int64_t deadline_us = esp_timer_get_time() + static_cast<int64_t>(timeout_ms) * 1000;
+        while (esp_timer_get_time() < deadline_us)
+        {
+            const size_t chunk_len = chunk_len_;
+            if (chunk_len == 0)
+            {
+                vTaskDelay(pdMS_TO_TICKS(10));
+                continue;
+            }
+
+            if (GetU32(chunk_) == id && GetU32(chunk_ + 4) == offset)
+                return true;
+            chunk_len_ = 0; // Redelivered earlier chunk
+        }
+        return false;
+    }
+
+    esp_err_t DeltaUpdater::checkHeader(const DeltaHeader &header)
+    {
+        const esp_partition_t *running = esp_ota_get_running_partition();
+        const esp_partition_t *target = esp_ota_get_next_update_partition(nullptr);
+        if (!running || !target)
+            return ESP_ERR_NOT_FOUND;
+        if (header.base_size > running->size || header.target_size > target->size)
+            return ESP_ERR_INVALID_SIZE;
+
+        uint8_t sha256[32];
+        const esp_err_t err = hashPartition(running, header.base_size, sha256);
+        if (err != ESP_OK)
+            return err;
+        if (memcmp(sha256, header.base_sha256, sizeof(sha256)) != 0)
+        {
+            ESP_LOGW(LOG_TAG, "Update to %s was built for a different firmware", header.target_version);
+            return ESP_ERR_INVALID_CRC;
+        }
+
+        ESP_LOGI(LOG_TAG, "Updating to %s: %lu bytes into %s", header.target_version,
+                 static_cast<unsigned long>(header.target_size), target->label);
+        return ESP_OK;
+    }
+
+    esp_err_t DeltaUpdater::install()
+    {
+        const esp_partition_t *target = esp_ota_get_next_update_partition(nullptr);
+        const DeltaHeader &header = progress_->header;
+
+        uint8_t sha256[32];
+        esp_err_t err = hashPartition(target, header.target_size, sha256);
+        if (err == ESP_OK && memcmp(sha256, header.target_sha256, sizeof(sha256)) != 0)
+            err = ESP_ERR_INVALID_CRC;
+        if (err == ESP_OK)
+            err = esp_ota_set_boot_partition(target); // Also validates the image structure
+        if (err != ESP_OK)
+        {
+            reject("rebuilt image failed verification");
+            return err;
+        }
+
+        ESP_LOGI(LOG_TAG, "Firmware %s verified and selected for boot", header.target_version);
+        progress_->finished_id = progress_->delta_id;
+        progress_->delta_id = 0;
+        ready_to_reboot_ = true;
+        return ESP_OK;
+    }
+
+    esp_err_t DeltaUpdater::hashPartition(const esp_partition_t *partition, uint32_t len, uint8_t out[32])
+    {
+        uint8_t buf[512];
+        mbedtls_sha256_context ctx;
+        mbedtls_sha256_init(&ctx);
+        mbedtls_sha256_starts(&ctx, 0);
+
+        esp_err_t err = ESP_OK;
+        for (uint32_t offset = 0; offset < len && err == ESP_OK; offset += sizeof(buf))
+        {
+            const size_t n = std::min<size_t>(sizeof(buf), len - offset);
+            err = esp_partition_read(partition, offset, buf, n);
+            if (err == ESP_OK)
+                mbedtls_sha256_update(&ctx, buf, n);
+        }
+
+        mbedtls_sha256_finish(&ctx, out);
+        mbedtls_sha256_free(&ctx);
+        return err;
+    }
+
+    void DeltaUpdater::reject(const char *reason)
+    {
+        ESP_LOGE(LOG_TAG, "Update %08lx rejected: %s", static_cast<unsigned long>(progress_->delta_id), reason);
+        const uint32_t id = progress_->delta_id;
+        *progress_ = {};
+        progress_->finished_id = id;
+    }
+
+    esp_err_t DeltaUpdater::save()
+    {
+        nvs_handle_t handle;
+        esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+        if (err == ESP_OK)
+        {
+            err = nvs_set_blob(handle, NVS_KEY, progress_, sizeof(*progress_));
+            if (err == ESP_OK)
+                err = nvs_commit(handle);
+            nvs_close(handle);
+        }
+
+        if (err != ESP_OK)
+            ESP_LOGE(LOG_TAG, "Failed to save update progress: %s", esp_err_to_name(err));
+        return err;
+    }
+}
\ No newline at end of file
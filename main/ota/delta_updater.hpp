@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+
+#include "delta_patch.hpp"
+#include "telemetry.hpp"
+
+namespace Ota
+{
+    // Download progress that must survive deep sleep (RtcStore) and power loss (NVS)
+    struct UpdateProgress
+    {
+        uint32_t delta_id;      ///< Delta being downloaded (0: none)
+        uint32_t delta_size;    ///< Total bytes of delta_id
+        uint32_t delta_offset;  ///< Delta bytes applied, always a window boundary (0: header not yet received)
+        uint32_t target_offset; ///< Target bytes written to the update partition
+        uint32_t finished_id;   ///< Last delta installed or rejected, never downloaded again
+        DeltaHeader header;     ///< Header of delta_id (valid once delta_offset > 0)
+    };
+
+    /**
+     * Firmware update over the reporting sessions the device opens anyway
+     *
+     * An operator publishes a retained offer on {base}/ota/offer:
+     *
+     *   {"id":3735928559,"size":48213,"version":"1.1.0"}
+     *
+     * where id identifies the delta (tools/delta builds and serves it).
+     * Each session asks for the next chunks on {base}/ota/req
+     * ({"id","offset","len"}) and receives them on {base}/ota/data as
+     * [u32 id][u32 offset][bytes], little-endian. Complete windows are
+     * applied straight into the inactive OTA slot, so progress is kept as
+     * one offset and the next session resumes there. Before the first
+     * window the running image is checked against the delta's base hash;
+     * after the last, the rebuilt image is checked against the target hash
+     * and only then selected for boot.
+     *
+     * The new image boots pending verification (app rollback) and must
+     * complete one reporting session to be kept, see ConfirmRunningImage().
+     */
+    class DeltaUpdater
+    {
+    public:
+        // Updater over the RTC progress (must be initialized with Load() after power loss)
+        explicit DeltaUpdater(UpdateProgress *rtc_progress);
+
+        ~DeltaUpdater();
+
+        // Fill the progress from NVS (NVS must be initialized)
+        esp_err_t Load();
+
+        // Subscribe to offers and chunks on an initialized telemetry session
+        esp_err_t Attach(Telemetry::Telemetry *telemetry);
+
+        /**
+         * Continue the offered update for at most budget_ms
+         *
+         * Does nothing if no offer arrived or the offered delta was already
+         * handled. Stops early after Config::OTA_CHUNKS_PER_SESSION chunks or
+         * when a chunk does not arrive in time; either way the progress up to
+         * the last complete window is saved to NVS.
+         */
+        esp_err_t Run(uint32_t budget_ms);
+
+        // A verified image was written and selected for boot (restart to run it)
+        bool ReadyToReboot() const { return ready_to_reboot_; }
+
+        // The running image was just installed and is still pending verification
+        static bool PendingVerify();
+
+        // Keep the running image, or mark it invalid and reboot into the previous one
+        static void ConfirmRunningImage(bool healthy);
+
+    private:
+        static constexpr const char *LOG_TAG = "OTA";
+        static constexpr const char *NVS_NAMESPACE = "ota";
+        static constexpr const char *NVS_KEY = "progress";
+        static constexpr size_t MAX_OFFER_LEN = 128;
+        static constexpr size_t CHUNK_HEADER_LEN = 8;
+
+        // Applies windows between the running and the update partition
+        class PartitionIo : public ImageIo
+        {
+        public:
+            PartitionIo(const esp_partition_t *base, const esp_partition_t *target);
+            esp_err_t ReadBase(uint32_t offset, void *buf, size_t len) override;
+            esp_err_t ReadTarget(uint32_t offset, void *buf, size_t len) override;
+            esp_err_t WriteWindow(uint32_t offset, const uint8_t *data, size_t len) override;
+
+        private:
+            const esp_partition_t *base_;
+            const esp_partition_t *target_;
+        };
+
+        UpdateProgress *progress_;        ///< RTC mirror
+        Telemetry::Telemetry *telemetry_; ///< Session chunks are requested on (NULL until attached)
+        PartitionIo *io_;                 ///< Partition access (NULL until an update runs)
+        DeltaPatcher *patcher_;           ///< Allocated when an update runs (~8 KB)
+        bool ready_to_reboot_;
+
+        char offer_[MAX_OFFER_LEN];     ///< Last {base}/ota/offer payload
+        std::atomic<size_t> offer_len_; ///< Valid bytes in offer_ (0 if none)
+
+        static constexpr size_t MAX_CHUNK_LEN = CHUNK_HEADER_LEN + Config::OTA_CHUNK_BYTES;
+        uint8_t *chunk_;                ///< Last {base}/ota/data payload (MAX_CHUNK_LEN, allocated by Attach)
+        std::atomic<size_t> chunk_len_; ///< Valid bytes in chunk_ (0: free for the next chunk)
+
+        // Copy an offer / chunk (MQTT task) for Run() to process
+        static void onOfferMessage(const char *data, int data_len, void *arg);
+        static void onChunkMessage(const char *data, int data_len, void *arg);
+
+        // Parse offer_, false if there is none or it is malformed
+        bool parseOffer(uint32_t *id, uint32_t *size);
+
+        // Request [offset, offset + len) and wait for it, false on timeout
+        bool fetchChunk(uint32_t id, uint32_t offset, uint32_t len, uint32_t timeout_ms);
+
+        // Check the running image against the delta's base and the update slot's size
+        esp_err_t checkHeader(const DeltaHeader &header);
+
+        // Verify the rebuilt image and select it for boot
+        esp_err_t install();
+
+        // SHA-256 of the first len bytes of a partition
+        static esp_err_t hashPartition(const esp_partition_t *partition, uint32_t len, uint8_t out[32]);
+
+        // Give up on the current delta for good
+        void reject(const char *reason);
+
+        // Write the progress to NVS
+        esp_err_t save();
+    };
+}
\ No newline at end of file
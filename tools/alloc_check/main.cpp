@@ -0,0 +1,395 @@
+#include "fleet_sim/trace_model.hpp"
+
+#include "host_adc.hpp"
+#include "host_mqtt.hpp"
+#include "host_nvs.hpp"
+#include "config/config.hpp"
+#include "config/runtime_config.hpp"
+#include "diagnostics/alloc_tracker.hpp"
+#include "sensor/battery/battery_monitor.hpp"
+#include "processor/checkpoint.hpp"
+#include "processor/digest.hpp"
+#include "processor/flap_damper.hpp"
+#include "processor/processor.hpp"
+#include "telemetry/report_schedule.hpp"
+#include "telemetry/telemetry.hpp"
+#include "transport/broker_endpoints.hpp"
+#include "esp_log.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <thread>
+
+// Every allocation of the process goes through here and on to glibc
+extern "C"
+{
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t count, size_t size);
+    void *__libc_realloc(void *ptr, size_t size);
+    void *__libc_memalign(size_t alignment, size_t size);
+
+    void *malloc(size_t size)
+    {
+        Diagnostics::AllocTracker::OnAlloc(size);
+        return __libc_malloc(size);
+    }
+
+    void *calloc(size_t count, size_t size)
+    {
+        Diagnostics::AllocTracker::OnAlloc(count * size);
+        return __libc_calloc(count, size);
+    }
+
+    void *realloc(void *ptr, size_t size)
+    {
+        Diagnostics::AllocTracker::OnAlloc(size);
+        return __libc_realloc(ptr, size);
+    }
+
+    void *memalign(size_t alignment, size_t size)
+    {
+        Diagnostics::AllocTracker::OnAlloc(size);
+        return __libc_memalign(alignment, size);
+    }
+
+    void *aligned_alloc(size_t alignment, size_t size)
+    {
+        return memalign(alignment, size);
+    }
+
+    int posix_memalign(void **ptr, size_t alignment, size_t size)
+    {
+        *ptr = memalign(alignment, size);
+        return *ptr ? 0 : ENOMEM;
+    }
+}
+
+namespace
+{
+    // RTC memory of the checked device, as in app_main
+    struct RtcStore
+    {
+        uint32_t boot_count;
+        Processor::StateContext processor_state;
+        uint64_t last_telemetry_time_sec;
+        uint64_t virtual_time_us;
+        Telemetry::PersistentState telemetry_state;
+        Config::RuntimeConfig runtime_config;
+        Hardware::Battery::BatteryState battery;
+        Processor::CheckpointState checkpoint;
+        Processor::DigestState digest;
+        Processor::FlapState flap;
+        Telemetry::BackoffState backoff;
+        Telemetry::Publisher::EndpointCache endpoints;
+    };
+
+    struct Options
+    {
+        const char *broker_uri;
+        uint32_t wakes;
+        uint32_t connect_ms;
+        int32_t digest_at_min;
+        bool flap_damping;
+        uint64_t seed;
+    };
+
+    // What the run did, for the summary
+    struct Counters
+    {
+        uint32_t sessions;
+        uint32_t events;
+        uint32_t obstructions;
+        uint32_t obstructed_wakes;
+        uint64_t obstructed_us;
+    };
+
+    // Client ID of the checked device, also the source of its heartbeat phase
+    constexpr const char *DEVICE_ID = "alloc-check-device";
+
+    // Wall clock of the first wake (2026-01-01 12:00 UTC); it then follows virtual time
+    constexpr int64_t START_WALL_S = 1767268800 + 12 * 3600;
+
+    void usage(const char *argv0)
+    {
+        printf("Usage: %s [options]\n"
+               "  --broker URI          broker to publish to (default mqtt://127.0.0.1:1883)\n"
+               "  --wakes N             number of wakes to run (default 2000)\n"
+               "  --connect-ms MS       wait for the broker per session, 0 = publish offline (default 0)\n"
+               "  --drops-per-day X     mean mail drops per day (default 200)\n"
+               "  --digest-at MIN       digest mode: report once a day at this minute after midnight, -1 = off (default -1)\n"
+               "  --flaps-per-day X     mean flapping episodes per day, a curled envelope at the threshold (default 0)\n"
+               "  --flap-minutes M      length of one flapping episode (default 30)\n"
+               "  --flap-period S       flat/curled period during an episode (default 30)\n"
+               "  --no-flap-damping     report every transition, as without Config::FLAP_DAMPING_ENABLED\n"
+               "  --obstructions X      mean sensor obstructions per day, every reading invalid (default 0)\n"
+               "  --obstruct-hours H    length of one obstruction (default 6)\n"
+               "  --seed N              random seed of the distance trace (default 1)\n"
+               "  --verbose             print firmware INFO logs\n",
+               argv0);
+    }
+
+    /**
+     * One wake of app_main without the radio bring-up
+     *
+     * Wi-Fi, SNTP and OTA are left out; they run inside Exempt scopes on the
+     * device anyway. Returns the allocations the wake counted.
+     */
+    uint32_t runWake(const Options &options, RtcStore &rtc, Config::RuntimeConfigStore &config_store,
+                     FleetSim::TraceModel &trace, bool is_fresh_boot, Counters *counters)
+    {
+        Diagnostics::AllocTracker::Begin();
+        Processor::CheckpointStore checkpoint(&rtc.checkpoint);
+        uint64_t slept_us = 0;
+
+        if (is_fresh_boot)
+        {
+            Diagnostics::AllocTracker::Exempt exempt; // NVS
+            config_store.Load();
+            rtc.runtime_config.digest_at_min = options.digest_at_min;
+            Processor::Processor temp(rtc.runtime_config);
+            rtc.processor_state = temp.GetContext();
+            checkpoint.Restore(&rtc.processor_state, &rtc.boot_count);
+        }
+        else
+        {
+            rtc.boot_count++;
+            slept_us = Processor::SleepUs(rtc.processor_state, Hardware::Battery::SleepUs(rtc.battery.level, rtc.runtime_config));
+            rtc.virtual_time_us += slept_us;
+        }
+
+        Hardware::Battery::BatteryMonitor battery(&rtc.battery);
+        battery.Update(is_fresh_boot);
+
+        Processor::Processor processor(rtc.processor_state, rtc.runtime_config);
+        Processor::DistanceData data = processor.Process(trace.Sample(rtc.virtual_time_us), rtc.virtual_time_us);
+        rtc.processor_state = processor.GetContext();
+        Telemetry::EventTrace event_trace = {};
+        event_trace.detected_us = esp_timer_get_time();
+        event_trace.window_ms = static_cast<uint32_t>(slept_us / 1000ULL);
+
+        Processor::FlapDamper flap(&rtc.flap);
+        if (options.flap_damping)
+            flap.Record(data, rtc.virtual_time_us);
+
+        if (checkpoint.Due(rtc.processor_state, rtc.virtual_time_us))
+        {
+            Diagnostics::AllocTracker::Exempt exempt; // NVS
+            checkpoint.Save(rtc.processor_state, rtc.boot_count, rtc.virtual_time_us);
+        }
+
+        const bool digest_mode = rtc.runtime_config.digest_at_min >= 0;
+        Processor::DigestAggregator digest(&rtc.digest);
+        const int64_t wall_s = START_WALL_S + static_cast<int64_t>(rtc.virtual_time_us / 1000000ULL);
+        digest.Record(data, battery.Level() == Hardware::Battery::PowerLevel::CRITICAL, rtc.virtual_time_us, wall_s);
+        const uint8_t alarms = digest_mode ? digest.PendingAlarms(rtc.virtual_time_us) : 0;
+
+        const uint64_t virtual_time_sec = rtc.virtual_time_us / 1000000ULL;
+        const uint64_t heartbeat_interval_sec = Hardware::Battery::HeartbeatIntervalSec(battery.Level(), rtc.runtime_config);
+        const uint64_t heartbeat_phase_sec = Config::HEARTBEAT_PHASE_SPREAD
+                                                 ? Telemetry::PhaseOffsetSec(DEVICE_ID, heartbeat_interval_sec)
+                                                 : heartbeat_interval_sec;
+        const uint32_t digest_offset_sec = Telemetry::PhaseOffsetSec(DEVICE_ID, Config::DIGEST_SPREAD_SEC);
+        Telemetry::ReconnectBackoff backoff(&rtc.backoff);
+        const bool backing_off = backoff.Waiting(rtc.virtual_time_us);
+        const bool periodic_update =
+            !backing_off &&
+            (digest_mode ? digest.Due(rtc.runtime_config.digest_at_min, digest_offset_sec, rtc.virtual_time_us, wall_s)
+                         : Telemetry::HeartbeatDue(virtual_time_sec, rtc.last_telemetry_time_sec, heartbeat_interval_sec,
+                                                   heartbeat_phase_sec));
+        const bool crucial_event = digest_mode ? alarms != 0
+                                               : (data.mail_detected || data.mail_collected || data.obstruction_changed);
+        const bool flap_report = !digest_mode && !backing_off && flap.ReportDue();
+        if (data.mail_detected || data.mail_collected)
+            counters->events++;
+        if (data.obstruction_changed && data.state == Processor::MailboxState::OBSTRUCTED)
+            counters->obstructions++;
+
+        if (crucial_event || periodic_update || flap_report)
+        {
+            Telemetry::Telemetry telemetry(&rtc.telemetry_state, rtc.boot_count, &config_store);
+            if (battery.HasReading())
+                telemetry.SetBattery(battery.Millivolts(), battery.Percent(), battery.Level());
+            telemetry.SetStability(flap.Suppressed(), flap.State().suppressed_events);
+
+            Telemetry::Publisher::BrokerEndpoints endpoints(&rtc.endpoints, &options.broker_uri, 1);
+            endpoints.Begin(rtc.virtual_time_us);
+            const size_t endpoint = endpoints.Pick(0);
+            if (telemetry.InitMQTT(endpoints.Uri(endpoint, rtc.virtual_time_us), "alloc_check", DEVICE_ID) == ESP_OK)
+            {
+                uint32_t waited = 0;
+                for (; waited < options.connect_ms && !telemetry.IsConnected(); waited += 10)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                if (telemetry.IsConnected())
+                {
+                    event_trace.mqtt_us = esp_timer_get_time();
+                    endpoints.Connected(endpoint, rtc.virtual_time_us, waited);
+                }
+                else if (options.connect_ms > 0)
+                {
+                    endpoints.Failed(endpoint, rtc.virtual_time_us);
+                }
+                telemetry.SetTrace(event_trace);
+
+                // Offline the messages are still built, the publish itself fails
+                if (!digest_mode)
+                    telemetry.Publish(data, processor.GetBaseline(), processor.GetThreshold(), "10.0.0.1");
+                if (alarms != 0)
+                    telemetry.PublishAlarms(alarms, data, "10.0.0.1");
+                if (digest_mode && periodic_update)
+                    telemetry.PublishDigest(digest.State(), rtc.virtual_time_us, data, processor.GetBaseline(),
+                                            processor.GetThreshold(), "10.0.0.1");
+                telemetry.Stop();
+                counters->sessions++;
+            }
+
+            if (periodic_update)
+                rtc.last_telemetry_time_sec = virtual_time_sec;
+
+            // Delivery is not what is checked here: take the session as delivered
+            if (alarms != 0)
+                digest.AlarmsSent(alarms);
+            if (digest_mode && periodic_update)
+                digest.Sent(rtc.virtual_time_us, wall_s);
+            if (!digest_mode || periodic_update)
+                flap.Reported();
+            backoff.Succeeded();
+        }
+
+        // Nominal awake time; the sleep before the next wake counts towards the state it was scheduled in
+        rtc.virtual_time_us += 100000ULL;
+        if (rtc.processor_state.current_state == Processor::MailboxState::OBSTRUCTED)
+        {
+            counters->obstructed_wakes++;
+            counters->obstructed_us += Processor::SleepUs(rtc.processor_state,
+                                                          Hardware::Battery::SleepUs(rtc.battery.level, rtc.runtime_config));
+        }
+
+        return Diagnostics::AllocTracker::End();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options = {};
+    options.broker_uri = "mqtt://127.0.0.1:1883";
+    options.wakes = 2000;
+    options.connect_ms = 0;
+    options.digest_at_min = Config::DIGEST_AT_MIN;
+    options.flap_damping = Config::FLAP_DAMPING_ENABLED;
+    options.seed = 1;
+    bool verbose = false;
+
+    FleetSim::TraceParams trace_params = {};
+    trace_params.baseline_cm = Config::BASELINE_CM;
+    trace_params.noise_sigma_cm = 0.3f;
+    trace_params.dropout_prob = 0.01f;
+    trace_params.drops_per_day = 200.0f;
+    trace_params.collections_per_day = 100.0f;
+    trace_params.item_min_cm = 2.5f;
+    trace_params.item_max_cm = 6.0f;
+    trace_params.flap_minutes = 30.0f;
+    trace_params.flap_period_s = 30.0f;
+    trace_params.flap_cm = 3.0f;
+    trace_params.obstruction_hours = 6.0f;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        const auto need = [&]()
+        {
+            if (!value)
+            {
+                fprintf(stderr, "Missing value for %s\n", arg);
+                exit(2);
+            }
+            ++i;
+            return value;
+        };
+
+        if (!strcmp(arg, "--broker"))
+            options.broker_uri = need();
+        else if (!strcmp(arg, "--wakes"))
+            options.wakes = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--connect-ms"))
+            options.connect_ms = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--drops-per-day"))
+            trace_params.drops_per_day = static_cast<float>(atof(need()));
+        else if (!strcmp(arg, "--digest-at"))
+            options.digest_at_min = atoi(need());
+        else if (!strcmp(arg, "--flaps-per-day"))
+            trace_params.flaps_per_day = static_cast<float>(atof(need()));
+        else if (!strcmp(arg, "--flap-minutes"))
+            trace_params.flap_minutes = static_cast<float>(atof(need()));
+        else if (!strcmp(arg, "--flap-period"))
+            trace_params.flap_period_s = static_cast<float>(atof(need()));
+        else if (!strcmp(arg, "--no-flap-damping"))
+            options.flap_damping = false;
+        else if (!strcmp(arg, "--obstructions"))
+            trace_params.obstructions_per_day = static_cast<float>(atof(need()));
+        else if (!strcmp(arg, "--obstruct-hours"))
+            trace_params.obstruction_hours = static_cast<float>(atof(need()));
+        else if (!strcmp(arg, "--seed"))
+            options.seed = strtoull(need(), nullptr, 10);
+        else if (!strcmp(arg, "--verbose"))
+            verbose = true;
+        else
+        {
+            usage(argv[0]);
+            return !strcmp(arg, "--help") ? 0 : 2;
+        }
+    }
+
+    esp_log_level_set("*", verbose ? ESP_LOG_INFO : ESP_LOG_WARN);
+
+    // glibc loads the time zone on first use; newlib on the device does not allocate for it
+    tzset();
+
+    HostNvs::Partition nvs;
+    HostAdc::Input adc;
+    adc.pin_mv = 3900.0f / Config::BATTERY_DIVIDER_RATIO;
+    HostNvs::Scope nvs_scope(&nvs);
+    HostAdc::Scope adc_scope(&adc);
+
+    RtcStore rtc = {};
+    Config::RuntimeConfigStore config_store(&rtc.runtime_config);
+    FleetSim::TraceModel trace(trace_params, options.seed);
+
+    Counters counters = {};
+    uint32_t failed_wakes = 0;
+    uint64_t total_allocations = 0;
+    for (uint32_t wake = 0; wake < options.wakes; ++wake)
+    {
+        const uint32_t allocations = runWake(options, rtc, config_store, trace, wake == 0, &counters);
+        if (allocations > 0)
+        {
+            if (failed_wakes < 10)
+                printf("[alloc] wake %u: %u allocations, %zu bytes\n", wake, allocations,
+                       Diagnostics::AllocTracker::Bytes());
+            failed_wakes++;
+            total_allocations += allocations;
+        }
+    }
+
+    HostMqtt::Loop::Instance().Stop();
+
+    const double days = rtc.virtual_time_us / 86400e6;
+    printf("[alloc] %u wakes over %.1f days, %u sessions (%.1f per day): %u wakes allocated (%llu allocations)\n",
+           options.wakes, days, counters.sessions, days > 0 ? counters.sessions / days : 0.0, failed_wakes,
+           static_cast<unsigned long long>(total_allocations));
+    if (trace_params.flaps_per_day > 0.0f)
+        printf("[flap] %u flapping episodes: %u events reported, %u transitions suppressed in %u suppressions\n",
+               trace.GetFlaps(), counters.events, rtc.flap.suppressed_total, rtc.flap.suppressions);
+    if (trace_params.obstructions_per_day > 0.0f)
+    {
+        const double obstructed_h = counters.obstructed_us / 3600e6;
+        printf("[obstructed] %u obstructions in the trace, %u detected: %.1f h obstructed, %u wakes (%.1f per hour)\n",
+               trace.GetObstructions(), counters.obstructions, obstructed_h, counters.obstructed_wakes,
+               obstructed_h > 0 ? counters.obstructed_wakes / obstructed_h : 0.0);
+    }
+    return failed_wakes > 0 ? 1 : 0;
+}
\ No newline at end of file
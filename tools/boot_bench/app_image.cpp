@@ -0,0 +1,120 @@
+#include "app_image.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+
+namespace BootBench
+{
+    namespace
+    {
+        constexpr uint8_t IMAGE_MAGIC = 0xE9;
+        constexpr size_t IMAGE_HEADER_LEN = 24;  // esp_image_header_t
+        constexpr size_t SEGMENT_HEADER_LEN = 8; // esp_image_segment_header_t
+        constexpr size_t HASH_APPENDED_OFFSET = 23;
+        constexpr uint8_t MAX_SEGMENTS = 16;
+
+        // ESP32-C3 address ranges (soc.h)
+        struct Region
+        {
+            uint32_t low;
+            uint32_t high;
+            SegmentKind kind;
+        };
+        constexpr Region REGIONS[] = {
+            {0x42000000, 0x42800000, SegmentKind::FLASH_CODE},
+            {0x3C000000, 0x3C800000, SegmentKind::FLASH_DATA},
+            {0x4037C000, 0x403E0000, SegmentKind::IRAM},
+            {0x3FC80000, 0x3FCE0000, SegmentKind::DRAM},
+            {0x50000000, 0x50002000, SegmentKind::RTC},
+        };
+
+        constexpr const char *KIND_NAMES[] = {"irom", "drom", "iram", "dram", "rtc", "other"};
+
+        uint32_t readU32(const uint8_t *p)
+        {
+            return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+        }
+
+        SegmentKind classify(uint32_t load_addr)
+        {
+            for (const Region &region : REGIONS)
+            {
+                if (load_addr >= region.low && load_addr < region.high)
+                    return region.kind;
+            }
+            return SegmentKind::OTHER;
+        }
+    }
+
+    uint32_t AppImage::Bytes(SegmentKind kind) const
+    {
+        uint32_t total = 0;
+        for (const Segment &segment : segments)
+        {
+            if (segment.kind == kind)
+                total += segment.size;
+        }
+        return total;
+    }
+
+    uint32_t AppImage::LoadedBytes() const { return Bytes(SegmentKind::IRAM) + Bytes(SegmentKind::DRAM); }
+
+    uint32_t AppImage::MappedBytes() const { return Bytes(SegmentKind::FLASH_CODE) + Bytes(SegmentKind::FLASH_DATA); }
+
+    bool LoadAppImage(const char *path, AppImage *image, std::string *error)
+    {
+        FILE *f = fopen(path, "rb");
+        if (!f)
+        {
+            *error = std::string("cannot read ") + path;
+            return false;
+        }
+        std::vector<uint8_t> data;
+        uint8_t buf[65536];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+            data.insert(data.end(), buf, buf + n);
+        fclose(f);
+
+        if (data.size() < IMAGE_HEADER_LEN || data[0] != IMAGE_MAGIC || data[1] == 0 || data[1] > MAX_SEGMENTS)
+        {
+            *error = std::string(path) + " is not an app image";
+            return false;
+        }
+
+        *image = {};
+        image->file_size = static_cast<uint32_t>(data.size());
+        image->entry_addr = readU32(&data[4]);
+        image->hash_appended = data[HASH_APPENDED_OFFSET] == 1;
+
+        size_t offset = IMAGE_HEADER_LEN;
+        for (uint8_t i = 0; i < data[1]; ++i)
+        {
+            if (offset + SEGMENT_HEADER_LEN > data.size())
+            {
+                *error = std::string(path) + ": segment header past the end of the file";
+                return false;
+            }
+            Segment segment;
+            segment.load_addr = readU32(&data[offset]);
+            segment.size = readU32(&data[offset + 4]);
+            segment.file_offset = static_cast<uint32_t>(offset + SEGMENT_HEADER_LEN);
+            segment.kind = classify(segment.load_addr);
+            if (segment.file_offset + static_cast<uint64_t>(segment.size) > data.size())
+            {
+                *error = std::string(path) + ": segment data past the end of the file";
+                return false;
+            }
+            image->segments.push_back(segment);
+            offset = segment.file_offset + segment.size;
+        }
+        return true;
+    }
+
+    const char *SegmentKindToString(SegmentKind kind)
+    {
+        const size_t index = static_cast<size_t>(kind);
+        return index < std::size(KIND_NAMES) ? KIND_NAMES[index] : "unknown";
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace BootBench
+{
+    // Where the second stage bootloader puts a segment of an ESP32-C3 app image
+    enum class SegmentKind : uint8_t
+    {
+        FLASH_CODE, ///< IROM: mapped through the flash cache, not copied
+        FLASH_DATA, ///< DROM: mapped through the flash cache, not copied
+        IRAM,       ///< Copied into internal RAM on every boot
+        DRAM,       ///< Copied into internal RAM on every boot
+        RTC,        ///< RTC fast memory: only loaded after power-up, kept on a deep sleep wake
+        OTHER       ///< Padding or an address outside the known regions
+    };
+
+    struct Segment
+    {
+        uint32_t load_addr;
+        uint32_t file_offset; ///< Offset of the data in the .bin
+        uint32_t size;
+        SegmentKind kind;
+    };
+
+    // Header and segments of an app image (build/iot_test.bin)
+    struct AppImage
+    {
+        uint32_t file_size;    ///< Bytes the bootloader validates (checksum, and the SHA-256 if appended)
+        uint32_t entry_addr;
+        bool hash_appended;
+        std::vector<Segment> segments;
+
+        // Bytes of the given kind
+        uint32_t Bytes(SegmentKind kind) const;
+
+        // Bytes copied into RAM on a timer wake (IRAM and DRAM)
+        uint32_t LoadedBytes() const;
+
+        // Bytes left in flash behind the cache (IROM and DROM)
+        uint32_t MappedBytes() const;
+    };
+
+    /**
+     * Parse the esp_image_header_t and segment headers of an app image
+     *
+     * Only the layout is read; checksum and hash are not verified. Segments
+     * are classified by load address with the ESP32-C3 memory map.
+     */
+    bool LoadAppImage(const char *path, AppImage *image, std::string *error);
+
+    // "irom", "drom", "iram", "dram", "rtc", "other"
+    const char *SegmentKindToString(SegmentKind kind);
+}
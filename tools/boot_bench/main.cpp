@@ -0,0 +1,235 @@
+#include "app_image.hpp"
+
+#include "ringlog/file_flash.hpp"
+
+#include "diagnostics/ring_log.hpp"
+#include "diagnostics/wake_record.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+    void usage(const char *argv0)
+    {
+        printf("Usage: %s [options] NAME:APP.bin[:DIAGLOG.bin] ...\n"
+               "  NAME:APP.bin[:DIAGLOG.bin]  one build variant: its app image, and the diaglog partition\n"
+               "                              read back from a device running it (esptool read_flash)\n"
+               "  --segments                  list the segments of every image\n",
+               argv0);
+    }
+
+    // One build of the firmware and the boot times measured with it
+    struct Variant
+    {
+        std::string name;
+        BootBench::AppImage image;
+        std::vector<double> boot_ms; ///< Timer wakes that measured their boot
+    };
+
+    void addBootTime(const Diagnostics::RecordHeader &header, const uint8_t *payload, void *arg)
+    {
+        if (header.type != static_cast<uint8_t>(Diagnostics::RecordType::WAKE) ||
+            header.len != sizeof(Diagnostics::WakeRecord))
+            return;
+
+        Diagnostics::WakeRecord record;
+        memcpy(&record, payload, sizeof(record));
+        if ((record.flags & Diagnostics::WAKE_FRESH_BOOT) || record.boot_10us == 0)
+            return;
+        static_cast<std::vector<double> *>(arg)->push_back(record.boot_10us / 100.0);
+    }
+
+    bool loadBootTimes(const char *path, std::vector<double> *boot_ms, std::string *error)
+    {
+        RingLogTool::FileFlash flash(0);
+        if (!flash.Load(path))
+        {
+            *error = std::string("cannot read ") + path;
+            return false;
+        }
+        Diagnostics::RingLogState log_state = {};
+        Diagnostics::RingLog log(&flash, &log_state);
+        if (!log.Available())
+        {
+            *error = std::string(path) + " is too small for a ring log";
+            return false;
+        }
+        log.ForEach(addBootTime, boot_ms);
+        return true;
+    }
+
+    // NAME:APP.bin[:DIAGLOG.bin]
+    bool loadVariant(const char *arg, Variant *variant, std::string *error)
+    {
+        std::vector<std::string> parts;
+        for (const char *p = arg;; ++p)
+        {
+            const char *end = strchr(p, ':');
+            parts.emplace_back(p, end ? end - p : strlen(p));
+            if (!end)
+                break;
+            p = end;
+        }
+        if (parts.size() < 2 || parts.size() > 3 || parts[0].empty() || parts[1].empty())
+        {
+            *error = std::string("expected NAME:APP.bin[:DIAGLOG.bin], got ") + arg;
+            return false;
+        }
+
+        variant->name = parts[0];
+        if (!BootBench::LoadAppImage(parts[1].c_str(), &variant->image, error))
+            return false;
+        if (parts.size() == 3 && !loadBootTimes(parts[2].c_str(), &variant->boot_ms, error))
+            return false;
+        std::sort(variant->boot_ms.begin(), variant->boot_ms.end());
+        return true;
+    }
+
+    // Value at quantile q of sorted values
+    double quantile(const std::vector<double> &sorted, double q)
+    {
+        return sorted[static_cast<size_t>(q * (sorted.size() - 1) + 0.5)];
+    }
+
+    /**
+     * Least-squares fit of boot = a + b * loaded KB + c * image KB
+     *
+     * Loaded bytes are copied into RAM by the bootloader; the whole image is
+     * read for its checksum and hash, unless validation is skipped on deep
+     * sleep wakes. Needs three variants whose sizes are not collinear.
+     * Returns false if the normal equations are singular.
+     */
+    bool fit(const std::vector<const Variant *> &measured, double coef[3])
+    {
+        double ata[3][3] = {};
+        double atb[3] = {};
+        for (const Variant *v : measured)
+        {
+            const double row[3] = {1.0, v->image.LoadedBytes() / 1024.0, v->image.file_size / 1024.0};
+            const double y = quantile(v->boot_ms, 0.5);
+            for (int i = 0; i < 3; ++i)
+            {
+                for (int j = 0; j < 3; ++j)
+                    ata[i][j] += row[i] * row[j];
+                atb[i] += row[i] * y;
+            }
+        }
+
+        // Gaussian elimination with partial pivoting
+        for (int col = 0; col < 3; ++col)
+        {
+            int pivot = col;
+            for (int r = col + 1; r < 3; ++r)
+            {
+                if (fabs(ata[r][col]) > fabs(ata[pivot][col]))
+                    pivot = r;
+            }
+            if (fabs(ata[pivot][col]) < 1e-9)
+                return false;
+            std::swap(ata[col], ata[pivot]);
+            std::swap(atb[col], atb[pivot]);
+            for (int r = col + 1; r < 3; ++r)
+            {
+                const double factor = ata[r][col] / ata[col][col];
+                for (int c = col; c < 3; ++c)
+                    ata[r][c] -= factor * ata[col][c];
+                atb[r] -= factor * atb[col];
+            }
+        }
+        for (int r = 2; r >= 0; --r)
+        {
+            double sum = atb[r];
+            for (int c = r + 1; c < 3; ++c)
+                sum -= ata[r][c] * coef[c];
+            coef[r] = sum / ata[r][r];
+        }
+        return true;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bool list_segments = false;
+    std::vector<Variant> variants;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        if (!strcmp(arg, "--segments"))
+            list_segments = true;
+        else if (arg[0] == '-')
+        {
+            usage(argv[0]);
+            return !strcmp(arg, "--help") ? 0 : 2;
+        }
+        else
+        {
+            Variant variant;
+            std::string error;
+            if (!loadVariant(arg, &variant, &error))
+            {
+                fprintf(stderr, "[boot] %s\n", error.c_str());
+                return 1;
+            }
+            variants.push_back(std::move(variant));
+        }
+    }
+    if (variants.empty())
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    printf("[boot] %-16s %9s %9s %9s %9s %9s %7s %9s %9s\n", "variant", "image KB", "loaded KB", "iram KB",
+           "dram KB", "mapped KB", "wakes", "median ms", "p90 ms");
+    std::vector<const Variant *> measured;
+    for (const Variant &v : variants)
+    {
+        const BootBench::AppImage &image = v.image;
+        printf("[boot] %-16s %9.1f %9.1f %9.1f %9.1f %9.1f %7zu", v.name.c_str(), image.file_size / 1024.0,
+               image.LoadedBytes() / 1024.0, image.Bytes(BootBench::SegmentKind::IRAM) / 1024.0,
+               image.Bytes(BootBench::SegmentKind::DRAM) / 1024.0, image.MappedBytes() / 1024.0, v.boot_ms.size());
+        if (v.boot_ms.empty())
+            printf(" %9s %9s\n", "-", "-");
+        else
+            printf(" %9.2f %9.2f\n", quantile(v.boot_ms, 0.5), quantile(v.boot_ms, 0.9));
+
+        if (!v.boot_ms.empty())
+            measured.push_back(&v);
+        if (list_segments)
+        {
+            for (const BootBench::Segment &segment : image.segments)
+                printf("         %-5s 0x%08x %8u bytes at file offset 0x%06x\n",
+                       BootBench::SegmentKindToString(segment.kind), segment.load_addr, segment.size,
+                       segment.file_offset);
+        }
+    }
+
+    if (measured.size() < 3)
+    {
+        printf("[boot] %zu variants with boot times: at least 3 needed to relate size to boot time\n",
+               measured.size());
+        return 0;
+    }
+
+    double coef[3] = {};
+    if (!fit(measured, coef))
+    {
+        printf("[boot] loaded and image sizes of the variants are collinear: vary them independently\n");
+        return 1;
+    }
+    printf("[boot] boot ms = %.2f + %.4f per loaded KB + %.4f per image KB\n", coef[0], coef[1], coef[2]);
+    for (const Variant *v : measured)
+    {
+        const double predicted = coef[0] + coef[1] * v->image.LoadedBytes() / 1024.0 + coef[2] * v->image.file_size / 1024.0;
+        printf("[boot] %-16s predicted %7.2f ms, measured %7.2f ms\n", v->name.c_str(), predicted,
+               quantile(v->boot_ms, 0.5));
+    }
+    return 0;
+}
@@ -0,0 +1,136 @@
+#include "chunk_server.hpp"
+#include "delta_image.hpp"
+
+#include "cJSON.h"
+
+#include <mosquitto.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <utility>
+
+namespace Delta
+{
+    ChunkServer::ChunkServer(const std::string &base_topic, std::vector<uint8_t> delta, const char *version)
+        : base_topic_(base_topic), delta_(std::move(delta)), version_(version ? version : ""), id_(DeltaId(delta_))
+    {
+    }
+
+    ChunkServer::~ChunkServer() { Stop(); }
+
+    bool ChunkServer::Start(const char *host, int port, const char *client_id)
+    {
+        mosq_ = mosquitto_new(client_id, true, this);
+        if (!mosq_)
+        {
+            fprintf(stderr, "[ota] failed to create client\n");
+            return false;
+        }
+        mosquitto_connect_callback_set(mosq_, onConnect);
+        mosquitto_message_callback_set(mosq_, onMessage);
+        mosquitto_publish_callback_set(mosq_, onPublish);
+        mosquitto_reconnect_delay_set(mosq_, 1, 10, false);
+
+        const int rc = mosquitto_connect_async(mosq_, host, port, 30);
+        if (rc != MOSQ_ERR_SUCCESS)
+            fprintf(stderr, "[ota] connect to %s:%d failed: %s (retrying)\n", host, port, mosquitto_strerror(rc));
+        mosquitto_loop_start(mosq_);
+        return true;
+    }
+
+    void ChunkServer::Stop()
+    {
+        if (!mosq_)
+            return;
+
+        // Give the broker a moment to take the cleared offer before the connection goes
+        const int clear_mid = publishOffer(true);
+        for (int i = 0; i < 100 && clear_mid >= 0 && last_acked_ != clear_mid; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+        mosquitto_disconnect(mosq_);
+        mosquitto_loop_stop(mosq_, false);
+        mosquitto_destroy(mosq_);
+        mosq_ = nullptr;
+    }
+
+    void ChunkServer::onConnect(struct mosquitto *mosq, void *arg, int rc)
+    {
+        auto *server = static_cast<ChunkServer *>(arg);
+        if (rc != 0)
+        {
+            fprintf(stderr, "[ota] connect refused: %s\n", mosquitto_connack_string(rc));
+            return;
+        }
+
+        const std::string topic = server->base_topic_ + "/ota/req";
+        mosquitto_subscribe(mosq, nullptr, topic.c_str(), 0);
+        server->publishOffer(false);
+    }
+
+    void ChunkServer::onMessage(struct mosquitto *, void *arg, const struct mosquitto_message *msg)
+    {
+        static_cast<ChunkServer *>(arg)->handleRequest(static_cast<const char *>(msg->payload), msg->payloadlen);
+    }
+
+    void ChunkServer::onPublish(struct mosquitto *, void *arg, int mid)
+    {
+        static_cast<ChunkServer *>(arg)->last_acked_ = mid;
+    }
+
+    int ChunkServer::publishOffer(bool clear)
+    {
+        const std::string topic = base_topic_ + "/ota/offer";
+        char offer[128];
+        // An empty retained message removes the offer from the broker
+        const int len = clear ? 0
+                              : snprintf(offer, sizeof(offer), "{\"id\":%u,\"size\":%zu,\"version\":\"%s\"}", id_,
+                                         delta_.size(), version_.c_str());
+
+        int mid = -1;
+        if (mosquitto_publish(mosq_, &mid, topic.c_str(), len, clear ? nullptr : offer, 1, true) != MOSQ_ERR_SUCCESS)
+            return -1;
+        return mid;
+    }
+
+    void ChunkServer::handleRequest(const char *payload, int len)
+    {
+        ++requests_;
+
+        cJSON *root = cJSON_ParseWithLength(payload, static_cast<size_t>(std::max(len, 0)));
+        const cJSON *id = cJSON_GetObjectItemCaseSensitive(root, "id");
+        const cJSON *offset = cJSON_GetObjectItemCaseSensitive(root, "offset");
+        const cJSON *size = cJSON_GetObjectItemCaseSensitive(root, "len");
+        const bool valid = cJSON_IsNumber(id) && cJSON_IsNumber(offset) && cJSON_IsNumber(size) &&
+                           static_cast<uint32_t>(id->valuedouble) == id_ && offset->valuedouble >= 0 &&
+                           size->valuedouble > 0 && size->valuedouble <= MAX_CHUNK &&
+                           offset->valuedouble + size->valuedouble <= delta_.size();
+        const uint32_t chunk_offset = valid ? static_cast<uint32_t>(offset->valuedouble) : 0;
+        const uint32_t chunk_len = valid ? static_cast<uint32_t>(size->valuedouble) : 0;
+        cJSON_Delete(root);
+
+        if (!valid)
+        {
+            // Malformed, out of range, or for a delta this server does not serve
+            ++rejected_;
+            return;
+        }
+
+        std::vector<uint8_t> message(8 + chunk_len);
+        Ota::PutU32(message.data(), id_);
+        Ota::PutU32(message.data() + 4, chunk_offset);
+        memcpy(message.data() + 8, &delta_[chunk_offset], chunk_len);
+
+        const std::string topic = base_topic_ + "/ota/data";
+        mosquitto_publish(mosq_, nullptr, topic.c_str(), static_cast<int>(message.size()), message.data(), 1, false);
+        bytes_sent_ += chunk_len;
+
+        uint32_t progress = progress_;
+        while (chunk_offset + chunk_len > progress && !progress_.compare_exchange_weak(progress, chunk_offset + chunk_len))
+        {
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct mosquitto;
+struct mosquitto_message;
+
+namespace Delta
+{
+    /**
+     * Serves one delta to one device over MQTT
+     *
+     * Publishes the retained offer on {base}/ota/offer and answers every
+     * {base}/ota/req with the requested range on {base}/ota/data (see
+     * main/ota/delta_updater.hpp). The offer is cleared on Stop() so devices
+     * do not keep asking a server that is gone.
+     */
+    class ChunkServer
+    {
+    public:
+        ChunkServer(const std::string &base_topic, std::vector<uint8_t> delta, const char *version);
+        ~ChunkServer();
+
+        bool Start(const char *host, int port, const char *client_id);
+        void Stop();
+
+        uint32_t Id() const { return id_; }
+        uint64_t Requests() const { return requests_; }
+        uint64_t BytesSent() const { return bytes_sent_; }
+        uint64_t Rejected() const { return rejected_; }
+
+        // Highest delta offset requested + len, i.e. how far the device got
+        uint32_t Progress() const { return progress_; }
+
+    private:
+        static constexpr uint32_t MAX_CHUNK = 4096;
+
+        std::string base_topic_;
+        std::vector<uint8_t> delta_;
+        std::string version_;
+        uint32_t id_;
+        struct mosquitto *mosq_ = nullptr;
+
+        std::atomic<uint64_t> requests_{0};
+        std::atomic<uint64_t> bytes_sent_{0};
+        std::atomic<uint64_t> rejected_{0};
+        std::atomic<uint32_t> progress_{0};
+        std::atomic<int> last_acked_{-1};
+
+        static void onConnect(struct mosquitto *mosq, void *arg, int rc);
+        static void onMessage(struct mosquitto *mosq, void *arg, const struct mosquitto_message *msg);
+        static void onPublish(struct mosquitto *mosq, void *arg, int mid);
+
+        // Publish (or clear) the retained offer, returns the message ID (-1 if not queued)
+        int publishOffer(bool clear);
+        void handleRequest(const char *payload, int len);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,240 @@
+#include "delta_encoder.hpp"
+#include "delta_image.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Delta
+{
+    namespace
+    {
+        constexpr uint32_t MIN_MATCH = 8; // A copy costs up to 7 bytes
+        constexpr int HASH_BITS = 20;
+        constexpr int MAX_CHAIN = 32;
+        constexpr int32_t NONE = -1;
+
+        uint32_t hashAt(const uint8_t *p)
+        {
+            uint64_t v;
+            memcpy(&v, p, sizeof(v));
+            return static_cast<uint32_t>((v * 0x9E3779B97F4A7C15ULL) >> (64 - HASH_BITS));
+        }
+
+        // Positions with the same 8-byte hash, most recent first
+        class HashChains
+        {
+        public:
+            explicit HashChains(size_t positions) : head_(1u << HASH_BITS, NONE), prev_(positions, NONE) {}
+
+            void Insert(const std::vector<uint8_t> &data, uint32_t pos)
+            {
+                if (pos + MIN_MATCH > data.size())
+                    return;
+                const uint32_t h = hashAt(&data[pos]);
+                prev_[pos] = head_[h];
+                head_[h] = static_cast<int32_t>(pos);
+            }
+
+            int32_t Head(uint32_t hash) const { return head_[hash]; }
+            int32_t Prev(int32_t pos) const { return prev_[pos]; }
+
+        private:
+            std::vector<int32_t> head_;
+            std::vector<int32_t> prev_;
+        };
+
+        uint32_t matchLength(const uint8_t *a, const uint8_t *b, uint32_t max)
+        {
+            uint32_t n = 0;
+            while (n < max && a[n] == b[n])
+                ++n;
+            return n;
+        }
+
+        class WindowWriter
+        {
+        public:
+            explicit WindowWriter(std::vector<uint8_t> &out) : out_(out) {}
+
+            void Literal(const uint8_t *data, uint32_t len)
+            {
+                tag(len, Ota::DeltaOp::LITERAL);
+                out_.insert(out_.end(), data, data + len);
+            }
+
+            void Copy(Ota::DeltaOp op, uint32_t len, uint32_t operand)
+            {
+                tag(len, op);
+                varint(operand);
+            }
+
+        private:
+            std::vector<uint8_t> &out_;
+
+            void tag(uint32_t len, Ota::DeltaOp op) { varint(len << 2 | static_cast<uint32_t>(op)); }
+
+            void varint(uint32_t v)
+            {
+                uint8_t buf[5];
+                out_.insert(out_.end(), buf, buf + Ota::PutVarint(buf, v));
+            }
+        };
+    }
+
+    std::vector<uint8_t> Encode(const std::vector<uint8_t> &base, const std::vector<uint8_t> &target,
+                                const char *target_version, EncodeStats *stats)
+    {
+        EncodeStats local;
+        EncodeStats &s = stats ? *stats : local;
+
+        Ota::DeltaHeader header = {};
+        header.base_size = static_cast<uint32_t>(base.size());
+        header.target_size = static_cast<uint32_t>(target.size());
+        Sha256(base.data(), base.size(), header.base_sha256);
+        Sha256(target.data(), target.size(), header.target_sha256);
+        strncpy(header.target_version, target_version, Ota::VERSION_LEN - 1);
+
+        std::vector<uint8_t> out(Ota::HEADER_SIZE);
+        Ota::SerializeHeader(header, out.data());
+
+        HashChains base_chains(base.size());
+        for (uint32_t pos = 0; pos < base.size(); ++pos)
+            base_chains.Insert(base, pos);
+        HashChains target_chains(target.size());
+
+        std::vector<uint8_t> ops;
+        for (uint32_t window_offset = 0; window_offset < target.size(); window_offset += Ota::WINDOW_SIZE)
+        {
+            const uint32_t window_len = std::min<uint32_t>(Ota::WINDOW_SIZE, target.size() - window_offset);
+            const uint8_t *window = &target[window_offset];
+            EncodeStats window_stats;
+
+            ops.clear();
+            WindowWriter writer(ops);
+            uint32_t base_cursor = window_offset;
+            uint32_t literal_start = 0;
+            uint32_t pos = 0;
+
+            while (pos < window_len)
+            {
+                const uint32_t absolute = window_offset + pos;
+                const uint32_t max_len = window_len - pos;
+                uint32_t best_len = 0;
+                uint32_t best_source = 0;
+                Ota::DeltaOp best_op = Ota::DeltaOp::LITERAL;
+
+                const auto tryBase = [&](uint32_t source)
+                {
+                    if (source >= base.size())
+                        return;
+                    const uint32_t len = matchLength(&base[source], window + pos,
+                                                     std::min<uint32_t>(max_len, base.size() - source));
+                    if (len > best_len)
+                    {
+                        best_len = len;
+                        best_source = source;
+                        best_op = Ota::DeltaOp::COPY_BASE;
+                    }
+                };
+
+                if (max_len >= MIN_MATCH)
+                {
+                    tryBase(base_cursor);
+                    const uint32_t h = hashAt(window + pos);
+                    int depth = 0;
+                    for (int32_t c = base_chains.Head(h); c != NONE && depth < MAX_CHAIN && best_len < max_len;
+                         c = base_chains.Prev(c), ++depth)
+                        tryBase(static_cast<uint32_t>(c));
+
+                    // Earlier target bytes; comparing against the target itself is what an overlapping copy yields
+                    depth = 0;
+                    for (int32_t c = target_chains.Head(h); c != NONE && depth < MAX_CHAIN && best_len < max_len;
+                         c = target_chains.Prev(c), ++depth)
+                    {
+                        const uint32_t len = matchLength(&target[c], window + pos, max_len);
+                        if (len > best_len)
+                        {
+                            best_len = len;
+                            best_source = static_cast<uint32_t>(c);
+                            best_op = Ota::DeltaOp::COPY_TARGET;
+                        }
+                    }
+                    // Byte runs (erased padding) are a copy from one byte back
+                    if (absolute > 0)
+                    {
+                        const uint32_t len = matchLength(&target[absolute - 1], window + pos, max_len);
+                        if (len > best_len)
+                        {
+                            best_len = len;
+                            best_source = absolute - 1;
+                            best_op = Ota::DeltaOp::COPY_TARGET;
+                        }
+                    }
+                }
+
+                if (best_len < MIN_MATCH)
+                {
+                    target_chains.Insert(target, absolute);
+                    ++pos;
+                    continue;
+                }
+
+                if (literal_start < pos)
+                {
+                    writer.Literal(window + literal_start, pos - literal_start);
+                    window_stats.literal_bytes += pos - literal_start;
+                    ++window_stats.ops;
+                }
+
+                if (best_op == Ota::DeltaOp::COPY_BASE)
+                {
+                    writer.Copy(best_op, best_len,
+                                Ota::ZigZag(static_cast<int32_t>(best_source) - static_cast<int32_t>(base_cursor)));
+                    base_cursor = best_source + best_len;
+                    window_stats.copy_base_bytes += best_len;
+                }
+                else
+                {
+                    writer.Copy(best_op, best_len, absolute - best_source);
+                    window_stats.copy_target_bytes += best_len;
+                }
+                ++window_stats.ops;
+
+                for (uint32_t i = 0; i < best_len; ++i)
+                    target_chains.Insert(target, absolute + i);
+                pos += best_len;
+                literal_start = pos;
+            }
+
+            if (literal_start < window_len)
+            {
+                writer.Literal(window + literal_start, window_len - literal_start);
+                window_stats.literal_bytes += window_len - literal_start;
+                ++window_stats.ops;
+            }
+
+            // Many short copies can cost more than the bytes they replace
+            uint8_t prefix[5];
+            const size_t literal_size = Ota::PutVarint(prefix, window_len << 2) + window_len;
+            if (ops.size() > literal_size)
+            {
+                ops.clear();
+                writer.Literal(window, window_len);
+                window_stats = {};
+                window_stats.literal_bytes = window_len;
+                window_stats.ops = 1;
+            }
+
+            out.insert(out.end(), prefix, prefix + Ota::PutVarint(prefix, static_cast<uint32_t>(ops.size())));
+            out.insert(out.end(), ops.begin(), ops.end());
+
+            ++s.windows;
+            s.copy_base_bytes += window_stats.copy_base_bytes;
+            s.copy_target_bytes += window_stats.copy_target_bytes;
+            s.literal_bytes += window_stats.literal_bytes;
+            s.ops += window_stats.ops;
+        }
+
+        return out;
+    }
+}
\ No newline at end of file
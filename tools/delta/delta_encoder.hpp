@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ota/delta_format.hpp"
+
+namespace Delta
+{
+    struct EncodeStats
+    {
+        uint32_t windows = 0;
+        uint64_t copy_base_bytes = 0;   ///< Target bytes taken from the base image
+        uint64_t copy_target_bytes = 0; ///< Target bytes repeated from earlier target bytes
+        uint64_t literal_bytes = 0;     ///< Target bytes sent as is
+        uint64_t ops = 0;
+    };
+
+    /**
+     * Build a delta (format in main/ota/delta_format.hpp) rebuilding target from base
+     *
+     * Greedy longest-match over hash chains of 8-byte prefixes: at every
+     * target position the expected base position (unchanged code stays in
+     * place or shifts uniformly), up to MAX_CHAIN earlier base positions and
+     * as many earlier target positions are tried, and the longest match
+     * within the window wins. Bytes nothing matches become literals. A window
+     * that comes out larger than its literal-only form is sent as literal.
+     */
+    std::vector<uint8_t> Encode(const std::vector<uint8_t> &base, const std::vector<uint8_t> &target,
+                                const char *target_version, EncodeStats *stats = nullptr);
+}
\ No newline at end of file
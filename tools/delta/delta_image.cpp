@@ -0,0 +1,161 @@
+#include "delta_image.hpp"
+
+#include <openssl/evp.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+namespace Delta
+{
+    namespace
+    {
+        // Device flash stand-in: the base image and a target image that grows window by window
+        class MemoryIo : public Ota::ImageIo
+        {
+        public:
+            MemoryIo(const std::vector<uint8_t> &base, std::vector<uint8_t> &target) : base_(base), target_(target) {}
+
+            esp_err_t ReadBase(uint32_t offset, void *buf, size_t len) override
+            {
+                if (offset + len > base_.size())
+                    return ESP_ERR_INVALID_SIZE;
+                memcpy(buf, &base_[offset], len);
+                return ESP_OK;
+            }
+
+            esp_err_t ReadTarget(uint32_t offset, void *buf, size_t len) override
+            {
+                if (offset + len > target_.size())
+                    return ESP_ERR_INVALID_SIZE;
+                memcpy(buf, &target_[offset], len);
+                return ESP_OK;
+            }
+
+            esp_err_t WriteWindow(uint32_t offset, const uint8_t *data, size_t len) override
+            {
+                if (offset % Ota::WINDOW_SIZE != 0 || offset + len > target_.size())
+                    return ESP_ERR_INVALID_SIZE;
+                memcpy(&target_[offset], data, len);
+                return ESP_OK;
+            }
+
+        private:
+            const std::vector<uint8_t> &base_;
+            std::vector<uint8_t> &target_;
+        };
+    }
+
+    bool ReadFile(const char *path, std::vector<uint8_t> *out)
+    {
+        FILE *f = fopen(path, "rb");
+        if (!f)
+            return false;
+
+        out->clear();
+        uint8_t buf[65536];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+            out->insert(out->end(), buf, buf + n);
+        const bool ok = !ferror(f);
+        fclose(f);
+        return ok;
+    }
+
+    bool WriteFile(const char *path, const std::vector<uint8_t> &data)
+    {
+        FILE *f = fopen(path, "wb");
+        if (!f)
+            return false;
+        const bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+        return fclose(f) == 0 && ok;
+    }
+
+    void Sha256(const uint8_t *data, size_t len, uint8_t out[32])
+    {
+        EVP_Digest(data, len, out, nullptr, EVP_sha256(), nullptr);
+    }
+
+    uint32_t DeltaId(const std::vector<uint8_t> &delta)
+    {
+        uint8_t sha256[32];
+        Sha256(delta.data(), delta.size(), sha256);
+        const uint32_t id = Ota::GetU32(sha256);
+        return id != 0 ? id : 1;
+    }
+
+    bool ApplyDelta(const std::vector<uint8_t> &base, const std::vector<uint8_t> &delta, const ApplyOptions &options,
+                    std::vector<uint8_t> *target, Ota::DeltaHeader *header, std::string *error)
+    {
+        if (delta.size() < Ota::HEADER_SIZE || !Ota::ParseHeader(delta.data(), header))
+        {
+            *error = "not a delta (bad magic, format version or window size)";
+            return false;
+        }
+
+        uint8_t sha256[32];
+        Sha256(base.data(), base.size(), sha256);
+        if (base.size() != header->base_size || memcmp(sha256, header->base_sha256, sizeof(sha256)) != 0)
+        {
+            *error = "base image does not match the delta";
+            return false;
+        }
+
+        // Otherwise no window ever completes within a session
+        if (options.session_chunks > 0 && options.session_chunks * options.chunk_bytes < Ota::MAX_ENCODED_WINDOW + 5)
+        {
+            *error = "sessions are too short to complete a window";
+            return false;
+        }
+
+        target->assign(header->target_size, 0xFF);
+        MemoryIo io(base, *target);
+        // ~8 KB of buffers, like on the device
+        std::unique_ptr<Ota::DeltaPatcher> patcher(new Ota::DeltaPatcher(&io));
+
+        const size_t chunk_bytes = std::max<size_t>(1, options.chunk_bytes);
+        size_t offset = 0;
+        size_t chunks = 0;
+        while (offset < delta.size())
+        {
+            // New session: whatever did not make up a complete window is requested again
+            if (options.session_chunks > 0 && chunks > 0 && chunks % options.session_chunks == 0 &&
+                patcher->HasHeader())
+            {
+                const Ota::DeltaHeader resumed = patcher->Header();
+                const uint32_t committed = patcher->CommittedOffset();
+                const uint32_t target_offset = patcher->TargetOffset();
+                patcher.reset(new Ota::DeltaPatcher(&io));
+                patcher->Resume(resumed, committed, target_offset);
+                offset = committed;
+            }
+
+            const size_t len = std::min(chunk_bytes, delta.size() - offset);
+            const esp_err_t err = patcher->Feed(&delta[offset], len);
+            if (err != ESP_OK)
+            {
+                char text[96];
+                snprintf(text, sizeof(text), "malformed delta near offset %zu (%s)", offset, esp_err_to_name(err));
+                *error = text;
+                return false;
+            }
+            offset += len;
+            ++chunks;
+        }
+
+        if (!patcher->IsComplete())
+        {
+            *error = "delta ends before the image is complete";
+            return false;
+        }
+
+        Sha256(target->data(), target->size(), sha256);
+        if (memcmp(sha256, header->target_sha256, sizeof(sha256)) != 0)
+        {
+            *error = "rebuilt image does not match the target hash";
+            return false;
+        }
+        return true;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ota/delta_patch.hpp"
+
+namespace Delta
+{
+    bool ReadFile(const char *path, std::vector<uint8_t> *out);
+    bool WriteFile(const char *path, const std::vector<uint8_t> &data);
+
+    void Sha256(const uint8_t *data, size_t len, uint8_t out[32]);
+
+    // Identifier devices track a delta by: the first 4 bytes of its SHA-256 (never 0)
+    uint32_t DeltaId(const std::vector<uint8_t> &delta);
+
+    struct ApplyOptions
+    {
+        size_t chunk_bytes = 2048;  ///< Bytes fed per Feed() call (one device chunk)
+        size_t session_chunks = 0;  ///< Restart the patcher from its committed offset after this many chunks (0: never)
+    };
+
+    /**
+     * Rebuild the target with the firmware's DeltaPatcher, as a device would
+     *
+     * Checks the base against the header, feeds the delta in device-sized
+     * chunks (optionally dropping the partial window every session_chunks
+     * chunks and resuming like a new session), then checks the result
+     * against the target hash. Returns false with a reason in *error.
+     */
+    bool ApplyDelta(const std::vector<uint8_t> &base, const std::vector<uint8_t> &delta, const ApplyOptions &options,
+                    std::vector<uint8_t> *target, Ota::DeltaHeader *header, std::string *error);
+}
\ No newline at end of file
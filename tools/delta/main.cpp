@@ -0,0 +1,275 @@
+#include "chunk_server.hpp"
+#include "delta_encoder.hpp"
+#include "delta_image.hpp"
+
+#include <mosquitto.h>
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    std::atomic<bool> g_stop{false};
+
+    void usage(const char *argv0)
+    {
+        printf("Usage: %s --build | --verify | --serve [options]\n"
+               "Modes:\n"
+               "  --build               write a delta rebuilding --target from --base to --out\n"
+               "  --verify              apply --delta to --base as a device would and check the result\n"
+               "  --serve               offer --delta to the device at --base-topic and answer its chunk requests\n"
+               "Options:\n"
+               "  --base FILE           firmware image the device runs (build/verify)\n"
+               "  --target FILE         new firmware image (build; verify: also compare byte for byte)\n"
+               "  --delta FILE          delta to verify or serve\n"
+               "  --out FILE            delta written by --build\n"
+               "  --version TEXT        version recorded in the delta and the offer (default: unknown)\n"
+               "  --chunk N             bytes per device request when verifying (default 2048)\n"
+               "  --session N           verify: resume from the last complete window every N chunks\n"
+               "                        (default 32, 0 feeds everything in one session)\n"
+               "  --host HOST           broker host (default 127.0.0.1)\n"
+               "  --port N              broker port (default 1883)\n"
+               "  --base-topic TOPIC    device base topic (default home/mailbox)\n"
+               "  --client-id ID        client id of the server (default mailbox-ota)\n"
+               "  --report S            seconds between report lines when serving (default 5)\n",
+               argv0);
+    }
+
+    int build(const char *base_path, const char *target_path, const char *out_path, const char *version)
+    {
+        std::vector<uint8_t> base;
+        std::vector<uint8_t> target;
+        if (!Delta::ReadFile(base_path, &base) || !Delta::ReadFile(target_path, &target))
+        {
+            fprintf(stderr, "[ota] cannot read %s or %s\n", base_path, target_path);
+            return 1;
+        }
+        if (target.empty())
+        {
+            fprintf(stderr, "[ota] %s is empty\n", target_path);
+            return 1;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        Delta::EncodeStats stats;
+        const std::vector<uint8_t> delta = Delta::Encode(base, target, version, &stats);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // Never ship a delta that does not rebuild the target
+        std::vector<uint8_t> rebuilt;
+        Ota::DeltaHeader header;
+        std::string error;
+        if (!Delta::ApplyDelta(base, delta, Delta::ApplyOptions(), &rebuilt, &header, &error) || rebuilt != target)
+        {
+            fprintf(stderr, "[ota] internal error, delta does not rebuild the target: %s\n", error.c_str());
+            return 1;
+        }
+        if (!Delta::WriteFile(out_path, delta))
+        {
+            fprintf(stderr, "[ota] cannot write %s\n", out_path);
+            return 1;
+        }
+
+        printf("[ota] %s: %zu -> %zu bytes, delta %zu bytes (%.1f%% of target) in %.2f s, id %08x\n", out_path,
+               base.size(), target.size(), delta.size(), 100.0 * delta.size() / target.size(), seconds,
+               Delta::DeltaId(delta));
+        printf("[ota] %u windows, %llu ops: %llu bytes copied from base, %llu from target, %llu literal\n",
+               stats.windows, static_cast<unsigned long long>(stats.ops),
+               static_cast<unsigned long long>(stats.copy_base_bytes),
+               static_cast<unsigned long long>(stats.copy_target_bytes),
+               static_cast<unsigned long long>(stats.literal_bytes));
+        return 0;
+    }
+
+    int verify(const char *base_path, const char *delta_path, const char *target_path,
+               const Delta::ApplyOptions &options)
+    {
+        std::vector<uint8_t> base;
+        std::vector<uint8_t> delta;
+        if (!Delta::ReadFile(base_path, &base) || !Delta::ReadFile(delta_path, &delta))
+        {
+            fprintf(stderr, "[ota] cannot read %s or %s\n", base_path, delta_path);
+            return 1;
+        }
+
+        std::vector<uint8_t> rebuilt;
+        Ota::DeltaHeader header;
+        std::string error;
+        if (!Delta::ApplyDelta(base, delta, options, &rebuilt, &header, &error))
+        {
+            fprintf(stderr, "[ota] %s: %s\n", delta_path, error.c_str());
+            return 1;
+        }
+
+        if (target_path)
+        {
+            std::vector<uint8_t> target;
+            if (!Delta::ReadFile(target_path, &target) || target != rebuilt)
+            {
+                fprintf(stderr, "[ota] %s: rebuilt image differs from %s\n", delta_path, target_path);
+                return 1;
+            }
+        }
+
+        const size_t sessions = options.session_chunks
+                                    ? (delta.size() + options.session_chunks * options.chunk_bytes - 1) /
+                                          (options.session_chunks * options.chunk_bytes)
+                                    : 1;
+        printf("[ota] %s OK: version %s, %u -> %u bytes, id %08x, about %zu sessions of %zu x %zu bytes\n",
+               delta_path, header.target_version, header.base_size, header.target_size, Delta::DeltaId(delta),
+               sessions, options.session_chunks, options.chunk_bytes);
+        return 0;
+    }
+
+    int serve(const char *delta_path, const char *version, const char *host, int port, const char *base_topic,
+              const char *client_id, double report_s)
+    {
+        std::vector<uint8_t> delta;
+        Ota::DeltaHeader header;
+        if (!Delta::ReadFile(delta_path, &delta) || delta.size() < Ota::HEADER_SIZE ||
+            !Ota::ParseHeader(delta.data(), &header))
+        {
+            fprintf(stderr, "[ota] %s is not a delta\n", delta_path);
+            return 1;
+        }
+        const size_t size = delta.size();
+
+        signal(SIGINT, [](int)
+               { g_stop = true; });
+        signal(SIGTERM, [](int)
+               { g_stop = true; });
+
+        mosquitto_lib_init();
+        Delta::ChunkServer server(base_topic, std::move(delta), version ? version : header.target_version);
+        if (!server.Start(host, port, client_id))
+            return 1;
+        printf("[ota] serving %s (id %08x, %zu bytes) on %s/ota/# at %s:%d\n", delta_path, server.Id(), size,
+               base_topic, host, port);
+
+        auto next_report = std::chrono::steady_clock::now() + std::chrono::duration<double>(report_s);
+        while (!g_stop)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            if (std::chrono::steady_clock::now() >= next_report)
+            {
+                printf("[ota] requests=%llu sent=%llu bytes rejected=%llu progress=%u/%zu\n",
+                       static_cast<unsigned long long>(server.Requests()),
+                       static_cast<unsigned long long>(server.BytesSent()),
+                       static_cast<unsigned long long>(server.Rejected()), server.Progress(), size);
+                next_report += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double>(report_s));
+            }
+        }
+
+        server.Stop();
+        mosquitto_lib_cleanup();
+        printf("[ota] offer withdrawn after %llu requests\n", static_cast<unsigned long long>(server.Requests()));
+        return 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    enum class Mode
+    {
+        NONE,
+        BUILD,
+        VERIFY,
+        SERVE
+    } mode = Mode::NONE;
+
+    const char *base_path = nullptr;
+    const char *target_path = nullptr;
+    const char *delta_path = nullptr;
+    const char *out_path = nullptr;
+    const char *version = nullptr;
+    const char *host = "127.0.0.1";
+    int port = 1883;
+    const char *base_topic = "home/mailbox";
+    const char *client_id = "mailbox-ota";
+    double report_s = 5.0;
+
+    Delta::ApplyOptions options;
+    options.chunk_bytes = 2048;
+    options.session_chunks = 32;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        const auto need = [&]()
+        {
+            if (!value)
+            {
+                fprintf(stderr, "Missing value for %s\n", arg);
+                exit(2);
+            }
+            ++i;
+            return value;
+        };
+
+        if (!strcmp(arg, "--build"))
+            mode = Mode::BUILD;
+        else if (!strcmp(arg, "--verify"))
+            mode = Mode::VERIFY;
+        else if (!strcmp(arg, "--serve"))
+            mode = Mode::SERVE;
+        else if (!strcmp(arg, "--base"))
+            base_path = need();
+        else if (!strcmp(arg, "--target"))
+            target_path = need();
+        else if (!strcmp(arg, "--delta"))
+            delta_path = need();
+        else if (!strcmp(arg, "--out"))
+            out_path = need();
+        else if (!strcmp(arg, "--version"))
+            version = need();
+        else if (!strcmp(arg, "--chunk"))
+            options.chunk_bytes = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--session"))
+            options.session_chunks = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--host"))
+            host = need();
+        else if (!strcmp(arg, "--port"))
+            port = atoi(need());
+        else if (!strcmp(arg, "--base-topic"))
+            base_topic = need();
+        else if (!strcmp(arg, "--client-id"))
+            client_id = need();
+        else if (!strcmp(arg, "--report"))
+            report_s = atof(need());
+        else
+        {
+            usage(argv[0]);
+            return !strcmp(arg, "--help") ? 0 : 2;
+        }
+    }
+
+    switch (mode)
+    {
+    case Mode::BUILD:
+        if (base_path && target_path && out_path)
+            return build(base_path, target_path, out_path, version ? version : "unknown");
+        break;
+    case Mode::VERIFY:
+        if (base_path && delta_path && options.chunk_bytes > 0)
+            return verify(base_path, delta_path, target_path, options);
+        break;
+    case Mode::SERVE:
+        if (delta_path && report_s > 0)
+            return serve(delta_path, version, host, port, base_topic, client_id, report_s);
+        break;
+    case Mode::NONE:
+        break;
+    }
+
+    usage(argv[0]);
+    return 2;
+}
\ No newline at end of file
@@ -0,0 +1,270 @@
+#include "host_mqtt.hpp"
+#include "config/config.hpp"
+#include "telemetry/telemetry.hpp"
+#include "transport/broker_endpoints.hpp"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Teardown allowed on top of the connect deadline: the old client waiting to reconnect, and scheduling
+    constexpr uint32_t TEARDOWN_SLACK_MS = 200;
+
+    void usage(const char *argv0)
+    {
+        printf("Usage: %s [options]\n"
+               "  --rounds N            sessions per scenario (default 3)\n"
+               "  --verbose             print firmware INFO logs\n",
+               argv0);
+    }
+
+    /**
+     * Broker stand-in on a local port
+     *
+     * A hung broker accepts the TCP connection and never answers, like one
+     * whose MQTT task is stuck: the client waits for CONNACK. An answering
+     * broker acknowledges every CONNECT and PINGREQ and ignores the rest.
+     */
+    class LocalBroker
+    {
+    public:
+        explicit LocalBroker(bool answer) : answer_(answer), listen_fd_(-1), port_(0), running_(false) {}
+
+        ~LocalBroker()
+        {
+            running_ = false;
+            if (thread_.joinable())
+                thread_.join();
+            for (int fd : clients_)
+                close(fd);
+            if (listen_fd_ >= 0)
+                close(listen_fd_);
+        }
+
+        bool Start()
+        {
+            listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in addr = {};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            socklen_t len = sizeof(addr);
+            if (listen_fd_ < 0 || bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+                listen(listen_fd_, 8) != 0 || getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&addr), &len) != 0)
+                return false;
+            port_ = ntohs(addr.sin_port);
+            running_ = true;
+            thread_ = std::thread([this]
+                                  { run(); });
+            return true;
+        }
+
+        std::string Uri() const { return "mqtt://127.0.0.1:" + std::to_string(port_); }
+
+    private:
+        bool answer_;
+        int listen_fd_;
+        int port_;
+        std::atomic<bool> running_;
+        std::thread thread_;
+        std::vector<int> clients_;
+
+        void run()
+        {
+            std::vector<struct pollfd> fds;
+            while (running_)
+            {
+                fds.clear();
+                fds.push_back({listen_fd_, POLLIN, 0});
+                for (int fd : clients_)
+                    fds.push_back({fd, static_cast<short>(answer_ ? POLLIN : 0), 0});
+                if (poll(fds.data(), fds.size(), 10) <= 0)
+                    continue;
+
+                if (fds[0].revents & POLLIN)
+                {
+                    const int fd = accept(listen_fd_, nullptr, nullptr);
+                    if (fd >= 0)
+                        clients_.push_back(fd);
+                }
+                for (size_t i = 1; i < fds.size(); ++i)
+                {
+                    if (fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+                        serve(fds[i].fd);
+                }
+            }
+        }
+
+        // Answers by the packet type in each fixed header read; packets of a test session fit one read
+        void serve(int fd)
+        {
+            uint8_t buf[512];
+            const ssize_t n = read(fd, buf, sizeof(buf));
+            if (n <= 0)
+            {
+                clients_.erase(std::find(clients_.begin(), clients_.end(), fd));
+                close(fd);
+                return;
+            }
+            static const uint8_t CONNACK[] = {0x20, 0x02, 0x00, 0x00};
+            static const uint8_t PINGRESP[] = {0xd0, 0x00};
+            if ((buf[0] & 0xf0) == 0x10)
+                (void)!write(fd, CONNACK, sizeof(CONNACK));
+            else if ((buf[0] & 0xf0) == 0xc0)
+                (void)!write(fd, PINGRESP, sizeof(PINGRESP));
+        }
+    };
+
+    // URI of a local port nobody listens on: the connect is refused at once
+    std::string refusedUri()
+    {
+        const int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+        getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &len);
+        close(fd);
+        return "mqtt://127.0.0.1:" + std::to_string(ntohs(addr.sin_port));
+    }
+
+    struct Switch
+    {
+        bool connected;
+        int64_t connack_ms;  ///< From the start of the session to CONNACK of the second broker
+        int64_t teardown_ms; ///< Time InitMQTT of the second broker spent tearing down the first client
+    };
+
+    // The broker loop of app_main, from a fresh boot
+    Switch runSession(const std::string &first, const std::string &second)
+    {
+        const char *uris[] = {first.c_str(), second.c_str()};
+        Telemetry::Publisher::EndpointCache cache = {};
+        Telemetry::Publisher::BrokerEndpoints endpoints(&cache, uris, 2);
+        endpoints.Begin(0);
+        Telemetry::Telemetry telemetry;
+
+        Switch result = {};
+        const int64_t session_start_us = esp_timer_get_time();
+        for (size_t attempt = 0; attempt < endpoints.Count() && !telemetry.IsConnected(); ++attempt)
+        {
+            const size_t endpoint = endpoints.Pick(attempt);
+            const int64_t connect_start_us = esp_timer_get_time();
+            telemetry.InitMQTT(endpoints.Uri(endpoint, 0), Config::MQTT_BASE_TOPIC, "failover-check");
+            if (attempt > 0)
+                result.teardown_ms = (esp_timer_get_time() - connect_start_us) / 1000;
+            while (!telemetry.IsConnected() &&
+                   esp_timer_get_time() - connect_start_us < Config::MQTT_CONNECT_DEADLINE_MS * 1000LL)
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+            if (telemetry.IsConnected())
+            {
+                result.connected = endpoint == 1;
+                endpoints.Connected(endpoint, 0, static_cast<uint32_t>((esp_timer_get_time() - connect_start_us) / 1000));
+            }
+            else
+            {
+                endpoints.Failed(endpoint, 0);
+            }
+        }
+        result.connack_ms = (esp_timer_get_time() - session_start_us) / 1000;
+        telemetry.Stop();
+        return result;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t rounds = 3;
+    bool verbose = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        const auto need = [&]()
+        {
+            if (!value)
+            {
+                fprintf(stderr, "Missing value for %s\n", arg);
+                exit(2);
+            }
+            ++i;
+            return value;
+        };
+
+        if (!strcmp(arg, "--rounds"))
+            rounds = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--verbose"))
+            verbose = true;
+        else
+        {
+            usage(argv[0]);
+            return !strcmp(arg, "--help") ? 0 : 2;
+        }
+    }
+
+    // Failed connects log errors on purpose
+    esp_log_level_set("*", verbose ? ESP_LOG_INFO : ESP_LOG_NONE);
+
+    LocalBroker hung(false);
+    LocalBroker healthy(true);
+    if (!hung.Start() || !healthy.Start())
+    {
+        fprintf(stderr, "[failover] cannot listen on a local port\n");
+        return 1;
+    }
+
+    struct Scenario
+    {
+        const char *name;
+        std::string first;
+    };
+    const Scenario scenarios[] = {{"hung", hung.Uri()}, {"refused", refusedUri()}};
+
+    const int64_t budget_ms = Config::MQTT_CONNECT_DEADLINE_MS + Config::MQTT_RECONNECT_TIMEOUT_MS / 2 + TEARDOWN_SLACK_MS;
+    bool failed = false;
+    for (const Scenario &scenario : scenarios)
+    {
+        int64_t worst_ms = 0;
+        int64_t worst_teardown_ms = 0;
+        bool connected = true;
+        for (uint32_t round = 0; round < rounds && connected; ++round)
+        {
+            const Switch result = runSession(scenario.first, healthy.Uri());
+            connected = result.connected;
+            worst_ms = std::max(worst_ms, result.connack_ms);
+            worst_teardown_ms = std::max(worst_teardown_ms, result.teardown_ms);
+        }
+        if (connected)
+            printf("[failover] %-8s first broker: CONNACK from the second after %lld ms at worst (teardown %lld ms), "
+                   "budget %lld ms\n",
+                   scenario.name, static_cast<long long>(worst_ms), static_cast<long long>(worst_teardown_ms),
+                   static_cast<long long>(budget_ms));
+        else
+            printf("[failover] %-8s first broker: no CONNACK from the second, session gave up after %lld ms "
+                   "(teardown %lld ms)\n",
+                   scenario.name, static_cast<long long>(worst_ms), static_cast<long long>(worst_teardown_ms));
+        if (!connected || worst_ms > budget_ms)
+            failed = true;
+    }
+
+    HostMqtt::Loop::Instance().Stop();
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,85 @@
+#include "broker_model.hpp"
+
+#include <algorithm>
+
+namespace FleetSim
+{
+    void BrokerModel::SetAcceptRate(uint32_t connects_per_s)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        accept_rate_ = connects_per_s;
+        tokens_ = connects_per_s;
+    }
+
+    void BrokerModel::Start(int64_t now_us)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        start_us_ = now_us;
+        refilled_us_ = now_us;
+        attempts_.clear();
+        window_start_ = 0;
+        refused_ = 0;
+        window_refused_ = 0;
+    }
+
+    bool BrokerModel::Connect(int64_t now_us)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // Devices may wake before the run starts; those count towards second 0
+        const size_t second = now_us > start_us_ ? static_cast<size_t>((now_us - start_us_) / 1000000) : 0;
+        if (attempts_.size() <= second)
+            attempts_.resize(second + 1, 0);
+        attempts_[second]++;
+
+        if (accept_rate_ == 0)
+            return true;
+
+        if (now_us > refilled_us_)
+        {
+            tokens_ = std::min<double>(accept_rate_, tokens_ + accept_rate_ * ((now_us - refilled_us_) / 1e6));
+            refilled_us_ = now_us;
+        }
+        if (tokens_ >= 1.0)
+        {
+            tokens_ -= 1.0;
+            return true;
+        }
+
+        refused_++;
+        window_refused_++;
+        return false;
+    }
+
+    std::array<double, 4> BrokerModel::TakeRates(int64_t now_us, bool whole_run)
+    {
+        std::vector<uint32_t> window;
+        uint64_t refused;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            // Seconds since the window started; the current one is still filling, except at the end of the run
+            const size_t now_second = now_us > start_us_ ? static_cast<size_t>((now_us - start_us_) / 1000000) : 0;
+            const size_t first = whole_run ? 0 : window_start_;
+            const size_t end = whole_run ? now_second + 1 : std::max(first, now_second);
+            if (attempts_.size() < end)
+                attempts_.resize(end, 0);
+            window.assign(attempts_.begin() + first, attempts_.begin() + end);
+
+            refused = whole_run ? refused_ : window_refused_;
+            window_start_ = end;
+            window_refused_ = 0;
+        }
+
+        if (window.empty())
+            return {0.0, 0.0, 0.0, static_cast<double>(refused)};
+
+        uint64_t total = 0;
+        for (uint32_t attempts : window)
+            total += attempts;
+        std::sort(window.begin(), window.end());
+        const size_t p99 = std::min(window.size() - 1, static_cast<size_t>(0.99 * window.size()));
+        return {static_cast<double>(window.back()), static_cast<double>(window[p99]),
+                static_cast<double>(total) / window.size(), static_cast<double>(refused)};
+    }
+}
\ No newline at end of file
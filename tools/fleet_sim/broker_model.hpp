@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace FleetSim
+{
+    /**
+     * Broker-side load model
+     *
+     * Counts the connection attempts the broker sees in every (real) second
+     * of the run; the peak and the 99th percentile of that rate are what a
+     * fleet that reconnects in step drives up. Optionally the broker accepts
+     * only so many new connections per second (a token bucket with one
+     * second of burst, like the connection rate limits of production brokers):
+     * a refused device sees a failed session and goes into its reconnect
+     * backoff, as it would against an overloaded broker.
+     */
+    class BrokerModel
+    {
+    public:
+        // Accept at most connects_per_s new connections per second (0: no limit)
+        void SetAcceptRate(uint32_t connects_per_s);
+
+        // Mark the start of the run (second 0 of the rate histogram)
+        void Start(int64_t now_us);
+
+        // A device opens a session at now_us; false if the broker refuses it
+        bool Connect(int64_t now_us);
+
+        // Return {peak, p99, mean, refused} attempts per second of the current window and start a new one
+        std::array<double, 4> TakeRates(int64_t now_us, bool whole_run);
+
+    private:
+        std::mutex mutex_;
+        uint32_t accept_rate_ = 0;
+        double tokens_ = 0.0;            ///< Connections the broker would accept right now
+        int64_t refilled_us_ = 0;        ///< Time tokens_ was last refilled to
+        int64_t start_us_ = 0;           ///< Start of second 0
+        std::vector<uint32_t> attempts_; ///< Connection attempts per second since the start
+        size_t window_start_ = 0;        ///< First second of the current window
+        uint64_t refused_ = 0;           ///< Refused attempts over the whole run
+        uint64_t window_refused_ = 0;    ///< Refused attempts in the current window
+    };
+}
\ No newline at end of file
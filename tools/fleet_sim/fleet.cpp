@@ -0,0 +1,115 @@
+#include "fleet.hpp"
+
+#include "config/config.hpp"
+#include "esp_timer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <queue>
+#include <random>
+#include <thread>
+
+namespace FleetSim
+{
+    Fleet::Fleet(const FleetParams &params, const DeviceParams &device_params, Metrics &metrics)
+        : params_(params), device_params_(device_params), metrics_(metrics), running_(false), storm_generation_(0)
+    {
+        params_.sim_threads = std::max<uint32_t>(1, params_.sim_threads);
+
+        devices_.reserve(params_.devices);
+        for (uint32_t i = 0; i < params_.devices; ++i)
+            devices_.emplace_back(new VirtualDevice(i, device_params_, metrics_, params_.seed + i));
+    }
+
+    void Fleet::Run()
+    {
+        running_ = true;
+
+        std::vector<std::thread> workers;
+        for (uint32_t w = 0; w < params_.sim_threads; ++w)
+            workers.emplace_back([this, w]
+                                 { runWorker(w); });
+
+        const int64_t start_us = esp_timer_get_time();
+        const int64_t end_us = start_us + static_cast<int64_t>(params_.duration_s * 1e6);
+        const int64_t storm_us = params_.storm_at_s >= 0 ? start_us + static_cast<int64_t>(params_.storm_at_s * 1e6) : -1;
+        int64_t next_report_us = start_us + static_cast<int64_t>(params_.report_interval_s * 1e6);
+
+        metrics_.Start(start_us);
+        while (esp_timer_get_time() < end_us)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            const int64_t now_us = esp_timer_get_time();
+
+            if (storm_us >= 0 && now_us >= storm_us && storm_generation_ == 0)
+            {
+                printf("[fleet] power cut: all %u devices fresh-boot within %u ms\n",
+                       params_.devices, params_.storm_spread_ms);
+                storm_generation_++;
+            }
+
+            if (now_us >= next_report_us)
+            {
+                metrics_.Report(now_us, false);
+                next_report_us += static_cast<int64_t>(params_.report_interval_s * 1e6);
+            }
+        }
+
+        running_ = false;
+        for (auto &worker : workers)
+            worker.join();
+
+        // Close sessions still in flight
+        for (auto &device : devices_)
+            device->PowerCycle();
+
+        metrics_.Report(esp_timer_get_time(), true);
+    }
+
+    void Fleet::runWorker(uint32_t worker_index)
+    {
+        using Entry = std::pair<int64_t, uint32_t>; // (due time, device index)
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> due;
+        std::mt19937 rng(static_cast<uint32_t>(params_.seed) + worker_index);
+
+        // Devices were installed at different times: spread first wakes over one sleep period
+        const int64_t start_us = esp_timer_get_time();
+        const int64_t period_us = std::max<int64_t>(1, static_cast<int64_t>(Config::DEEP_SLEEP_US / device_params_.time_scale));
+        std::uniform_int_distribution<int64_t> phase(0, period_us);
+        for (uint32_t i = worker_index; i < devices_.size(); i += params_.sim_threads)
+            due.push({start_us + phase(rng), i});
+
+        uint32_t seen_storm = 0;
+        while (running_)
+        {
+            int64_t now_us = esp_timer_get_time();
+
+            if (storm_generation_ != seen_storm)
+            {
+                // Rebuild the heap: everyone reboots within the spread window, sessions in flight are cut
+                seen_storm = storm_generation_;
+                std::uniform_int_distribution<int64_t> spread(0, static_cast<int64_t>(params_.storm_spread_ms) * 1000);
+                decltype(due) rebooted;
+                while (!due.empty())
+                {
+                    const uint32_t index = due.top().second;
+                    due.pop();
+                    devices_[index]->PowerCycle();
+                    rebooted.push({now_us + spread(rng), index});
+                }
+                due.swap(rebooted);
+            }
+
+            if (due.empty() || due.top().first > now_us)
+            {
+                const int64_t wait_us = due.empty() ? 1000 : std::min<int64_t>(1000, due.top().first - now_us);
+                std::this_thread::sleep_for(std::chrono::microseconds(wait_us));
+                continue;
+            }
+
+            const uint32_t index = due.top().second;
+            due.pop();
+            due.push({devices_[index]->Step(now_us), index});
+        }
+    }
+}
\ No newline at end of file
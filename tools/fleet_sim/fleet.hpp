@@ -0,0 +1,51 @@
+#pragma once
+
+#include "virtual_device.hpp"
+#include "metrics.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace FleetSim
+{
+    // Fleet size, threading and scripted disturbances
+    struct FleetParams
+    {
+        uint32_t devices;         ///< Number of virtual devices
+        uint32_t sim_threads;     ///< Threads stepping devices (MQTT I/O runs on its own pool)
+        uint64_t seed;            ///< Base seed; device i uses seed + i
+        double duration_s;        ///< Real run time (seconds)
+        double report_interval_s; ///< Real time between report lines (seconds)
+        double storm_at_s;        ///< Real time of a fleet-wide power cut (< 0 disables)
+        uint32_t storm_spread_ms; ///< Devices come back up within this window after the power cut
+    };
+
+    /**
+     * Owns the virtual devices and steps them on a pool of threads
+     *
+     * Devices are partitioned across threads; each thread keeps a min-heap of
+     * (due time, device) and steps whatever is due. No device ever blocks a
+     * thread - radio sessions poll the MQTT client and reschedule themselves.
+     */
+    class Fleet
+    {
+    public:
+        Fleet(const FleetParams &params, const DeviceParams &device_params, Metrics &metrics);
+
+        // Run for params.duration_s, printing a report every params.report_interval_s
+        void Run();
+
+    private:
+        FleetParams params_;
+        DeviceParams device_params_; ///< Shared by reference with every device
+        Metrics &metrics_;
+        std::vector<std::unique_ptr<VirtualDevice>> devices_;
+        std::atomic<bool> running_;
+        std::atomic<uint32_t> storm_generation_; ///< Incremented for each fleet-wide power cut
+
+        // Step the devices with index % sim_threads == worker_index
+        void runWorker(uint32_t worker_index);
+    };
+}
\ No newline at end of file
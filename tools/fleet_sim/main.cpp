@@ -0,0 +1,268 @@
+#include "fleet.hpp"
+#include "metrics.hpp"
+
+#include "config/config.hpp"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "host_mqtt.hpp"
+#include "mqtt_client.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    void usage(const char *argv0)
+    {
+        printf("Usage: %s [options]\n"
+               "  --broker URI          broker to publish to (default mqtt://127.0.0.1:1883); repeat for failover brokers\n"
+               "  --base-topic TOPIC    base topic, devices use TOPIC/<client_id> (default sim/mailbox)\n"
+               "  --devices N           number of virtual devices (default 1000)\n"
+               "  --duration S          real run time in seconds (default 60)\n"
+               "  --time-scale X        virtual seconds per real second while sleeping (default 1)\n"
+               "  --drops-per-day X     mean mail drops per device per day (default 2)\n"
+               "  --flaps-per-day X     mean flapping episodes per device per day (default 0)\n"
+               "  --flap-minutes M      length of one flapping episode (default 30)\n"
+               "  --flap-period S       flat/curled period during an episode (default 30)\n"
+               "  --jitter-ms MS        random jitter added to each sleep (default 50)\n"
+               "  --linger-ms MS        time a session stays open after publishing (default 1000)\n"
+               "  --wifi-ms MS          Wi-Fi and SNTP time per session in the charge estimate (default 1800)\n"
+               "  --deadline-ms MS      fail over to the next broker without CONNACK after MS (default 2500)\n"
+               "  --no-spread           first heartbeat one interval after boot, without the per-device phase offset\n"
+               "  --no-backoff          retry a failed heartbeat on every wake, without the reconnect backoff\n"
+               "  --accept-rate N       broker accepts at most N new connections per second, 0 = no limit (default 0)\n"
+               "  --battery-mv MV       mean battery voltage at the start (default 4000)\n"
+               "  --battery-spread MV   start voltages vary by up to +/- MV (default 100)\n"
+               "  --battery-drain MV    battery voltage lost per virtual day of sleep (default 0)\n"
+               "  --session-mv MV       battery voltage lost per radio session (default 0)\n"
+               "  --adc-noise-mv MV     noise of each battery ADC conversion (default 10)\n"
+               "  --storm-at S          fleet-wide power cut after S real seconds (default off)\n"
+               "  --storm-spread-ms MS  devices reboot within this window (default 2000)\n"
+               "  --sim-threads N       device stepping threads (default hardware concurrency)\n"
+               "  --mqtt-threads N      MQTT I/O threads (default hardware concurrency)\n"
+               "  --report S            seconds between report lines (default 5)\n"
+               "  --seed N              base random seed (default 1)\n"
+               "  --verbose             print firmware INFO logs\n",
+               argv0);
+    }
+
+    // Subscriber that receives everything the fleet publishes to one broker, for end-to-end latency
+    esp_mqtt_client_handle_t startProbe(const char *broker_uri, const char *client_id, const std::string &filter,
+                                        FleetSim::Metrics &metrics)
+    {
+        struct ProbeContext
+        {
+            std::string filter;
+            FleetSim::Metrics *metrics;
+        };
+        static std::deque<ProbeContext> contexts; // One per broker, never moved
+        contexts.push_back({filter, &metrics});
+        ProbeContext &context = contexts.back();
+
+        esp_mqtt_client_config_t cfg = {};
+        cfg.broker.address.uri = broker_uri;
+        cfg.credentials.client_id = client_id;
+        cfg.network.reconnect_timeout_ms = 1000;
+
+        esp_mqtt_client_handle_t probe = esp_mqtt_client_init(&cfg);
+        if (!probe)
+            return nullptr;
+
+        esp_mqtt_client_register_event(
+            probe, MQTT_EVENT_ANY,
+            [](void *arg, esp_event_base_t, int32_t event_id, void *event_data)
+            {
+                auto *ctx = static_cast<ProbeContext *>(arg);
+                auto *event = static_cast<esp_mqtt_event_handle_t>(event_data);
+                if (event_id == MQTT_EVENT_CONNECTED)
+                    esp_mqtt_client_subscribe(event->client, ctx->filter.c_str(), 1);
+                else if (event_id == MQTT_EVENT_DATA)
+                    ctx->metrics->NoteDelivered(event->topic, event->topic_len, event->data, event->data_len,
+                                                esp_timer_get_time());
+            },
+            &context);
+
+        esp_mqtt_client_start(probe);
+        return probe;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const unsigned hw_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<const char *> broker_uris;
+    const char *base_topic = "sim/mailbox";
+    uint32_t mqtt_threads = hw_threads;
+    bool verbose = false;
+
+    FleetSim::FleetParams fleet = {};
+    fleet.devices = 1000;
+    fleet.sim_threads = hw_threads;
+    fleet.seed = 1;
+    fleet.duration_s = 60.0;
+    fleet.report_interval_s = 5.0;
+    fleet.storm_at_s = -1.0;
+    fleet.storm_spread_ms = 2000;
+
+    FleetSim::DeviceParams device = {};
+    device.time_scale = 1.0;
+    device.wake_jitter_ms = 50;
+    device.connect_timeout_ms = Config::MQTT_CONNECT_DEADLINE_MS;
+    device.linger_ms = 1000;
+    device.wifi_ms = 1800;
+    device.spread_heartbeats = Config::HEARTBEAT_PHASE_SPREAD;
+    device.reconnect_backoff = true;
+    uint32_t accept_rate = 0;
+    device.trace.baseline_cm = Config::BASELINE_CM;
+    device.trace.noise_sigma_cm = 0.3f;
+    device.trace.dropout_prob = 0.01f;
+    device.trace.drops_per_day = 2.0f;
+    device.trace.collections_per_day = 1.0f;
+    device.trace.item_min_cm = 2.5f;
+    device.trace.item_max_cm = 6.0f;
+    device.trace.flap_minutes = 30.0f;
+    device.trace.flap_period_s = 30.0f;
+    device.trace.flap_cm = 3.0f;
+    device.battery.start_mv = 4000.0f;
+    device.battery.spread_mv = 100.0f;
+    device.battery.drain_mv_per_day = 0.0f;
+    device.battery.session_mv = 0.0f;
+    device.battery.adc_noise_mv = 10.0f;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        const auto need = [&]()
+        {
+            if (!value)
+            {
+                fprintf(stderr, "Missing value for %s\n", arg);
+                exit(2);
+            }
+            ++i;
+            return value;
+        };
+
+        if (!strcmp(arg, "--broker"))
+            broker_uris.push_back(need());
+        else if (!strcmp(arg, "--base-topic"))
+            base_topic = need();
+        else if (!strcmp(arg, "--devices"))
+            fleet.devices = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--duration"))
+            fleet.duration_s = atof(need());
+        else if (!strcmp(arg, "--time-scale"))
+            device.time_scale = atof(need());
+        else if (!strcmp(arg, "--drops-per-day"))
+            device.trace.drops_per_day = static_cast<float>(atof(need()));
+        else if (!strcmp(arg, "--flaps-per-day"))
+            device.trace.flaps_per_day = static_cast<float>(atof(need()));
+        else if (!strcmp(arg, "--flap-minutes"))
+            device.trace.flap_minutes = static_cast<float>(atof(need()));
+        else if (!strcmp(arg, "--flap-period"))
+            device.trace.flap_period_s = static_cast<float>(atof(need()));
+        else if (!strcmp(arg, "--jitter-ms"))
+            device.wake_jitter_ms = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--linger-ms"))
+            device.linger_ms = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--wifi-ms"))
+            device.wifi_ms = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--deadline-ms"))
+            device.connect_timeout_ms = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--no-spread"))
+            device.spread_heartbeats = false;
+        else if (!strcmp(arg, "--no-backoff"))
+            device.reconnect_backoff = false;
+        else if (!strcmp(arg, "--accept-rate"))
+            accept_rate = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--battery-mv"))
+            device.battery.start_mv = static_cast<float>(atof(need()));
+        else if (!strcmp(arg, "--battery-spread"))
+            device.battery.spread_mv = static_cast<float>(atof(need()));
+        else if (!strcmp(arg, "--battery-drain"))
+            device.battery.drain_mv_per_day = static_cast<float>(atof(need()));
+        else if (!strcmp(arg, "--session-mv"))
+            device.battery.session_mv = static_cast<float>(atof(need()));
+        else if (!strcmp(arg, "--adc-noise-mv"))
+            device.battery.adc_noise_mv = static_cast<float>(atof(need()));
+        else if (!strcmp(arg, "--storm-at"))
+            fleet.storm_at_s = atof(need());
+        else if (!strcmp(arg, "--storm-spread-ms"))
+            fleet.storm_spread_ms = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--sim-threads"))
+            fleet.sim_threads = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--mqtt-threads"))
+            mqtt_threads = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--report"))
+            fleet.report_interval_s = atof(need());
+        else if (!strcmp(arg, "--seed"))
+            fleet.seed = strtoull(need(), nullptr, 10);
+        else if (!strcmp(arg, "--verbose"))
+            verbose = true;
+        else
+        {
+            usage(argv[0]);
+            return !strcmp(arg, "--help") ? 0 : 2;
+        }
+    }
+
+    if (fleet.devices == 0 || device.time_scale <= 0.0)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (broker_uris.empty())
+        broker_uris.push_back("mqtt://127.0.0.1:1883");
+    if (broker_uris.size() > Telemetry::Publisher::MAX_BROKER_ENDPOINTS)
+    {
+        fprintf(stderr, "At most %zu brokers\n", Telemetry::Publisher::MAX_BROKER_ENDPOINTS);
+        return 2;
+    }
+    device.broker_uris = broker_uris.data();
+    device.broker_count = broker_uris.size();
+    device.base_topic = base_topic;
+    esp_log_level_set("*", verbose ? ESP_LOG_INFO : ESP_LOG_WARN);
+
+    FleetSim::Metrics metrics;
+    metrics.broker.SetAcceptRate(accept_rate);
+    HostMqtt::SetPublishHook([&metrics](const char *topic, const char *data, int len)
+                             { metrics.NotePublished(topic, data, len, esp_timer_get_time()); });
+    HostMqtt::Loop::Instance().Start(mqtt_threads);
+
+    // Each broker gets its own probe: after a failover the messages arrive at the next one
+    std::vector<esp_mqtt_client_handle_t> probes;
+    for (size_t i = 0; i < broker_uris.size(); ++i)
+    {
+        char probe_id[32];
+        snprintf(probe_id, sizeof(probe_id), i == 0 ? "sim-latency-probe" : "sim-latency-probe-%zu", i);
+        esp_mqtt_client_handle_t probe = startProbe(broker_uris[i], probe_id, std::string(base_topic) + "/#", metrics);
+        if (!probe)
+        {
+            fprintf(stderr, "Failed to create latency probe for %s\n", broker_uris[i]);
+            return 1;
+        }
+        probes.push_back(probe);
+    }
+
+    printf("[fleet] %u devices -> %s%s (%s/#), time scale %.1fx, %u sim threads, %u MQTT threads\n",
+           fleet.devices, broker_uris[0], broker_uris.size() > 1 ? " with failover" : "", base_topic,
+           device.time_scale, fleet.sim_threads, mqtt_threads);
+
+    {
+        FleetSim::Fleet sim(fleet, device, metrics);
+        sim.Run();
+    }
+
+    for (esp_mqtt_client_handle_t probe : probes)
+        esp_mqtt_client_destroy(probe);
+    HostMqtt::Loop::Instance().Stop();
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace FleetSim
+{
+    void LatencyRecorder::Record(int64_t latency_us)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        window_.push_back(latency_us);
+        run_.push_back(latency_us);
+    }
+
+    std::array<int64_t, 5> LatencyRecorder::TakePercentiles(bool whole_run)
+    {
+        std::vector<int64_t> samples;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (whole_run)
+                samples = run_;
+            else
+                samples.swap(window_);
+        }
+
+        if (samples.empty())
+            return {0, 0, 0, 0, 0};
+
+        std::sort(samples.begin(), samples.end());
+        const auto at = [&samples](double q)
+        {
+            return samples[std::min(samples.size() - 1, static_cast<size_t>(q * samples.size()))];
+        };
+        return {at(0.50), at(0.90), at(0.99), samples.back(), static_cast<int64_t>(samples.size())};
+    }
+
+    void Metrics::NotePublished(const char *topic, const char *data, int len, int64_t now_us)
+    {
+        const uint64_t hash = hashMessage(topic, strlen(topic), data, len);
+        Shard &shard = shards_[hash % SHARDS];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.published_at[hash] = now_us;
+        publishes++;
+    }
+
+    void Metrics::NoteDelivered(const char *topic, int topic_len, const char *data, int len, int64_t now_us)
+    {
+        const uint64_t hash = hashMessage(topic, topic_len, data, len);
+        Shard &shard = shards_[hash % SHARDS];
+
+        int64_t published_at = -1;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.published_at.find(hash);
+            if (it == shard.published_at.end())
+                return; // Retained message from an earlier run
+            published_at = it->second;
+            shard.published_at.erase(it);
+        }
+
+        delivered++;
+        delivery_latency.Record(now_us - published_at);
+    }
+
+    void Metrics::Start(int64_t now_us)
+    {
+        start_us_ = now_us;
+        last_report_us_ = now_us;
+        broker.Start(now_us);
+        last_wakes_ = wakes;
+        last_sessions_ = sessions;
+        last_publishes_ = publishes;
+        last_delivered_ = delivered;
+    }
+
+    void Metrics::Report(int64_t now_us, bool final_report)
+    {
+        if (final_report)
+        {
+            // Rates over the whole run
+            last_report_us_ = start_us_;
+            last_wakes_ = last_sessions_ = last_publishes_ = last_delivered_ = 0;
+        }
+
+        const double elapsed_s = std::max(1e-3, (now_us - last_report_us_) / 1e6);
+        const uint64_t w = wakes, s = sessions, p = publishes, d = delivered;
+
+        const auto connect = connect_latency.TakePercentiles(final_report);
+        const auto delivery = delivery_latency.TakePercentiles(final_report);
+        const auto restore = restore_latency.TakePercentiles(final_report);
+        const auto connects = broker.TakeRates(now_us, final_report);
+
+        // Flash wear: NVS writes per device and virtual day, over the whole run
+        const double device_days = virtual_us.load() / 86400e6;
+        const double nvs_per_day = device_days > 0.0 ? nvs_writes.load() / device_days : 0.0;
+
+        // Charge per wake, over the whole run
+        const double wakes_run = std::max<uint64_t>(w, 1);
+
+        printf("%s wakes/s=%.0f sessions/s=%.1f publish/s=%.1f delivered/s=%.1f active=%lld "
+               "connect_fail=%llu failovers=%llu events=%llu suppressed=%llu power_low=%lld power_critical=%lld nvs_writes/day=%.2f "
+               "| connect ms p50=%.1f p90=%.1f p99=%.1f max=%.1f (n=%lld) "
+               "| e2e ms p50=%.1f p90=%.1f p99=%.1f max=%.1f (n=%lld) "
+               "| restore us p50=%lld p99=%lld (n=%lld, total %llu) "
+               "| broker connects/s peak=%.0f p99=%.0f mean=%.1f refused=%.0f "
+               "| uC/wake off=%.0f dfs=%.0f light_sleep=%.0f\n",
+               final_report ? "[total]" : "[fleet]",
+               (w - last_wakes_) / elapsed_s, (s - last_sessions_) / elapsed_s,
+               (p - last_publishes_) / elapsed_s, (d - last_delivered_) / elapsed_s,
+               static_cast<long long>(active_sessions.load()),
+               static_cast<unsigned long long>(connect_failures.load()),
+               static_cast<unsigned long long>(failovers.load()),
+               static_cast<unsigned long long>(events.load()), static_cast<unsigned long long>(suppressed.load()),
+               static_cast<long long>(power_low.load()), static_cast<long long>(power_critical.load()),
+               nvs_per_day,
+               connect[0] / 1e3, connect[1] / 1e3, connect[2] / 1e3, connect[3] / 1e3,
+               static_cast<long long>(connect[4]),
+               delivery[0] / 1e3, delivery[1] / 1e3, delivery[2] / 1e3, delivery[3] / 1e3,
+               static_cast<long long>(delivery[4]),
+               static_cast<long long>(restore[0]), static_cast<long long>(restore[2]),
+               static_cast<long long>(restore[4]), static_cast<unsigned long long>(restores.load()),
+               connects[0], connects[1], connects[2], connects[3],
+               charge_uc[0] / wakes_run, charge_uc[1] / wakes_run, charge_uc[2] / wakes_run);
+        fflush(stdout);
+
+        last_report_us_ = now_us;
+        last_wakes_ = w;
+        last_sessions_ = s;
+        last_publishes_ = p;
+        last_delivered_ = d;
+    }
+
+    uint64_t Metrics::hashMessage(const char *topic, size_t topic_len, const char *data, size_t len)
+    {
+        // FNV-1a over topic and payload
+        uint64_t hash = 1469598103934665603ULL;
+        for (size_t i = 0; i < topic_len; ++i)
+            hash = (hash ^ static_cast<uint8_t>(topic[i])) * 1099511628211ULL;
+        for (size_t i = 0; i < len; ++i)
+            hash = (hash ^ static_cast<uint8_t>(data[i])) * 1099511628211ULL;
+        return hash;
+    }
+}
\ No newline at end of file
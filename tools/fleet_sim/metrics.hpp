@@ -0,0 +1,97 @@
+#pragma once
+
+#include "broker_model.hpp"
+
+#include "sensor/power/charge_model.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace FleetSim
+{
+    // Latency samples of the current reporting window and of the whole run
+    class LatencyRecorder
+    {
+    public:
+        void Record(int64_t latency_us);
+
+        // Return {p50, p90, p99, max, count} in microseconds and start a new window
+        std::array<int64_t, 5> TakePercentiles(bool whole_run);
+
+    private:
+        std::mutex mutex_;
+        std::vector<int64_t> window_;
+        std::vector<int64_t> run_;
+    };
+
+    /**
+     * Fleet-wide counters and latency distributions
+     *
+     * Counters are cumulative; Report() prints the rates since the previous
+     * report and the latency and broker connection rate percentiles of the
+     * samples collected in between, or - for the final report - the same
+     * figures over the whole run.
+     */
+    class Metrics
+    {
+    public:
+        std::atomic<uint64_t> wakes{0};            ///< Device wakes processed
+        std::atomic<uint64_t> sessions{0};         ///< Radio sessions started
+        std::atomic<uint64_t> connect_failures{0}; ///< Sessions that never reached the broker
+        std::atomic<uint64_t> failovers{0};        ///< Connects moved on to the next broker after a missed deadline
+        std::atomic<uint64_t> publishes{0};        ///< Messages handed to the MQTT client
+        std::atomic<uint64_t> delivered{0};        ///< Messages received back by the latency probe
+        std::atomic<int64_t> active_sessions{0};   ///< Sessions currently open
+        std::atomic<uint64_t> events{0};           ///< mail_drop + mail_collected detections
+        std::atomic<uint64_t> suppressed{0};       ///< Detections held back by flap damping
+        std::atomic<int64_t> power_low{0};         ///< Devices currently at the LOW power level
+        std::atomic<int64_t> power_critical{0};    ///< Devices currently at the CRITICAL power level
+        std::atomic<uint64_t> restores{0};         ///< Fresh boots that restored a checkpoint
+        std::atomic<uint64_t> nvs_writes{0};       ///< NVS values written, all devices
+        std::atomic<uint64_t> virtual_us{0};       ///< Virtual time lived, all devices (µs)
+
+        // Estimated charge of all wakes, per power management mode (µC)
+        std::array<std::atomic<uint64_t>, static_cast<size_t>(Hardware::Power::PmMode::COUNT)> charge_uc{};
+
+        LatencyRecorder connect_latency;  ///< Session start to MQTT CONNACK
+        LatencyRecorder delivery_latency; ///< Publish to delivery at the probe subscriber
+        LatencyRecorder restore_latency;  ///< Checkpoint restore after a power cut
+        BrokerModel broker;               ///< Connection attempts per second as the broker sees them
+
+        // Remember when a payload was published so the probe can match it
+        void NotePublished(const char *topic, const char *data, int len, int64_t now_us);
+
+        // Match a delivered payload against its publish time (ignored if unknown)
+        void NoteDelivered(const char *topic, int topic_len, const char *data, int len, int64_t now_us);
+
+        // Mark the start of the run (first reporting window)
+        void Start(int64_t now_us);
+
+        // Print one report line covering the time since the previous call (or the whole run)
+        void Report(int64_t now_us, bool final_report);
+
+    private:
+        static constexpr size_t SHARDS = 16;
+
+        struct Shard
+        {
+            std::mutex mutex;
+            std::unordered_map<uint64_t, int64_t> published_at; ///< Payload hash -> publish time
+        };
+        std::array<Shard, SHARDS> shards_;
+
+        int64_t start_us_ = 0;
+        int64_t last_report_us_ = 0;
+        uint64_t last_wakes_ = 0;
+        uint64_t last_sessions_ = 0;
+        uint64_t last_publishes_ = 0;
+        uint64_t last_delivered_ = 0;
+
+        static uint64_t hashMessage(const char *topic, size_t topic_len, const char *data, size_t len);
+    };
+}
\ No newline at end of file
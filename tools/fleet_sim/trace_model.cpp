@@ -0,0 +1,80 @@
+#include "trace_model.hpp"
+
+#include <cmath>
+
+namespace FleetSim
+{
+    TraceModel::TraceModel(const TraceParams &params, uint64_t seed)
+        : params_(params),
+          rng_(seed),
+          noise_(0.0f, params.noise_sigma_cm),
+          unit_(0.0f, 1.0f),
+          last_time_us_(0),
+          pile_cm_(0.0f),
+          drops_(0),
+          collections_(0),
+          flaps_(0),
+          flap_start_us_(0),
+          flap_end_us_(0),
+          obstructions_(0),
+          obstruction_end_us_(0)
+    {
+    }
+
+    float TraceModel::Sample(uint64_t virtual_time_us)
+    {
+        const uint64_t dt_us = virtual_time_us > last_time_us_ ? virtual_time_us - last_time_us_ : 0;
+        last_time_us_ = virtual_time_us;
+
+        if (pile_cm_ > 0.0f && unit_(rng_) < eventProbability(params_.collections_per_day, dt_us))
+        {
+            pile_cm_ = 0.0f;
+            collections_++;
+        }
+        else if (unit_(rng_) < eventProbability(params_.drops_per_day, dt_us))
+        {
+            pile_cm_ += params_.item_min_cm + unit_(rng_) * (params_.item_max_cm - params_.item_min_cm);
+            drops_++;
+        }
+
+        float curl_cm = 0.0f;
+        if (params_.flaps_per_day > 0.0f && virtual_time_us >= flap_end_us_ &&
+            unit_(rng_) < eventProbability(params_.flaps_per_day, dt_us))
+        {
+            flap_start_us_ = virtual_time_us;
+            flap_end_us_ = virtual_time_us + static_cast<uint64_t>(params_.flap_minutes * 60e6f);
+            flaps_++;
+        }
+        if (virtual_time_us < flap_end_us_ && params_.flap_period_s > 0.0f)
+        {
+            const uint64_t half_period_us = static_cast<uint64_t>(params_.flap_period_s * 0.5e6f);
+            if (((virtual_time_us - flap_start_us_) / half_period_us) & 1)
+                curl_cm = params_.flap_cm;
+        }
+
+        if (params_.obstructions_per_day > 0.0f && virtual_time_us >= obstruction_end_us_ &&
+            unit_(rng_) < eventProbability(params_.obstructions_per_day, dt_us))
+        {
+            obstruction_end_us_ = virtual_time_us + static_cast<uint64_t>(params_.obstruction_hours * 3600e6f);
+            obstructions_++;
+        }
+        if (virtual_time_us < obstruction_end_us_)
+            return -1.0f;
+
+        if (unit_(rng_) < params_.dropout_prob)
+            return -1.0f;
+
+        return std::max(2.0f, params_.baseline_cm - pile_cm_ - curl_cm + noise_(rng_));
+    }
+
+    uint32_t TraceModel::GetDrops() const { return drops_; }
+    uint32_t TraceModel::GetCollections() const { return collections_; }
+    uint32_t TraceModel::GetFlaps() const { return flaps_; }
+    uint32_t TraceModel::GetObstructions() const { return obstructions_; }
+
+    float TraceModel::eventProbability(float per_day, uint64_t dt_us) const
+    {
+        static constexpr double US_PER_DAY = 86400.0 * 1e6;
+        return static_cast<float>(1.0 - std::exp(-per_day * static_cast<double>(dt_us) / US_PER_DAY));
+    }
+}
\ No newline at end of file
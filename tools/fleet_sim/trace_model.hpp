@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+
+namespace FleetSim
+{
+    // Parameters of the synthetic mailbox distance trace
+    struct TraceParams
+    {
+        float baseline_cm;          ///< Empty mailbox distance (centimeters)
+        float noise_sigma_cm;       ///< Gaussian measurement noise (centimeters)
+        float dropout_prob;         ///< Probability that a reading times out (-1)
+        float drops_per_day;        ///< Mean number of mail drops per day (Poisson)
+        float collections_per_day;  ///< Mean number of collections per day while mail is present (Poisson)
+        float item_min_cm;          ///< Minimum thickness of one mail item (centimeters)
+        float item_max_cm;          ///< Maximum thickness of one mail item (centimeters)
+        float flaps_per_day;        ///< Mean number of flapping episodes per day (Poisson, 0: none)
+        float flap_minutes;         ///< Length of one flapping episode (minutes)
+        float flap_period_s;        ///< An episode alternates between flat and curled with this period (seconds)
+        float flap_cm;              ///< Height of the curled item above the pile (centimeters)
+        float obstructions_per_day; ///< Mean number of sensor obstructions per day (Poisson, 0: none)
+        float obstruction_hours;    ///< Length of one obstruction: every reading is invalid meanwhile (hours)
+    };
+
+    /**
+     * Per-device synthetic distance source
+     *
+     * Mail drops and collections arrive as Poisson processes in virtual time.
+     * Each drop adds an item of random thickness; a collection removes all items.
+     * The returned reading is the distance to the top of the pile plus noise,
+     * or -1 for a dropout, exactly like HCSR04::MeasureDistance.
+     *
+     * Flapping episodes model a curled envelope right at the trigger
+     * threshold: for flap_minutes the reading alternates between the pile and
+     * flap_cm above it, which the processor sees as drop/collection cycles.
+     * During an obstruction (a web or a package on the sensor face) every
+     * reading is invalid.
+     */
+    class TraceModel
+    {
+    public:
+        TraceModel(const TraceParams &params, uint64_t seed);
+
+        // Distance reading for a wake at the given virtual time (microseconds)
+        float Sample(uint64_t virtual_time_us);
+
+        // Number of drops/collections generated so far (ground truth)
+        uint32_t GetDrops() const;
+        uint32_t GetCollections() const;
+        uint32_t GetFlaps() const;
+        uint32_t GetObstructions() const;
+
+    private:
+        TraceParams params_;
+        std::mt19937_64 rng_;
+        std::normal_distribution<float> noise_;
+        std::uniform_real_distribution<float> unit_;
+
+        uint64_t last_time_us_; ///< Virtual time of the previous sample (microseconds)
+        float pile_cm_;         ///< Current thickness of the mail pile (centimeters)
+        uint32_t drops_;
+        uint32_t collections_;
+        uint32_t flaps_;
+        uint64_t flap_start_us_;      ///< Start of the current (or last) flapping episode
+        uint64_t flap_end_us_;        ///< End of the current (or last) flapping episode
+        uint32_t obstructions_;
+        uint64_t obstruction_end_us_; ///< End of the current (or last) obstruction
+
+        // Probability that a Poisson process with the given daily rate fires within dt
+        float eventProbability(float per_day, uint64_t dt_us) const;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,306 @@
+#include "virtual_device.hpp"
+
+#include "config/config.hpp"
+#include "sensor/battery/battery_monitor.hpp"
+#include "sensor/power/charge_model.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace FleetSim
+{
+    static constexpr int64_t SESSION_POLL_US = 10000;   ///< Poll interval while a session is open
+    static constexpr float EMPTY_CELL_MV = 3000.0f;     ///< The simulated cell does not drop below this
+    static constexpr uint32_t WAKE_BUSY_US = 60000;     ///< CPU time of a wake on the device: boot, measure, process
+    static constexpr uint32_t SESSION_BUSY_US = 150000; ///< CPU time a session adds: TLS, JSON, MQTT
+
+    VirtualDevice::VirtualDevice(uint32_t index, const DeviceParams &params, Metrics &metrics, uint64_t seed)
+        : params_(params),
+          metrics_(metrics),
+          trace_(params.trace, seed),
+          rng_(static_cast<uint32_t>(seed ^ (seed >> 32))),
+          rtc_{},
+          config_store_(&rtc_.runtime_config),
+          checkpoint_(&rtc_.checkpoint),
+          battery_mv_(params.battery.start_mv),
+          level_(Hardware::Battery::PowerLevel::NORMAL),
+          nvs_writes_seen_(0),
+          fresh_boot_(true),
+          phase_(Phase::SLEEPING),
+          data_{},
+          baseline_cm_(0.0f),
+          threshold_cm_(0.0f),
+          periodic_update_(false),
+          flap_report_(false),
+          event_trace_{},
+          attempt_(0),
+          wake_start_us_(0),
+          session_start_us_(0),
+          attempt_start_us_(0),
+          linger_until_us_(0),
+          radio_on_(false)
+    {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "sim-mailbox-%06u", index);
+        client_id_ = buf;
+        base_topic_ = std::string(params.base_topic) + "/" + client_id_;
+        snprintf(buf, sizeof(buf), "10.%u.%u.%u", (index >> 16) & 0xFF, (index >> 8) & 0xFF, index & 0xFF);
+        ip_addr_ = buf;
+
+        if (params.battery.spread_mv > 0.0f)
+            battery_mv_ += std::uniform_real_distribution<float>(-params.battery.spread_mv, params.battery.spread_mv)(rng_);
+        adc_.noise_mv = params.battery.adc_noise_mv / Config::BATTERY_DIVIDER_RATIO;
+    }
+
+    void VirtualDevice::PowerCycle()
+    {
+        HostNvs::Scope nvs_scope(&nvs_);
+
+        // An open session dies with the power; RTC memory is rebuilt on the next wake, NVS is kept
+        if (telemetry_)
+        {
+            telemetry_->Stop();
+            telemetry_.reset();
+            metrics_.active_sessions--;
+        }
+        endpoints_.reset();
+        phase_ = Phase::SLEEPING;
+        fresh_boot_ = true;
+    }
+
+    int64_t VirtualDevice::Step(int64_t now_us)
+    {
+        // Firmware code running below sees this device's NVS and ADC
+        HostNvs::Scope nvs_scope(&nvs_);
+        HostAdc::Scope adc_scope(&adc_);
+
+        switch (phase_)
+        {
+        case Phase::SLEEPING:
+            return wake(now_us);
+
+        case Phase::CONNECTING:
+            if (telemetry_->IsConnected())
+            {
+                metrics_.connect_latency.Record(now_us - session_start_us_);
+                endpoints_->Connected(endpoints_->Pick(attempt_), rtc_.virtual_time_us,
+                                      static_cast<uint32_t>((now_us - attempt_start_us_) / 1000));
+                Telemetry::ReconnectBackoff(&rtc_.backoff).Succeeded();
+                event_trace_.mqtt_us = now_us;
+                telemetry_->SetTrace(event_trace_);
+                telemetry_->Publish(data_, baseline_cm_, threshold_cm_, ip_addr_.c_str());
+                linger_until_us_ = now_us + static_cast<int64_t>(params_.linger_ms) * 1000;
+                phase_ = Phase::LINGERING;
+                return linger_until_us_;
+            }
+            if (now_us - attempt_start_us_ > static_cast<int64_t>(params_.connect_timeout_ms) * 1000)
+            {
+                endpoints_->Failed(endpoints_->Pick(attempt_), rtc_.virtual_time_us);
+                attempt_++;
+                if (connectNext(now_us))
+                    return now_us + SESSION_POLL_US;
+                sessionFailed();
+                return sleep(now_us);
+            }
+            return now_us + SESSION_POLL_US;
+
+        case Phase::LINGERING:
+            return sleep(now_us);
+        }
+
+        return now_us;
+    }
+
+    int64_t VirtualDevice::wake(int64_t now_us)
+    {
+        wake_start_us_ = now_us;
+        metrics_.wakes++;
+
+        // Same bookkeeping as app_main
+        const bool is_fresh_boot = fresh_boot_;
+        event_trace_ = {};
+        radio_on_ = false;
+        if (is_fresh_boot)
+        {
+            fresh_boot_ = false;
+            rtc_ = {};
+            config_store_.Load();
+            Processor::Processor temp(rtc_.runtime_config);
+            rtc_.processor_state = temp.GetContext();
+            if (checkpoint_.Restore(&rtc_.processor_state, &rtc_.boot_count) == ESP_OK)
+            {
+                metrics_.restores++;
+                metrics_.restore_latency.Record(rtc_.checkpoint.restore_us);
+            }
+        }
+        else
+        {
+            rtc_.boot_count++;
+            const uint64_t slept_us = Processor::SleepUs(rtc_.processor_state,
+                                                         Hardware::Battery::SleepUs(rtc_.battery.level, rtc_.runtime_config));
+            rtc_.virtual_time_us += slept_us;
+            metrics_.virtual_us += slept_us;
+            event_trace_.window_ms = static_cast<uint32_t>(slept_us / 1000ULL);
+            drainBattery(params_.battery.drain_mv_per_day * (slept_us / 86400e6f));
+        }
+
+        // The monitor reads the fake ADC on the wakes it samples, like on the device
+        adc_.pin_mv = battery_mv_ / Config::BATTERY_DIVIDER_RATIO;
+        Hardware::Battery::BatteryMonitor battery(&rtc_.battery);
+        battery.Update(is_fresh_boot);
+        countLevel(battery.Level());
+
+        Processor::Processor processor(rtc_.processor_state, rtc_.runtime_config);
+        const float raw_dist = trace_.Sample(rtc_.virtual_time_us);
+        data_ = processor.Process(raw_dist, rtc_.virtual_time_us);
+        event_trace_.detected_us = now_us;
+        rtc_.processor_state = processor.GetContext();
+        if (checkpoint_.Due(rtc_.processor_state, rtc_.virtual_time_us))
+            checkpoint_.Save(rtc_.processor_state, rtc_.boot_count, rtc_.virtual_time_us);
+        baseline_cm_ = processor.GetBaseline();
+        threshold_cm_ = processor.GetThreshold();
+
+        Processor::FlapDamper flap(&rtc_.flap);
+        if (Config::FLAP_DAMPING_ENABLED && flap.Record(data_, rtc_.virtual_time_us))
+            metrics_.suppressed++;
+        flap_report_ = flap.ReportDue();
+
+        if (data_.mail_detected || data_.mail_collected)
+            metrics_.events++;
+        const bool crucial_event = data_.mail_detected || data_.mail_collected || data_.obstruction_changed;
+
+        const uint64_t virtual_time_sec = rtc_.virtual_time_us / 1000000ULL;
+        const uint64_t heartbeat_interval_sec = Hardware::Battery::HeartbeatIntervalSec(battery.Level(), rtc_.runtime_config);
+        const uint64_t heartbeat_phase_sec = params_.spread_heartbeats
+                                                 ? Telemetry::PhaseOffsetSec(client_id_.c_str(), heartbeat_interval_sec)
+                                                 : heartbeat_interval_sec;
+        const bool backing_off = Telemetry::ReconnectBackoff(&rtc_.backoff).Waiting(rtc_.virtual_time_us);
+        periodic_update_ = !backing_off && Telemetry::HeartbeatDue(virtual_time_sec, rtc_.last_telemetry_time_sec,
+                                                                   heartbeat_interval_sec, heartbeat_phase_sec);
+        flap_report_ = flap_report_ && !backing_off;
+
+        if (!crucial_event && !periodic_update_ && !flap_report_)
+            return sleep(now_us);
+
+        radio_on_ = true;
+        telemetry_.reset(new Telemetry::Telemetry(&rtc_.telemetry_state, rtc_.boot_count, &config_store_));
+        if (battery.HasReading())
+            telemetry_->SetBattery(battery.Millivolts(), battery.Percent(), battery.Level());
+        telemetry_->SetStability(flap.Suppressed(), rtc_.flap.suppressed_events);
+        drainBattery(params_.battery.session_mv);
+        endpoints_.reset(new Telemetry::Publisher::BrokerEndpoints(&rtc_.endpoints, params_.broker_uris,
+                                                                   params_.broker_count));
+        endpoints_->Begin(rtc_.virtual_time_us);
+        attempt_ = 0;
+        if (!connectNext(now_us))
+        {
+            telemetry_.reset();
+            endpoints_.reset();
+            sessionFailed();
+            return sleep(now_us);
+        }
+
+        metrics_.sessions++;
+        metrics_.active_sessions++;
+        session_start_us_ = now_us;
+        event_trace_.wifi_us = now_us; // Simulated devices are online at once
+        event_trace_.time_sync_us = now_us;
+        phase_ = Phase::CONNECTING;
+        return now_us + SESSION_POLL_US;
+    }
+
+    int64_t VirtualDevice::sleep(int64_t now_us)
+    {
+        endpoints_.reset();
+        if (telemetry_)
+        {
+            telemetry_->Stop();
+            telemetry_.reset();
+            metrics_.active_sessions--;
+
+            if (periodic_update_)
+                rtc_.last_telemetry_time_sec = rtc_.virtual_time_us / 1000000ULL;
+            if (flap_report_)
+                Processor::FlapDamper(&rtc_.flap).Reported();
+        }
+
+        countCharge(now_us);
+
+        // Awake time counts towards virtual time like on the device
+        rtc_.virtual_time_us += static_cast<uint64_t>(now_us - wake_start_us_);
+        metrics_.virtual_us += static_cast<uint64_t>(now_us - wake_start_us_);
+
+        // Every NVS write of the wake (checkpoint, sequence blocks, config) counts towards flash wear
+        metrics_.nvs_writes += nvs_.writes - nvs_writes_seen_;
+        nvs_writes_seen_ = nvs_.writes;
+        phase_ = Phase::SLEEPING;
+
+        std::uniform_int_distribution<uint32_t> jitter(0, params_.wake_jitter_ms);
+        const uint64_t sleep_us = Processor::SleepUs(rtc_.processor_state,
+                                                     Hardware::Battery::SleepUs(rtc_.battery.level, rtc_.runtime_config));
+        const double sleep_real_us = sleep_us / params_.time_scale;
+        return now_us + static_cast<int64_t>(sleep_real_us) + static_cast<int64_t>(jitter(rng_)) * 1000;
+    }
+
+    bool VirtualDevice::connectNext(int64_t now_us)
+    {
+        for (; attempt_ < endpoints_->Count(); ++attempt_)
+        {
+            const size_t endpoint = endpoints_->Pick(attempt_);
+            if (attempt_ > 0)
+                metrics_.failovers++;
+            attempt_start_us_ = now_us;
+
+            // A broker over its accept rate refuses at once; that counts as a missed deadline
+            if (metrics_.broker.Connect(now_us) &&
+                telemetry_->InitMQTT(endpoints_->Uri(endpoint, rtc_.virtual_time_us), base_topic_.c_str(),
+                                     client_id_.c_str()) == ESP_OK)
+                return true;
+            endpoints_->Failed(endpoint, rtc_.virtual_time_us);
+        }
+        return false;
+    }
+
+    void VirtualDevice::sessionFailed()
+    {
+        metrics_.connect_failures++;
+        periodic_update_ = false; // Not delivered, retried after the backoff (or on the next wake without it)
+        flap_report_ = false;
+        if (params_.reconnect_backoff)
+            Telemetry::ReconnectBackoff(&rtc_.backoff).Failed(rtc_.virtual_time_us, rng_());
+    }
+
+    void VirtualDevice::countCharge(int64_t now_us)
+    {
+        // The simulated wake is all waiting (for CONNACK, then the linger); the CPU time is that of the device
+        const uint32_t busy_us = WAKE_BUSY_US + (radio_on_ ? SESSION_BUSY_US : 0);
+        const uint32_t wait_us = static_cast<uint32_t>(now_us - wake_start_us_) + (radio_on_ ? params_.wifi_ms * 1000 : 0);
+        const Hardware::Power::WakeTiming timing = {busy_us + wait_us, wait_us, radio_on_ ? wait_us : 0};
+        for (size_t mode = 0; mode < metrics_.charge_uc.size(); ++mode)
+            metrics_.charge_uc[mode] +=
+                static_cast<uint64_t>(Hardware::Power::WakeChargeUc(timing, static_cast<Hardware::Power::PmMode>(mode)));
+    }
+
+    void VirtualDevice::drainBattery(float millivolts)
+    {
+        battery_mv_ = std::max(EMPTY_CELL_MV, battery_mv_ - millivolts);
+    }
+
+    void VirtualDevice::countLevel(Hardware::Battery::PowerLevel level)
+    {
+        if (level == level_)
+            return;
+
+        if (level_ == Hardware::Battery::PowerLevel::LOW)
+            metrics_.power_low--;
+        else if (level_ == Hardware::Battery::PowerLevel::CRITICAL)
+            metrics_.power_critical--;
+
+        if (level == Hardware::Battery::PowerLevel::LOW)
+            metrics_.power_low++;
+        else if (level == Hardware::Battery::PowerLevel::CRITICAL)
+            metrics_.power_critical++;
+
+        level_ = level;
+    }
+}
\ No newline at end of file
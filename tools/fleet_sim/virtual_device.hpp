@@ -0,0 +1,160 @@
+#pragma once
+
+#include "trace_model.hpp"
+#include "metrics.hpp"
+
+#include "host_adc.hpp"
+#include "host_nvs.hpp"
+#include "config/runtime_config.hpp"
+#include "sensor/battery/battery_policy.hpp"
+#include "processor/checkpoint.hpp"
+#include "processor/flap_damper.hpp"
+#include "processor/processor.hpp"
+#include "telemetry/report_schedule.hpp"
+#include "telemetry/telemetry.hpp"
+#include "transport/broker_endpoints.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+
+namespace FleetSim
+{
+    // Simulated cell behind the battery sense divider
+    struct BatteryParams
+    {
+        float start_mv;         ///< Mean battery voltage at the start of the run
+        float spread_mv;        ///< Start voltages are uniform within start_mv +/- spread_mv
+        float drain_mv_per_day; ///< Voltage lost per virtual day of sleep
+        float session_mv;       ///< Voltage lost per radio session
+        float adc_noise_mv;     ///< Noise of each ADC conversion (at the pin)
+    };
+
+    // Settings shared by all virtual devices of a fleet
+    struct DeviceParams
+    {
+        const char *const *broker_uris; ///< Brokers in order of preference (Config::MQTT_BROKER_URIS)
+        size_t broker_count;            ///< Entries in broker_uris
+        const char *base_topic;         ///< Per-device topics are {base_topic}/{client_id}/...
+        double time_scale;              ///< Virtual seconds per real second while sleeping
+        uint32_t wake_jitter_ms;        ///< Random jitter added to each (real-time) sleep
+        uint32_t connect_timeout_ms;    ///< Fail over to the next broker after this long without CONNACK
+        uint32_t linger_ms;             ///< Time kept connected after publishing (firmware: 1 s)
+        uint32_t wifi_ms;               ///< Wi-Fi association and SNTP time per session, added to the charge model only
+        bool spread_heartbeats;         ///< Phase offsets from the client ID (Config::HEARTBEAT_PHASE_SPREAD)
+        bool reconnect_backoff;         ///< Back off heartbeats after failed sessions, instead of retrying every wake
+        TraceParams trace;              ///< Synthetic distance source parameters
+        BatteryParams battery;          ///< Battery discharge model read through the fake ADC
+    };
+
+    // Mirror of the firmware RtcStore: everything a device keeps across deep sleep
+    struct DeviceRtc
+    {
+        uint32_t boot_count;
+        Processor::StateContext processor_state;
+        uint64_t last_telemetry_time_sec;
+        uint64_t virtual_time_us;
+        Telemetry::PersistentState telemetry_state;
+        Config::RuntimeConfig runtime_config;
+        Hardware::Battery::BatteryState battery;
+        Processor::CheckpointState checkpoint;
+        Processor::FlapState flap;
+        Telemetry::BackoffState backoff;
+        Telemetry::Publisher::EndpointCache endpoints;
+    };
+
+    /**
+     * One simulated mailbox
+     *
+     * Runs the firmware app_main flow as a non-blocking state machine: wake,
+     * measure (synthetic trace), Processor::Process, and - on events or due
+     * heartbeats - a radio session through the real Telemetry/MQTTPublisher code.
+     * The battery is read through the real BatteryMonitor from a fake ADC whose
+     * voltage follows a simple discharge model, so the power policy stretches
+     * sleep and heartbeat intervals exactly as on the device. Power cuts
+     * restore the mailbox state from the NVS checkpoint, which survives them.
+     * Drops and collections go through the flap damper first, as on the device.
+     * Sessions go through the broker load model, which may refuse them, and
+     * fail over between the brokers like the firmware's BrokerEndpoints.
+ * Each wake's charge is estimated with the firmware's charge model for
+ * every power management mode.
+     * Step() does one unit of work and returns the real time it wants to run again.
+     */
+    class VirtualDevice
+    {
+    public:
+        VirtualDevice(uint32_t index, const DeviceParams &params, Metrics &metrics, uint64_t seed);
+
+        // Advance the device; returns the next real time (esp_timer microseconds) it is due
+        int64_t Step(int64_t now_us);
+
+        // Simulate a power cut: the next wake is a fresh boot with RTC memory lost
+        void PowerCycle();
+
+    private:
+        enum class Phase
+        {
+            SLEEPING,   ///< Waiting for the next timer wake
+            CONNECTING, ///< Session open, waiting for CONNACK
+            LINGERING   ///< Published, keeping the session open for acknowledgements
+        };
+
+        const DeviceParams &params_;
+        Metrics &metrics_;
+        TraceModel trace_;
+        std::mt19937 rng_;
+
+        std::string client_id_;
+        std::string base_topic_;
+        std::string ip_addr_;
+
+        DeviceRtc rtc_;
+        HostNvs::Partition nvs_;                  ///< Flash contents, kept across power cycles
+        Config::RuntimeConfigStore config_store_; ///< Over rtc_.runtime_config, updated from {base}/config
+        Processor::CheckpointStore checkpoint_;   ///< Over rtc_.checkpoint, writes to nvs_
+        HostAdc::Input adc_;                      ///< Battery sense pin, kept across power cycles
+        float battery_mv_;                        ///< Simulated cell voltage
+        Hardware::Battery::PowerLevel level_;     ///< Level counted in the fleet metrics
+        uint64_t nvs_writes_seen_;                ///< nvs_.writes already counted in the fleet metrics
+        bool fresh_boot_;
+        Phase phase_;
+
+        // Session state (valid while not SLEEPING)
+        std::unique_ptr<Telemetry::Telemetry> telemetry_;
+        Processor::DistanceData data_;
+        float baseline_cm_;
+        float threshold_cm_;
+        bool periodic_update_;
+        bool flap_report_;
+        Telemetry::EventTrace event_trace_;
+        std::unique_ptr<Telemetry::Publisher::BrokerEndpoints> endpoints_;
+        size_t attempt_;
+        int64_t wake_start_us_;
+        int64_t session_start_us_;
+        int64_t attempt_start_us_;
+        int64_t linger_until_us_;
+        bool radio_on_; ///< This wake started Wi-Fi
+
+        // Measure, process and decide whether to open a radio session
+        int64_t wake(int64_t now_us);
+
+        // Close the session (if any), save state and go back to sleep
+        int64_t sleep(int64_t now_us);
+
+        // Connect to the next broker of the session that takes the connection; false when all were tried
+        bool connectNext(int64_t now_us);
+
+        // A session did not reach the broker: back off, and retry the heartbeat later
+        void sessionFailed();
+
+        // Add the charge of the wake ending at now_us to the fleet metrics, for each power management mode
+        void countCharge(int64_t now_us);
+
+        // Take charge out of the simulated cell
+        void drainBattery(float millivolts);
+
+        // Move this device between the power level gauges of the fleet metrics
+        void countLevel(Hardware::Battery::PowerLevel level);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,3 @@
+#pragma once
+
+// Host build placeholder: config.hpp includes the I2C driver header
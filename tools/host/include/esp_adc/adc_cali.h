@@ -0,0 +1,10 @@
+#pragma once
+
+// Host build of the ADC calibration API: inverse of the host conversion
+
+#include "esp_err.h"
+#include "hal/adc_types.h"
+
+typedef struct host_adc_cali *adc_cali_handle_t;
+
+esp_err_t adc_cali_raw_to_voltage(adc_cali_handle_t handle, int raw, int *voltage);
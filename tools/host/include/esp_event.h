@@ -0,0 +1,9 @@
+#pragma once
+
+// Host build of the esp_event types used by the MQTT client API
+
+#include "esp_err.h"
+
+typedef const char *esp_event_base_t;
+typedef void (*esp_event_handler_t)(void *event_handler_arg, esp_event_base_t event_base,
+                                    int32_t event_id, void *event_data);
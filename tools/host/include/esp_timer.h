@@ -0,0 +1,7 @@
+#pragma once
+
+// Host build of esp_timer: microseconds since process start (monotonic)
+
+#include "esp_err.h"
+
+int64_t esp_timer_get_time(void);
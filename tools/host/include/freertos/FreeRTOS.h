@@ -0,0 +1,9 @@
+#pragma once
+
+// Host build of the FreeRTOS tick: one tick per millisecond
+
+#include <cstdint>
+
+typedef uint32_t TickType_t;
+
+#define pdMS_TO_TICKS(ms) (static_cast<TickType_t>(ms))
@@ -0,0 +1,7 @@
+#pragma once
+
+// Host build of the FreeRTOS task delay: sleeps the calling thread
+
+#include "FreeRTOS.h"
+
+void vTaskDelay(TickType_t ticks);
@@ -0,0 +1,42 @@
+#pragma once
+
+// Host build of the ADC types used by the firmware sources (see host_adc.hpp)
+
+typedef enum
+{
+    ADC_UNIT_1,
+    ADC_UNIT_2
+} adc_unit_t;
+
+typedef enum
+{
+    ADC_CHANNEL_0,
+    ADC_CHANNEL_1,
+    ADC_CHANNEL_2,
+    ADC_CHANNEL_3,
+    ADC_CHANNEL_4,
+    ADC_CHANNEL_5,
+    ADC_CHANNEL_6,
+    ADC_CHANNEL_7,
+    ADC_CHANNEL_8,
+    ADC_CHANNEL_9
+} adc_channel_t;
+
+typedef enum
+{
+    ADC_ATTEN_DB_0,
+    ADC_ATTEN_DB_2_5,
+    ADC_ATTEN_DB_6,
+    ADC_ATTEN_DB_12
+} adc_atten_t;
+
+typedef enum
+{
+    ADC_BITWIDTH_DEFAULT = 0,
+    ADC_BITWIDTH_12 = 12
+} adc_bitwidth_t;
+
+typedef enum
+{
+    ADC_ULP_MODE_DISABLE
+} adc_ulp_mode_t;
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+namespace HostAdc
+{
+    /**
+     * Analog input of one simulated device
+     *
+     * Every ADC channel reads this voltage, with uniform noise of up to
+     * noise_mv added to each conversion. Calibration inverts the conversion
+     * to within one LSB, so firmware code sees the voltage set here.
+     */
+    struct Input
+    {
+        float pin_mv = 2000.0f; ///< Voltage at the ADC pin (millivolts)
+        float noise_mv = 0.0f;  ///< Max noise added to each conversion (millivolts)
+        uint64_t reads = 0;     ///< Conversions done so far
+        uint64_t units = 0;     ///< ADC units created so far (one per firmware sample)
+    };
+
+    /**
+     * Routes the ADC calls of the current thread to an input
+     *
+     * Without a scope the calls use one process-wide input. Scopes nest;
+     * units must be deleted before their scope ends.
+     */
+    class Scope
+    {
+    public:
+        explicit Scope(Input *input);
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        Input *previous_;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct esp_mqtt_client;
+
+namespace HostMqtt
+{
+    /**
+     * Worker pool that drives all started host MQTT clients
+     *
+     * Each worker polls the sockets of the clients assigned to it and runs the
+     * libmosquitto read/write/keepalive steps, dispatching esp-mqtt style events
+     * from its own thread - the same way the esp-mqtt task does on the device.
+     */
+    class Loop
+    {
+    public:
+        static Loop &Instance();
+
+        // Start the worker threads (idempotent)
+        void Start(size_t threads);
+
+        // Stop and join the worker threads
+        void Stop();
+
+        // Assign a started client to the least recently used worker
+        void Add(esp_mqtt_client *client);
+
+        // Detach a client; returns once no worker touches it anymore
+        void Remove(esp_mqtt_client *client);
+
+    private:
+        struct Worker
+        {
+            std::mutex mutex;
+            std::vector<esp_mqtt_client *> clients;
+            std::thread thread;
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers_;
+        std::atomic<bool> running_{false};
+        std::atomic<size_t> next_{0};
+
+        void run(Worker &worker);
+    };
+
+    // Called for every publish before it is handed to libmosquitto
+    using PublishHook = std::function<void(const char *topic, const char *data, int len)>;
+
+    // Install a publish hook (not thread-safe: set before starting clients)
+    void SetPublishHook(PublishHook hook);
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace HostNvs
+{
+    /**
+     * Flash contents of one simulated device
+     *
+     * Unlike RTC memory it survives power cycles, so a virtual device keeps
+     * its Partition for its whole lifetime.
+     */
+    struct Partition
+    {
+        std::map<std::string, std::vector<uint8_t>> entries; ///< "namespace/key" -> value
+        uint64_t writes = 0;                                 ///< Number of set calls that changed a value
+        uint32_t failing_reads = 0;                          ///< The next N get calls fail with ESP_FAIL
+        uint32_t failing_writes = 0;                         ///< The next N set calls fail with ESP_FAIL
+    };
+
+    /**
+     * Routes the NVS calls of the current thread to a partition
+     *
+     * Without a scope the calls use one process-wide partition. Scopes nest;
+     * handles must be closed before their scope ends.
+     */
+    class Scope
+    {
+    public:
+        explicit Scope(Partition *partition);
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        Partition *previous_;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,8 @@
+#pragma once
+
+// Host build of sdkconfig.h: the firmware features of main/Kconfig.projbuild at their defaults
+
+#define CONFIG_MAILBOX_MQTT_TLS 1
+#define CONFIG_MAILBOX_LOG_UPLOAD 1
+#define CONFIG_MAILBOX_DELTA_OTA 1
+#define CONFIG_MAILBOX_REMOTE_CONFIG 1
@@ -0,0 +1,110 @@
+#include "esp_adc/adc_oneshot.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "host_adc.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <random>
+
+struct host_adc_unit
+{
+    HostAdc::Input *input;
+};
+
+struct host_adc_cali
+{
+    adc_atten_t atten;
+};
+
+namespace
+{
+    constexpr int MAX_RAW = 4095;            ///< 12-bit conversions
+    constexpr float FULL_SCALE_MV = 3300.0f; ///< Pin voltage read as MAX_RAW
+
+    HostAdc::Input g_default_input;
+    std::mutex g_default_mutex; // Only the default input is shared between threads
+    thread_local HostAdc::Input *t_input = nullptr;
+    thread_local std::mt19937 t_rng(0x41444331u);
+
+    HostAdc::Input *current() { return t_input ? t_input : &g_default_input; }
+
+    std::unique_lock<std::mutex> lockFor(const HostAdc::Input *input)
+    {
+        return input == &g_default_input ? std::unique_lock<std::mutex>(g_default_mutex)
+                                         : std::unique_lock<std::mutex>();
+    }
+}
+
+namespace HostAdc
+{
+    Scope::Scope(Input *input) : previous_(t_input) { t_input = input; }
+
+    Scope::~Scope() { t_input = previous_; }
+}
+
+esp_err_t adc_oneshot_new_unit(const adc_oneshot_unit_init_cfg_t *init_config, adc_oneshot_unit_handle_t *ret_unit)
+{
+    if (!init_config || !ret_unit)
+        return ESP_ERR_INVALID_ARG;
+
+    HostAdc::Input *input = current();
+    const auto lock = lockFor(input);
+    input->units++;
+    *ret_unit = new host_adc_unit{input};
+    return ESP_OK;
+}
+
+esp_err_t adc_oneshot_config_channel(adc_oneshot_unit_handle_t handle, adc_channel_t channel,
+                                     const adc_oneshot_chan_cfg_t *config)
+{
+    return handle && config ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t adc_oneshot_read(adc_oneshot_unit_handle_t handle, adc_channel_t chan, int *out_raw)
+{
+    if (!handle || !out_raw)
+        return ESP_ERR_INVALID_ARG;
+
+    HostAdc::Input *input = handle->input;
+    const auto lock = lockFor(input);
+    input->reads++;
+
+    float mv = input->pin_mv;
+    if (input->noise_mv > 0.0f)
+        mv += std::uniform_real_distribution<float>(-input->noise_mv, input->noise_mv)(t_rng);
+
+    *out_raw = std::clamp(static_cast<int>(std::lround(mv * MAX_RAW / FULL_SCALE_MV)), 0, MAX_RAW);
+    return ESP_OK;
+}
+
+esp_err_t adc_oneshot_del_unit(adc_oneshot_unit_handle_t handle)
+{
+    if (!handle)
+        return ESP_ERR_INVALID_ARG;
+    delete handle;
+    return ESP_OK;
+}
+
+esp_err_t adc_cali_create_scheme_curve_fitting(const adc_cali_curve_fitting_config_t *config,
+                                               adc_cali_handle_t *ret_handle)
+{
+    if (!config || !ret_handle)
+        return ESP_ERR_INVALID_ARG;
+    *ret_handle = new host_adc_cali{config->atten};
+    return ESP_OK;
+}
+
+esp_err_t adc_cali_delete_scheme_curve_fitting(adc_cali_handle_t handle)
+{
+    delete handle;
+    return ESP_OK;
+}
+
+esp_err_t adc_cali_raw_to_voltage(adc_cali_handle_t handle, int raw, int *voltage)
+{
+    if (!handle || !voltage)
+        return ESP_ERR_INVALID_ARG;
+    *voltage = static_cast<int>(std::lround(raw * FULL_SCALE_MV / MAX_RAW));
+    return ESP_OK;
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#include "esp_log.h"
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+
+namespace
+{
+    std::atomic<int> g_level{ESP_LOG_WARN};
+
+    char levelLetter(esp_log_level_t level)
+    {
+        switch (level)
+        {
+        case ESP_LOG_ERROR:
+            return 'E';
+        case ESP_LOG_WARN:
+            return 'W';
+        case ESP_LOG_INFO:
+            return 'I';
+        case ESP_LOG_DEBUG:
+            return 'D';
+        default:
+            return 'V';
+        }
+    }
+}
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    g_level = level;
+}
+
+void host_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    if (level > g_level)
+        return;
+
+    char line[512];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+
+    // One fprintf per line keeps output from concurrent devices unmixed
+    fprintf(stderr, "%c (%s) %s\n", levelLetter(level), tag, line);
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#include "esp_timer.h"
+
+#include <chrono>
+
+namespace
+{
+    const auto g_start = std::chrono::steady_clock::now();
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - g_start).count();
+}
\ No newline at end of file
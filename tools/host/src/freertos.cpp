@@ -0,0 +1,9 @@
+#include "freertos/task.h"
+
+#include <chrono>
+#include <thread>
+
+void vTaskDelay(TickType_t ticks)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
\ No newline at end of file
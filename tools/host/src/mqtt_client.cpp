@@ -0,0 +1,457 @@
+#include "mqtt_client.h"
+#include "host_mqtt.hpp"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include <mosquitto.h>
+#include <poll.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+
+static const char *LOG_TAG = "HOST_MQTT";
+
+struct esp_mqtt_client
+{
+    struct mosquitto *mosq;
+    std::string host;
+    int port;
+    int keepalive;
+    int reconnect_timeout_ms;
+    int timeout_ms; ///< Bound of one connect attempt, up to CONNACK
+    bool auto_reconnect;
+
+    esp_event_handler_t handler;
+    void *handler_arg;
+
+    bool started;
+    std::atomic<bool> connected; ///< Read by publishing threads, written by the loop worker
+    int64_t reconnect_at_us;     ///< Next reconnect attempt (0 = none scheduled)
+    int64_t connect_until_us;    ///< End of the connect attempt in flight (0 = none)
+};
+
+namespace
+{
+    HostMqtt::PublishHook g_publish_hook;
+    std::once_flag g_lib_init;
+
+    void dispatch(esp_mqtt_client *client, esp_mqtt_event_id_t id, esp_mqtt_event_t &event)
+    {
+        event.event_id = id;
+        event.client = client;
+        if (client->handler)
+            client->handler(client->handler_arg, "MQTT_EVENTS", id, &event);
+    }
+
+    void scheduleReconnect(esp_mqtt_client *client)
+    {
+        client->connect_until_us = 0;
+        client->reconnect_at_us = client->auto_reconnect
+                                      ? esp_timer_get_time() + static_cast<int64_t>(client->reconnect_timeout_ms) * 1000
+                                      : 0;
+    }
+
+    void onConnect(struct mosquitto *, void *obj, int rc)
+    {
+        auto *client = static_cast<esp_mqtt_client *>(obj);
+        client->connect_until_us = 0;
+        esp_mqtt_event_t event = {};
+        esp_mqtt_error_codes_t error = {};
+        event.error_handle = &error;
+
+        if (rc != 0)
+        {
+            error.error_type = MQTT_ERROR_TYPE_CONNECTION_REFUSED;
+            error.connect_return_code = rc;
+            dispatch(client, MQTT_EVENT_ERROR, event);
+            return;
+        }
+
+        client->connected = true;
+        dispatch(client, MQTT_EVENT_CONNECTED, event);
+    }
+
+    void onDisconnect(struct mosquitto *, void *obj, int rc)
+    {
+        auto *client = static_cast<esp_mqtt_client *>(obj);
+        esp_mqtt_event_t event = {};
+        client->connected = false;
+        dispatch(client, MQTT_EVENT_DISCONNECTED, event);
+
+        if (rc != 0 && client->started)
+            scheduleReconnect(client);
+    }
+
+    void onPublish(struct mosquitto *, void *obj, int mid)
+    {
+        esp_mqtt_event_t event = {};
+        event.msg_id = mid;
+        dispatch(static_cast<esp_mqtt_client *>(obj), MQTT_EVENT_PUBLISHED, event);
+    }
+
+    void onMessage(struct mosquitto *, void *obj, const struct mosquitto_message *msg)
+    {
+        esp_mqtt_event_t event = {};
+        event.msg_id = msg->mid;
+        event.topic = msg->topic;
+        event.topic_len = static_cast<int>(strlen(msg->topic));
+        event.data = static_cast<char *>(msg->payload);
+        event.data_len = msg->payloadlen;
+        event.total_data_len = msg->payloadlen;
+        event.qos = msg->qos;
+        event.retain = msg->retain;
+        dispatch(static_cast<esp_mqtt_client *>(obj), MQTT_EVENT_DATA, event);
+    }
+
+    void onSubscribe(struct mosquitto *, void *obj, int mid, int, const int *)
+    {
+        esp_mqtt_event_t event = {};
+        event.msg_id = mid;
+        dispatch(static_cast<esp_mqtt_client *>(obj), MQTT_EVENT_SUBSCRIBED, event);
+    }
+
+    void connectFailed(esp_mqtt_client *client, int rc)
+    {
+        esp_mqtt_event_t event = {};
+        esp_mqtt_error_codes_t error = {};
+        error.error_type = MQTT_ERROR_TYPE_TCP_TRANSPORT;
+        error.esp_transport_sock_errno = rc;
+        event.error_handle = &error;
+        dispatch(client, MQTT_EVENT_ERROR, event);
+        scheduleReconnect(client);
+    }
+
+    // Begin a connect attempt; like the esp-mqtt task, it gets timeout_ms to reach CONNACK
+    void beginConnect(esp_mqtt_client *client, bool first)
+    {
+        client->connect_until_us = esp_timer_get_time() + static_cast<int64_t>(client->timeout_ms) * 1000;
+        const int rc = first ? mosquitto_connect_async(client->mosq, client->host.c_str(), client->port, client->keepalive)
+                             : mosquitto_reconnect_async(client->mosq);
+        if (rc != MOSQ_ERR_SUCCESS)
+            connectFailed(client, rc);
+    }
+
+    // One read/write/keepalive step of a client whose socket polled with revents
+    int step(esp_mqtt_client *client, short revents)
+    {
+        int rc = MOSQ_ERR_SUCCESS;
+        if (revents & (POLLIN | POLLHUP | POLLERR))
+            rc = mosquitto_loop_read(client->mosq, 1);
+        if (rc == MOSQ_ERR_SUCCESS && (revents & POLLOUT))
+            rc = mosquitto_loop_write(client->mosq, 1);
+        if (rc == MOSQ_ERR_SUCCESS)
+            rc = mosquitto_loop_misc(client->mosq);
+        return rc;
+    }
+
+    // mosquitto_loop() would close the socket on I/O errors; we drive the steps ourselves
+    void handleLoopResult(esp_mqtt_client *client, int rc)
+    {
+        if (rc == MOSQ_ERR_SUCCESS || rc == MOSQ_ERR_NO_CONN)
+        {
+            // No CONNACK within timeout_ms: esp-mqtt gives up on the attempt and waits to reconnect
+            if (client->connect_until_us != 0 && esp_timer_get_time() >= client->connect_until_us)
+                connectFailed(client, MOSQ_ERR_CONN_PENDING);
+            return;
+        }
+
+        if (!client->connected && client->connect_until_us != 0)
+        {
+            connectFailed(client, rc);
+            return;
+        }
+
+        if (client->connected)
+        {
+            client->connected = false;
+            esp_mqtt_event_t event = {};
+            dispatch(client, MQTT_EVENT_DISCONNECTED, event);
+        }
+
+        // mosquitto_reconnect_async() closes the broken socket before reconnecting
+        if (client->reconnect_at_us == 0)
+            scheduleReconnect(client);
+    }
+
+    // Parse "mqtt://host[:port]" into host and port
+    bool parseUri(const char *uri, std::string &host, int &port)
+    {
+        static constexpr const char *SCHEME = "mqtt://";
+        if (!uri || strncmp(uri, SCHEME, strlen(SCHEME)) != 0)
+            return false;
+
+        std::string rest(uri + strlen(SCHEME));
+        const size_t colon = rest.rfind(':');
+        if (colon == std::string::npos)
+        {
+            host = rest;
+            port = 1883;
+        }
+        else
+        {
+            host = rest.substr(0, colon);
+            port = atoi(rest.c_str() + colon + 1);
+        }
+        return !host.empty() && port > 0;
+    }
+}
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t *config)
+{
+    std::call_once(g_lib_init, []
+                   { mosquitto_lib_init(); });
+
+    auto *client = new esp_mqtt_client();
+    if (!parseUri(config->broker.address.uri, client->host, client->port))
+    {
+        ESP_LOGE(LOG_TAG, "Unsupported broker URI on host: %s", config->broker.address.uri);
+        delete client;
+        return nullptr;
+    }
+
+    client->keepalive = config->session.keepalive > 0 ? config->session.keepalive : 120;
+    client->reconnect_timeout_ms = config->network.reconnect_timeout_ms > 0 ? config->network.reconnect_timeout_ms : 10000;
+    client->timeout_ms = config->network.timeout_ms > 0 ? config->network.timeout_ms : 10000;
+    client->auto_reconnect = !config->network.disable_auto_reconnect;
+
+    client->mosq = mosquitto_new(config->credentials.client_id, !config->session.disable_clean_session, client);
+    if (!client->mosq)
+    {
+        delete client;
+        return nullptr;
+    }
+
+    mosquitto_threaded_set(client->mosq, true);
+    if (config->credentials.username)
+        mosquitto_username_pw_set(client->mosq, config->credentials.username,
+                                  config->credentials.authentication.password);
+
+    mosquitto_connect_callback_set(client->mosq, onConnect);
+    mosquitto_disconnect_callback_set(client->mosq, onDisconnect);
+    mosquitto_publish_callback_set(client->mosq, onPublish);
+    mosquitto_message_callback_set(client->mosq, onMessage);
+    mosquitto_subscribe_callback_set(client->mosq, onSubscribe);
+
+    return client;
+}
+
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event,
+                                         esp_event_handler_t event_handler, void *event_handler_arg)
+{
+    if (!client)
+        return ESP_ERR_INVALID_ARG;
+
+    client->handler = event_handler;
+    client->handler_arg = event_handler_arg;
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client)
+{
+    if (!client || client->started)
+        return ESP_ERR_INVALID_STATE;
+
+    client->started = true;
+    beginConnect(client, true);
+
+    HostMqtt::Loop::Instance().Add(client);
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_stop(esp_mqtt_client_handle_t client)
+{
+    if (!client || !client->started)
+        return ESP_ERR_INVALID_STATE;
+
+    HostMqtt::Loop::Instance().Remove(client);
+
+    // The esp-mqtt task only sees the stop between steps: a connect in flight runs to CONNACK or its timeout,
+    // and a wait to reconnect sleeps up to half of reconnect_timeout_ms
+    while (client->connect_until_us != 0)
+    {
+        struct pollfd pfd = {};
+        pfd.fd = mosquitto_socket(client->mosq);
+        pfd.events = POLLIN | (mosquitto_want_write(client->mosq) ? POLLOUT : 0);
+        if (pfd.fd < 0 || poll(&pfd, 1, 5) < 0)
+            break;
+        handleLoopResult(client, step(client, pfd.revents));
+    }
+    if (!client->connected && client->reconnect_at_us != 0)
+    {
+        const int64_t wake_us = std::min(client->reconnect_at_us,
+                                         esp_timer_get_time() + static_cast<int64_t>(client->reconnect_timeout_ms) * 500);
+        const int64_t left_us = wake_us - esp_timer_get_time();
+        if (left_us > 0)
+            std::this_thread::sleep_for(std::chrono::microseconds(left_us));
+    }
+
+    client->started = false;
+    client->reconnect_at_us = 0;
+    client->connect_until_us = 0;
+
+    if (client->connected)
+    {
+        mosquitto_disconnect(client->mosq);
+        // Flush the DISCONNECT packet; the worker no longer drives this client
+        mosquitto_loop_write(client->mosq, 1);
+        client->connected = false;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_destroy(esp_mqtt_client_handle_t client)
+{
+    if (!client)
+        return ESP_ERR_INVALID_ARG;
+
+    if (client->started)
+        esp_mqtt_client_stop(client);
+
+    mosquitto_destroy(client->mosq);
+    delete client;
+    return ESP_OK;
+}
+
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char *topic, const char *data,
+                            int len, int qos, int retain)
+{
+    if (!client || !client->connected)
+        return -1;
+
+    if (len == 0 && data)
+        len = static_cast<int>(strlen(data));
+
+    if (g_publish_hook)
+        g_publish_hook(topic, data, len);
+
+    int mid = 0;
+    const int rc = mosquitto_publish(client->mosq, &mid, topic, len, data, qos, retain != 0);
+    return rc == MOSQ_ERR_SUCCESS ? mid : -1;
+}
+
+int esp_mqtt_client_subscribe(esp_mqtt_client_handle_t client, const char *topic, int qos)
+{
+    if (!client || !client->connected)
+        return -1;
+
+    int mid = 0;
+    const int rc = mosquitto_subscribe(client->mosq, &mid, topic, qos);
+    return rc == MOSQ_ERR_SUCCESS ? mid : -1;
+}
+
+namespace HostMqtt
+{
+    Loop &Loop::Instance()
+    {
+        static Loop loop;
+        return loop;
+    }
+
+    void Loop::Start(size_t threads)
+    {
+        if (running_.exchange(true))
+            return;
+
+        for (size_t i = 0; i < std::max<size_t>(1, threads); ++i)
+            workers_.emplace_back(new Worker());
+
+        for (auto &worker : workers_)
+            worker->thread = std::thread([this, &worker]
+                                         { run(*worker); });
+    }
+
+    void Loop::Stop()
+    {
+        if (!running_.exchange(false))
+            return;
+
+        for (auto &worker : workers_)
+            worker->thread.join();
+        workers_.clear();
+    }
+
+    void Loop::Add(esp_mqtt_client *client)
+    {
+        Start(std::thread::hardware_concurrency());
+
+        Worker &worker = *workers_[next_++ % workers_.size()];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.clients.push_back(client);
+    }
+
+    void Loop::Remove(esp_mqtt_client *client)
+    {
+        for (auto &worker : workers_)
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            auto &clients = worker->clients;
+            for (size_t i = 0; i < clients.size(); ++i)
+            {
+                if (clients[i] == client)
+                {
+                    clients[i] = clients.back();
+                    clients.pop_back();
+                    return;
+                }
+            }
+        }
+    }
+
+    void Loop::run(Worker &worker)
+    {
+        static constexpr int POLL_TIMEOUT_MS = 5;
+
+        std::vector<struct pollfd> fds;
+        std::vector<esp_mqtt_client *> polled;
+
+        while (running_)
+        {
+            // The worker mutex is held for the whole iteration so Remove() cannot
+            // return while a client is still being driven
+            std::unique_lock<std::mutex> lock(worker.mutex);
+
+            fds.clear();
+            polled.clear();
+            const int64_t now_us = esp_timer_get_time();
+            for (esp_mqtt_client *client : worker.clients)
+            {
+                if (client->reconnect_at_us != 0 && now_us >= client->reconnect_at_us)
+                {
+                    client->reconnect_at_us = 0;
+                    beginConnect(client, false);
+                }
+
+                const int sock = mosquitto_socket(client->mosq);
+                if (sock < 0)
+                    continue;
+
+                struct pollfd pfd = {};
+                pfd.fd = sock;
+                pfd.events = POLLIN | (mosquitto_want_write(client->mosq) ? POLLOUT : 0);
+                fds.push_back(pfd);
+                polled.push_back(client);
+            }
+
+            if (fds.empty())
+            {
+                lock.unlock();
+                std::this_thread::sleep_for(std::chrono::milliseconds(POLL_TIMEOUT_MS));
+                continue;
+            }
+
+            poll(fds.data(), fds.size(), POLL_TIMEOUT_MS);
+
+            for (size_t i = 0; i < fds.size(); ++i)
+                handleLoopResult(polled[i], step(polled[i], fds[i].revents));
+        }
+    }
+
+    void SetPublishHook(PublishHook hook)
+    {
+        g_publish_hook = std::move(hook);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include "nvs.h"
+#include "host_nvs.hpp"
+
+#include <mutex>
+
+namespace
+{
+    HostNvs::Partition g_default_partition;
+    std::mutex g_default_mutex; // Only the default partition is shared between threads
+    thread_local HostNvs::Partition *t_partition = nullptr;
+
+    struct OpenHandle
+    {
+        HostNvs::Partition *partition;
+        std::string name_space;
+        bool writable;
+    };
+
+    thread_local std::map<nvs_handle_t, OpenHandle> t_handles;
+    thread_local nvs_handle_t t_next_handle = 1;
+
+    std::unique_lock<std::mutex> lockFor(const HostNvs::Partition *partition)
+    {
+        return partition == &g_default_partition ? std::unique_lock<std::mutex>(g_default_mutex)
+                                                 : std::unique_lock<std::mutex>();
+    }
+
+    esp_err_t find(nvs_handle_t handle, bool write, const char *key, OpenHandle **out, std::string *entry)
+    {
+        const auto it = t_handles.find(handle);
+        if (it == t_handles.end())
+            return ESP_ERR_NVS_INVALID_HANDLE;
+        if (write && !it->second.writable)
+            return ESP_ERR_INVALID_STATE;
+        if (!key)
+            return ESP_ERR_INVALID_ARG;
+
+        *out = &it->second;
+        *entry = it->second.name_space + "/" + key;
+        return ESP_OK;
+    }
+
+    esp_err_t get(nvs_handle_t handle, const char *key, void *out_value, size_t *length, bool exact)
+    {
+        OpenHandle *open;
+        std::string entry;
+        esp_err_t err = find(handle, false, key, &open, &entry);
+        if (err != ESP_OK)
+            return err;
+
+        const auto lock = lockFor(open->partition);
+        if (open->partition->failing_reads > 0)
+        {
+            // Injected read fault, as from a corrupt page
+            open->partition->failing_reads--;
+            return ESP_FAIL;
+        }
+        const auto it = open->partition->entries.find(entry);
+        if (it == open->partition->entries.end())
+            return ESP_ERR_NVS_NOT_FOUND;
+
+        const std::vector<uint8_t> &value = it->second;
+        if (!out_value)
+        {
+            *length = value.size();
+            return ESP_OK;
+        }
+        if (exact ? value.size() != *length : value.size() > *length)
+            return ESP_ERR_NVS_INVALID_LENGTH;
+
+        memcpy(out_value, value.data(), value.size());
+        *length = value.size();
+        return ESP_OK;
+    }
+
+    esp_err_t set(nvs_handle_t handle, const char *key, const void *value, size_t length)
+    {
+        OpenHandle *open;
+        std::string entry;
+        esp_err_t err = find(handle, true, key, &open, &entry);
+        if (err != ESP_OK)
+            return err;
+
+        const auto lock = lockFor(open->partition);
+        if (open->partition->failing_writes > 0)
+        {
+            // Injected write fault, as from a full or worn partition
+            open->partition->failing_writes--;
+            return ESP_FAIL;
+        }
+        const auto *bytes = static_cast<const uint8_t *>(value);
+        std::vector<uint8_t> &stored = open->partition->entries[entry];
+        if (stored.size() != length || memcmp(stored.data(), bytes, length) != 0)
+        {
+            // Like the real NVS, writing an unchanged value costs no flash write
+            stored.assign(bytes, bytes + length);
+            open->partition->writes++;
+        }
+        return ESP_OK;
+    }
+}
+
+namespace HostNvs
+{
+    Scope::Scope(Partition *partition) : previous_(t_partition) { t_partition = partition; }
+
+    Scope::~Scope() { t_partition = previous_; }
+}
+
+esp_err_t nvs_open(const char *name_space, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    if (!name_space || !out_handle)
+        return ESP_ERR_INVALID_ARG;
+
+    HostNvs::Partition *partition = t_partition ? t_partition : &g_default_partition;
+    *out_handle = t_next_handle++;
+    t_handles[*out_handle] = {partition, name_space, open_mode == NVS_READWRITE};
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) { t_handles.erase(handle); }
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    return t_handles.count(handle) ? ESP_OK : ESP_ERR_NVS_INVALID_HANDLE;
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char *key, uint32_t *out_value)
+{
+    size_t length = sizeof(*out_value);
+    return get(handle, key, out_value, &length, true);
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char *key, uint32_t value)
+{
+    return set(handle, key, &value, sizeof(value));
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    if (!length)
+        return ESP_ERR_INVALID_ARG;
+    return get(handle, key, out_value, length, false);
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    return set(handle, key, value, length);
+}
\ No newline at end of file
@@ -0,0 +1,292 @@
+#include "pipeline.hpp"
+#include "tsdb_sink.hpp"
+
+#include "cJSON.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Offline benchmark of the ingest path: no broker, messages are generated in memory
+namespace
+{
+    struct Message
+    {
+        std::string topic;
+        std::string payload;
+    };
+
+    void usage(const char *argv0)
+    {
+        printf("Usage: %s [options]\n"
+               "  --devices N      distinct device topics (default 10000)\n"
+               "  --messages N     messages per run (default 1000000)\n"
+               "  --producers N    threads submitting like MQTT callbacks (default 2)\n"
+               "  --shards N       ingest worker threads (default hardware concurrency)\n"
+               "  --dup-rate X     fraction of messages redelivered (default 0.05)\n"
+               "  --seed N         random seed (default 1)\n"
+               "  --tsdb DIR       also archive applied messages into a columnar store\n",
+               argv0);
+    }
+
+    const char *STATES[] = {"empty", "has_mail", "full", "emptied"};
+
+    // Payloads shaped exactly like Telemetry's (cJSON_PrintUnformatted, same keys and order)
+    std::vector<Message> makeCorpus(uint32_t devices, uint32_t count, double dup_rate, uint64_t seed)
+    {
+        std::mt19937_64 rng(seed);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        std::vector<Message> corpus;
+        corpus.reserve(count);
+        std::vector<uint32_t> next_seq(devices, 0);
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            // Redeliveries follow shortly after the original (reconnect within the session)
+            if (!corpus.empty() && unit(rng) < dup_rate)
+            {
+                const size_t back = std::min<size_t>(corpus.size(), 1 + rng() % 64);
+                corpus.push_back(corpus[corpus.size() - back]);
+                continue;
+            }
+
+            const uint32_t device = rng() % devices;
+            const std::string base = "sim/mailbox/mailbox-" + std::to_string(device);
+            char ip[16];
+            snprintf(ip, sizeof(ip), "10.%u.%u.%u", (device >> 16) & 0xff, (device >> 8) & 0xff, device & 0xff);
+            char timestamp[32];
+            snprintf(timestamp, sizeof(timestamp), "01.01.1970 %02u:%02u:%02u", (i / 3600) % 24, (i / 60) % 60, i % 60);
+
+            cJSON *root = cJSON_CreateObject();
+            const double roll = unit(rng);
+            const float distance = 30.0f + static_cast<float>(unit(rng) * 10.0);
+            Message message;
+
+            if (roll < 0.9)
+            {
+                const bool keyframe = unit(rng) < 1.0 / 24.0;
+                if (keyframe)
+                    cJSON_AddStringToObject(root, "device_ip", ip);
+                cJSON_AddStringToObject(root, "timestamp", timestamp);
+                cJSON_AddNumberToObject(root, "kf", keyframe ? 1 : 0);
+                cJSON_AddNumberToObject(root, "distance_cm", distance);
+                if (keyframe)
+                {
+                    cJSON_AddNumberToObject(root, "baseline_cm", 40.0f);
+                    cJSON_AddNumberToObject(root, "threshold_cm", 38.0f);
+                }
+                cJSON_AddNumberToObject(root, "success_rate", 0.98f);
+                if (keyframe)
+                    cJSON_AddStringToObject(root, "mailbox_state", STATES[rng() % 4]);
+                message.topic = base + "/status";
+            }
+            else if (roll < 0.95)
+            {
+                cJSON_AddStringToObject(root, "device_ip", ip);
+                cJSON_AddStringToObject(root, "timestamp", timestamp);
+                cJSON_AddNumberToObject(root, "distance_cm", distance);
+                cJSON_AddNumberToObject(root, "baseline_cm", 40.0f);
+                cJSON_AddNumberToObject(root, "duration_ms", 200);
+                cJSON_AddNumberToObject(root, "confidence", 0.87f);
+                cJSON_AddNumberToObject(root, "success_rate", 0.98f);
+                cJSON_AddStringToObject(root, "new_state", "has_mail");
+                message.topic = base + "/events/mail_drop";
+            }
+            else
+            {
+                cJSON_AddStringToObject(root, "device_ip", ip);
+                cJSON_AddStringToObject(root, "timestamp", timestamp);
+                cJSON_AddNumberToObject(root, "before_cm", distance);
+                cJSON_AddNumberToObject(root, "after_cm", 40.0f);
+                cJSON_AddNumberToObject(root, "baseline_cm", 40.0f);
+                cJSON_AddNumberToObject(root, "duration_ms", 200);
+                cJSON_AddNumberToObject(root, "success_rate", 0.98f);
+                cJSON_AddStringToObject(root, "new_state", "emptied");
+                message.topic = base + "/events/mail_collected";
+            }
+
+            // Stamped last, like Telemetry::publishJSON (a redelivery above repeats the same number)
+            cJSON_AddNumberToObject(root, "seq", next_seq[device]++);
+            cJSON_AddNumberToObject(root, "wake", i / devices);
+
+            char *json = cJSON_PrintUnformatted(root);
+            message.payload = json;
+            cJSON_free(json);
+            cJSON_Delete(root);
+            corpus.push_back(std::move(message));
+        }
+
+        return corpus;
+    }
+
+    double seconds(std::chrono::steady_clock::time_point since)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+    }
+
+    // Parse-only comparison: schema parser vs. generic cJSON tree + lookups
+    void benchParsers(const std::vector<Message> &corpus)
+    {
+        volatile float sink = 0.0f;
+
+        auto start = std::chrono::steady_clock::now();
+        uint64_t ok = 0;
+        for (const Message &m : corpus)
+        {
+            Ingest::Payload payload;
+            if (Ingest::ParsePayload(m.payload.data(), m.payload.size(), &payload))
+            {
+                sink = sink + payload.distance_cm;
+                ++ok;
+            }
+        }
+        const double schema_s = seconds(start);
+
+        start = std::chrono::steady_clock::now();
+        uint64_t cjson_ok = 0;
+        for (const Message &m : corpus)
+        {
+            cJSON *root = cJSON_ParseWithLength(m.payload.data(), m.payload.size());
+            if (root)
+            {
+                const cJSON *distance = cJSON_GetObjectItemCaseSensitive(root, "distance_cm");
+                const cJSON *state = cJSON_GetObjectItemCaseSensitive(root, "mailbox_state");
+                if (cJSON_IsNumber(distance))
+                    sink = sink + static_cast<float>(distance->valuedouble);
+                if (cJSON_IsString(state))
+                    sink = sink + state->valuestring[0];
+                cJSON_Delete(root);
+                ++cjson_ok;
+            }
+        }
+        const double cjson_s = seconds(start);
+
+        printf("[parse] schema parser: %.0f msg/s (%.0f ns/msg, %llu ok) | cJSON: %.0f msg/s (%.0f ns/msg, %llu ok)\n",
+               corpus.size() / schema_s, schema_s * 1e9 / corpus.size(), static_cast<unsigned long long>(ok),
+               corpus.size() / cjson_s, cjson_s * 1e9 / corpus.size(), static_cast<unsigned long long>(cjson_ok));
+    }
+
+    // Full pipeline: producers submit like MQTT callbacks, shards parse, dedupe and apply
+    void benchPipeline(const std::vector<Message> &corpus, uint32_t producers, const Ingest::PipelineParams &params,
+                       const char *tsdb_dir)
+    {
+        Ingest::IngestMetrics metrics;
+        Ingest::Pipeline pipeline(params, metrics);
+
+        std::unique_ptr<Ingest::TsdbSink> tsdb;
+        if (tsdb_dir)
+        {
+            tsdb.reset(new Ingest::TsdbSink(tsdb_dir, params.shards, 24 * 3600 * 1000LL, 1000));
+            if (!tsdb->Ok())
+                return;
+            pipeline.SetSink(tsdb.get());
+        }
+        pipeline.Start();
+
+        const auto start = std::chrono::steady_clock::now();
+        metrics.Start(Ingest::Pipeline::NowUs());
+
+        std::vector<std::thread> threads;
+        for (uint32_t p = 0; p < producers; ++p)
+        {
+            threads.emplace_back(
+                [&, p]
+                {
+                    for (size_t i = p; i < corpus.size(); i += producers)
+                    {
+                        const Message &m = corpus[i];
+                        while (!pipeline.Submit(m.topic.data(), m.topic.size(), m.payload.data(), m.payload.size(),
+                                                Ingest::Pipeline::NowUs()))
+                            std::this_thread::yield();
+                    }
+                });
+        }
+        for (auto &thread : threads)
+            thread.join();
+        pipeline.Stop();
+        if (tsdb)
+            tsdb->Close();
+
+        const double elapsed_s = seconds(start);
+        printf("[pipeline] %zu msgs, %u producers, %u shards: %.0f msg/s\n",
+               corpus.size(), producers, params.shards, corpus.size() / elapsed_s);
+        metrics.Report(Ingest::Pipeline::NowUs(), pipeline.QueueDepth(), pipeline.Devices().Size(), true);
+
+        if (tsdb)
+        {
+            const uint64_t raw = std::accumulate(corpus.begin(), corpus.end(), uint64_t{0},
+                                                 [](uint64_t sum, const Message &m)
+                                                 { return sum + m.topic.size() + m.payload.size(); });
+            printf("[tsdb] %llu bytes for %llu rows (%.1f bytes/row, raw JSON %.1f bytes/msg)\n",
+                   static_cast<unsigned long long>(tsdb->BytesWritten()),
+                   static_cast<unsigned long long>(metrics.applied.load()),
+                   static_cast<double>(tsdb->BytesWritten()) / std::max<uint64_t>(1, metrics.applied),
+                   static_cast<double>(raw) / corpus.size());
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t devices = 10000;
+    uint32_t messages = 1000000;
+    uint32_t producers = 2;
+    double dup_rate = 0.05;
+    uint64_t seed = 1;
+    const char *tsdb_dir = nullptr;
+
+    Ingest::PipelineParams params = {};
+    params.shards = std::max(1u, std::thread::hardware_concurrency());
+    params.queue_depth = 65536;
+    params.table_capacity = 262144;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!value && strcmp(arg, "--help") != 0)
+        {
+            usage(argv[0]);
+            return 2;
+        }
+
+        if (!strcmp(arg, "--devices"))
+            devices = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(arg, "--messages"))
+            messages = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(arg, "--producers"))
+            producers = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(arg, "--shards"))
+            params.shards = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(arg, "--dup-rate"))
+            dup_rate = atof(argv[++i]);
+        else if (!strcmp(arg, "--seed"))
+            seed = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(arg, "--tsdb"))
+            tsdb_dir = argv[++i];
+        else
+        {
+            usage(argv[0]);
+            return !strcmp(arg, "--help") ? 0 : 2;
+        }
+    }
+
+    if (devices == 0 || messages == 0 || producers == 0)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    const std::vector<Message> corpus = makeCorpus(devices, messages, dup_rate, seed);
+    benchParsers(corpus);
+    benchPipeline(corpus, producers, params, tsdb_dir);
+    return 0;
+}
\ No newline at end of file
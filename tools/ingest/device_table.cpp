@@ -0,0 +1,114 @@
+#include "device_table.hpp"
+
+#include <cstring>
+
+namespace Ingest
+{
+    DeviceTable::DeviceTable(size_t capacity)
+        : capacity_(1)
+    {
+        while (capacity_ < capacity)
+            capacity_ <<= 1;
+        mask_ = capacity_ - 1;
+        slots_.reset(new Slot[capacity_]);
+    }
+
+    uint64_t DeviceTable::Hash(Span device)
+    {
+        // FNV-1a, finalized so that low bits are usable for both shard and slot
+        uint64_t hash = 1469598103934665603ULL;
+        for (uint32_t i = 0; i < device.len; ++i)
+            hash = (hash ^ static_cast<uint8_t>(device.data[i])) * 1099511628211ULL;
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        return hash ? hash : 1;
+    }
+
+    DeviceTable::Slot *DeviceTable::Acquire(Span device, uint64_t hash)
+    {
+        if (device.len > MAX_KEY_LEN)
+            return nullptr;
+
+        for (size_t probe = 0; probe < capacity_; ++probe)
+        {
+            Slot &slot = slots_[(hash + probe) & mask_];
+            uint64_t key = slot.key.load(std::memory_order_acquire);
+
+            if (key == 0)
+            {
+                uint64_t expected = 0;
+                if (slot.key.compare_exchange_strong(expected, hash, std::memory_order_acq_rel))
+                {
+                    // Only the owning shard inserts this key, so it is the sole writer from here on
+                    memcpy(slot.name, device.data, device.len);
+                    slot.name[device.len] = '\0';
+                    slot.state = {};
+                    slot.window.Clear();
+                    slot.seq.store(2, std::memory_order_release);
+                    size_.fetch_add(1, std::memory_order_relaxed);
+                    return &slot;
+                }
+                key = expected; // Another shard claimed it first
+            }
+
+            // Same hash from a different key: keep probing
+            if (key == hash && slot.seq.load(std::memory_order_acquire) != 0 &&
+                strncmp(slot.name, device.data, device.len) == 0 && slot.name[device.len] == '\0')
+            {
+                return &slot;
+            }
+        }
+
+        return nullptr;
+    }
+
+    DeviceState *DeviceTable::BeginWrite(Slot *slot)
+    {
+        slot->seq.store(slot->seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        return &slot->state;
+    }
+
+    void DeviceTable::EndWrite(Slot *slot)
+    {
+        slot->seq.store(slot->seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool DeviceTable::Read(Span device, DeviceState *out) const
+    {
+        const uint64_t hash = Hash(device);
+        for (size_t probe = 0; probe < capacity_; ++probe)
+        {
+            const Slot &slot = slots_[(hash + probe) & mask_];
+            const uint64_t key = slot.key.load(std::memory_order_acquire);
+            if (key == 0)
+                return false;
+            if (key == hash && slot.seq.load(std::memory_order_acquire) != 0 &&
+                device.len <= MAX_KEY_LEN && strncmp(slot.name, device.data, device.len) == 0 &&
+                slot.name[device.len] == '\0')
+            {
+                return readSlot(slot, out);
+            }
+        }
+        return false;
+    }
+
+    bool DeviceTable::readSlot(const Slot &slot, DeviceState *out)
+    {
+        for (;;)
+        {
+            const uint32_t before = slot.seq.load(std::memory_order_acquire);
+            if (before == 0)
+                return false;
+            if (before & 1)
+                continue;
+
+            memcpy(out, &slot.state, sizeof(*out));
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (slot.seq.load(std::memory_order_relaxed) == before)
+                return true;
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "event_latency.hpp"
+#include "payload_parser.hpp"
+#include "sequence_window.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Ingest
+{
+    // Latest known state of one device, as assembled from keyframes, deltas and events
+    struct DeviceState
+    {
+        char device_ip[16];                    ///< Last reported IP ("" until known)
+        Processor::MailboxState mailbox_state; ///< Current mailbox state
+        bool has_keyframe;                     ///< False until a full status was applied
+        float distance_cm;                     ///< Last filtered distance (centimeters)
+        float baseline_cm;                     ///< Baseline from the last keyframe/delta (centimeters)
+        float threshold_cm;                    ///< Trigger threshold from the last keyframe/delta (centimeters)
+        float success_rate;                    ///< Last reported measurement success rate
+        uint32_t statuses;                     ///< Heartbeats applied
+        uint32_t mail_drops;                   ///< mail_drop events applied
+        uint32_t mail_collections;             ///< mail_collected events applied
+        int64_t last_seen_us;                  ///< Receive time of the last applied message
+        uint32_t last_seq;                     ///< Sequence number of the last applied message
+        uint32_t wake;                         ///< Wake counter of the last applied message
+        uint32_t config_version;               ///< Runtime config version the device last reported
+        uint32_t battery_mv;                   ///< Last reported battery voltage (0 until known)
+        uint32_t battery_percent;              ///< Last reported remaining capacity estimate
+        Hardware::Battery::PowerLevel power;   ///< Power level the device last reported
+        DeviceLatency latency;                 ///< Phases of the traced events applied
+    };
+
+    /**
+     * Fixed-capacity open-addressing map from device key to DeviceState
+     *
+     * Keys are claimed with a CAS and never removed, so lookups need no locks.
+     * Each device is written by exactly one ingest shard (the one its key
+     * hashes to), and the value is guarded by a per-slot sequence counter:
+     * readers copy it optimistically and retry if a write overlapped.
+     */
+    class DeviceTable
+    {
+    public:
+        static constexpr size_t MAX_KEY_LEN = 63; ///< Longest device key (topic prefix) stored
+
+        struct Slot
+        {
+            std::atomic<uint64_t> key{0}; ///< Hash of the device key (0 = free)
+            std::atomic<uint32_t> seq{0}; ///< Even: stable, odd: write in progress, 0: not published
+            char name[MAX_KEY_LEN + 1];   ///< Device key, written once before the first publish
+            DeviceState state;            ///< Guarded by seq
+
+            // Owner-shard private: sequence numbers already applied (QoS 1 redelivery filter)
+            SequenceWindow window;
+        };
+
+        // Capacity is rounded up to a power of two
+        explicit DeviceTable(size_t capacity);
+
+        // Hash of a device key as used for slot and shard selection (never 0)
+        static uint64_t Hash(Span device);
+
+        /**
+         * Find or insert the slot of a device (owning shard only)
+         *
+         * Returns NULL if the key is too long or the table is full.
+         */
+        Slot *Acquire(Span device, uint64_t hash);
+
+        // Bracket a modification of slot->state (owning shard only)
+        static DeviceState *BeginWrite(Slot *slot);
+        static void EndWrite(Slot *slot);
+
+        // Copy the current state of a device; false if it is unknown
+        bool Read(Span device, DeviceState *out) const;
+
+        // Call fn(name, state) with a consistent copy of every published device
+        template <typename Fn>
+        void ForEach(Fn &&fn) const
+        {
+            for (size_t i = 0; i < capacity_; ++i)
+            {
+                DeviceState state;
+                if (readSlot(slots_[i], &state))
+                    fn(slots_[i].name, state);
+            }
+        }
+
+        // Number of devices currently stored
+        size_t Size() const { return size_.load(std::memory_order_relaxed); }
+
+        size_t Capacity() const { return capacity_; }
+
+    private:
+        size_t capacity_;
+        size_t mask_;
+        std::unique_ptr<Slot[]> slots_;
+        std::atomic<size_t> size_{0};
+
+        static bool readSlot(const Slot &slot, DeviceState *out);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,126 @@
+#include "event_latency.hpp"
+
+#include <algorithm>
+
+namespace Ingest
+{
+    namespace
+    {
+        size_t bucketOf(uint32_t ms)
+        {
+            if (ms < 64)
+                return 0;
+            const unsigned msb = 31 - __builtin_clz(ms);
+            return std::min<size_t>(msb - 5, DeviceLatency::BUCKETS - 1);
+        }
+
+        uint32_t upperBound(size_t bucket) { return 64u << bucket; }
+    }
+
+    const char *PhaseName(LatencyPhase phase)
+    {
+        switch (phase)
+        {
+        case PHASE_WINDOW:
+            return "window";
+        case PHASE_WIFI:
+            return "wifi";
+        case PHASE_TIME_SYNC:
+            return "ntp";
+        case PHASE_MQTT:
+            return "mqtt";
+        case PHASE_PUBLISH:
+            return "publish";
+        case PHASE_DELIVERY:
+            return "delivery";
+        case PHASE_TOTAL:
+            return "total";
+        default:
+            return "unknown";
+        }
+    }
+
+    uint32_t SplitLatency(const Payload &payload, int64_t received_wall_ms, uint32_t phases_ms[LATENCY_PHASES],
+                          bool *skewed)
+    {
+        *skewed = false;
+        const auto has = [&](uint32_t bit)
+        { return (payload.fields & bit) != 0; };
+        if (!has(FIELD_TRACE_PUBLISH))
+            return 0;
+
+        uint32_t mask = 0;
+        const auto set = [&](LatencyPhase phase, int64_t ms)
+        {
+            phases_ms[phase] = static_cast<uint32_t>(std::clamp<int64_t>(ms, 0, UINT32_MAX));
+            mask |= 1u << phase;
+        };
+
+        // A phase needs the offsets at both of its ends; the device leaves out the ones it did not reach
+        const TraceOffsets &trace = payload.trace;
+        if (has(FIELD_TRACE_WINDOW))
+            set(PHASE_WINDOW, trace.window_ms);
+        if (has(FIELD_TRACE_WIFI))
+            set(PHASE_WIFI, trace.wifi_ms);
+        if (has(FIELD_TRACE_WIFI) && has(FIELD_TRACE_TIME_SYNC))
+            set(PHASE_TIME_SYNC, static_cast<int64_t>(trace.time_sync_ms) - trace.wifi_ms);
+        if (has(FIELD_TRACE_TIME_SYNC) && has(FIELD_TRACE_MQTT))
+            set(PHASE_MQTT, static_cast<int64_t>(trace.mqtt_ms) - trace.time_sync_ms);
+        if (has(FIELD_TRACE_MQTT))
+            set(PHASE_PUBLISH, static_cast<int64_t>(trace.publish_ms) - trace.mqtt_ms);
+
+        if (has(FIELD_DETECTED))
+        {
+            const int64_t total_ms = received_wall_ms - static_cast<int64_t>(payload.detected_ms);
+            const int64_t delivery_ms = total_ms - trace.publish_ms;
+            if (delivery_ms < -CLOCK_TOLERANCE_MS)
+            {
+                *skewed = true;
+            }
+            else
+            {
+                set(PHASE_DELIVERY, delivery_ms);
+                set(PHASE_TOTAL, std::max<int64_t>(total_ms, trace.publish_ms));
+            }
+        }
+        return mask;
+    }
+
+    void DeviceLatency::Record(uint32_t mask, const uint32_t phases_ms[LATENCY_PHASES])
+    {
+        events++;
+        for (size_t phase = 0; phase < LATENCY_PHASES; ++phase)
+        {
+            if (!(mask & (1u << phase)))
+                continue;
+
+            uint8_t *buckets = counts[phase];
+            uint8_t &count = buckets[bucketOf(phases_ms[phase])];
+            if (count == UINT8_MAX)
+            {
+                for (size_t i = 0; i < BUCKETS; ++i)
+                    buckets[i] /= 2;
+            }
+            count++;
+        }
+    }
+
+    uint32_t DeviceLatency::Percentile(LatencyPhase phase, double q) const
+    {
+        uint32_t total = 0;
+        for (uint8_t c : counts[phase])
+            total += c;
+        if (total == 0)
+            return 0;
+
+        const uint32_t rank = static_cast<uint32_t>(q * total);
+        uint32_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i)
+        {
+            seen += counts[phase][i];
+            if (seen > rank)
+                return upperBound(i);
+        }
+        return upperBound(BUCKETS - 1);
+    }
+}
\ No newline at end of file
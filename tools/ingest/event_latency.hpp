@@ -0,0 +1,62 @@
+#pragma once
+
+#include "payload_parser.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Ingest
+{
+    // Stages of an event on its way from the mailbox to the backend
+    enum LatencyPhase : uint8_t
+    {
+        PHASE_WINDOW,    ///< Drop to detection at most: the sleep before the detecting measurement
+        PHASE_WIFI,      ///< Detection to Wi-Fi up
+        PHASE_TIME_SYNC, ///< Wi-Fi up to the clock synchronized
+        PHASE_MQTT,      ///< Clock synchronized to the broker connected
+        PHASE_PUBLISH,   ///< Broker connected to the message handed to the MQTT client
+        PHASE_DELIVERY,  ///< MQTT client to the ingest callback (needs "t_det")
+        PHASE_TOTAL,     ///< Detection to the ingest callback (needs "t_det")
+        LATENCY_PHASES
+    };
+
+    // Name of a phase in reports and exports ("window", "wifi", ...)
+    const char *PhaseName(LatencyPhase phase);
+
+    static constexpr int64_t CLOCK_TOLERANCE_MS = 250; ///< SNTP error accepted between device and backend clocks
+
+    /**
+     * Split the latency of a traced event into its phases
+     *
+     * received_wall_ms is the wall-clock time the message reached the ingest
+     * callback, which stands in for the broker receipt. Returns the mask of
+     * the phases written to phases_ms (bit = 1 << phase): the device-side
+     * ones come from the "tr_*" offsets, delivery and total need "t_det" as
+     * well, and so a device clock in step with ours. Within
+     * CLOCK_TOLERANCE_MS a negative delivery is taken as 0; beyond it the
+     * two are left out and *skewed is set.
+     */
+    uint32_t SplitLatency(const Payload &payload, int64_t received_wall_ms, uint32_t phases_ms[LATENCY_PHASES],
+                          bool *skewed);
+
+    /**
+     * Event latency of one device, small enough for every device table slot
+     *
+     * One saturating histogram per phase with power-of-two millisecond
+     * buckets (<= 2x error). When a bucket is full, all buckets of that
+     * phase halve, so old events fade and the percentiles follow the recent
+     * ones.
+     */
+    struct DeviceLatency
+    {
+        static constexpr size_t BUCKETS = 16; ///< < 64 ms, then one per octave; the last holds >= 2^20 ms
+
+        uint8_t counts[LATENCY_PHASES][BUCKETS];
+        uint32_t events; ///< Traced events recorded
+
+        void Record(uint32_t mask, const uint32_t phases_ms[LATENCY_PHASES]);
+
+        // Upper bound (ms) of the bucket holding quantile q of a phase; 0 without samples
+        uint32_t Percentile(LatencyPhase phase, double q) const;
+    };
+}
\ No newline at end of file
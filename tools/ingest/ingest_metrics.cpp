@@ -0,0 +1,145 @@
+#include "ingest_metrics.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace Ingest
+{
+    size_t LagHistogram::bucketOf(uint64_t lag_us)
+    {
+        if (lag_us < 4)
+            return static_cast<size_t>(lag_us);
+
+        const unsigned msb = 63 - __builtin_clzll(lag_us);
+        const size_t bucket = 4 + (msb - 2) * 4 + ((lag_us >> (msb - 2)) & 3);
+        return std::min(bucket, BUCKETS - 1);
+    }
+
+    int64_t LagHistogram::upperBound(size_t bucket)
+    {
+        if (bucket < 4)
+            return static_cast<int64_t>(bucket);
+
+        const size_t octave = (bucket - 4) / 4;
+        const size_t step = (bucket - 4) % 4;
+        return static_cast<int64_t>(5 + step) << octave;
+    }
+
+    void LagHistogram::Record(int64_t lag_us)
+    {
+        window_[bucketOf(static_cast<uint64_t>(std::max<int64_t>(0, lag_us)))].fetch_add(1, std::memory_order_relaxed);
+
+        int64_t max = window_max_.load(std::memory_order_relaxed);
+        while (lag_us > max && !window_max_.compare_exchange_weak(max, lag_us, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    std::array<int64_t, 5> LagHistogram::TakeWindow()
+    {
+        std::array<uint64_t, BUCKETS> counts;
+        for (size_t i = 0; i < BUCKETS; ++i)
+        {
+            counts[i] = window_[i].exchange(0, std::memory_order_relaxed);
+            run_[i] += counts[i];
+        }
+        const int64_t max = window_max_.exchange(0, std::memory_order_relaxed);
+        run_max_ = std::max(run_max_, max);
+        return percentiles(counts, max);
+    }
+
+    std::array<int64_t, 5> LagHistogram::RunTotals() const { return percentiles(run_, run_max_); }
+
+    std::array<int64_t, 5> LagHistogram::percentiles(const std::array<uint64_t, BUCKETS> &counts, int64_t max)
+    {
+        uint64_t total = 0;
+        for (uint64_t c : counts)
+            total += c;
+        if (total == 0)
+            return {0, 0, 0, 0, 0};
+
+        const auto at = [&](double q)
+        {
+            const uint64_t rank = static_cast<uint64_t>(q * total);
+            uint64_t seen = 0;
+            for (size_t i = 0; i < BUCKETS; ++i)
+            {
+                seen += counts[i];
+                if (seen > rank)
+                    return std::min(max, upperBound(i));
+            }
+            return max;
+        };
+        return {at(0.50), at(0.90), at(0.99), max, static_cast<int64_t>(total)};
+    }
+
+    void IngestMetrics::Start(int64_t now_us)
+    {
+        start_us_ = now_us;
+        last_report_us_ = now_us;
+        last_received_ = received;
+        last_applied_ = applied;
+        last_traced_ = traced;
+    }
+
+    void IngestMetrics::Report(int64_t now_us, size_t queue_depth, size_t devices, bool final_report)
+    {
+        std::array<int64_t, 5> lag_window = lag.TakeWindow();
+        if (final_report)
+        {
+            last_report_us_ = start_us_;
+            last_received_ = last_applied_ = 0;
+            lag_window = lag.RunTotals();
+        }
+
+        const double elapsed_s = std::max(1e-3, (now_us - last_report_us_) / 1e6);
+        const uint64_t r = received, a = applied;
+
+        printf("%s recv/s=%.0f applied/s=%.0f queued=%zu devices=%zu dup=%llu stale=%llu seq_reset=%llu "
+               "unsequenced=%llu parse_err=%llu unknown=%llu oversized=%llu rejected=%llu orphan_delta=%llu "
+               "stalls=%llu | lag ms p50=%.2f p90=%.2f p99=%.2f max=%.2f (n=%lld)\n",
+               final_report ? "[total]" : "[ingest]",
+               (r - last_received_) / elapsed_s, (a - last_applied_) / elapsed_s, queue_depth, devices,
+               static_cast<unsigned long long>(duplicates.load()),
+               static_cast<unsigned long long>(stale.load()),
+               static_cast<unsigned long long>(seq_resets.load()),
+               static_cast<unsigned long long>(unsequenced.load()),
+               static_cast<unsigned long long>(parse_errors.load()),
+               static_cast<unsigned long long>(unknown_topic.load()),
+               static_cast<unsigned long long>(oversized.load()),
+               static_cast<unsigned long long>(rejected.load()),
+               static_cast<unsigned long long>(orphan_deltas.load()),
+               static_cast<unsigned long long>(stalls.load()),
+               lag_window[0] / 1e3, lag_window[1] / 1e3, lag_window[2] / 1e3, lag_window[3] / 1e3,
+               static_cast<long long>(lag_window[4]));
+
+        // Event latency by phase, once traced events arrive; p50 and p99 only, the line is long enough
+        const uint64_t t = traced;
+        const uint64_t new_traced = final_report ? t : t - last_traced_;
+        std::array<std::array<int64_t, 5>, LATENCY_PHASES> phases;
+        for (size_t phase = 0; phase < LATENCY_PHASES; ++phase)
+        {
+            phases[phase] = event_latency[phase].TakeWindow();
+            if (final_report)
+                phases[phase] = event_latency[phase].RunTotals();
+        }
+        if (new_traced > 0)
+        {
+            printf("%s traced=%llu clock_skew=%llu | event ms p50/p99", final_report ? "[total]" : "[latency]",
+                   static_cast<unsigned long long>(new_traced), static_cast<unsigned long long>(clock_skew.load()));
+            for (size_t phase = 0; phase < LATENCY_PHASES; ++phase)
+            {
+                if (phases[phase][4] > 0)
+                    printf(" %s=%.0f/%.0f", PhaseName(static_cast<LatencyPhase>(phase)), phases[phase][0] / 1e3,
+                           phases[phase][2] / 1e3);
+            }
+            printf("\n");
+        }
+        fflush(stdout);
+
+        last_report_us_ = now_us;
+        last_received_ = r;
+        last_applied_ = a;
+        last_traced_ = t;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "event_latency.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Ingest
+{
+    /**
+     * Lock-free latency histogram with log-linear microsecond buckets
+     *
+     * Every power of two is split into four buckets (<= 25% error), and
+     * Record() is a single relaxed increment, cheap enough for every message.
+     * Percentiles are reported as the upper bound of the bucket they fall in.
+     */
+    class LagHistogram
+    {
+    public:
+        static constexpr size_t BUCKETS = 4 + 4 * 36; ///< 0..3 us exact, then 4 per octave up to 2^38 us
+
+        void Record(int64_t lag_us);
+
+        // Return {p50, p90, p99, max, count} (microseconds) since the last call and fold them into the run totals
+        std::array<int64_t, 5> TakeWindow();
+
+        // Same figures over the whole run
+        std::array<int64_t, 5> RunTotals() const;
+
+    private:
+        std::array<std::atomic<uint64_t>, BUCKETS> window_{};
+        std::atomic<int64_t> window_max_{0};
+        std::array<uint64_t, BUCKETS> run_{};
+        int64_t run_max_ = 0;
+
+        static size_t bucketOf(uint64_t lag_us);
+        static int64_t upperBound(size_t bucket);
+        static std::array<int64_t, 5> percentiles(const std::array<uint64_t, BUCKETS> &counts, int64_t max);
+    };
+
+    /**
+     * Ingest counters
+     *
+     * Cumulative; Report() prints rates since the previous report. "lag" is
+     * the time from the MQTT client callback to the device state being
+     * updated, i.e. how far ingestion trails the broker. "event_latency"
+     * holds the phases of the traced events over the whole fleet; Report()
+     * adds a line for them once there are any.
+     */
+    class IngestMetrics
+    {
+    public:
+        std::atomic<uint64_t> received{0};      ///< Messages handed to the pipeline
+        std::atomic<uint64_t> applied{0};       ///< Messages applied to device state
+        std::atomic<uint64_t> duplicates{0};    ///< QoS 1 redeliveries dropped (sequence number already applied)
+        std::atomic<uint64_t> stale{0};         ///< Messages dropped as older than the dedupe window
+        std::atomic<uint64_t> seq_resets{0};    ///< Devices whose sequence restarted (NVS erased)
+        std::atomic<uint64_t> unsequenced{0};   ///< Messages without a sequence number (applied, not deduplicated)
+        std::atomic<uint64_t> parse_errors{0};  ///< Payloads the schema parser rejected
+        std::atomic<uint64_t> unknown_topic{0}; ///< Messages on topics Telemetry does not publish
+        std::atomic<uint64_t> oversized{0};     ///< Messages larger than a queue cell
+        std::atomic<uint64_t> rejected{0};      ///< Devices that did not fit the table
+        std::atomic<uint64_t> orphan_deltas{0}; ///< Delta heartbeats received before any keyframe
+        std::atomic<uint64_t> stalls{0};        ///< Submit attempts that found the shard queue full
+        std::atomic<uint64_t> traced{0};        ///< Events applied with a latency trace
+        std::atomic<uint64_t> clock_skew{0};    ///< Traced events sent by a device whose clock is ahead of ours
+
+        LagHistogram lag;                                          ///< Callback to applied latency
+        std::array<LagHistogram, LATENCY_PHASES> event_latency{}; ///< Phases of the traced events, by LatencyPhase
+
+        // Mark the start of the run
+        void Start(int64_t now_us);
+
+        // Print one report line (or the whole-run summary)
+        void Report(int64_t now_us, size_t queue_depth, size_t devices, bool final_report);
+
+    private:
+        int64_t start_us_ = 0;
+        int64_t last_report_us_ = 0;
+        uint64_t last_received_ = 0;
+        uint64_t last_applied_ = 0;
+        uint64_t last_traced_ = 0;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Ingest
+{
+    /**
+     * Bounded multi-producer queue of preallocated cells
+     *
+     * Producers (MQTT callback threads) fill a cell in place and the owning
+     * shard worker consumes it in place, so a message is copied exactly once
+     * from the client's buffer into the ring. Each cell carries a sequence
+     * number that tells producers and the consumer whose turn it is; no locks
+     * are taken and a full queue is reported instead of blocking.
+     */
+    template <typename T>
+    class IngestQueue
+    {
+    public:
+        // Capacity is rounded up to a power of two
+        explicit IngestQueue(size_t capacity)
+            : capacity_(1)
+        {
+            while (capacity_ < capacity)
+                capacity_ <<= 1;
+            mask_ = capacity_ - 1;
+            cells_.reset(new Cell[capacity_]);
+            for (size_t i = 0; i < capacity_; ++i)
+                cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+
+        // Fill the next free cell with fill(T&); false if the queue is full
+        template <typename Fill>
+        bool TryPush(Fill &&fill)
+        {
+            size_t pos = tail_.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                Cell &cell = cells_[pos & mask_];
+                const size_t seq = cell.seq.load(std::memory_order_acquire);
+                const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+                if (diff == 0)
+                {
+                    if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        fill(cell.value);
+                        cell.seq.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    pos = tail_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Consume the oldest cell with consume(T&) (single consumer); false if empty
+        template <typename Consume>
+        bool TryPop(Consume &&consume)
+        {
+            Cell &cell = cells_[head_ & mask_];
+            if (cell.seq.load(std::memory_order_acquire) != head_ + 1)
+                return false;
+
+            consume(cell.value);
+            cell.seq.store(head_ + capacity_, std::memory_order_release);
+            ++head_;
+            return true;
+        }
+
+        // Approximate number of queued cells
+        size_t Depth() const
+        {
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+            const size_t head = head_seen_.load(std::memory_order_relaxed);
+            return tail > head ? tail - head : 0;
+        }
+
+        // Publish the consumer position for Depth() (called by the consumer now and then)
+        void PublishHead() { head_seen_.store(head_, std::memory_order_relaxed); }
+
+    private:
+        struct Cell
+        {
+            std::atomic<size_t> seq;
+            T value;
+        };
+
+        size_t capacity_;
+        size_t mask_;
+        std::unique_ptr<Cell[]> cells_;
+
+        alignas(64) std::atomic<size_t> tail_{0}; ///< Next position producers claim
+        alignas(64) size_t head_ = 0;             ///< Next position the consumer reads
+        std::atomic<size_t> head_seen_{0};        ///< head_ as last published for Depth()
+    };
+}
\ No newline at end of file
@@ -0,0 +1,307 @@
+#include "pipeline.hpp"
+#include "tsdb_sink.hpp"
+
+#include <mosquitto.h>
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    std::atomic<bool> g_stop{false};
+
+    void usage(const char *argv0)
+    {
+        printf("Usage: %s [options]\n"
+               "  --host HOST           broker host (default 127.0.0.1)\n"
+               "  --port N              broker port (default 1883)\n"
+               "  --base-topic TOPIC    subscribe to TOPIC/# (default sim/mailbox)\n"
+               "  --client-id ID        persistent session id prefix (default mailbox-ingest)\n"
+               "  --connections N       broker connections sharing the subscription (default 1)\n"
+               "  --shards N            ingest worker threads (default hardware concurrency)\n"
+               "  --queue N             messages buffered per shard (default 65536)\n"
+               "  --capacity N          maximum number of devices (default 262144)\n"
+               "  --report S            seconds between report lines (default 5)\n"
+               "  --duration S          stop after S seconds (default: run until interrupted)\n"
+               "  --dump                print the device table on exit\n"
+               "  --latency-csv FILE    write event latency percentiles per device and phase on exit\n"
+               "  --tsdb DIR            archive every applied message into a columnar store\n"
+               "  --partition-hours H   time span of one store segment (default 24)\n",
+               argv0);
+    }
+
+    const char *stateName(Processor::MailboxState state)
+    {
+        switch (state)
+        {
+        case Processor::MailboxState::EMPTY:
+            return "empty";
+        case Processor::MailboxState::HAS_MAIL:
+            return "has_mail";
+        case Processor::MailboxState::FULL:
+            return "full";
+        case Processor::MailboxState::EMPTIED:
+            return "emptied";
+        case Processor::MailboxState::OBSTRUCTED:
+            return "obstructed";
+        default:
+            return "unknown";
+        }
+    }
+
+    // One row per device and phase with samples: device,phase,events,p50_ms,p90_ms,p99_ms
+    bool writeLatencyCsv(const char *path, const Ingest::DeviceTable &devices)
+    {
+        FILE *file = fopen(path, "w");
+        if (!file)
+        {
+            fprintf(stderr, "[ingest] cannot write %s\n", path);
+            return false;
+        }
+
+        size_t rows = 0;
+        fprintf(file, "device,phase,events,p50_ms,p90_ms,p99_ms\n");
+        devices.ForEach(
+            [&](const char *name, const Ingest::DeviceState &state)
+            {
+                for (size_t i = 0; i < Ingest::LATENCY_PHASES; ++i)
+                {
+                    const auto phase = static_cast<Ingest::LatencyPhase>(i);
+                    const uint32_t p50 = state.latency.Percentile(phase, 0.50);
+                    if (p50 == 0)
+                        continue;
+                    fprintf(file, "%s,%s,%u,%u,%u,%u\n", name, Ingest::PhaseName(phase), state.latency.events, p50,
+                            state.latency.Percentile(phase, 0.90), state.latency.Percentile(phase, 0.99));
+                    rows++;
+                }
+            });
+
+        const bool ok = fclose(file) == 0;
+        printf("[ingest] wrote %zu latency rows to %s\n", rows, path);
+        return ok;
+    }
+
+    struct Connection
+    {
+        struct mosquitto *mosq;
+        std::string filter;
+        Ingest::Pipeline *pipeline;
+    };
+
+    void onConnect(struct mosquitto *mosq, void *arg, int rc)
+    {
+        auto *conn = static_cast<Connection *>(arg);
+        if (rc != 0)
+        {
+            fprintf(stderr, "[ingest] connect refused: %s\n", mosquitto_connack_string(rc));
+            return;
+        }
+        mosquitto_subscribe(mosq, nullptr, conn->filter.c_str(), 1);
+    }
+
+    void onMessage(struct mosquitto *, void *arg, const struct mosquitto_message *msg)
+    {
+        auto *conn = static_cast<Connection *>(arg);
+        const int64_t received_us = Ingest::Pipeline::NowUs();
+        const size_t topic_len = strlen(msg->topic);
+
+        // Backpressure: hold the network thread (and so the PUBACK) until the shard has room
+        while (!conn->pipeline->Submit(msg->topic, topic_len, static_cast<const char *>(msg->payload),
+                                       static_cast<size_t>(msg->payloadlen), received_us))
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const unsigned hw_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    const char *host = "127.0.0.1";
+    int port = 1883;
+    const char *base_topic = "sim/mailbox";
+    const char *client_id = "mailbox-ingest";
+    uint32_t connections = 1;
+    double report_s = 5.0;
+    double duration_s = 0.0;
+    bool dump = false;
+    const char *latency_csv = nullptr;
+    const char *tsdb_dir = nullptr;
+    double partition_hours = 24.0;
+
+    Ingest::PipelineParams params = {};
+    params.shards = hw_threads;
+    params.queue_depth = 65536;
+    params.table_capacity = 262144;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        const auto need = [&]()
+        {
+            if (!value)
+            {
+                fprintf(stderr, "Missing value for %s\n", arg);
+                exit(2);
+            }
+            ++i;
+            return value;
+        };
+
+        if (!strcmp(arg, "--host"))
+            host = need();
+        else if (!strcmp(arg, "--port"))
+            port = atoi(need());
+        else if (!strcmp(arg, "--base-topic"))
+            base_topic = need();
+        else if (!strcmp(arg, "--client-id"))
+            client_id = need();
+        else if (!strcmp(arg, "--connections"))
+            connections = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--shards"))
+            params.shards = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--queue"))
+            params.queue_depth = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--capacity"))
+            params.table_capacity = strtoull(need(), nullptr, 10);
+        else if (!strcmp(arg, "--report"))
+            report_s = atof(need());
+        else if (!strcmp(arg, "--duration"))
+            duration_s = atof(need());
+        else if (!strcmp(arg, "--dump"))
+            dump = true;
+        else if (!strcmp(arg, "--latency-csv"))
+            latency_csv = need();
+        else if (!strcmp(arg, "--tsdb"))
+            tsdb_dir = need();
+        else if (!strcmp(arg, "--partition-hours"))
+            partition_hours = atof(need());
+        else
+        {
+            usage(argv[0]);
+            return !strcmp(arg, "--help") ? 0 : 2;
+        }
+    }
+
+    if (connections == 0 || params.shards == 0 || params.queue_depth == 0 || params.table_capacity == 0 ||
+        partition_hours <= 0)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    signal(SIGINT, [](int)
+           { g_stop = true; });
+    signal(SIGTERM, [](int)
+           { g_stop = true; });
+
+    Ingest::IngestMetrics metrics;
+    Ingest::Pipeline pipeline(params, metrics);
+
+    std::unique_ptr<Ingest::TsdbSink> tsdb;
+    if (tsdb_dir)
+    {
+        tsdb.reset(new Ingest::TsdbSink(tsdb_dir, params.shards, static_cast<int64_t>(partition_hours * 3600e3),
+                                        5000));
+        if (!tsdb->Ok())
+            return 1;
+        pipeline.SetSink(tsdb.get());
+    }
+    pipeline.Start();
+
+    // Several connections split the load through a shared subscription (MQTT 5 / mosquitto 1.6+)
+    const std::string topic_filter = std::string(base_topic) + "/#";
+    const std::string filter = connections > 1 ? "$share/" + std::string(client_id) + "/" + topic_filter
+                                               : topic_filter;
+
+    mosquitto_lib_init();
+    std::vector<Connection> conns(connections);
+    for (uint32_t i = 0; i < connections; ++i)
+    {
+        const std::string id = connections > 1 ? std::string(client_id) + "-" + std::to_string(i) : client_id;
+        conns[i].filter = filter;
+        conns[i].pipeline = &pipeline;
+
+        // Persistent session: QoS 1 messages published while we are down are redelivered on reconnect
+        conns[i].mosq = mosquitto_new(id.c_str(), false, &conns[i]);
+        if (!conns[i].mosq)
+        {
+            fprintf(stderr, "[ingest] failed to create client %s\n", id.c_str());
+            return 1;
+        }
+        mosquitto_connect_callback_set(conns[i].mosq, onConnect);
+        mosquitto_message_callback_set(conns[i].mosq, onMessage);
+        mosquitto_reconnect_delay_set(conns[i].mosq, 1, 10, false);
+
+        const int rc = mosquitto_connect_async(conns[i].mosq, host, port, 30);
+        if (rc != MOSQ_ERR_SUCCESS)
+            fprintf(stderr, "[ingest] connect to %s:%d failed: %s (retrying)\n", host, port, mosquitto_strerror(rc));
+        mosquitto_loop_start(conns[i].mosq);
+    }
+
+    printf("[ingest] %s:%d %s, %u connections, %u shards, %u queue/shard, %zu devices max\n",
+           host, port, filter.c_str(), connections, params.shards, params.queue_depth, params.table_capacity);
+
+    const int64_t start_us = Ingest::Pipeline::NowUs();
+    const int64_t end_us = duration_s > 0 ? start_us + static_cast<int64_t>(duration_s * 1e6) : INT64_MAX;
+    int64_t next_report_us = start_us + static_cast<int64_t>(report_s * 1e6);
+    metrics.Start(start_us);
+
+    while (!g_stop && Ingest::Pipeline::NowUs() < end_us)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        const int64_t now_us = Ingest::Pipeline::NowUs();
+        if (now_us >= next_report_us)
+        {
+            metrics.Report(now_us, pipeline.QueueDepth(), pipeline.Devices().Size(), false);
+            next_report_us += static_cast<int64_t>(report_s * 1e6);
+        }
+    }
+
+    for (Connection &conn : conns)
+    {
+        mosquitto_disconnect(conn.mosq);
+        mosquitto_loop_stop(conn.mosq, false);
+        mosquitto_destroy(conn.mosq);
+    }
+    mosquitto_lib_cleanup();
+    pipeline.Stop();
+
+    metrics.Report(Ingest::Pipeline::NowUs(), pipeline.QueueDepth(), pipeline.Devices().Size(), true);
+    if (tsdb)
+    {
+        tsdb->Close();
+        printf("[ingest] archived %llu bytes to %s\n", static_cast<unsigned long long>(tsdb->BytesWritten()),
+               tsdb_dir);
+    }
+
+    if (dump)
+    {
+        pipeline.Devices().ForEach(
+            [](const char *name, const Ingest::DeviceState &state)
+            {
+                printf("%s ip=%s state=%s kf=%d distance=%.1f baseline=%.1f threshold=%.1f success=%.2f "
+                       "statuses=%u drops=%u collections=%u seq=%u wake=%u cfg=%u batt=%umV/%u%% power=%s\n",
+                       name, state.device_ip, stateName(state.mailbox_state), state.has_keyframe ? 1 : 0,
+                       state.distance_cm, state.baseline_cm, state.threshold_cm, state.success_rate,
+                       state.statuses, state.mail_drops, state.mail_collections, state.last_seq, state.wake,
+                       state.config_version, state.battery_mv, state.battery_percent,
+                       Hardware::Battery::LevelToString(state.power));
+            });
+    }
+
+    if (latency_csv && !writeLatencyCsv(latency_csv, pipeline.Devices()))
+        return 1;
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,407 @@
+#include "payload_parser.hpp"
+
+#include <charconv>
+#include <cstring>
+
+namespace Ingest
+{
+    namespace
+    {
+        struct Suffix
+        {
+            const char *text;
+            size_t len;
+            MessageKind kind;
+        };
+
+        constexpr Suffix SUFFIXES[] = {
+            {"/status", 7, MessageKind::STATUS},
+            {"/events/mail_drop", 17, MessageKind::MAIL_DROP},
+            {"/events/mail_collected", 22, MessageKind::MAIL_COLLECTED},
+            {"/config", 7, MessageKind::CONFIG},
+            {"/ota/offer", 10, MessageKind::OTA},
+            {"/ota/req", 8, MessageKind::OTA},
+            {"/ota/data", 9, MessageKind::OTA},
+        };
+
+        bool equals(Span s, const char *literal, size_t len)
+        {
+            return s.len == len && memcmp(s.data, literal, len) == 0;
+        }
+
+        // Cursor over the payload; every helper leaves `p` after what it consumed
+        struct Reader
+        {
+            const char *p;
+            const char *end;
+
+            void skipSpace()
+            {
+                while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+                    ++p;
+            }
+
+            bool consume(char c)
+            {
+                skipSpace();
+                if (p >= end || *p != c)
+                    return false;
+                ++p;
+                return true;
+            }
+
+            // Quoted string as a raw span (escape sequences are kept, not decoded)
+            bool string(Span *out)
+            {
+                if (!consume('"'))
+                    return false;
+                const char *start = p;
+                while (p < end && *p != '"')
+                    p += (*p == '\\') ? 2 : 1;
+                if (p >= end)
+                    return false;
+                *out = {start, static_cast<uint32_t>(p - start)};
+                ++p;
+                return true;
+            }
+
+            bool number(float *out)
+            {
+                skipSpace();
+
+                // Fast path for the plain decimals the firmware prints ("38.5", "-1", "0.98000001907348633" from cJSON builds)
+                const char *q = p;
+                const bool negative = q < end && *q == '-';
+                q += negative;
+                uint64_t mantissa = 0;
+                int digits = 0;
+                int scale = 0;
+                for (; q < end && *q >= '0' && *q <= '9'; ++q)
+                {
+                    if (digits < 18)
+                        mantissa = mantissa * 10 + static_cast<uint64_t>(*q - '0'), ++digits;
+                    else
+                        ++scale;
+                }
+                if (q < end && *q == '.')
+                {
+                    for (++q; q < end && *q >= '0' && *q <= '9'; ++q)
+                    {
+                        if (digits < 18)
+                            mantissa = mantissa * 10 + static_cast<uint64_t>(*q - '0'), ++digits, --scale;
+                    }
+                }
+                if (digits > 0 && (q >= end || (*q != 'e' && *q != 'E')))
+                {
+                    static constexpr double POW10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+                                                       1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18};
+                    if (scale >= -18 && scale <= 18)
+                    {
+                        double value = static_cast<double>(mantissa);
+                        value = scale < 0 ? value / POW10[-scale] : value * POW10[scale];
+                        *out = static_cast<float>(negative ? -value : value);
+                        p = q;
+                        return true;
+                    }
+                }
+
+                // Exponents and anything unusual
+                auto [next, ec] = std::from_chars(p, end, *out);
+                if (ec != std::errc())
+                    return false;
+                p = next;
+                return true;
+            }
+
+            bool integer(uint32_t *out)
+            {
+                skipSpace();
+
+                // Exact path: sequence numbers outgrow the 24-bit float mantissa
+                const char *q = p;
+                uint64_t exact = 0;
+                for (; q < end && *q >= '0' && *q <= '9' && exact <= UINT32_MAX; ++q)
+                    exact = exact * 10 + static_cast<uint64_t>(*q - '0');
+                if (q > p && exact <= UINT32_MAX && (q >= end || (*q != '.' && *q != 'e' && *q != 'E')))
+                {
+                    *out = static_cast<uint32_t>(exact);
+                    p = q;
+                    return true;
+                }
+
+                // Integers are printed without a fraction, but accept one anyway
+                float value = 0.0f;
+                if (!number(&value) || value < 0.0f)
+                    return false;
+                *out = static_cast<uint32_t>(value);
+                return true;
+            }
+
+            // Millisecond timestamps need all 64 bits
+            bool integer64(uint64_t *out)
+            {
+                skipSpace();
+                const char *q = p;
+                uint64_t value = 0;
+                for (; q < end && *q >= '0' && *q <= '9' && q - p < 19; ++q)
+                    value = value * 10 + static_cast<uint64_t>(*q - '0');
+                if (q == p || (q < end && ((*q >= '0' && *q <= '9') || *q == '.' || *q == 'e' || *q == 'E')))
+                    return false;
+                *out = value;
+                p = q;
+                return true;
+            }
+
+            // Skip the value of an unknown key (flat schema: scalars only)
+            bool skipValue()
+            {
+                skipSpace();
+                if (p >= end)
+                    return false;
+                if (*p == '"')
+                {
+                    Span ignored;
+                    return string(&ignored);
+                }
+                if (*p == '{' || *p == '[')
+                    return false;
+                while (p < end && *p != ',' && *p != '}')
+                    ++p;
+                return p < end;
+            }
+        };
+
+        bool parseState(Reader &reader, Payload *out)
+        {
+            Span text;
+            if (!reader.string(&text) || !ParseMailboxState(text, &out->mailbox_state))
+                return false;
+            out->fields |= FIELD_STATE;
+            return true;
+        }
+
+        bool parseInteger(Reader &reader, Payload *out, uint32_t *field, uint32_t bit)
+        {
+            if (!reader.integer(field))
+                return false;
+            out->fields |= bit;
+            return true;
+        }
+
+        bool parseFloat(Reader &reader, Payload *out, float *field, uint32_t bit)
+        {
+            if (!reader.number(field))
+                return false;
+            out->fields |= bit;
+            return true;
+        }
+
+        // Dispatch on the keys Telemetry emits; length first, then compare
+        bool parseField(Reader &reader, Span key, Payload *out)
+        {
+            switch (key.len)
+            {
+            case 2:
+                if (equals(key, "kf", 2))
+                {
+                    uint32_t kf = 0;
+                    if (!reader.integer(&kf))
+                        return false;
+                    out->keyframe = kf != 0;
+                    out->fields |= FIELD_KEYFRAME;
+                    return true;
+                }
+                break;
+            case 3:
+                if (equals(key, "seq", 3))
+                {
+                    if (!reader.integer(&out->seq))
+                        return false;
+                    out->fields |= FIELD_SEQ;
+                    return true;
+                }
+                if (equals(key, "cfg", 3))
+                {
+                    if (!reader.integer(&out->config_version))
+                        return false;
+                    out->fields |= FIELD_CONFIG;
+                    return true;
+                }
+                break;
+            case 4:
+                if (equals(key, "wake", 4))
+                {
+                    if (!reader.integer(&out->wake))
+                        return false;
+                    out->fields |= FIELD_WAKE;
+                    return true;
+                }
+                break;
+            case 5:
+                if (equals(key, "power", 5))
+                {
+                    Span text;
+                    if (!reader.string(&text) || !ParsePowerLevel(text, &out->power))
+                        return false;
+                    out->fields |= FIELD_POWER;
+                    return true;
+                }
+                if (equals(key, "t_det", 5))
+                {
+                    if (!reader.integer64(&out->detected_ms))
+                        return false;
+                    out->fields |= FIELD_DETECTED;
+                    return true;
+                }
+                break;
+            case 6:
+                if (equals(key, "tr_win", 6))
+                    return parseInteger(reader, out, &out->trace.window_ms, FIELD_TRACE_WINDOW);
+                if (equals(key, "tr_ntp", 6))
+                    return parseInteger(reader, out, &out->trace.time_sync_ms, FIELD_TRACE_TIME_SYNC);
+                if (equals(key, "tr_pub", 6))
+                    return parseInteger(reader, out, &out->trace.publish_ms, FIELD_TRACE_PUBLISH);
+                break;
+            case 7:
+                if (equals(key, "batt_mv", 7))
+                {
+                    if (!reader.integer(&out->battery_mv))
+                        return false;
+                    out->fields |= FIELD_BATTERY_MV;
+                    return true;
+                }
+                if (equals(key, "tr_wifi", 7))
+                    return parseInteger(reader, out, &out->trace.wifi_ms, FIELD_TRACE_WIFI);
+                if (equals(key, "tr_mqtt", 7))
+                    return parseInteger(reader, out, &out->trace.mqtt_ms, FIELD_TRACE_MQTT);
+                break;
+            case 8:
+                if (equals(key, "after_cm", 8))
+                    return parseFloat(reader, out, &out->after_cm, FIELD_AFTER);
+                if (equals(key, "batt_pct", 8))
+                {
+                    if (!reader.integer(&out->battery_percent))
+                        return false;
+                    out->fields |= FIELD_BATTERY_PCT;
+                    return true;
+                }
+                break;
+            case 9:
+                if (equals(key, "device_ip", 9))
+                {
+                    if (!reader.string(&out->device_ip))
+                        return false;
+                    out->fields |= FIELD_DEVICE_IP;
+                    return true;
+                }
+                if (equals(key, "timestamp", 9))
+                {
+                    if (!reader.string(&out->timestamp))
+                        return false;
+                    out->fields |= FIELD_TIMESTAMP;
+                    return true;
+                }
+                if (equals(key, "before_cm", 9))
+                    return parseFloat(reader, out, &out->before_cm, FIELD_BEFORE);
+                if (equals(key, "new_state", 9))
+                    return parseState(reader, out);
+                break;
+            case 10:
+                if (equals(key, "confidence", 10))
+                    return parseFloat(reader, out, &out->confidence, FIELD_CONFIDENCE);
+                break;
+            case 11:
+                if (equals(key, "distance_cm", 11))
+                    return parseFloat(reader, out, &out->distance_cm, FIELD_DISTANCE);
+                if (equals(key, "baseline_cm", 11))
+                    return parseFloat(reader, out, &out->baseline_cm, FIELD_BASELINE);
+                if (equals(key, "duration_ms", 11))
+                {
+                    if (!reader.integer(&out->duration_ms))
+                        return false;
+                    out->fields |= FIELD_DURATION;
+                    return true;
+                }
+                break;
+            case 12:
+                if (equals(key, "threshold_cm", 12))
+                    return parseFloat(reader, out, &out->threshold_cm, FIELD_THRESHOLD);
+                if (equals(key, "success_rate", 12))
+                    return parseFloat(reader, out, &out->success_rate, FIELD_SUCCESS_RATE);
+                break;
+            case 13:
+                if (equals(key, "mailbox_state", 13))
+                    return parseState(reader, out);
+                break;
+            default:
+                break;
+            }
+
+            return reader.skipValue();
+        }
+    }
+
+    MessageKind ClassifyTopic(const char *topic, size_t len, Span *device)
+    {
+        for (const Suffix &suffix : SUFFIXES)
+        {
+            if (len >= suffix.len && memcmp(topic + len - suffix.len, suffix.text, suffix.len) == 0)
+            {
+                *device = {topic, static_cast<uint32_t>(len - suffix.len)};
+                return suffix.kind;
+            }
+        }
+
+        *device = {topic, static_cast<uint32_t>(len)};
+        return MessageKind::UNKNOWN;
+    }
+
+    bool ParsePayload(const char *data, size_t len, Payload *out)
+    {
+        *out = {};
+        Reader reader = {data, data + len};
+
+        if (!reader.consume('{'))
+            return false;
+        if (reader.consume('}'))
+            return true;
+
+        do
+        {
+            Span key;
+            if (!reader.string(&key) || !reader.consume(':') || !parseField(reader, key, out))
+                return false;
+        } while (reader.consume(','));
+
+        return reader.consume('}');
+    }
+
+    bool ParseMailboxState(Span text, Processor::MailboxState *state)
+    {
+        if (equals(text, "empty", 5))
+            *state = Processor::MailboxState::EMPTY;
+        else if (equals(text, "has_mail", 8))
+            *state = Processor::MailboxState::HAS_MAIL;
+        else if (equals(text, "full", 4))
+            *state = Processor::MailboxState::FULL;
+        else if (equals(text, "emptied", 7))
+            *state = Processor::MailboxState::EMPTIED;
+        else if (equals(text, "obstructed", 10))
+            *state = Processor::MailboxState::OBSTRUCTED;
+        else
+            return false;
+        return true;
+    }
+    bool ParsePowerLevel(Span text, Hardware::Battery::PowerLevel *level)
+    {
+        if (equals(text, "normal", 6))
+            *level = Hardware::Battery::PowerLevel::NORMAL;
+        else if (equals(text, "low", 3))
+            *level = Hardware::Battery::PowerLevel::LOW;
+        else if (equals(text, "critical", 8))
+            *level = Hardware::Battery::PowerLevel::CRITICAL;
+        else
+            return false;
+        return true;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "sensor/battery/battery_policy.hpp"
+#include "processor/processor.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Ingest
+{
+    enum class MessageKind : uint8_t
+    {
+        STATUS,         ///< {base}/status heartbeat (keyframe or delta)
+        MAIL_DROP,      ///< {base}/events/mail_drop
+        MAIL_COLLECTED, ///< {base}/events/mail_collected
+        UNKNOWN,        ///< Any other topic below the subscription
+        CONFIG,         ///< {base}/config (runtime configuration sent to the device)
+        OTA             ///< {base}/ota/offer, /ota/req, /ota/data (firmware update traffic)
+    };
+
+    // Non-owning view into a received topic or payload
+    struct Span
+    {
+        const char *data;
+        uint32_t len;
+    };
+
+    // Bits of Payload::fields, one per key the firmware may send
+    enum PayloadField : uint32_t
+    {
+        FIELD_DEVICE_IP = 1u << 0,
+        FIELD_TIMESTAMP = 1u << 1,
+        FIELD_KEYFRAME = 1u << 2,
+        FIELD_DISTANCE = 1u << 3,
+        FIELD_BASELINE = 1u << 4,
+        FIELD_THRESHOLD = 1u << 5,
+        FIELD_SUCCESS_RATE = 1u << 6,
+        FIELD_STATE = 1u << 7,
+        FIELD_BEFORE = 1u << 8,
+        FIELD_AFTER = 1u << 9,
+        FIELD_DURATION = 1u << 10,
+        FIELD_CONFIDENCE = 1u << 11,
+        FIELD_SEQ = 1u << 12,
+        FIELD_WAKE = 1u << 13,
+        FIELD_CONFIG = 1u << 14,
+        FIELD_BATTERY_MV = 1u << 15,
+        FIELD_BATTERY_PCT = 1u << 16,
+        FIELD_POWER = 1u << 17,
+        FIELD_DETECTED = 1u << 18,
+        FIELD_TRACE_WINDOW = 1u << 19,
+        FIELD_TRACE_WIFI = 1u << 20,
+        FIELD_TRACE_TIME_SYNC = 1u << 21,
+        FIELD_TRACE_MQTT = 1u << 22,
+        FIELD_TRACE_PUBLISH = 1u << 23
+    };
+
+    // Wake timeline of an event, in ms after its detection (events of firmware that traces them)
+    struct TraceOffsets
+    {
+        uint32_t window_ms;    ///< "tr_win": sleep before the detecting measurement
+        uint32_t wifi_ms;      ///< "tr_wifi": Wi-Fi up
+        uint32_t time_sync_ms; ///< "tr_ntp": clock synchronized
+        uint32_t mqtt_ms;      ///< "tr_mqtt": broker connected
+        uint32_t publish_ms;   ///< "tr_pub": message handed to the MQTT client
+    };
+
+    /**
+     * One decoded Telemetry payload
+     *
+     * String fields point into the receive buffer, nothing is copied or
+     * allocated. Only fields whose bit is set in `fields` are valid; delta
+     * heartbeats ("kf":0) leave out everything that did not change.
+     */
+    struct Payload
+    {
+        uint32_t fields;                       ///< PayloadField bits present in the message
+        Span device_ip;                        ///< "device_ip"
+        Span timestamp;                        ///< "timestamp" (device local time, dd.mm.yyyy hh:mm:ss)
+        bool keyframe;                         ///< "kf" (status only)
+        float distance_cm;                     ///< "distance_cm"
+        float baseline_cm;                     ///< "baseline_cm"
+        float threshold_cm;                    ///< "threshold_cm" (status only)
+        float success_rate;                    ///< "success_rate"
+        float before_cm;                       ///< "before_cm" (mail_collected only)
+        float after_cm;                        ///< "after_cm" (mail_collected only)
+        float confidence;                      ///< "confidence" (mail_drop only)
+        uint32_t duration_ms;                  ///< "duration_ms" (events only)
+        Processor::MailboxState mailbox_state; ///< "mailbox_state" (status) or "new_state" (events)
+        uint32_t seq;                          ///< "seq" (device-unique, monotonic across power loss)
+        uint32_t wake;                         ///< "wake" (wakes since the last fresh boot)
+        uint32_t config_version;               ///< "cfg" (status only: applied runtime config version)
+        uint32_t battery_mv;                   ///< "batt_mv" (status only: smoothed battery voltage)
+        uint32_t battery_percent;              ///< "batt_pct" (status only: estimated remaining capacity)
+        Hardware::Battery::PowerLevel power;   ///< "power" (status only: power level the device runs at)
+        uint64_t detected_ms;                  ///< "t_det" (events only: wall-clock time of the detection, ms since the epoch)
+        TraceOffsets trace;                    ///< "tr_*" (events only)
+    };
+
+    /**
+     * Classify a topic below the subscribed base topic
+     *
+     * Strips the known suffix ("/status", "/events/mail_drop",
+     * "/events/mail_collected", "/config", "/ota/...") and returns the remainder as the device key,
+     * so both "home/mailbox/status" and "sim/mailbox/<id>/status" work.
+     */
+    MessageKind ClassifyTopic(const char *topic, size_t len, Span *device);
+
+    /**
+     * Parse a Telemetry JSON payload without allocating
+     *
+     * Accepts the flat objects produced by Telemetry (JsonWriter, or cJSON
+     * in older firmware; whitespace is tolerated). Unknown keys are skipped;
+     * nested objects or arrays, truncated input and malformed numbers are
+     * rejected.
+     */
+    bool ParsePayload(const char *data, size_t len, Payload *out);
+
+    // Map a state string ("empty", "has_mail", ...) to the firmware enum
+    bool ParseMailboxState(Span text, Processor::MailboxState *state);
+
+    // Map a power level string ("normal", "low", "critical") to the firmware enum
+    bool ParsePowerLevel(Span text, Hardware::Battery::PowerLevel *level);
+}
\ No newline at end of file
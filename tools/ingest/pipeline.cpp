@@ -0,0 +1,260 @@
+#include "pipeline.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace Ingest
+{
+    Pipeline::Pipeline(const PipelineParams &params, IngestMetrics &metrics)
+        : params_(params), metrics_(metrics), table_(params.table_capacity), running_(false),
+          sink_(nullptr),
+          wall_offset_us_(std::chrono::duration_cast<std::chrono::microseconds>(
+                              std::chrono::system_clock::now().time_since_epoch())
+                              .count() -
+                          NowUs())
+    {
+        params_.shards = std::max<uint32_t>(1, params_.shards);
+        for (uint32_t i = 0; i < params_.shards; ++i)
+            shards_.emplace_back(new Shard(i, params_.queue_depth));
+    }
+
+    Pipeline::~Pipeline() { Stop(); }
+
+    void Pipeline::Start()
+    {
+        if (running_.exchange(true))
+            return;
+
+        for (auto &shard : shards_)
+            shard->thread = std::thread([this, s = shard.get()]
+                                        { runShard(*s); });
+    }
+
+    void Pipeline::Stop()
+    {
+        if (!running_.exchange(false))
+            return;
+
+        for (auto &shard : shards_)
+            shard->thread.join();
+    }
+
+    int64_t Pipeline::NowUs()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    size_t Pipeline::QueueDepth() const
+    {
+        size_t depth = 0;
+        for (const auto &shard : shards_)
+            depth += shard->queue.Depth();
+        return depth;
+    }
+
+    bool Pipeline::Submit(const char *topic, size_t topic_len, const char *payload, size_t len, int64_t received_us)
+    {
+        Span device;
+        const MessageKind kind = ClassifyTopic(topic, topic_len, &device);
+        if (kind == MessageKind::UNKNOWN)
+        {
+            metrics_.unknown_topic++;
+            return true;
+        }
+        if (kind == MessageKind::CONFIG || kind == MessageKind::OTA)
+            return true; // Configuration and firmware updates sent to the devices, not telemetry
+        if (device.len + len > MAX_MESSAGE)
+        {
+            metrics_.oversized++;
+            return true;
+        }
+
+        const uint64_t hash = DeviceTable::Hash(device);
+        Shard &shard = *shards_[hash % shards_.size()];
+
+        const bool queued = shard.queue.TryPush(
+            [&](QueuedMessage &m)
+            {
+                m.received_us = received_us;
+                m.device_hash = hash;
+                m.kind = kind;
+                m.device_len = static_cast<uint16_t>(device.len);
+                m.payload_off = static_cast<uint16_t>(device.len);
+                m.payload_len = static_cast<uint16_t>(len);
+                memcpy(m.buf, device.data, device.len);
+                memcpy(m.buf + device.len, payload, len);
+                metrics_.received++; // Before the cell is visible, so applied never exceeds received
+            });
+
+        if (!queued)
+            metrics_.stalls++;
+        return queued;
+    }
+
+    void Pipeline::runShard(Shard &shard)
+    {
+        uint32_t idle = 0;
+        uint32_t processed = 0;
+        for (;;)
+        {
+            if (shard.queue.TryPop([this, &shard](const QueuedMessage &m)
+                                   { apply(shard, m); }))
+            {
+                if ((++processed & 0xff) == 0)
+                    shard.queue.PublishHead();
+                idle = 0;
+                continue;
+            }
+
+            shard.queue.PublishHead();
+            if (idle == 0 && sink_)
+                sink_->OnIdle(shard.index);
+            if (!running_.load(std::memory_order_relaxed))
+                return; // Queue drained
+
+            // Spin briefly, then back off so idle shards do not burn a core
+            if (++idle < 64)
+                std::this_thread::yield();
+            else
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+
+    bool Pipeline::isDuplicate(DeviceTable::Slot *slot, const Payload &payload)
+    {
+        // Firmware without sequence numbers cannot be deduplicated
+        if (!(payload.fields & FIELD_SEQ))
+        {
+            metrics_.unsequenced++;
+            return false;
+        }
+
+        switch (slot->window.Accept(payload.seq))
+        {
+        case SequenceWindow::Verdict::FRESH:
+            return false;
+        case SequenceWindow::Verdict::RESET:
+            metrics_.seq_resets++;
+            return false;
+        case SequenceWindow::Verdict::DUPLICATE:
+            metrics_.duplicates++;
+            return true;
+        case SequenceWindow::Verdict::STALE:
+            metrics_.stale++;
+            return true;
+        }
+        return false;
+    }
+
+    void Pipeline::apply(const Shard &shard, const QueuedMessage &m)
+    {
+        const Span device = {m.buf, m.device_len};
+        const char *payload_data = m.buf + m.payload_off;
+
+        Payload payload;
+        if (!ParsePayload(payload_data, m.payload_len, &payload))
+        {
+            metrics_.parse_errors++;
+            return;
+        }
+
+        DeviceTable::Slot *slot = table_.Acquire(device, m.device_hash);
+        if (!slot)
+        {
+            metrics_.rejected++;
+            return;
+        }
+
+        // A redelivered QoS 1 message carries the sequence number of the original
+        if (isDuplicate(slot, payload))
+            return;
+
+        // Events of firmware that traces them carry their timeline; the receive time closes it
+        uint32_t phases_ms[LATENCY_PHASES];
+        uint32_t phase_mask = 0;
+        bool skewed = false;
+        if (m.kind == MessageKind::MAIL_DROP || m.kind == MessageKind::MAIL_COLLECTED)
+            phase_mask = SplitLatency(payload, (m.received_us + wall_offset_us_) / 1000, phases_ms, &skewed);
+
+        DeviceState *state = DeviceTable::BeginWrite(slot);
+
+        if (payload.fields & FIELD_SEQ)
+            state->last_seq = payload.seq;
+        if (payload.fields & FIELD_WAKE)
+            state->wake = payload.wake;
+        if (payload.fields & FIELD_CONFIG)
+            state->config_version = payload.config_version;
+
+        if (payload.fields & FIELD_DEVICE_IP)
+        {
+            const size_t n = std::min<size_t>(payload.device_ip.len, sizeof(state->device_ip) - 1);
+            memcpy(state->device_ip, payload.device_ip.data, n);
+            state->device_ip[n] = '\0';
+        }
+        if (payload.fields & FIELD_STATE)
+            state->mailbox_state = payload.mailbox_state;
+        if (payload.fields & FIELD_BASELINE)
+            state->baseline_cm = payload.baseline_cm;
+        if (payload.fields & FIELD_SUCCESS_RATE)
+            state->success_rate = payload.success_rate;
+
+        switch (m.kind)
+        {
+        case MessageKind::STATUS:
+            if ((payload.fields & FIELD_KEYFRAME) && payload.keyframe)
+                state->has_keyframe = true;
+            else if (!state->has_keyframe)
+                metrics_.orphan_deltas++;
+            if (payload.fields & FIELD_DISTANCE)
+                state->distance_cm = payload.distance_cm;
+            if (payload.fields & FIELD_THRESHOLD)
+                state->threshold_cm = payload.threshold_cm;
+            if (payload.fields & FIELD_BATTERY_MV)
+                state->battery_mv = payload.battery_mv;
+            if (payload.fields & FIELD_BATTERY_PCT)
+                state->battery_percent = payload.battery_percent;
+            if (payload.fields & FIELD_POWER)
+                state->power = payload.power;
+            state->statuses++;
+            break;
+        case MessageKind::MAIL_DROP:
+            if (payload.fields & FIELD_DISTANCE)
+                state->distance_cm = payload.distance_cm;
+            state->mail_drops++;
+            break;
+        case MessageKind::MAIL_COLLECTED:
+            if (payload.fields & FIELD_AFTER)
+                state->distance_cm = payload.after_cm;
+            state->mail_collections++;
+            break;
+        default:
+            break;
+        }
+        state->last_seen_us = m.received_us;
+        if (phase_mask != 0)
+            state->latency.Record(phase_mask, phases_ms);
+
+        DeviceTable::EndWrite(slot);
+
+        if (phase_mask != 0)
+        {
+            metrics_.traced++;
+            if (skewed)
+                metrics_.clock_skew++;
+            for (size_t phase = 0; phase < LATENCY_PHASES; ++phase)
+            {
+                if (phase_mask & (1u << phase))
+                    metrics_.event_latency[phase].Record(static_cast<int64_t>(phases_ms[phase]) * 1000);
+            }
+        }
+
+        if (sink_)
+            sink_->OnApplied(shard.index, device, m.kind, payload, *state);
+
+        metrics_.applied++;
+        metrics_.lag.Record(NowUs() - m.received_us);
+    }
+}
\ No newline at end of file
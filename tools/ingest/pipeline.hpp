@@ -0,0 +1,118 @@
+#pragma once
+
+#include "device_table.hpp"
+#include "ingest_metrics.hpp"
+#include "ingest_queue.hpp"
+#include "payload_parser.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace Ingest
+{
+    struct PipelineParams
+    {
+        uint32_t shards;       ///< Worker threads; each owns the devices hashing to it
+        uint32_t queue_depth;  ///< Messages buffered per shard
+        size_t table_capacity; ///< Maximum number of distinct devices
+    };
+
+    // Receives every applied message, on the thread of the shard that applied it
+    class ApplySink
+    {
+    public:
+        virtual ~ApplySink() = default;
+
+        // Called after the message was applied; state is the device state including it
+        virtual void OnApplied(uint32_t shard, Span device, MessageKind kind, const Payload &payload,
+                               const DeviceState &state) = 0;
+
+        // Called when the shard's queue runs empty (a good moment to flush)
+        virtual void OnIdle(uint32_t shard) = 0;
+    };
+
+    /**
+     * Sharded ingestion pipeline
+     *
+     * Submit() classifies the topic, hashes the device key and copies the
+     * message into the queue of the shard that owns the device. Each shard
+     * worker parses its messages in place, drops QoS 1 redeliveries and applies
+     * the result to the shared DeviceTable, which it is the only writer for.
+     * Traced events are split into their latency phases against the time
+     * they were received, per device and fleet-wide.
+     */
+    class Pipeline
+    {
+    public:
+        static constexpr size_t MAX_MESSAGE = 480; ///< Topic + payload bytes that fit a queue cell
+
+        Pipeline(const PipelineParams &params, IngestMetrics &metrics);
+        ~Pipeline();
+
+        // Forward applied messages to a sink (set before Start)
+        void SetSink(ApplySink *sink) { sink_ = sink; }
+
+        // Start the shard workers
+        void Start();
+
+        // Drain the queues and join the shard workers
+        void Stop();
+
+        /**
+         * Hand one MQTT message to its shard (thread-safe, lock-free)
+         *
+         * Returns false only if the shard queue is full; the caller decides
+         * whether to retry (backpressure) or drop. Messages on unknown topics
+         * and oversized messages are counted and accepted.
+         */
+        bool Submit(const char *topic, size_t topic_len, const char *payload, size_t len, int64_t received_us);
+
+        // Latest state of every device
+        const DeviceTable &Devices() const { return table_; }
+
+        // Messages waiting in all shard queues
+        size_t QueueDepth() const;
+
+        // Monotonic time in microseconds used for receive and lag stamps
+        static int64_t NowUs();
+
+    private:
+        struct QueuedMessage
+        {
+            int64_t received_us;
+            uint64_t device_hash;
+            MessageKind kind;
+            uint16_t device_len;  ///< Device key is buf[0, device_len)
+            uint16_t payload_off; ///< Payload is buf[payload_off, payload_off + payload_len)
+            uint16_t payload_len;
+            char buf[MAX_MESSAGE];
+        };
+
+        struct Shard
+        {
+            Shard(uint32_t index, size_t depth) : index(index), queue(depth) {}
+
+            uint32_t index;
+            IngestQueue<QueuedMessage> queue;
+            std::thread thread;
+        };
+
+        PipelineParams params_;
+        IngestMetrics &metrics_;
+        DeviceTable table_;
+        std::vector<std::unique_ptr<Shard>> shards_;
+        std::atomic<bool> running_;
+        ApplySink *sink_;
+        int64_t wall_offset_us_; ///< Wall clock minus NowUs(), to date receive stamps for the event latency
+
+        void runShard(Shard &shard);
+        void apply(const Shard &shard, const QueuedMessage &message);
+
+        // Returns true if the message must be dropped (redelivered or too old), counting why
+        bool isDuplicate(DeviceTable::Slot *slot, const Payload &payload);
+    };
+}
\ No newline at end of file
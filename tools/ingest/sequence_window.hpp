@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace Ingest
+{
+    /**
+     * Sliding bitmap of the sequence numbers accepted from one device
+     *
+     * Keeps the highest sequence number seen and one bit for each of the
+     * WINDOW numbers up to it (the anti-replay window of IPsec/DTLS). A
+     * redelivered message finds its bit already set and is dropped; late but
+     * unseen messages inside the window are still accepted. Each check is
+     * O(1): advancing the window clears at most WINDOW / 64 + 1 words.
+     *
+     * Firmware sequence numbers never repeat, but NVS may be erased (reflash,
+     * factory reset). A number RESET_GAP or more below the highest is taken
+     * as such a restart; anything between is too old to tell and dropped.
+     */
+    class SequenceWindow
+    {
+    public:
+        static constexpr uint32_t WINDOW = 256;     ///< Sequence numbers tracked below the highest
+        static constexpr uint32_t RESET_GAP = 4096; ///< Step back that is treated as a device restart
+
+        enum class Verdict
+        {
+            FRESH,     ///< Not seen before: apply
+            DUPLICATE, ///< Already accepted: drop
+            STALE,     ///< Older than the window: drop
+            RESET      ///< Counter restarted: window rebuilt, apply
+        };
+
+        Verdict Accept(uint32_t seq)
+        {
+            if (!started_)
+            {
+                restart(seq);
+                return Verdict::FRESH;
+            }
+
+            if (seq > top_)
+            {
+                advance(seq);
+                return Verdict::FRESH;
+            }
+
+            const uint32_t behind = top_ - seq;
+            if (behind >= WINDOW)
+            {
+                if (behind < RESET_GAP)
+                    return Verdict::STALE;
+                restart(seq);
+                return Verdict::RESET;
+            }
+
+            uint64_t &word = bits_[(seq / 64) % WORDS];
+            const uint64_t mask = 1ULL << (seq % 64);
+            if (word & mask)
+                return Verdict::DUPLICATE;
+            word |= mask;
+            return Verdict::FRESH;
+        }
+
+        // Forget everything (next number starts a new window)
+        void Clear() { started_ = false; }
+
+    private:
+        // One spare word so the whole WINDOW below top stays addressable while top's word fills up
+        static constexpr uint32_t WORDS = WINDOW / 64 + 1;
+        static_assert(WINDOW % 64 == 0, "window must be whole words");
+
+        uint64_t bits_[WORDS]; ///< Bit (n % 64) of word (n / 64) % WORDS is set if n was accepted
+        uint32_t top_ = 0;     ///< Highest accepted sequence number
+        bool started_ = false;
+
+        void restart(uint32_t seq)
+        {
+            memset(bits_, 0, sizeof(bits_));
+            started_ = true;
+            top_ = seq;
+            bits_[(seq / 64) % WORDS] |= 1ULL << (seq % 64);
+        }
+
+        // Slide the window so seq becomes the highest number, clearing the bits it passes
+        void advance(uint32_t seq)
+        {
+            if (seq - top_ >= WINDOW)
+            {
+                memset(bits_, 0, sizeof(bits_));
+            }
+            else
+            {
+                // Words strictly after top's word up to seq's are reused for new numbers
+                const uint32_t top_word = top_ / 64;
+                const uint32_t seq_word = seq / 64;
+                for (uint32_t w = top_word + 1; w <= seq_word; ++w)
+                    bits_[w % WORDS] = 0;
+            }
+
+            top_ = seq;
+            bits_[(seq / 64) % WORDS] |= 1ULL << (seq % 64);
+        }
+    };
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "tsdb_sink.hpp"
+
+#include "tsdb/store.hpp"
+
+#include <chrono>
+
+namespace Ingest
+{
+    TsdbSink::TsdbSink(const std::string &dir, uint32_t shards, int64_t partition_ms, int64_t flush_interval_ms)
+        : ok_(Tsdb::Store::Create(dir, partition_ms)), flush_interval_ms_(flush_interval_ms)
+    {
+        for (uint32_t i = 0; i < shards; ++i)
+            writers_.push_back({std::make_unique<Tsdb::SegmentWriter>(dir, i, partition_ms), wallMs(), false});
+    }
+
+    int64_t TsdbSink::wallMs()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+    void TsdbSink::OnApplied(uint32_t shard, Span device, MessageKind kind, const Payload &payload,
+                             const DeviceState &state)
+    {
+        Tsdb::RowFields fields = {};
+        fields.kind = static_cast<uint8_t>(kind);
+        fields.mailbox_state = static_cast<uint8_t>(state.mailbox_state);
+        fields.keyframe = state.has_keyframe ? 1 : 0;
+        fields.distance_cm = state.distance_cm;
+        fields.baseline_cm = state.baseline_cm;
+        fields.threshold_cm = state.threshold_cm;
+        fields.success_rate = state.success_rate;
+        fields.confidence = (payload.fields & FIELD_CONFIDENCE) ? payload.confidence : 0.0f;
+        fields.duration_ms = (payload.fields & FIELD_DURATION) ? payload.duration_ms : 0;
+
+        Writer &writer = writers_[shard];
+        writer.segments->Append(wallMs(), device.data, device.len, fields);
+        writer.dirty = true;
+    }
+
+    void TsdbSink::OnIdle(uint32_t shard)
+    {
+        Writer &writer = writers_[shard];
+        if (!writer.dirty)
+            return;
+
+        const int64_t now_ms = wallMs();
+        if (now_ms - writer.last_flush_ms < flush_interval_ms_)
+            return;
+
+        writer.segments->Flush();
+        writer.last_flush_ms = now_ms;
+        writer.dirty = false;
+    }
+
+    void TsdbSink::Close()
+    {
+        for (Writer &writer : writers_)
+            writer.segments->Close();
+    }
+
+    uint64_t TsdbSink::BytesWritten() const
+    {
+        uint64_t total = 0;
+        for (const Writer &writer : writers_)
+            total += writer.segments->BytesWritten();
+        return total;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "pipeline.hpp"
+
+#include "tsdb/segment_writer.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Ingest
+{
+    /**
+     * Archives every applied message into the columnar store
+     *
+     * Each shard appends to its own SegmentWriter (writer id = shard index),
+     * so no locking is needed and segments of different shards are written
+     * in parallel. Partial blocks are flushed when a shard goes idle, at most
+     * once per flush interval, so quiet periods still reach disk without
+     * producing tiny blocks under load.
+     */
+    class TsdbSink : public ApplySink
+    {
+    public:
+        TsdbSink(const std::string &dir, uint32_t shards, int64_t partition_ms, int64_t flush_interval_ms);
+
+        // False if the store directory could not be prepared
+        bool Ok() const { return ok_; }
+
+        void OnApplied(uint32_t shard, Span device, MessageKind kind, const Payload &payload,
+                       const DeviceState &state) override;
+        void OnIdle(uint32_t shard) override;
+
+        // Flush and close all segments (call once the pipeline is stopped)
+        void Close();
+
+        // Compressed bytes written by all shards (after Close)
+        uint64_t BytesWritten() const;
+
+    private:
+        struct Writer
+        {
+            std::unique_ptr<Tsdb::SegmentWriter> segments;
+            int64_t last_flush_ms;
+            bool dirty;
+        };
+
+        bool ok_;
+        int64_t flush_interval_ms_;
+        std::vector<Writer> writers_;
+
+        static int64_t wallMs();
+    };
+}
\ No newline at end of file
@@ -0,0 +1,182 @@
+#include "corpus.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace Regress
+{
+    namespace
+    {
+        std::string trim(const std::string &s)
+        {
+            const size_t begin = s.find_first_not_of(" \t\r");
+            if (begin == std::string::npos)
+                return "";
+            const size_t end = s.find_last_not_of(" \t\r");
+            return s.substr(begin, end - begin + 1);
+        }
+
+        bool parseNumber(const std::string &value, double *out)
+        {
+            char *end = nullptr;
+            errno = 0;
+            *out = strtod(value.c_str(), &end);
+            return errno == 0 && !value.empty() && *end == '\0' && *out >= 0.0;
+        }
+
+        // "N" or "N-M"
+        bool parseRange(const std::string &value, uint32_t *first, uint32_t *last)
+        {
+            char *end = nullptr;
+            *first = strtoul(value.c_str(), &end, 10);
+            if (end == value.c_str())
+                return false;
+            *last = *first;
+            if (*end == '-')
+            {
+                const char *begin = end + 1;
+                *last = strtoul(begin, &end, 10);
+                if (end == begin)
+                    return false;
+            }
+            return *end == '\0' && *first <= *last;
+        }
+
+        // Entry line: kind name path key=value...
+        bool parseEntry(const std::string &line, const std::string &dir, CorpusEntry *entry, std::string *error)
+        {
+            std::istringstream words(line);
+            std::string kind, path;
+            words >> kind >> entry->name >> path;
+            if (path.empty())
+            {
+                *error = "expected: synthetic|recorded NAME PATH [key=value ...]";
+                return false;
+            }
+            if (kind == "synthetic")
+                entry->kind = EntryKind::SYNTHETIC;
+            else if (kind == "recorded")
+                entry->kind = EntryKind::RECORDED;
+            else
+            {
+                *error = "unknown entry kind '" + kind + "'";
+                return false;
+            }
+            entry->path = path[0] == '/' ? path : dir + "/" + path;
+            entry->first = 0;
+            entry->last = 0;
+            entry->max_sessions_per_day = 0.0;
+
+            for (std::string option; words >> option;)
+            {
+                const size_t eq = option.find('=');
+                const std::string key = option.substr(0, eq);
+                const std::string value = eq == std::string::npos ? "" : option.substr(eq + 1);
+                if (key == "traces" && entry->kind == EntryKind::SYNTHETIC)
+                {
+                    if (!parseRange(value, &entry->first, &entry->last))
+                    {
+                        *error = "bad trace range '" + value + "'";
+                        return false;
+                    }
+                }
+                else if (key == "max_sessions_per_day")
+                {
+                    if (!parseNumber(value, &entry->max_sessions_per_day))
+                    {
+                        *error = "bad session budget '" + value + "'";
+                        return false;
+                    }
+                }
+                else
+                {
+                    *error = "unknown option '" + option + "'";
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    bool LoadCorpus(const std::string &path, Corpus *corpus, std::string *error)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            *error = "cannot read " + path;
+            return false;
+        }
+        const size_t slash = path.find_last_of('/');
+        corpus->dir = slash == std::string::npos ? "." : path.substr(0, slash);
+        corpus->entries.clear();
+
+        std::string line;
+        for (int number = 1; std::getline(file, line); ++number)
+        {
+            const size_t comment = line.find('#');
+            if (comment != std::string::npos)
+                line.resize(comment);
+            line = trim(line);
+            if (line.empty())
+                continue;
+
+            const std::string where = path + ":" + std::to_string(number) + ": ";
+            const std::string first_word = line.substr(0, line.find_first_of(" \t"));
+            const size_t eq = line.find('=');
+            if (first_word != "synthetic" && first_word != "recorded")
+            {
+                if (eq == std::string::npos)
+                {
+                    *error = where + "expected key = value or an entry";
+                    return false;
+                }
+                const std::string key = trim(line.substr(0, eq));
+                const std::string value = trim(line.substr(eq + 1));
+                double parsed = 0.0;
+                if (!parseNumber(value, &parsed))
+                {
+                    *error = where + "bad value '" + value + "' for " + key;
+                    return false;
+                }
+                if (key == "version")
+                    corpus->version = static_cast<uint32_t>(parsed);
+                else if (key == "tolerance_s")
+                    corpus->tolerance_s = parsed;
+                else if (key == "max_cycles_per_sample")
+                    corpus->max_cycles_per_sample = parsed;
+                else
+                {
+                    *error = where + "unknown key '" + key + "'";
+                    return false;
+                }
+                continue;
+            }
+
+            CorpusEntry entry;
+            std::string message;
+            if (!parseEntry(line, corpus->dir, &entry, &message))
+            {
+                *error = where + message;
+                return false;
+            }
+            for (const CorpusEntry &other : corpus->entries)
+            {
+                if (other.name == entry.name)
+                {
+                    *error = where + "duplicate entry name '" + entry.name + "'";
+                    return false;
+                }
+            }
+            corpus->entries.push_back(entry);
+        }
+
+        if (corpus->version == 0)
+        {
+            *error = path + ": missing version";
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Regress
+{
+    enum class EntryKind : uint8_t
+    {
+        SYNTHETIC, ///< Traces generated from a scenario file
+        RECORDED   ///< A trace file converted from a device's diagnostic log
+    };
+
+    // One line of the manifest
+    struct CorpusEntry
+    {
+        EntryKind kind;
+        std::string name;              ///< Prefix of the golden files
+        std::string path;              ///< Scenario or trace file, resolved against the manifest directory
+        uint32_t first;                ///< Synthetic: first trace index
+        uint32_t last;                 ///< Synthetic: last trace index (inclusive)
+        double max_sessions_per_day;   ///< Radio session budget (0: unchecked)
+    };
+
+    /**
+     * Versioned corpus of traces with golden event sequences
+     *
+     * The manifest is "key = value" header lines followed by one entry per
+     * line, '#' starting a comment:
+     *
+     *   version = 3
+     *   tolerance_s = 30
+     *   max_cycles_per_sample = 2500
+     *   synthetic busy ../../trace_gen/scenarios/busy_summer.scn traces=0-3 max_sessions_per_day=40
+     *   recorded porch recorded/porch-2026-05.trace max_sessions_per_day=30
+     *
+     * version is written into every golden file; a golden of another
+     * version is stale and has to be regenerated.
+     */
+    struct Corpus
+    {
+        uint32_t version = 0;
+        double tolerance_s = 0.0;           ///< How far an event may move before it counts as changed
+        double max_cycles_per_sample = 0.0; ///< Wake logic budget per trace sample (0: unchecked)
+        std::string dir;                    ///< Directory of the manifest
+        std::vector<CorpusEntry> entries;
+    };
+
+    // false with a message naming the line if the manifest is unreadable or malformed
+    bool LoadCorpus(const std::string &path, Corpus *corpus, std::string *error);
+}
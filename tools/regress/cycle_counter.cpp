@@ -0,0 +1,114 @@
+#include "cycle_counter.hpp"
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+namespace Regress
+{
+    namespace
+    {
+        int openCycles()
+        {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+
+        uint64_t nowNs()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+    }
+
+    CycleCounter::CycleCounter() : source_(Source::NANOS), fd_(openCycles()), start_(0), count_(0)
+    {
+        if (fd_ >= 0)
+        {
+            source_ = Source::PERF;
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+        }
+#if defined(__x86_64__)
+        else
+        {
+            source_ = Source::TSC;
+        }
+#endif
+    }
+
+    CycleCounter::~CycleCounter()
+    {
+        if (fd_ >= 0)
+            close(fd_);
+    }
+
+    void CycleCounter::Start()
+    {
+        switch (source_)
+        {
+        case Source::PERF:
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+            break;
+#if defined(__x86_64__)
+        case Source::TSC:
+            start_ = __rdtsc();
+            break;
+#endif
+        default:
+            start_ = nowNs();
+            break;
+        }
+    }
+
+    void CycleCounter::Stop()
+    {
+        switch (source_)
+        {
+        case Source::PERF:
+        {
+            ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+            uint64_t value = 0;
+            if (read(fd_, &value, sizeof(value)) == sizeof(value))
+                count_ = value;
+            break;
+        }
+#if defined(__x86_64__)
+        case Source::TSC:
+            count_ += __rdtsc() - start_;
+            break;
+#endif
+        default:
+            count_ += nowNs() - start_;
+            break;
+        }
+    }
+
+    const char *CycleCounter::Unit() const
+    {
+        switch (source_)
+        {
+        case Source::PERF:
+            return "cycles";
+        case Source::TSC:
+            return "TSC cycles";
+        default:
+            return "ns";
+        }
+    }
+}
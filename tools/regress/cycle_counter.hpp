@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Regress
+{
+    /**
+     * CPU cycles spent by this thread between Start() and Stop()
+     *
+     * Uses the hardware cycle counter through perf_event_open (user space
+     * only). Where that is not available (containers, VMs without a PMU),
+     * falls back to the TSC on x86-64, which counts at the nominal clock
+     * whatever the actual one, and to nanoseconds elsewhere; Unit() says
+     * which.
+     */
+    class CycleCounter
+    {
+    public:
+        enum class Source : uint8_t
+        {
+            PERF, ///< Core cycles, user space
+            TSC,  ///< Time stamp counter ticks
+            NANOS ///< Not cycles: steady_clock nanoseconds
+        };
+
+        CycleCounter();
+        ~CycleCounter();
+
+        CycleCounter(const CycleCounter &) = delete;
+        CycleCounter &operator=(const CycleCounter &) = delete;
+
+        void Start();
+        void Stop();
+
+        // Counted so far, over all Start()/Stop() pairs
+        uint64_t Count() const { return count_; }
+
+        Source GetSource() const { return source_; }
+
+        // "cycles", "TSC cycles" or "ns"
+        const char *Unit() const;
+
+    private:
+        Source source_;
+        int fd_;         ///< perf event, -1 if not used
+        uint64_t start_; ///< TSC or ns at Start()
+        uint64_t count_;
+    };
+}
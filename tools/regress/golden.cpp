@@ -0,0 +1,208 @@
+#include "golden.hpp"
+
+#include <cinttypes>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+
+namespace Regress
+{
+    namespace
+    {
+        constexpr const char *GOLDEN_TAG = "# trace_regress golden events";
+
+        bool same(const Event &a, const Event &b, uint64_t tolerance_us)
+        {
+            const uint64_t apart = a.time_us > b.time_us ? a.time_us - b.time_us : b.time_us - a.time_us;
+            return a.kind == b.kind && a.state == b.state && apart <= tolerance_us;
+        }
+
+        // "day 3 14:02:11.250"
+        std::string formatTime(uint64_t time_us)
+        {
+            const uint64_t ms = time_us / 1000;
+            char text[48];
+            snprintf(text, sizeof(text), "day %" PRIu64 " %02u:%02u:%02u.%03u", ms / 86400000,
+                     static_cast<unsigned>(ms / 3600000 % 24), static_cast<unsigned>(ms / 60000 % 60),
+                     static_cast<unsigned>(ms / 1000 % 60), static_cast<unsigned>(ms % 1000));
+            return text;
+        }
+
+        void printLine(FILE *out, const DiffLine &line)
+        {
+            const Event &event = line.mark == '+' ? line.actual : line.golden;
+            fprintf(out, "  %c %s  %-10s %s", line.mark, formatTime(event.time_us).c_str(),
+                    EventKindToString(event.kind), StateToString(event.state));
+            if (line.mark == '~')
+            {
+                const double moved_s = (static_cast<double>(line.actual.time_us) - line.golden.time_us) / 1e6;
+                fprintf(out, " -> %s  %s (%+.1f s)", formatTime(line.actual.time_us).c_str(),
+                        StateToString(line.actual.state), moved_s);
+            }
+            fprintf(out, "\n");
+        }
+    }
+
+    bool WriteGolden(const std::string &path, const Golden &golden)
+    {
+        FILE *file = fopen(path.c_str(), "w");
+        if (!file)
+            return false;
+        fprintf(file, "%s\n", GOLDEN_TAG);
+        fprintf(file, "version %" PRIu32 "\n", golden.corpus_version);
+        fprintf(file, "seed 0x%016" PRIx64 "\n", golden.seed);
+        fprintf(file, "scenario_hash 0x%016" PRIx64 "\n", golden.scenario_hash);
+        fprintf(file, "events %zu\n", golden.events.size());
+        for (const Event &event : golden.events)
+            fprintf(file, "%" PRIu64 " %s %s\n", event.time_us, EventKindToString(event.kind),
+                    StateToString(event.state));
+        return fclose(file) == 0;
+    }
+
+    bool ReadGolden(const std::string &path, Golden *golden, std::string *error)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            *error = "cannot read " + path;
+            return false;
+        }
+
+        // Tag line, then "key value" lines up to the event count
+        std::string line, key, value;
+        bool header = std::getline(file, line) && line == GOLDEN_TAG;
+        const char *keys[] = {"version", "seed", "scenario_hash", "events"};
+        uint64_t values[std::size(keys)] = {};
+        for (size_t k = 0; header && k < std::size(keys); ++k)
+        {
+            char *end = nullptr;
+            header = (file >> key >> value) && key == keys[k];
+            values[k] = header ? strtoull(value.c_str(), &end, 0) : 0;
+            header = header && *end == '\0';
+        }
+        if (!header)
+        {
+            *error = path + ": not a golden events file";
+            return false;
+        }
+        golden->corpus_version = static_cast<uint32_t>(values[0]);
+        golden->seed = values[1];
+        golden->scenario_hash = values[2];
+        const size_t count = static_cast<size_t>(values[3]);
+
+        golden->events.clear();
+        golden->events.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            Event event = {};
+            std::string kind, state;
+            if (!(file >> event.time_us >> kind >> state) || !EventKindFromString(kind.c_str(), &event.kind) ||
+                !StateFromString(state.c_str(), &event.state))
+            {
+                *error = path + ": bad event " + std::to_string(i + 1);
+                return false;
+            }
+            golden->events.push_back(event);
+        }
+        return true;
+    }
+
+    Comparison Compare(const std::vector<Event> &golden, const std::vector<Event> &actual, uint64_t tolerance_us)
+    {
+        // lcs[i][j]: matches possible between golden[i..] and actual[j..]
+        const size_t n = golden.size();
+        const size_t m = actual.size();
+        std::vector<uint32_t> lcs((n + 1) * (m + 1), 0);
+        const auto at = [&](size_t i, size_t j) -> uint32_t & { return lcs[i * (m + 1) + j]; };
+        for (size_t i = n; i-- > 0;)
+            for (size_t j = m; j-- > 0;)
+                at(i, j) = same(golden[i], actual[j], tolerance_us) ? at(i + 1, j + 1) + 1
+                                                                   : std::max(at(i + 1, j), at(i, j + 1));
+
+        Comparison result;
+        std::vector<Event> lost;  ///< Golden events since the last match
+        std::vector<Event> found; ///< Actual events since the last match
+
+        // Settle the unmatched events between two matches
+        const auto flush = [&]()
+        {
+            std::vector<DiffLine> lines;
+            std::vector<bool> paired(found.size(), false);
+            for (const Event &g : lost)
+            {
+                DiffLine line = {'-', g, {}};
+                for (size_t k = 0; k < found.size(); ++k)
+                {
+                    if (!paired[k] && found[k].kind == g.kind)
+                    {
+                        paired[k] = true;
+                        line = {'~', g, found[k]};
+                        break;
+                    }
+                }
+                lines.push_back(line);
+            }
+            for (size_t k = 0; k < found.size(); ++k)
+                if (!paired[k])
+                    lines.push_back({'+', {}, found[k]});
+
+            std::stable_sort(lines.begin(), lines.end(),
+                             [](const DiffLine &a, const DiffLine &b)
+                             {
+                                 const uint64_t ta = a.mark == '+' ? a.actual.time_us : a.golden.time_us;
+                                 const uint64_t tb = b.mark == '+' ? b.actual.time_us : b.golden.time_us;
+                                 return ta < tb;
+                             });
+            for (const DiffLine &line : lines)
+            {
+                result.changed += line.mark == '~';
+                result.missing += line.mark == '-';
+                result.extra += line.mark == '+';
+                result.lines.push_back(line);
+            }
+            lost.clear();
+            found.clear();
+        };
+
+        size_t i = 0, j = 0;
+        while (i < n || j < m)
+        {
+            if (i < n && j < m && same(golden[i], actual[j], tolerance_us) && at(i, j) == at(i + 1, j + 1) + 1)
+            {
+                flush();
+                result.lines.push_back({' ', golden[i], actual[j]});
+                result.matched++;
+                ++i;
+                ++j;
+            }
+            else if (j == m || (i < n && at(i + 1, j) >= at(i, j + 1)))
+                lost.push_back(golden[i++]);
+            else
+                found.push_back(actual[j++]);
+        }
+        flush();
+        return result;
+    }
+
+    void PrintDiff(FILE *out, const Comparison &comparison, size_t context)
+    {
+        const std::vector<DiffLine> &lines = comparison.lines;
+        size_t printed = 0; ///< Lines before this one are printed
+        for (size_t k = 0; k < lines.size(); ++k)
+        {
+            if (lines[k].mark == ' ')
+                continue;
+            const size_t from = std::max(printed, k > context ? k - context : 0);
+            fprintf(out, "  @@ line %zu\n", from + 1);
+            // Print up to context unchanged lines after the last divergent one in this hunk
+            size_t to = k;
+            for (size_t quiet = 0; to + 1 < lines.size() && quiet < context; ++to)
+                quiet = lines[to + 1].mark == ' ' ? quiet + 1 : 0;
+            for (size_t l = from; l <= to; ++l)
+                printLine(out, lines[l]);
+            printed = to + 1;
+            k = to;
+        }
+    }
+}
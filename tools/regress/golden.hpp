@@ -0,0 +1,65 @@
+#pragma once
+
+#include "replay.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace Regress
+{
+    /**
+     * Expected events of one trace
+     *
+     * Stored as text, one "time_us kind STATE" line per event after a short
+     * header, so a change to the goldens reviews like any other diff. The
+     * header ties the events to the corpus version and to the trace they came
+     * from (seed and scenario hash); if either changed, the golden is stale.
+     */
+    struct Golden
+    {
+        uint32_t corpus_version;
+        uint64_t seed;
+        uint64_t scenario_hash;
+        std::vector<Event> events;
+    };
+
+    bool WriteGolden(const std::string &path, const Golden &golden);
+
+    // false with a message if the file is missing or malformed
+    bool ReadGolden(const std::string &path, Golden *golden, std::string *error);
+
+    // One line of an event diff
+    struct DiffLine
+    {
+        char mark;    ///< ' ' same, '~' moved beyond the tolerance or other state, '-' missing, '+' extra
+        Event golden; ///< ' ', '~', '-'
+        Event actual; ///< ' ', '~', '+'
+    };
+
+    struct Comparison
+    {
+        uint32_t matched = 0;
+        uint32_t changed = 0; ///< '~' lines
+        uint32_t missing = 0;
+        uint32_t extra = 0;
+        std::vector<DiffLine> lines; ///< Golden and actual merged in time order
+
+        bool Passed() const { return changed == 0 && missing == 0 && extra == 0; }
+    };
+
+    /**
+     * Align actual events against the golden ones
+     *
+     * Events match if they are of the same kind, lead to the same state and
+     * are at most tolerance_us apart; the alignment keeps both sequences in
+     * order and matches as many as possible (longest common subsequence).
+     * Between two matches, leftover golden and actual events of the same kind
+     * are paired up in order as changed; the rest are missing or extra.
+     */
+    Comparison Compare(const std::vector<Event> &golden, const std::vector<Event> &actual, uint64_t tolerance_us);
+
+    // Print the divergent lines with context lines around them, like a unified diff
+    void PrintDiff(FILE *out, const Comparison &comparison, size_t context);
+}
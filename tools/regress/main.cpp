@@ -0,0 +1,248 @@
+#include "corpus.hpp"
+#include "cycle_counter.hpp"
+#include "golden.hpp"
+#include "recorded.hpp"
+#include "replay.hpp"
+
+#include "trace_gen/generator.hpp"
+#include "trace_gen/scenario.hpp"
+#include "trace_gen/trace_file.hpp"
+
+#include "esp_log.h"
+
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+    void usage(const char *argv0)
+    {
+        printf("Usage: %s [options]\n"
+               "  --corpus FILE         corpus manifest (default tools/regress/corpus/manifest.txt)\n"
+               "  --filter TEXT         only entries whose name contains TEXT\n"
+               "  --update              write the goldens from this replay instead of comparing\n"
+               "  --context N           unchanged events shown around a divergence (default 3)\n"
+               "  --verbose             firmware log output down to INFO\n"
+               "  --import IMAGE        convert a diaglog partition image into a recorded trace (with --out)\n"
+               "  --out FILE            trace file written by --import\n",
+               argv0);
+    }
+
+    // One trace of an entry and where its golden lives
+    struct Case
+    {
+        std::string name;
+        std::string golden_path;
+        TraceGen::Trace trace;
+    };
+
+    // Load the traces of an entry; false with a message if a file is missing or broken
+    bool loadCases(const Regress::Corpus &corpus, const Regress::CorpusEntry &entry, std::vector<Case> *cases,
+                   std::string *error)
+    {
+        const std::string golden_dir = corpus.dir + "/golden/";
+        cases->clear();
+        if (entry.kind == Regress::EntryKind::RECORDED)
+        {
+            Case c = {entry.name, golden_dir + entry.name + ".events", {}};
+            if (!TraceGen::ReadTrace(entry.path, &c.trace))
+            {
+                *error = "cannot read trace " + entry.path;
+                return false;
+            }
+            cases->push_back(std::move(c));
+            return true;
+        }
+
+        TraceGen::Scenario scenario;
+        uint64_t scenario_hash = 0;
+        if (!TraceGen::LoadScenario(entry.path, &scenario, &scenario_hash, error))
+            return false;
+        for (uint32_t index = entry.first; index <= entry.last; ++index)
+        {
+            char name[256];
+            snprintf(name, sizeof(name), "%s-%05u", entry.name.c_str(), index);
+            Case c = {name, golden_dir + name + ".events", {}};
+            TraceGen::TraceGenerator generator(scenario, TraceGen::TraceSeed(scenario.seed, index));
+            generator.Generate(&c.trace);
+            c.trace.scenario_hash = scenario_hash;
+            cases->push_back(std::move(c));
+        }
+        return true;
+    }
+
+    int importImage(const char *image, const char *out)
+    {
+        TraceGen::Trace trace;
+        std::string error;
+        if (!Regress::ImportRingLog(image, &trace, &error))
+        {
+            fprintf(stderr, "[regress] %s\n", error.c_str());
+            return 1;
+        }
+        if (!TraceGen::WriteTrace(out, trace))
+        {
+            fprintf(stderr, "[regress] cannot write %s\n", out);
+            return 1;
+        }
+        printf("[regress] %s: %zu wakes over %.1f days -> %s\n", image, trace.samples.size(),
+               (trace.samples.back().time_us - trace.samples.front().time_us) / 86400e6, out);
+        return 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *corpus_path = "tools/regress/corpus/manifest.txt";
+    const char *filter = nullptr;
+    const char *import_image = nullptr;
+    const char *import_out = nullptr;
+    bool update = false;
+    bool verbose = false;
+    size_t context = 3;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        const auto need = [&]()
+        {
+            if (!value)
+            {
+                fprintf(stderr, "Missing value for %s\n", arg);
+                exit(2);
+            }
+            ++i;
+            return value;
+        };
+
+        if (!strcmp(arg, "--corpus"))
+            corpus_path = need();
+        else if (!strcmp(arg, "--filter"))
+            filter = need();
+        else if (!strcmp(arg, "--update"))
+            update = true;
+        else if (!strcmp(arg, "--context"))
+            context = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--verbose"))
+            verbose = true;
+        else if (!strcmp(arg, "--import"))
+            import_image = need();
+        else if (!strcmp(arg, "--out"))
+            import_out = need();
+        else
+        {
+            usage(argv[0]);
+            return !strcmp(arg, "--help") ? 0 : 2;
+        }
+    }
+
+    // The processor logs every event; only errors unless asked
+    esp_log_level_set("*", verbose ? ESP_LOG_INFO : ESP_LOG_ERROR);
+
+    if (import_image || import_out)
+    {
+        if (!import_image || !import_out)
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        return importImage(import_image, import_out);
+    }
+
+    Regress::Corpus corpus;
+    std::string error;
+    if (!Regress::LoadCorpus(corpus_path, &corpus, &error))
+    {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+    const std::string golden_dir = corpus.dir + "/golden";
+    if (update && mkdir(golden_dir.c_str(), 0755) != 0 && errno != EEXIST)
+    {
+        fprintf(stderr, "Cannot create %s: %s\n", golden_dir.c_str(), strerror(errno));
+        return 1;
+    }
+
+    const Regress::CycleCounter probe;
+    const bool check_cycles = corpus.max_cycles_per_sample > 0.0 &&
+                              probe.GetSource() != Regress::CycleCounter::Source::NANOS;
+    const uint64_t tolerance_us = static_cast<uint64_t>(corpus.tolerance_s * 1e6);
+    printf("[regress] corpus version %" PRIu32 ", tolerance %.0f s, cycle counter: %s%s%s\n", corpus.version,
+           corpus.tolerance_s, probe.Unit(), check_cycles ? "" : " (budget not checked)",
+           update ? ", updating goldens" : "");
+
+    uint32_t traces = 0;
+    uint32_t failed = 0;
+    std::vector<Case> cases;
+    for (const Regress::CorpusEntry &entry : corpus.entries)
+    {
+        if (filter && !strstr(entry.name.c_str(), filter))
+            continue;
+        if (!loadCases(corpus, entry, &cases, &error))
+        {
+            printf("[regress] %-20s FAIL  %s\n", entry.name.c_str(), error.c_str());
+            failed++;
+            continue;
+        }
+
+        for (const Case &c : cases)
+        {
+            traces++;
+            const Regress::ReplayResult result = Regress::Replay(c.trace);
+            const double sessions_per_day = result.days > 0.0 ? result.sessions / result.days : 0.0;
+            const double cycles_per_sample =
+                c.trace.samples.empty() ? 0.0 : static_cast<double>(result.cycles) / c.trace.samples.size();
+
+            std::vector<std::string> problems;
+            if (entry.max_sessions_per_day > 0.0 && sessions_per_day > entry.max_sessions_per_day)
+                problems.push_back("sessions/day over budget " + std::to_string(entry.max_sessions_per_day));
+            if (check_cycles && cycles_per_sample > corpus.max_cycles_per_sample)
+                problems.push_back("cycles/sample over budget " + std::to_string(corpus.max_cycles_per_sample));
+
+            Regress::Comparison comparison;
+            if (update)
+            {
+                const Regress::Golden golden = {corpus.version, c.trace.seed, c.trace.scenario_hash, result.events};
+                if (!Regress::WriteGolden(c.golden_path, golden))
+                    problems.push_back("cannot write " + c.golden_path);
+            }
+            else
+            {
+                Regress::Golden golden;
+                if (!Regress::ReadGolden(c.golden_path, &golden, &error))
+                    problems.push_back(error + " (run with --update)");
+                else if (golden.corpus_version != corpus.version || golden.seed != c.trace.seed ||
+                         golden.scenario_hash != c.trace.scenario_hash)
+                    problems.push_back("golden is stale: corpus version or trace changed (run with --update)");
+                else
+                {
+                    comparison = Regress::Compare(golden.events, result.events, tolerance_us);
+                    if (!comparison.Passed())
+                        problems.push_back(std::to_string(comparison.missing) + " missing, " +
+                                           std::to_string(comparison.extra) + " extra, " +
+                                           std::to_string(comparison.changed) + " changed events");
+                }
+            }
+
+            printf("[regress] %-20s %s  %5zu events  %6.1f sessions/day  %8.0f %s/sample  %" PRIu64 " suppressed\n",
+                   c.name.c_str(), problems.empty() ? "ok  " : "FAIL", result.events.size(), sessions_per_day,
+                   cycles_per_sample, probe.Unit(), result.suppressed);
+            for (const std::string &problem : problems)
+                printf("  %s\n", problem.c_str());
+            if (!comparison.Passed())
+                Regress::PrintDiff(stdout, comparison, context);
+            failed += !problems.empty();
+        }
+    }
+
+    printf("[regress] %u traces, %u failed\n", traces, failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,72 @@
+#include "recorded.hpp"
+
+#include "ringlog/file_flash.hpp"
+
+#include "diagnostics/ring_log.hpp"
+#include "diagnostics/wake_record.hpp"
+
+#include <cstring>
+
+namespace Regress
+{
+    namespace
+    {
+        struct ImportState
+        {
+            TraceGen::Trace *trace;
+            uint64_t offset_us; ///< Added to the virtual time of the current boot
+            uint64_t last_us;   ///< Time of the last sample
+        };
+
+        void addRecord(const Diagnostics::RecordHeader &header, const uint8_t *payload, void *arg)
+        {
+            ImportState *state = static_cast<ImportState *>(arg);
+            if (header.type != static_cast<uint8_t>(Diagnostics::RecordType::WAKE) ||
+                header.len != sizeof(Diagnostics::WakeRecord))
+                return;
+
+            Diagnostics::WakeRecord record;
+            memcpy(&record, payload, sizeof(record));
+            uint64_t time_us = state->offset_us + record.virtual_time_s * 1000000ULL;
+            if (!state->trace->samples.empty() && time_us <= state->last_us)
+            {
+                // A fresh boot restarted the virtual time: carry on one second after the last wake
+                state->offset_us = state->last_us + 1000000ULL - record.virtual_time_s * 1000000ULL;
+                time_us = state->last_us + 1000000ULL;
+            }
+            state->last_us = time_us;
+
+            const float distance_cm = record.raw_mm < 0 ? -1.0f : record.raw_mm / 10.0f;
+            state->trace->samples.push_back({time_us, distance_cm, -1.0f});
+        }
+    }
+
+    bool ImportRingLog(const std::string &image, TraceGen::Trace *trace, std::string *error)
+    {
+        RingLogTool::FileFlash flash(0);
+        if (!flash.Load(image.c_str()))
+        {
+            *error = "cannot read " + image;
+            return false;
+        }
+        Diagnostics::RingLogState log_state = {};
+        Diagnostics::RingLog log(&flash, &log_state);
+        if (!log.Available())
+        {
+            *error = image + " is too small for a ring log";
+            return false;
+        }
+
+        *trace = {};
+        ImportState state = {trace, 0, 0};
+        log.ForEach(addRecord, &state);
+        if (trace->samples.empty())
+        {
+            *error = image + " holds no wake records";
+            return false;
+        }
+        trace->seed = TraceGen::Fnv1a64(trace->samples.data(), trace->samples.size() * sizeof(TraceGen::TraceSample));
+        trace->scenario_hash = trace->seed;
+        return true;
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "trace_gen/trace_file.hpp"
+
+#include <string>
+
+namespace Regress
+{
+    /**
+     * Trace of the wake records in a diagnostic log image
+     *
+     * image is a diaglog partition read back with esptool (or written by the
+     * ringlog tool). Every WakeRecord becomes a sample at its virtual time
+     * with its raw distance; a device's virtual time starts over at a fresh
+     * boot, so later boots are shifted to follow the wakes before. Recorded
+     * traces have no ground truth: truth_cm is -1 and there are no labels.
+     * seed and scenario_hash are the FNV-1a of the samples, so a golden can
+     * tell when its trace was replaced.
+     */
+    bool ImportRingLog(const std::string &image, TraceGen::Trace *trace, std::string *error);
+}
@@ -0,0 +1,120 @@
+#include "replay.hpp"
+#include "cycle_counter.hpp"
+
+#include "config/config.hpp"
+#include "config/runtime_config.hpp"
+#include "processor/flap_damper.hpp"
+#include "telemetry/report_schedule.hpp"
+
+#include <cstring>
+#include <iterator>
+
+namespace Regress
+{
+    namespace
+    {
+        constexpr const char *EVENT_NAMES[] = {"drop", "collection", "obstructed", "clear"};
+        constexpr const char *STATE_NAMES[] = {"EMPTY", "HAS_MAIL", "FULL", "EMPTIED", "OBSTRUCTED"};
+        static_assert(std::size(EVENT_NAMES) == static_cast<size_t>(EventKind::COUNT), "one name per event kind");
+    }
+
+    ReplayResult Replay(const TraceGen::Trace &trace)
+    {
+        const Config::RuntimeConfig &config = Config::DEFAULT_RUNTIME_CONFIG;
+        const uint64_t interval_sec = config.heartbeat_interval_sec;
+        const uint64_t phase_sec = Config::HEARTBEAT_PHASE_SPREAD
+                                       ? Telemetry::PhaseOffsetSec(Config::MQTT_CLIENT_ID, interval_sec)
+                                       : interval_sec;
+
+        ReplayResult result = {};
+        if (!trace.samples.empty())
+            result.days = (trace.samples.back().time_us - trace.samples.front().time_us) / 86400e6;
+
+        Processor::Processor processor(config);
+        Processor::FlapState flap_state = {};
+        Processor::FlapDamper flap(&flap_state);
+        uint64_t last_heartbeat_sec = 0;
+        uint64_t next_wake_us = 0;
+
+        CycleCounter counter;
+        for (const TraceGen::TraceSample &sample : trace.samples)
+        {
+            if (sample.time_us < next_wake_us)
+                continue;
+            result.wakes++;
+
+            counter.Start();
+            Processor::DistanceData data = processor.Process(sample.distance_cm, sample.time_us);
+            const bool obstruction_changed = data.obstruction_changed;
+            const bool detected = data.mail_detected;
+            const bool collected = data.mail_collected;
+            if (Config::FLAP_DAMPING_ENABLED && flap.Record(data, sample.time_us))
+                result.suppressed++;
+
+            const uint64_t now_sec = sample.time_us / 1000000ULL;
+            const bool event = data.mail_detected || data.mail_collected || data.obstruction_changed;
+            const bool heartbeat = Telemetry::HeartbeatDue(now_sec, last_heartbeat_sec, interval_sec, phase_sec);
+            if (event || heartbeat || flap.ReportDue())
+            {
+                result.sessions++;
+                flap.Reported();
+                if (heartbeat)
+                    last_heartbeat_sec = now_sec;
+            }
+            next_wake_us = sample.time_us + Processor::SleepUs(processor.GetContext(), config.deep_sleep_us);
+            counter.Stop();
+
+            // What the processor raised, before flap damping holds any of it back
+            if (detected)
+                result.events.push_back({sample.time_us, EventKind::DROP, data.state});
+            if (collected)
+                result.events.push_back({sample.time_us, EventKind::COLLECTION, data.state});
+            if (obstruction_changed)
+                result.events.push_back({sample.time_us,
+                                         data.state == Processor::MailboxState::OBSTRUCTED ? EventKind::OBSTRUCTED
+                                                                                           : EventKind::CLEAR,
+                                         data.state});
+        }
+
+        result.cycles = counter.Count();
+        return result;
+    }
+
+    const char *EventKindToString(EventKind kind)
+    {
+        const size_t index = static_cast<size_t>(kind);
+        return index < std::size(EVENT_NAMES) ? EVENT_NAMES[index] : "unknown";
+    }
+
+    bool EventKindFromString(const char *name, EventKind *kind)
+    {
+        for (size_t i = 0; i < std::size(EVENT_NAMES); ++i)
+        {
+            if (!strcmp(name, EVENT_NAMES[i]))
+            {
+                *kind = static_cast<EventKind>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const char *StateToString(Processor::MailboxState state)
+    {
+        const size_t index = static_cast<size_t>(state);
+        return index < std::size(STATE_NAMES) ? STATE_NAMES[index] : "unknown";
+    }
+
+    bool StateFromString(const char *name, Processor::MailboxState *state)
+    {
+        for (size_t i = 0; i < std::size(STATE_NAMES); ++i)
+        {
+            if (!strcmp(name, STATE_NAMES[i]))
+            {
+                *state = static_cast<Processor::MailboxState>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+}
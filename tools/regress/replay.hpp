@@ -0,0 +1,63 @@
+#pragma once
+
+#include "trace_gen/trace_file.hpp"
+
+#include "processor/processor.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace Regress
+{
+    enum class EventKind : uint8_t
+    {
+        DROP,       ///< mail_detected
+        COLLECTION, ///< mail_collected
+        OBSTRUCTED, ///< obstruction_changed into OBSTRUCTED
+        CLEAR,      ///< obstruction_changed out of OBSTRUCTED
+        COUNT
+    };
+
+    // An event the processor raised, i.e. one that opens the radio
+    struct Event
+    {
+        uint64_t time_us;
+        EventKind kind;
+        Processor::MailboxState state; ///< State after the wake
+    };
+
+    struct ReplayResult
+    {
+        std::vector<Event> events;
+        uint64_t wakes;      ///< Samples the device woke for (fewer than the trace while obstructed)
+        uint64_t sessions;   ///< Wakes that turned the radio on
+        uint64_t suppressed; ///< Events held back by flap damping
+        double days;         ///< Virtual time covered by the trace
+        uint64_t cycles;     ///< CycleCounter count over all wakes
+    };
+
+    /**
+     * Run a trace through the wake logic of app_main
+     *
+     * Every wake runs Processor::Process, flap damping and the session
+     * decision of the default reporting mode: a session for every event, a
+     * due heartbeat (at this device's phase offset) or a flap report. All
+     * sessions are taken to reach the broker. While the processor is
+     * obstructed, samples inside the longer sleep (Processor::SleepUs) are
+     * skipped, as the device would not wake for them. The cycle counter runs
+     * over the wake logic only.
+     */
+    ReplayResult Replay(const TraceGen::Trace &trace);
+
+    // "drop", "collection", "obstructed", "clear"
+    const char *EventKindToString(EventKind kind);
+
+    // false for an unknown name
+    bool EventKindFromString(const char *name, EventKind *kind);
+
+    // "EMPTY", "HAS_MAIL", "FULL", "EMPTIED", "OBSTRUCTED"
+    const char *StateToString(Processor::MailboxState state);
+
+    // false for an unknown name
+    bool StateFromString(const char *name, Processor::MailboxState *state);
+}
@@ -0,0 +1,82 @@
+#include "chunk_decoder.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace RingLogTool
+{
+    bool DecodeChunk(const uint8_t *message, size_t len, DecodedChunk *chunk, std::string *error)
+    {
+        char text[128];
+        if (len < sizeof(Diagnostics::UploadChunkHeader))
+        {
+            *error = "chunk shorter than its header";
+            return false;
+        }
+        memcpy(&chunk->header, message, sizeof(chunk->header));
+        const Diagnostics::UploadChunkHeader &header = chunk->header;
+
+        chunk->records.resize(header.raw_len);
+        const int raw_len = Diagnostics::Lz4::Decompress(message + sizeof(header), len - sizeof(header),
+                                                         chunk->records.data(), chunk->records.size());
+        if (raw_len != header.raw_len)
+        {
+            snprintf(text, sizeof(text), "block of records %lu+ does not decompress to %u bytes",
+                     static_cast<unsigned long>(header.first_record), header.raw_len);
+            *error = text;
+            return false;
+        }
+
+        size_t offset = 0;
+        uint32_t count = 0;
+        while (offset < chunk->records.size())
+        {
+            Diagnostics::RecordHeader record;
+            if (chunk->records.size() - offset < sizeof(record))
+                break;
+            memcpy(&record, &chunk->records[offset], sizeof(record));
+            const uint32_t size = Diagnostics::RingLog::RecordSize(record.len);
+            if (record.seq != header.first_record + count || record.len > Diagnostics::RingLog::MAX_PAYLOAD ||
+                size > chunk->records.size() - offset ||
+                record.checksum != Diagnostics::RingLog::RecordChecksum(record, &chunk->records[offset + sizeof(record)]))
+                break;
+            offset += size;
+            count++;
+        }
+
+        if (offset != chunk->records.size() || count != header.records)
+        {
+            snprintf(text, sizeof(text), "chunk of records %lu+ holds %lu valid of %u records",
+                     static_cast<unsigned long>(header.first_record), static_cast<unsigned long>(count), header.records);
+            *error = text;
+            return false;
+        }
+        if (static_cast<int32_t>(header.first_record - header.expected_record) < 0)
+        {
+            snprintf(text, sizeof(text), "chunk starts at record %lu, before the expected %lu",
+                     static_cast<unsigned long>(header.first_record), static_cast<unsigned long>(header.expected_record));
+            *error = text;
+            return false;
+        }
+        return true;
+    }
+
+    uint32_t ForEachRecord(const DecodedChunk &chunk, uint32_t from_record, Diagnostics::RingLog::RecordVisitor visitor,
+                           void *arg)
+    {
+        uint32_t visited = 0;
+        size_t offset = 0;
+        while (offset < chunk.records.size())
+        {
+            Diagnostics::RecordHeader record;
+            memcpy(&record, &chunk.records[offset], sizeof(record));
+            if (static_cast<int32_t>(record.seq - from_record) >= 0)
+            {
+                visitor(record, &chunk.records[offset + sizeof(record)], arg);
+                visited++;
+            }
+            offset += Diagnostics::RingLog::RecordSize(record.len);
+        }
+        return visited;
+    }
+}
\ No newline at end of file
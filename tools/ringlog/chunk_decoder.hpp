@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "diagnostics/log_uploader.hpp"
+#include "diagnostics/ring_log.hpp"
+
+namespace RingLogTool
+{
+    // A {base}/diag/data message, decompressed and checked
+    struct DecodedChunk
+    {
+        Diagnostics::UploadChunkHeader header; ///< As sent
+        std::vector<uint8_t> records;          ///< The records as stored on flash
+    };
+
+    /**
+     * Decode one chunk of a log upload
+     *
+     * Decompresses the block and checks that it holds exactly
+     * header.records whole records, numbered on from header.first_record,
+     * each with a valid checksum. Returns false with *error set otherwise.
+     */
+    bool DecodeChunk(const uint8_t *message, size_t len, DecodedChunk *chunk, std::string *error);
+
+    // Visit the records of a decoded chunk from from_record on (earlier ones were already seen)
+    uint32_t ForEachRecord(const DecodedChunk &chunk, uint32_t from_record, Diagnostics::RingLog::RecordVisitor visitor,
+                           void *arg);
+}
\ No newline at end of file
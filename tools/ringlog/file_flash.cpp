@@ -0,0 +1,124 @@
+#include "file_flash.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace RingLogTool
+{
+    FileFlash::FileFlash(uint32_t size)
+        : image_(size / SECTOR_SIZE * SECTOR_SIZE, 0xFF),
+          wear_(size / SECTOR_SIZE, 0),
+          armed_(false),
+          cut_(false),
+          budget_(0),
+          read_bytes_(0),
+          programs_(0),
+          programmed_bytes_(0),
+          erases_(0)
+    {
+    }
+
+    bool FileFlash::Load(const char *path)
+    {
+        FILE *f = fopen(path, "rb");
+        if (!f)
+            return false;
+
+        std::vector<uint8_t> image;
+        uint8_t buf[65536];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+            image.insert(image.end(), buf, buf + n);
+        const bool ok = !ferror(f);
+        fclose(f);
+        if (!ok)
+            return false;
+
+        image.resize(image.size() / SECTOR_SIZE * SECTOR_SIZE);
+        image_.swap(image);
+        wear_.assign(image_.size() / SECTOR_SIZE, 0);
+        return true;
+    }
+
+    bool FileFlash::Save(const char *path) const
+    {
+        FILE *f = fopen(path, "wb");
+        if (!f)
+            return false;
+        const bool ok = fwrite(image_.data(), 1, image_.size(), f) == image_.size();
+        return fclose(f) == 0 && ok;
+    }
+
+    esp_err_t FileFlash::Read(uint32_t offset, void *buf, size_t len)
+    {
+        if (cut_)
+            return ESP_FAIL;
+        if (offset > image_.size() || len > image_.size() - offset)
+            return ESP_ERR_INVALID_ARG;
+
+        memcpy(buf, image_.data() + offset, len);
+        read_bytes_ += len;
+        return ESP_OK;
+    }
+
+    esp_err_t FileFlash::Write(uint32_t offset, const void *data, size_t len)
+    {
+        if (cut_)
+            return ESP_FAIL;
+        if (offset > image_.size() || len > image_.size() - offset)
+            return ESP_ERR_INVALID_ARG;
+
+        const size_t done = consume(len);
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        for (size_t i = 0; i < done; ++i)
+            image_[offset + i] &= bytes[i];
+
+        programs_++;
+        programmed_bytes_ += done;
+        return done == len ? ESP_OK : ESP_FAIL;
+    }
+
+    esp_err_t FileFlash::EraseSector(uint32_t offset)
+    {
+        if (cut_)
+            return ESP_FAIL;
+        if (offset % SECTOR_SIZE != 0 || offset >= image_.size())
+            return ESP_ERR_INVALID_ARG;
+
+        // A torn erase leaves the start of the sector erased and the rest as it was
+        const size_t done = consume(SECTOR_SIZE);
+        memset(image_.data() + offset, 0xFF, done);
+
+        erases_++;
+        wear_[offset / SECTOR_SIZE]++;
+        return done == SECTOR_SIZE ? ESP_OK : ESP_FAIL;
+    }
+
+    void FileFlash::CutAfter(uint64_t budget)
+    {
+        armed_ = true;
+        budget_ = budget;
+    }
+
+    void FileFlash::PowerOn()
+    {
+        armed_ = false;
+        cut_ = false;
+    }
+
+    size_t FileFlash::consume(size_t len)
+    {
+        if (!armed_)
+            return len;
+        if (budget_ > len)
+        {
+            budget_ -= len;
+            return len;
+        }
+
+        const size_t done = static_cast<size_t>(budget_);
+        armed_ = false;
+        cut_ = true;
+        return done;
+    }
+}
\ No newline at end of file
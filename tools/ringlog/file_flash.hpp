@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "diagnostics/ring_log.hpp"
+
+namespace RingLogTool
+{
+    /**
+     * NOR flash image in memory, for the ring log on the host
+     *
+     * Programming ANDs the data into the image (bits only go from 1 to 0),
+     * erasing sets a sector to 0xFF, like the SPI flash of the device.
+     *
+     * CutAfter() arms a power cut: once the given number of bytes has been
+     * programmed or erased, the operation in progress stops half way and
+     * every later operation fails until PowerOn().
+     */
+    class FileFlash : public Diagnostics::FlashIo
+    {
+    public:
+        // Blank (erased) flash of size bytes, rounded down to whole sectors
+        explicit FileFlash(uint32_t size);
+
+        // Replace the image with a file (e.g. a partition read back with esptool); false if unreadable
+        bool Load(const char *path);
+        bool Save(const char *path) const;
+
+        uint32_t Size() const override { return static_cast<uint32_t>(image_.size()); }
+        esp_err_t Read(uint32_t offset, void *buf, size_t len) override;
+        esp_err_t Write(uint32_t offset, const void *data, size_t len) override;
+        esp_err_t EraseSector(uint32_t offset) override;
+        const uint8_t *Data() override { return image_.data(); }
+
+        // Cut the power after budget more bytes of program/erase
+        void CutAfter(uint64_t budget);
+
+        // Power is back: operations work again and no cut is armed
+        void PowerOn();
+
+        bool IsCut() const { return cut_; }
+
+        uint64_t ReadBytes() const { return read_bytes_; }
+        uint64_t Programs() const { return programs_; }
+        uint64_t ProgrammedBytes() const { return programmed_bytes_; }
+        uint64_t Erases() const { return erases_; }
+
+        // Erase count per sector
+        const std::vector<uint32_t> &Wear() const { return wear_; }
+
+    private:
+        std::vector<uint8_t> image_;
+        std::vector<uint32_t> wear_; ///< Erases per sector
+        bool armed_;                 ///< A power cut is pending
+        bool cut_;                   ///< The power is cut
+        uint64_t budget_;            ///< Bytes left before the pending cut
+        uint64_t read_bytes_;        ///< Bytes read
+        uint64_t programs_;          ///< Program operations
+        uint64_t programmed_bytes_;  ///< Bytes programmed
+        uint64_t erases_;            ///< Sector erases
+
+        // Bytes of an operation of len bytes that complete before the cut (len if none)
+        size_t consume(size_t len);
+    };
+}
\ No newline at end of file
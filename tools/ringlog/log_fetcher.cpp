@@ -0,0 +1,186 @@
+#include "log_fetcher.hpp"
+
+#include "cJSON.h"
+
+#include <mosquitto.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+namespace RingLogTool
+{
+    LogFetcher::LogFetcher(const std::string &base_topic, uint32_t request_id, uint32_t from_record,
+                           Diagnostics::RingLog::RecordVisitor visitor, void *arg)
+        : base_topic_(base_topic), request_id_(request_id), visitor_(visitor), arg_(arg), next_record_(from_record)
+    {
+    }
+
+    LogFetcher::~LogFetcher() { Stop(); }
+
+    bool LogFetcher::Start(const char *host, int port, const char *client_id)
+    {
+        mosq_ = mosquitto_new(client_id, true, this);
+        if (!mosq_)
+        {
+            fprintf(stderr, "[fetch] failed to create client\n");
+            return false;
+        }
+        mosquitto_connect_callback_set(mosq_, onConnect);
+        mosquitto_message_callback_set(mosq_, onMessage);
+        mosquitto_publish_callback_set(mosq_, onPublish);
+        mosquitto_reconnect_delay_set(mosq_, 1, 10, false);
+
+        const int rc = mosquitto_connect_async(mosq_, host, port, 30);
+        if (rc != MOSQ_ERR_SUCCESS)
+            fprintf(stderr, "[fetch] connect to %s:%d failed: %s (retrying)\n", host, port, mosquitto_strerror(rc));
+        mosquitto_loop_start(mosq_);
+        return true;
+    }
+
+    void LogFetcher::Stop()
+    {
+        if (!mosq_)
+            return;
+
+        // A finished dump is withdrawn, an unfinished one stays requested from where it got to
+        const int mid = publishRequest(done_);
+        for (int i = 0; i < 100 && mid >= 0 && last_acked_ != mid; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+        mosquitto_disconnect(mosq_);
+        mosquitto_loop_stop(mosq_, false);
+        mosquitto_destroy(mosq_);
+        mosq_ = nullptr;
+    }
+
+    std::string LogFetcher::LastProgress() const
+    {
+        std::lock_guard<std::mutex> lock(progress_mutex_);
+        return progress_;
+    }
+
+    void LogFetcher::onConnect(struct mosquitto *mosq, void *arg, int rc)
+    {
+        auto *fetcher = static_cast<LogFetcher *>(arg);
+        if (rc != 0)
+        {
+            fprintf(stderr, "[fetch] connect refused: %s\n", mosquitto_connack_string(rc));
+            return;
+        }
+
+        const std::string data_topic = fetcher->base_topic_ + "/diag/data";
+        const std::string progress_topic = fetcher->base_topic_ + "/diag/progress";
+        mosquitto_subscribe(mosq, nullptr, data_topic.c_str(), 0);
+        mosquitto_subscribe(mosq, nullptr, progress_topic.c_str(), 0);
+        fetcher->publishRequest(false);
+    }
+
+    void LogFetcher::onMessage(struct mosquitto *, void *arg, const struct mosquitto_message *msg)
+    {
+        auto *fetcher = static_cast<LogFetcher *>(arg);
+        const size_t base_len = fetcher->base_topic_.size();
+        if (strncmp(msg->topic, fetcher->base_topic_.c_str(), base_len) != 0)
+            return;
+
+        const char *subtopic = msg->topic + base_len;
+        if (!strcmp(subtopic, "/diag/data"))
+            fetcher->handleChunk(static_cast<const uint8_t *>(msg->payload), msg->payloadlen);
+        else if (!strcmp(subtopic, "/diag/progress"))
+            fetcher->handleProgress(static_cast<const char *>(msg->payload), msg->payloadlen);
+    }
+
+    void LogFetcher::onPublish(struct mosquitto *, void *arg, int mid)
+    {
+        static_cast<LogFetcher *>(arg)->last_acked_ = mid;
+    }
+
+    int LogFetcher::publishRequest(bool clear)
+    {
+        const std::string topic = base_topic_ + "/diag/req";
+        char request[64];
+        // An empty retained message removes the request from the broker
+        const int len = clear ? 0
+                              : snprintf(request, sizeof(request), "{\"id\":%u,\"from\":%u}", request_id_,
+                                         static_cast<uint32_t>(next_record_));
+
+        int mid = -1;
+        if (mosquitto_publish(mosq_, &mid, topic.c_str(), len, clear ? nullptr : request, 1, true) != MOSQ_ERR_SUCCESS)
+            return -1;
+        return mid;
+    }
+
+    void LogFetcher::publishAck()
+    {
+        const std::string topic = base_topic_ + "/diag/ack";
+        char ack[64];
+        const int len = snprintf(ack, sizeof(ack), "{\"id\":%u,\"next\":%u}", request_id_,
+                                 static_cast<uint32_t>(next_record_));
+        mosquitto_publish(mosq_, nullptr, topic.c_str(), len, ack, 0, false);
+    }
+
+    void LogFetcher::handleChunk(const uint8_t *payload, int len)
+    {
+        std::string error;
+        if (!DecodeChunk(payload, static_cast<size_t>(std::max(len, 0)), &chunk_, &error))
+        {
+            ++rejected_;
+            fprintf(stderr, "[fetch] %s\n", error.c_str());
+            return;
+        }
+
+        const Diagnostics::UploadChunkHeader &header = chunk_.header;
+        if (header.request_id != request_id_)
+            return;
+
+        const uint32_t next = next_record_;
+        const uint32_t chunk_end = header.first_record + header.records;
+        if (static_cast<int32_t>(chunk_end - next) <= 0)
+        {
+            // Sent again after an acknowledgement went missing: say again how far this got
+            ++dropped_;
+            publishAck();
+            return;
+        }
+        if (static_cast<int32_t>(header.expected_record - next) > 0)
+        {
+            // Follows a chunk that never arrived; the device resends from the acknowledged record
+            ++dropped_;
+            return;
+        }
+
+        // The device went on from a record at or before this one: any between are overwritten on the device
+        if (static_cast<int32_t>(header.first_record - next) > 0)
+            lost_ += header.first_record - next;
+        records_ += ForEachRecord(chunk_, next, visitor_, arg_);
+        chunks_++;
+        raw_bytes_ += header.raw_len;
+        received_bytes_ += static_cast<uint64_t>(len);
+        next_record_ = chunk_end;
+        publishAck();
+    }
+
+    void LogFetcher::handleProgress(const char *payload, int len)
+    {
+        cJSON *root = cJSON_ParseWithLength(payload, static_cast<size_t>(std::max(len, 0)));
+        const cJSON *id = cJSON_GetObjectItemCaseSensitive(root, "id");
+        const cJSON *acked = cJSON_GetObjectItemCaseSensitive(root, "acked");
+        const cJSON *end = cJSON_GetObjectItemCaseSensitive(root, "end");
+        const bool ours = cJSON_IsNumber(id) && static_cast<uint32_t>(id->valuedouble) == request_id_;
+        const bool done = ours && cJSON_IsNumber(acked) && cJSON_IsNumber(end) && acked->valuedouble >= end->valuedouble;
+        cJSON_Delete(root);
+        if (!ours)
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock(progress_mutex_);
+            progress_.assign(payload, static_cast<size_t>(std::max(len, 0)));
+        }
+        if (done)
+            done_ = true;
+        else
+            publishRequest(false);
+    }
+}
\ No newline at end of file
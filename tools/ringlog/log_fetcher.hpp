@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "chunk_decoder.hpp"
+
+struct mosquitto;
+struct mosquitto_message;
+
+namespace RingLogTool
+{
+    /**
+     * Backend side of a diagnostic log dump over MQTT
+     *
+     * Publishes the retained request on {base}/diag/req, takes the chunks
+     * from {base}/diag/data and acknowledges on {base}/diag/ack (see
+     * main/diagnostics/log_uploader.hpp). Every new record goes to the
+     * visitor, in order and once. A chunk that does not continue from the
+     * last record received (one before it was lost) is dropped; the device
+     * goes back to the acknowledged record when the acknowledgements stop
+     * moving.
+     *
+     * Each {base}/diag/progress of the device moves "from" in the retained
+     * request up, so a device that lost power resumes where this left off.
+     * Stop() clears the request once the dump is complete.
+     */
+    class LogFetcher
+    {
+    public:
+        LogFetcher(const std::string &base_topic, uint32_t request_id, uint32_t from_record,
+                   Diagnostics::RingLog::RecordVisitor visitor, void *arg);
+        ~LogFetcher();
+
+        bool Start(const char *host, int port, const char *client_id);
+        void Stop();
+
+        // The device reported the whole dump acknowledged
+        bool Done() const { return done_; }
+
+        uint32_t NextRecord() const { return next_record_; }
+        uint64_t Records() const { return records_; }
+        uint64_t Chunks() const { return chunks_; }
+        uint64_t Lost() const { return lost_; }
+        uint64_t Dropped() const { return dropped_; }
+        uint64_t Rejected() const { return rejected_; }
+        uint64_t RawBytes() const { return raw_bytes_; }
+        uint64_t ReceivedBytes() const { return received_bytes_; }
+
+        // Last {base}/diag/progress of the device (empty if none yet)
+        std::string LastProgress() const;
+
+    private:
+        std::string base_topic_;
+        uint32_t request_id_;
+        Diagnostics::RingLog::RecordVisitor visitor_;
+        void *arg_;
+        struct mosquitto *mosq_ = nullptr;
+        DecodedChunk chunk_; ///< Scratch for the message thread
+
+        std::atomic<uint32_t> next_record_; ///< Every record before this one was received
+        std::atomic<bool> done_{false};
+        std::atomic<uint64_t> records_{0};        ///< Records passed to the visitor
+        std::atomic<uint64_t> chunks_{0};         ///< Chunks accepted
+        std::atomic<uint64_t> lost_{0};           ///< Records the ring overwrote before they went out
+        std::atomic<uint64_t> dropped_{0};        ///< Chunks that did not continue the dump (resent or ahead of a loss)
+        std::atomic<uint64_t> rejected_{0};       ///< Chunks that failed to decode or check
+        std::atomic<uint64_t> raw_bytes_{0};      ///< Record bytes accepted
+        std::atomic<uint64_t> received_bytes_{0}; ///< Message bytes of the accepted chunks
+        std::atomic<int> last_acked_{-1};
+
+        mutable std::mutex progress_mutex_;
+        std::string progress_;
+
+        static void onConnect(struct mosquitto *mosq, void *arg, int rc);
+        static void onMessage(struct mosquitto *mosq, void *arg, const struct mosquitto_message *msg);
+        static void onPublish(struct mosquitto *mosq, void *arg, int mid);
+
+        // Publish (or clear) the retained request from next_record_, returns the message ID (-1 if not queued)
+        int publishRequest(bool clear);
+        void publishAck();
+        void handleChunk(const uint8_t *payload, int len);
+        void handleProgress(const char *payload, int len);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,662 @@
+#include "chunk_decoder.hpp"
+#include "file_flash.hpp"
+#include "log_fetcher.hpp"
+
+#include "diagnostics/log_uploader.hpp"
+#include "diagnostics/ring_log.hpp"
+#include "diagnostics/wake_record.hpp"
+#include "esp_log.h"
+
+#include <mosquitto.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Typical timings of the SPI NOR flash on ESP32-C3 modules
+    constexpr double PAGE_PROGRAM_US = 700.0;    // Per 256-byte page
+    constexpr double SECTOR_ERASE_US = 45000.0;  // Per 4 KB sector
+    constexpr uint32_t PAGE_SIZE = 256;
+    constexpr uint32_t DEFAULT_SIZE = 0x40000;   // diaglog in partitions.csv
+    constexpr uint8_t TEST_RECORD = 0x7E;
+
+    std::atomic<bool> g_stop{false};
+
+    void usage(const char *argv0)
+    {
+        printf("Usage: %s create | dump | bench | powercut | upload | fetch [options]\n"
+               "Commands:\n"
+               "  create                write an erased log image to --image\n"
+               "  dump                  print the wake records of --image (a diaglog partition read with esptool)\n"
+               "  bench                 append wake records and report the modeled append latency and wear\n"
+               "  powercut              cut the power at random points and check the log after each recovery\n"
+               "  upload                build the upload chunks of a full log and report their size and integrity\n"
+               "  fetch                 request a dump from a device over MQTT and print the records it uploads\n"
+               "Options:\n"
+               "  --image FILE          log image (create/dump)\n"
+               "  --size BYTES          size of the log area (default 0x40000)\n"
+               "  --records N           bench/upload: records to append (default 100000)\n"
+               "  --session-every N     bench: wakes per radio session that erases ahead, 0 = never (default 10)\n"
+               "  --rounds N            powercut: power cuts to survive (default 2000)\n"
+               "  --seed N              powercut: random seed (default 1)\n"
+               "  --host HOST           fetch: MQTT broker host (default 127.0.0.1)\n"
+               "  --port PORT           fetch: MQTT broker port (default 1883)\n"
+               "  --base-topic TOPIC    fetch: device base topic (default home/mailbox)\n"
+               "  --client-id ID        fetch: MQTT client ID (default mailbox-diag)\n"
+               "  --id N                fetch: dump ID, a new one for every dump (default: the time)\n"
+               "  --from N              fetch: first record wanted (default 0: the oldest still stored)\n"
+               "  --out FILE            fetch: write the records here instead of stdout\n",
+               argv0);
+    }
+
+    /**
+     * Payload of test record seq, written by append attempt number attempt
+     *
+     * Length and content follow from seq and attempt, and attempt is stored
+     * in the payload. A record retried after a power cut differs from the
+     * torn attempt, so writing it over the torn bytes would not go unnoticed.
+     */
+    size_t testPayload(uint32_t seq, uint32_t attempt, uint8_t *out)
+    {
+        const size_t len = 8 + (seq * 37u) % (Diagnostics::RingLog::MAX_PAYLOAD - 7);
+        memcpy(out, &seq, sizeof(seq));
+        memcpy(out + sizeof(seq), &attempt, sizeof(attempt));
+        for (size_t i = sizeof(seq) + sizeof(attempt); i < len; ++i)
+            out[i] = static_cast<uint8_t>(seq * 31u + attempt * 13u + i * 7u + (seq >> 8));
+        return len;
+    }
+
+    double modelUs(uint64_t programmed_bytes, uint64_t programs, uint64_t erases)
+    {
+        const uint64_t pages = programs + programmed_bytes / PAGE_SIZE;
+        return static_cast<double>(pages) * PAGE_PROGRAM_US + static_cast<double>(erases) * SECTOR_ERASE_US;
+    }
+
+    int create(const char *image_path, uint32_t size)
+    {
+        RingLogTool::FileFlash flash(size);
+        if (!flash.Save(image_path))
+        {
+            fprintf(stderr, "[ringlog] cannot write %s\n", image_path);
+            return 1;
+        }
+        printf("[ringlog] %s: %lu sectors erased\n", image_path,
+               static_cast<unsigned long>(flash.Size() / Diagnostics::FlashIo::SECTOR_SIZE));
+        return 0;
+    }
+
+    // Print one record to the FILE * in arg
+    void printRecord(const Diagnostics::RecordHeader &header, const uint8_t *payload, void *arg)
+    {
+        FILE *out = static_cast<FILE *>(arg);
+        if (header.type != static_cast<uint8_t>(Diagnostics::RecordType::WAKE) ||
+            header.len != sizeof(Diagnostics::WakeRecord))
+        {
+            fprintf(out, "%10lu  type %u, %u bytes\n", static_cast<unsigned long>(header.seq), header.type,
+                    header.len);
+            return;
+        }
+
+        Diagnostics::WakeRecord record;
+        memcpy(&record, payload, sizeof(record));
+        fprintf(out, "%10lu  wake %-8lu t %-9lu boot %6.2f ms  awake %5u ms  %4u mV  raw %6.1f  filtered %6.1f cm  state %u  %s%s%s%s%s%s\n",
+                static_cast<unsigned long>(header.seq), static_cast<unsigned long>(record.wake),
+                static_cast<unsigned long>(record.virtual_time_s), record.boot_10us / 100.0, record.awake_ms,
+                record.battery_mv, record.raw_mm / 10.0, record.filtered_mm / 10.0, record.state,
+                (record.flags & Diagnostics::WAKE_FRESH_BOOT) ? "boot " : "",
+                (record.flags & Diagnostics::WAKE_MAIL_DETECTED) ? "drop " : "",
+                (record.flags & Diagnostics::WAKE_MAIL_COLLECTED) ? "collect " : "",
+                (record.flags & Diagnostics::WAKE_SUPPRESSED) ? "suppressed " : "",
+                (record.flags & Diagnostics::WAKE_SESSION) ? "session " : "",
+                (record.flags & Diagnostics::WAKE_CONNECTED) ? "connected" : "");
+    }
+
+    int dump(const char *image_path)
+    {
+        RingLogTool::FileFlash flash(0);
+        if (!flash.Load(image_path))
+        {
+            fprintf(stderr, "[ringlog] cannot read %s\n", image_path);
+            return 1;
+        }
+
+        Diagnostics::RingLogState state = {};
+        Diagnostics::RingLog log(&flash, &state);
+        if (!log.Available())
+        {
+            fprintf(stderr, "[ringlog] %s is too small for a ring log\n", image_path);
+            return 1;
+        }
+
+        const uint32_t records = log.ForEach(printRecord, stdout);
+        printf("[ringlog] %lu records\n", static_cast<unsigned long>(records));
+        return 0;
+    }
+
+    int bench(uint32_t size, uint32_t records, uint32_t session_every)
+    {
+        RingLogTool::FileFlash flash(size);
+        Diagnostics::RingLogState state = {};
+        Diagnostics::RingLog log(&flash, &state);
+        if (!log.Available())
+        {
+            fprintf(stderr, "[ringlog] %lu bytes is too small for a ring log\n", static_cast<unsigned long>(size));
+            return 1;
+        }
+        log.Recover();
+
+        std::vector<double> latency;
+        latency.reserve(records);
+        for (uint32_t wake = 0; wake < records; ++wake)
+        {
+            // A session waits for the broker anyway; idle_wait() erases ahead meanwhile
+            if (session_every > 0 && wake % session_every == 0)
+                log.EraseAhead(Diagnostics::RingLog::ERASE_AHEAD_SECTORS);
+
+            Diagnostics::WakeRecord record = {};
+            record.wake = wake;
+            record.virtual_time_s = wake * 30;
+            record.flags = (session_every > 0 && wake % session_every == 0) ? Diagnostics::WAKE_SESSION : 0;
+
+            const uint64_t programmed = flash.ProgrammedBytes();
+            const uint64_t programs = flash.Programs();
+            const uint64_t erases = flash.Erases();
+            if (log.Append(static_cast<uint8_t>(Diagnostics::RecordType::WAKE), &record, sizeof(record)) != ESP_OK)
+            {
+                fprintf(stderr, "[ringlog] append %lu failed\n", static_cast<unsigned long>(wake));
+                return 1;
+            }
+            latency.push_back(modelUs(flash.ProgrammedBytes() - programmed, flash.Programs() - programs,
+                                      flash.Erases() - erases));
+        }
+
+        std::sort(latency.begin(), latency.end());
+        const auto percentile = [&](double p)
+        { return latency[static_cast<size_t>(p * (latency.size() - 1))]; };
+
+        const auto wear = std::minmax_element(flash.Wear().begin(), flash.Wear().end());
+        const double writes_per_record = static_cast<double>(flash.Programs()) / records;
+        printf("[ringlog] %lu records, %lu sectors, session every %lu wakes\n", static_cast<unsigned long>(records),
+               static_cast<unsigned long>(flash.Size() / Diagnostics::FlashIo::SECTOR_SIZE),
+               static_cast<unsigned long>(session_every));
+        printf("[ringlog] append latency (modeled) p50 %.1f ms  p99 %.1f ms  p99.9 %.1f ms  max %.1f ms\n",
+               percentile(0.50) / 1000.0, percentile(0.99) / 1000.0, percentile(0.999) / 1000.0,
+               latency.back() / 1000.0);
+        printf("[ringlog] %.2f programs/record, %lu inline erases, %llu erases in total, wear per sector %lu..%lu\n",
+               writes_per_record, static_cast<unsigned long>(state.inline_erases),
+               static_cast<unsigned long long>(flash.Erases()), static_cast<unsigned long>(*wear.first),
+               static_cast<unsigned long>(*wear.second));
+
+        // Recovery from a full ring, as after a battery swap
+        const uint64_t read_bytes = flash.ReadBytes();
+        const uint32_t next_record = state.next_record;
+        state = {};
+        log.Recover();
+        printf("[ringlog] recovery read %llu bytes (%lu us on the host), next record %lu %s\n",
+               static_cast<unsigned long long>(flash.ReadBytes() - read_bytes), static_cast<unsigned long>(state.recover_us),
+               static_cast<unsigned long>(state.next_record), state.next_record == next_record ? "(ok)" : "(MISMATCH)");
+        return state.next_record == next_record ? 0 : 1;
+    }
+
+    // What a walk over the records after a recovery found
+    struct Check
+    {
+        bool any;         ///< At least one record
+        uint32_t oldest;  ///< Sequence number of the oldest record
+        uint32_t newest;  ///< Sequence number of the newest record
+        uint32_t count;   ///< Records visited
+        char error[160];  ///< First problem found, empty if none
+    };
+
+    void checkRecord(const Diagnostics::RecordHeader &header, const uint8_t *payload, void *arg)
+    {
+        Check *check = static_cast<Check *>(arg);
+        if (check->error[0])
+            return;
+
+        uint32_t attempt = 0;
+        if (header.len >= 8)
+            memcpy(&attempt, payload + 4, sizeof(attempt));
+        uint8_t expected[Diagnostics::RingLog::MAX_PAYLOAD];
+        const size_t len = testPayload(header.seq, attempt, expected);
+        if (check->any && header.seq != check->newest + 1)
+            snprintf(check->error, sizeof(check->error), "record %lu follows %lu", static_cast<unsigned long>(header.seq),
+                     static_cast<unsigned long>(check->newest));
+        else if (header.type != TEST_RECORD || header.len != len || memcmp(payload, expected, len) != 0)
+            snprintf(check->error, sizeof(check->error), "record %lu has the wrong content",
+                     static_cast<unsigned long>(header.seq));
+
+        if (!check->any)
+            check->oldest = header.seq;
+        check->any = true;
+        check->newest = header.seq;
+        check->count++;
+    }
+
+    int powercut(uint32_t size, uint32_t rounds, uint64_t seed)
+    {
+        RingLogTool::FileFlash flash(size);
+        Diagnostics::RingLogState state = {};
+        Diagnostics::RingLog log(&flash, &state);
+        if (!log.Available())
+        {
+            fprintf(stderr, "[powercut] %lu bytes is too small for a ring log\n", static_cast<unsigned long>(size));
+            return 1;
+        }
+        log.Recover();
+
+        std::mt19937_64 rng(seed);
+        bool any_acked = false;
+        uint32_t acked = 0;       // Newest record whose append returned ESP_OK
+        uint64_t appended = 0;
+        uint32_t attempts = 0;
+        uint32_t max_recover_read = 0;
+        uint8_t payload[Diagnostics::RingLog::MAX_PAYLOAD];
+
+        for (uint32_t round = 0; round < rounds; ++round)
+        {
+            // Anywhere from the next record to a few sectors further, erases included
+            flash.CutAfter(rng() % (4 * Diagnostics::FlashIo::SECTOR_SIZE));
+            while (!flash.IsCut())
+            {
+                if (rng() % 16 == 0)
+                    log.EraseAhead(1 + rng() % 3);
+                if (flash.IsCut())
+                    break;
+
+                const uint32_t seq = state.next_record;
+                const size_t len = testPayload(seq, attempts++, payload);
+                if (log.Append(TEST_RECORD, payload, len) == ESP_OK)
+                {
+                    any_acked = true;
+                    acked = seq;
+                    appended++;
+                }
+            }
+
+            // Power back: RTC memory is gone, the head is found on flash
+            flash.PowerOn();
+            state = {};
+            const uint64_t read_bytes = flash.ReadBytes();
+            log.Recover();
+            max_recover_read = std::max(max_recover_read, static_cast<uint32_t>(flash.ReadBytes() - read_bytes));
+
+            Check check = {};
+            log.ForEach(checkRecord, &check);
+            if (!check.error[0] && any_acked)
+            {
+                // A record torn only in its padding is complete, so the newest may be one past the acked one
+                if (!check.any || static_cast<int32_t>(check.newest - acked) < 0 || check.newest - acked > 1)
+                    snprintf(check.error, sizeof(check.error), "newest record is %lu, %lu was acknowledged",
+                             static_cast<unsigned long>(check.newest), static_cast<unsigned long>(acked));
+                else if (state.next_record != check.newest + 1)
+                    snprintf(check.error, sizeof(check.error), "next record %lu after newest %lu",
+                             static_cast<unsigned long>(state.next_record), static_cast<unsigned long>(check.newest));
+            }
+
+            // Appends go on right after the recovery
+            const uint32_t seq = state.next_record;
+            const size_t len = testPayload(seq, attempts++, payload);
+            if (!check.error[0] && log.Append(TEST_RECORD, payload, len) != ESP_OK)
+                snprintf(check.error, sizeof(check.error), "append after recovery failed");
+            any_acked = true;
+            acked = seq;
+            appended++;
+
+            if (check.error[0])
+            {
+                printf("[powercut] round %lu: %s\n", static_cast<unsigned long>(round), check.error);
+                return 1;
+            }
+        }
+
+        Check check = {};
+        log.ForEach(checkRecord, &check);
+        const auto wear = std::minmax_element(flash.Wear().begin(), flash.Wear().end());
+        printf("[powercut] %lu power cuts survived, %llu records appended, %lu in the ring (%lu..%lu)\n",
+               static_cast<unsigned long>(rounds), static_cast<unsigned long long>(appended),
+               static_cast<unsigned long>(check.count), static_cast<unsigned long>(check.oldest),
+               static_cast<unsigned long>(check.newest));
+        printf("[powercut] recovery read at most %lu bytes, wear per sector %lu..%lu\n",
+               static_cast<unsigned long>(max_recover_read), static_cast<unsigned long>(*wear.first),
+               static_cast<unsigned long>(*wear.second));
+        return check.error[0] ? 1 : 0;
+    }
+
+    // Wake record number wake of a plausible deployment, for the upload figures
+    Diagnostics::WakeRecord makeWakeRecord(uint32_t wake)
+    {
+        std::mt19937 rng(wake);
+        Diagnostics::WakeRecord record = {};
+        record.wake = wake;
+        record.virtual_time_s = wake * 30;
+        record.awake_ms = static_cast<uint16_t>(38 + rng() % 6 + (wake % 10 == 0 ? 900 + rng() % 400 : 0));
+        record.battery_mv = static_cast<uint16_t>(4100 - wake / 200);
+        record.raw_mm = static_cast<int16_t>(420 + rng() % 5 - (wake % 500 > 400 ? 180 : 0));
+        record.filtered_mm = static_cast<int16_t>(422 - (wake % 500 > 402 ? 180 : 0));
+        record.state = wake % 500 > 402 ? 1 : 0;
+        record.flags = static_cast<uint8_t>((wake % 10 == 0 ? Diagnostics::WAKE_SESSION | Diagnostics::WAKE_CONNECTED : 0) |
+                                            (wake % 500 == 403 ? Diagnostics::WAKE_MAIL_DETECTED : 0));
+        return record;
+    }
+
+    // The backend side of an upload, in process: follows the chunks like LogFetcher does
+    struct Receiver
+    {
+        uint32_t next;    ///< Every record before this one was received
+        uint32_t records; ///< Records received
+        uint32_t lost;    ///< Records skipped by the device (overwritten)
+        char error[160];  ///< First problem found, empty if none
+    };
+
+    void receiveRecord(const Diagnostics::RecordHeader &header, const uint8_t *payload, void *arg)
+    {
+        Receiver *receiver = static_cast<Receiver *>(arg);
+        const Diagnostics::WakeRecord expected = makeWakeRecord(header.seq);
+        if (!receiver->error[0] &&
+            (header.len != sizeof(expected) || memcmp(payload, &expected, sizeof(expected)) != 0))
+            snprintf(receiver->error, sizeof(receiver->error), "record %lu has the wrong content",
+                     static_cast<unsigned long>(header.seq));
+        receiver->records++;
+    }
+
+    // Take one chunk as the backend would; false (with receiver->error set) if it is not a valid continuation
+    bool receiveChunk(const uint8_t *message, size_t len, Receiver *receiver)
+    {
+        RingLogTool::DecodedChunk chunk;
+        std::string error;
+        if (!RingLogTool::DecodeChunk(message, len, &chunk, &error))
+        {
+            snprintf(receiver->error, sizeof(receiver->error), "%s", error.c_str());
+            return false;
+        }
+        if (chunk.header.expected_record != receiver->next)
+        {
+            snprintf(receiver->error, sizeof(receiver->error), "chunk continues from record %lu, not %lu",
+                     static_cast<unsigned long>(chunk.header.expected_record), static_cast<unsigned long>(receiver->next));
+            return false;
+        }
+        receiver->lost += chunk.header.first_record - receiver->next;
+        RingLogTool::ForEachRecord(chunk, receiver->next, receiveRecord, receiver);
+        receiver->next = chunk.header.first_record + chunk.header.records;
+        return !receiver->error[0];
+    }
+
+    int upload(uint32_t size, uint32_t records)
+    {
+        RingLogTool::FileFlash flash(size);
+        Diagnostics::RingLogState state = {};
+        Diagnostics::RingLog log(&flash, &state);
+        if (!log.Available())
+        {
+            fprintf(stderr, "[upload] %lu bytes is too small for a ring log\n", static_cast<unsigned long>(size));
+            return 1;
+        }
+        log.Recover();
+
+        uint32_t wake = 0;
+        const auto append = [&](uint32_t count)
+        {
+            for (uint32_t end = wake + count; wake < end; ++wake)
+            {
+                if (wake % 10 == 0)
+                    log.EraseAhead(Diagnostics::RingLog::ERASE_AHEAD_SECTORS);
+                const Diagnostics::WakeRecord record = makeWakeRecord(wake);
+                if (log.Append(static_cast<uint8_t>(Diagnostics::RecordType::WAKE), &record, sizeof(record)) != ESP_OK)
+                    return false;
+            }
+            return true;
+        };
+        if (!append(records))
+        {
+            fprintf(stderr, "[upload] append failed\n");
+            return 1;
+        }
+
+        // A whole dump, chunk by chunk as Run() builds them
+        Diagnostics::UploadProgress progress = {};
+        Diagnostics::LogUploader uploader(&progress, &log, &flash);
+        std::vector<uint8_t> message(Diagnostics::LogUploader::MAX_CHUNK_LEN);
+        Receiver receiver = {};
+        const uint32_t end = log.NextRecord();
+        const uint64_t read_bytes = flash.ReadBytes();
+        uint64_t raw_bytes = 0;
+        uint64_t sent_bytes = 0;
+        uint32_t chunks = 0;
+        double build_s = 0;
+        for (uint32_t from = 0;;)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            uint32_t next = 0;
+            const size_t len = uploader.BuildChunk(1, from, end, message.data(), &next);
+            build_s += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (len == 0)
+                break;
+
+            Diagnostics::UploadChunkHeader header;
+            memcpy(&header, message.data(), sizeof(header));
+            raw_bytes += header.raw_len;
+            sent_bytes += len;
+            chunks++;
+            if (!receiveChunk(message.data(), len, &receiver))
+                break;
+            from = next;
+        }
+        if (!receiver.error[0] && (receiver.next != end || receiver.records + receiver.lost != end))
+            snprintf(receiver.error, sizeof(receiver.error), "dump ended at record %lu of %lu with %lu received",
+                     static_cast<unsigned long>(receiver.next), static_cast<unsigned long>(end),
+                     static_cast<unsigned long>(receiver.records));
+
+        const uint64_t header_reads = flash.ReadBytes() - read_bytes;
+        printf("[upload] %lu records in the ring (%lu overwritten before the dump), %lu chunks of up to %lu bytes\n",
+               static_cast<unsigned long>(receiver.records), static_cast<unsigned long>(receiver.lost),
+               static_cast<unsigned long>(chunks), static_cast<unsigned long>(Config::DIAG_UPLOAD_CHUNK_BYTES));
+        printf("[upload] %llu bytes of records sent as %llu (%.1f%%, %.0f bytes on air per KB of log)\n",
+               static_cast<unsigned long long>(raw_bytes), static_cast<unsigned long long>(sent_bytes),
+               raw_bytes > 0 ? 100.0 * sent_bytes / raw_bytes : 0.0,
+               raw_bytes > 0 ? 1024.0 * sent_bytes / raw_bytes : 0.0);
+        printf("[upload] %llu bytes copied out of flash (records are compressed in place), %.1f MB/s on the host\n",
+               static_cast<unsigned long long>(header_reads), build_s > 0 ? raw_bytes / build_s / 1e6 : 0.0);
+        if (receiver.error[0])
+        {
+            printf("[upload] %s\n", receiver.error);
+            return 1;
+        }
+
+        // The ring overtakes an upload in progress: the chunk after the gap says where it went on
+        uint32_t from = end - receiver.records;
+        progress = {};
+        receiver = {};
+        receiver.next = from;
+        uint32_t next = 0;
+        size_t len = uploader.BuildChunk(2, from, log.NextRecord(), message.data(), &next);
+        if (len == 0 || !receiveChunk(message.data(), len, &receiver))
+        {
+            printf("[upload] overtaken dump: %s\n", receiver.error[0] ? receiver.error : "no first chunk");
+            return 1;
+        }
+        from = next;
+        if (!append(size / Diagnostics::RingLog::RecordSize(sizeof(Diagnostics::WakeRecord))))
+        {
+            fprintf(stderr, "[upload] append failed\n");
+            return 1;
+        }
+        const uint32_t overtaken_end = log.NextRecord();
+        while ((len = uploader.BuildChunk(2, from, overtaken_end, message.data(), &next)) > 0 &&
+               receiveChunk(message.data(), len, &receiver))
+            from = next;
+        if (!receiver.error[0] && (receiver.next != overtaken_end || receiver.lost == 0))
+            snprintf(receiver.error, sizeof(receiver.error), "ended at record %lu of %lu, %lu lost",
+                     static_cast<unsigned long>(receiver.next), static_cast<unsigned long>(overtaken_end),
+                     static_cast<unsigned long>(receiver.lost));
+        printf("[upload] overtaken dump: %lu records received, %lu overwritten during the upload skipped %s\n",
+               static_cast<unsigned long>(receiver.records), static_cast<unsigned long>(receiver.lost),
+               receiver.error[0] ? receiver.error : "(ok)");
+        return receiver.error[0] ? 1 : 0;
+    }
+
+    int fetch(const char *host, int port, const char *base_topic, const char *client_id, uint32_t id, uint32_t from,
+              const char *out_path)
+    {
+        FILE *out = out_path ? fopen(out_path, "w") : stdout;
+        if (!out)
+        {
+            fprintf(stderr, "[fetch] cannot write %s\n", out_path);
+            return 1;
+        }
+
+        signal(SIGINT, [](int)
+               { g_stop = true; });
+        signal(SIGTERM, [](int)
+               { g_stop = true; });
+
+        mosquitto_lib_init();
+        RingLogTool::LogFetcher fetcher(base_topic, id, from, printRecord, out);
+        if (!fetcher.Start(host, port, client_id))
+            return 1;
+        fprintf(stderr, "[fetch] dump %lu requested from record %lu on %s/diag/# at %s:%d\n",
+                static_cast<unsigned long>(id), static_cast<unsigned long>(from), base_topic, host, port);
+
+        // The device uploads during its reporting sessions, so this may take a few wakes
+        const auto start = std::chrono::steady_clock::now();
+        std::string reported;
+        while (!g_stop && !fetcher.Done())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            const std::string progress = fetcher.LastProgress();
+            if (progress != reported)
+            {
+                fprintf(stderr, "[fetch] device: %s\n", progress.c_str());
+                reported = progress;
+            }
+        }
+
+        fetcher.Stop();
+        mosquitto_lib_cleanup();
+        if (out != stdout)
+            fclose(out);
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        fprintf(stderr,
+                "[fetch] %s: %llu records up to %lu in %.1f s, %llu lost on the device, %llu chunks (%llu bytes as %llu), "
+                "%llu dropped, %llu rejected\n",
+                fetcher.Done() ? "complete" : "interrupted", static_cast<unsigned long long>(fetcher.Records()),
+                static_cast<unsigned long>(fetcher.NextRecord()), seconds, static_cast<unsigned long long>(fetcher.Lost()),
+                static_cast<unsigned long long>(fetcher.Chunks()), static_cast<unsigned long long>(fetcher.RawBytes()),
+                static_cast<unsigned long long>(fetcher.ReceivedBytes()),
+                static_cast<unsigned long long>(fetcher.Dropped()), static_cast<unsigned long long>(fetcher.Rejected()));
+        return fetcher.Done() ? 0 : 1;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    const char *command = argv[1];
+    const char *image_path = nullptr;
+    uint32_t size = DEFAULT_SIZE;
+    uint32_t records = 100000;
+    uint32_t session_every = 10;
+    uint32_t rounds = 2000;
+    uint64_t seed = 1;
+    const char *host = "127.0.0.1";
+    int port = 1883;
+    const char *base_topic = "home/mailbox";
+    const char *client_id = "mailbox-diag";
+    uint32_t id = static_cast<uint32_t>(time(nullptr));
+    uint32_t from = 0;
+    const char *out_path = nullptr;
+
+    for (int i = 2; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        const auto need = [&]()
+        {
+            if (!value)
+            {
+                fprintf(stderr, "Missing value for %s\n", arg);
+                exit(2);
+            }
+            ++i;
+            return value;
+        };
+
+        if (!strcmp(arg, "--image"))
+            image_path = need();
+        else if (!strcmp(arg, "--size"))
+            size = strtoul(need(), nullptr, 0);
+        else if (!strcmp(arg, "--records"))
+            records = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--session-every"))
+            session_every = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--rounds"))
+            rounds = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--seed"))
+            seed = strtoull(need(), nullptr, 10);
+        else if (!strcmp(arg, "--host"))
+            host = need();
+        else if (!strcmp(arg, "--port"))
+            port = atoi(need());
+        else if (!strcmp(arg, "--base-topic"))
+            base_topic = need();
+        else if (!strcmp(arg, "--client-id"))
+            client_id = need();
+        else if (!strcmp(arg, "--id"))
+            id = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--from"))
+            from = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--out"))
+            out_path = need();
+        else
+        {
+            usage(argv[0]);
+            return !strcmp(arg, "--help") ? 0 : 2;
+        }
+    }
+
+    esp_log_level_set("*", ESP_LOG_WARN);
+
+    if (!strcmp(command, "create") || !strcmp(command, "dump"))
+    {
+        if (!image_path)
+        {
+            fprintf(stderr, "%s needs --image\n", command);
+            return 2;
+        }
+        return !strcmp(command, "create") ? create(image_path, size) : dump(image_path);
+    }
+    if (!strcmp(command, "bench"))
+        return bench(size, records > 0 ? records : 1, session_every);
+    if (!strcmp(command, "powercut"))
+        return powercut(size, rounds, seed);
+    if (!strcmp(command, "upload"))
+        return upload(size, records > 0 ? records : 1);
+    if (!strcmp(command, "fetch"))
+    {
+        if (id == 0)
+        {
+            fprintf(stderr, "fetch needs a dump --id above 0\n");
+            return 2;
+        }
+        return fetch(host, port, base_topic, client_id, id, from, out_path);
+    }
+
+    usage(argv[0]);
+    return !strcmp(command, "--help") ? 0 : 2;
+}
\ No newline at end of file
@@ -0,0 +1,208 @@
+#include "generator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace TraceGen
+{
+    namespace
+    {
+        constexpr double US_PER_DAY = 86400.0 * 1e6;
+        constexpr double US_PER_HOUR = 3600.0 * 1e6;
+        constexpr float FIRMWARE_SOUND_M_S = 343.0f; // HCSR04::calculateDistance
+        constexpr float MIN_READING_CM = 2.0f;       // Shorter echoes read as -1
+        constexpr float SETTLED_TAUS = 5.0f;         // Within 1 % of the final height
+        constexpr float FLAT_TAUS = 20.0f;           // Tilt left is below float resolution of the pile
+        constexpr double PI = 3.14159265358979323846;
+
+        // Speed of sound in air at temp_c (m/s)
+        float soundSpeed(float temp_c) { return 331.3f + 0.606f * temp_c; }
+
+        float perWake(float per_day, double interval_us)
+        {
+            return static_cast<float>(1.0 - std::exp(-per_day * interval_us / US_PER_DAY));
+        }
+    }
+
+    uint64_t TraceSeed(uint64_t scenario_seed, uint64_t index)
+    {
+        uint64_t z = scenario_seed + (index + 1) * 0x9e3779b97f4a7c15ULL;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    TraceGenerator::TraceGenerator(const Scenario &scenario, uint64_t seed)
+        : scenario_(scenario),
+          seed_(seed),
+          rng_(seed),
+          normal_(0.0f, 1.0f),
+          unit_(0.0f, 1.0f),
+          weather_c_(0.0f),
+          insect_end_us_(0),
+          insect_cm_(0.0f),
+          dropout_left_(0)
+    {
+        const double interval_us = (scenario.sample_interval_s * 1000.0 + scenario.wake_ms) * 1000.0;
+        drop_p_ = perWake(scenario.drops_per_day, interval_us);
+        collection_p_ = perWake(scenario.collections_per_day, interval_us);
+        insect_p_ = perWake(scenario.insects_per_day, interval_us);
+    }
+
+    void TraceGenerator::Generate(Trace *trace)
+    {
+        trace->seed = seed_;
+        trace->samples.clear();
+        trace->labels.clear();
+
+        const double sleep_us = scenario_.sample_interval_s * 1e6;
+        const uint64_t end_us = static_cast<uint64_t>(scenario_.days * US_PER_DAY);
+        trace->samples.reserve(static_cast<size_t>(end_us / (sleep_us + scenario_.wake_ms * 1000.0)) + 1);
+
+        // Weather drift: Ornstein-Uhlenbeck process with a one-day time constant
+        const float walk_decay = static_cast<float>(std::exp(-sleep_us / US_PER_DAY));
+        const float walk_step = scenario_.temp_walk_c * std::sqrt(1.0f - walk_decay * walk_decay);
+        weather_c_ = scenario_.temp_walk_c * normal_(rng_);
+
+        for (uint64_t now_us = 0; now_us < end_us;)
+        {
+            if (!pile_.empty() && unit_(rng_) < collection_p_)
+                collect(now_us, trace);
+            else if (unit_(rng_) < drop_p_)
+                drop(now_us, trace);
+
+            if (now_us >= insect_end_us_ && unit_(rng_) < insect_p_)
+            {
+                insect_end_us_ = now_us + static_cast<uint64_t>(
+                                              uniform(scenario_.insect_min_s, scenario_.insect_max_s) * 1e6f);
+                insect_cm_ = uniform(scenario_.insect_min_cm, scenario_.insect_max_cm);
+                trace->labels.push_back(
+                    {now_us, insect_end_us_, LabelType::INSECT, ItemKind::NONE, 0, 0, insect_cm_});
+            }
+
+            const float true_cm = std::max(0.0f, scenario_.baseline_cm - pileCm(now_us));
+            trace->samples.push_back({now_us, reading(true_cm, now_us), true_cm});
+
+            weather_c_ = weather_c_ * walk_decay + walk_step * normal_(rng_);
+            const float wake_ms = scenario_.wake_ms + uniform(-scenario_.wake_jitter_ms, scenario_.wake_jitter_ms);
+            now_us += static_cast<uint64_t>(sleep_us + std::max(0.0f, wake_ms) * 1000.0f);
+        }
+    }
+
+    float TraceGenerator::uniform(float min, float max)
+    {
+        return min + unit_(rng_) * (max - min);
+    }
+
+    ItemKind TraceGenerator::pickItem()
+    {
+        const float total = scenario_.envelope_weight + scenario_.magazine_weight + scenario_.parcel_weight;
+        const float pick = unit_(rng_) * total;
+        if (pick < scenario_.envelope_weight)
+            return ItemKind::ENVELOPE;
+        if (pick < scenario_.envelope_weight + scenario_.magazine_weight)
+            return ItemKind::MAGAZINE;
+        return ItemKind::PARCEL;
+    }
+
+    void TraceGenerator::drop(uint64_t now_us, Trace *trace)
+    {
+        const ItemKind kind = pickItem();
+        Item item = {};
+        item.landed_us = now_us;
+        switch (kind)
+        {
+        case ItemKind::ENVELOPE:
+            item.thickness_cm = uniform(scenario_.envelope_min_cm, scenario_.envelope_max_cm);
+            item.tilt_cm = uniform(0.0f, scenario_.envelope_tilt_cm);
+            break;
+        case ItemKind::MAGAZINE:
+            item.thickness_cm = uniform(scenario_.magazine_min_cm, scenario_.magazine_max_cm);
+            item.tilt_cm = uniform(0.0f, scenario_.magazine_tilt_cm);
+            break;
+        default:
+            item.thickness_cm = uniform(scenario_.parcel_min_cm, scenario_.parcel_max_cm);
+            item.tilt_cm = uniform(0.0f, scenario_.parcel_tilt_cm);
+            break;
+        }
+
+        // Nothing fits into a full box
+        if (pileCm(now_us) + item.thickness_cm + item.tilt_cm > scenario_.baseline_cm - MIN_READING_CM)
+            return;
+
+        pile_.push_back(item);
+        const uint64_t settled_us = now_us + static_cast<uint64_t>(SETTLED_TAUS * scenario_.settle_tau_s * 1e6f);
+        trace->labels.push_back({now_us, settled_us, LabelType::DROP, kind, 0, 0, item.thickness_cm});
+    }
+
+    void TraceGenerator::collect(uint64_t now_us, Trace *trace)
+    {
+        // A partial collection leaves a random part of the items behind
+        uint8_t partial = 0;
+        if (pile_.size() > 1 && unit_(rng_) < scenario_.partial_prob)
+        {
+            std::shuffle(pile_.begin(), pile_.end(), rng_);
+            const size_t keep = 1 + static_cast<size_t>(unit_(rng_) * (pile_.size() - 1));
+            pile_.resize(std::min(keep, pile_.size() - 1));
+            partial = 1;
+        }
+        else
+        {
+            pile_.clear();
+        }
+
+        float left_cm = 0.0f;
+        for (const Item &item : pile_)
+            left_cm += item.thickness_cm;
+        trace->labels.push_back({now_us, now_us, LabelType::COLLECTION, ItemKind::NONE, partial, 0, left_cm});
+    }
+
+    float TraceGenerator::pileCm(uint64_t now_us) const
+    {
+        float cm = 0.0f;
+        for (const Item &item : pile_)
+        {
+            cm += item.thickness_cm;
+            const float age_s = (now_us - item.landed_us) * 1e-6f;
+            if (item.tilt_cm > 0.0f && age_s < FLAT_TAUS * scenario_.settle_tau_s)
+                cm += item.tilt_cm * std::exp(-age_s / scenario_.settle_tau_s);
+        }
+        return cm;
+    }
+
+    float TraceGenerator::temperatureC(uint64_t now_us) const
+    {
+        // Traces start at midnight
+        const double hour = std::fmod(now_us / US_PER_HOUR, 24.0);
+        const double daily = std::cos((hour - scenario_.temp_peak_hour) * (2.0 * PI / 24.0));
+        return scenario_.temp_mean_c + scenario_.temp_daily_c * static_cast<float>(daily) + weather_c_;
+    }
+
+    float TraceGenerator::reading(float true_cm, uint64_t now_us)
+    {
+        const float scale = FIRMWARE_SOUND_M_S / soundSpeed(temperatureC(now_us));
+        float cm;
+        if (now_us < insect_end_us_ && unit_(rng_) < scenario_.insect_visible)
+            cm = insect_cm_ * scale;
+        else if (unit_(rng_) < scenario_.spike_prob)
+            cm = (true_cm + uniform(scenario_.spike_min_cm, scenario_.spike_max_cm)) * scale;
+        else
+            cm = true_cm * scale;
+        cm += scenario_.noise_sigma_cm * normal_(rng_);
+
+        // A dropout burst hides whatever the echo would have been
+        if (dropout_left_ > 0)
+        {
+            --dropout_left_;
+            return -1.0f;
+        }
+        if (unit_(rng_) < scenario_.dropout_prob)
+        {
+            std::geometric_distribution<uint32_t> burst(1.0 / scenario_.dropout_burst);
+            dropout_left_ = burst(rng_);
+            return -1.0f;
+        }
+
+        return cm < MIN_READING_CM ? -1.0f : cm;
+    }
+}
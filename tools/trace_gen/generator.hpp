@@ -0,0 +1,74 @@
+#pragma once
+
+#include "scenario.hpp"
+#include "trace_file.hpp"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace TraceGen
+{
+    // Seed of trace index under a scenario seed (splitmix64), so traces can be generated in any order
+    uint64_t TraceSeed(uint64_t scenario_seed, uint64_t index);
+
+    /**
+     * Synthetic distance trace of one mailbox, with its ground truth
+     *
+     * Wakes follow each other at the scenario's sleep interval plus the wake
+     * time. Each one produces the reading HCSR04::MeasureDistance would have
+     * returned:
+     *
+     * - The true distance is the baseline minus the pile. Drops add an item
+     *   that lands tilted and settles exponentially; collections take all
+     *   items out, or a random part of them.
+     * - The air temperature follows a daily cycle plus a day-scale random
+     *   walk. The firmware converts the echo time at 343 m/s, so the reading
+     *   is the true distance scaled by 343 / c(T) (about 0.17 % per degree).
+     * - Gaussian noise on every reading, occasional multipath echoes that
+     *   read long, and dropout bursts of -1.
+     * - Insect visits: while one lasts, a reading sees the insect close to
+     *   the sensor with probability insect_visible; below 2 cm it reads -1.
+     */
+    class TraceGenerator
+    {
+    public:
+        TraceGenerator(const Scenario &scenario, uint64_t seed);
+
+        // Replaces the samples and labels of trace with the whole trace
+        void Generate(Trace *trace);
+
+    private:
+        struct Item
+        {
+            float thickness_cm;
+            float tilt_cm; ///< Extra height on landing, decays with settle_tau_s
+            uint64_t landed_us;
+        };
+
+        const Scenario scenario_;
+        const uint64_t seed_;
+        std::mt19937_64 rng_;
+        std::normal_distribution<float> normal_;
+        std::uniform_real_distribution<float> unit_;
+
+        // Probabilities per wake of the Poisson processes, for the mean interval
+        float drop_p_;
+        float collection_p_;
+        float insect_p_;
+
+        std::vector<Item> pile_;
+        float weather_c_;        ///< Current offset of the weather random walk
+        uint64_t insect_end_us_; ///< End of the current (or last) insect visit
+        float insect_cm_;        ///< Distance of the visiting insect from the sensor
+        uint32_t dropout_left_;  ///< Readings left in the current dropout burst
+
+        float uniform(float min, float max);
+        ItemKind pickItem();
+        void drop(uint64_t now_us, Trace *trace);
+        void collect(uint64_t now_us, Trace *trace);
+        float pileCm(uint64_t now_us) const;
+        float temperatureC(uint64_t now_us) const;
+        float reading(float true_cm, uint64_t now_us);
+    };
+}
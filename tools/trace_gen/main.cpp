@@ -0,0 +1,220 @@
+#include "generator.hpp"
+#include "scenario.hpp"
+#include "trace_file.hpp"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    void usage(const char *argv0)
+    {
+        printf("Usage: %s [options]\n"
+               "  --scenario FILE       scenario description (default: built-in defaults)\n"
+               "  --traces N            traces to generate, one mailbox each (default 1)\n"
+               "  --out DIR             write DIR/<name>-<index>.trace (default: generate only, as a benchmark)\n"
+               "  --csv                 also write <name>-<index>.samples.csv and .labels.csv\n"
+               "  --seed N              override the scenario seed\n"
+               "  --days X              override the scenario length\n"
+               "  --threads N           generator threads (default hardware concurrency)\n"
+               "  --first N             index of the first trace (default 0), to extend a corpus\n",
+               argv0);
+    }
+
+    // Totals over the generated traces
+    struct Summary
+    {
+        uint64_t samples = 0;
+        uint64_t invalid = 0;
+        uint64_t labels[static_cast<size_t>(TraceGen::LabelType::COUNT)] = {};
+        uint64_t items[static_cast<size_t>(TraceGen::ItemKind::COUNT)] = {};
+        uint64_t partial = 0;
+        uint32_t failed = 0;
+
+        void Add(const TraceGen::Trace &trace)
+        {
+            samples += trace.samples.size();
+            for (const TraceGen::TraceSample &sample : trace.samples)
+                invalid += sample.distance_cm < 0.0f;
+            for (const TraceGen::TraceLabel &label : trace.labels)
+            {
+                labels[static_cast<size_t>(label.type)]++;
+                if (label.type == TraceGen::LabelType::DROP)
+                    items[static_cast<size_t>(label.item)]++;
+                partial += label.partial;
+            }
+        }
+
+        void Merge(const Summary &other)
+        {
+            samples += other.samples;
+            invalid += other.invalid;
+            for (size_t i = 0; i < std::size(labels); ++i)
+                labels[i] += other.labels[i];
+            for (size_t i = 0; i < std::size(items); ++i)
+                items[i] += other.items[i];
+            partial += other.partial;
+            failed += other.failed;
+        }
+    };
+}
+
+int main(int argc, char **argv)
+{
+    const char *scenario_path = nullptr;
+    const char *out_dir = nullptr;
+    bool csv = false;
+    uint32_t traces = 1;
+    uint32_t first = 0;
+    uint32_t threads = std::max(1u, std::thread::hardware_concurrency());
+    const char *seed_override = nullptr;
+    const char *days_override = nullptr;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        const auto need = [&]()
+        {
+            if (!value)
+            {
+                fprintf(stderr, "Missing value for %s\n", arg);
+                exit(2);
+            }
+            ++i;
+            return value;
+        };
+
+        if (!strcmp(arg, "--scenario"))
+            scenario_path = need();
+        else if (!strcmp(arg, "--traces"))
+            traces = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--out"))
+            out_dir = need();
+        else if (!strcmp(arg, "--csv"))
+            csv = true;
+        else if (!strcmp(arg, "--seed"))
+            seed_override = need();
+        else if (!strcmp(arg, "--days"))
+            days_override = need();
+        else if (!strcmp(arg, "--threads"))
+            threads = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--first"))
+            first = strtoul(need(), nullptr, 10);
+        else
+        {
+            usage(argv[0]);
+            return !strcmp(arg, "--help") ? 0 : 2;
+        }
+    }
+
+    if (traces == 0 || threads == 0 || (csv && !out_dir))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    TraceGen::Scenario scenario;
+    uint64_t scenario_hash = 0;
+    std::string error;
+    if (scenario_path && !TraceGen::LoadScenario(scenario_path, &scenario, &scenario_hash, &error))
+    {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+    if (seed_override)
+        scenario.seed = strtoull(seed_override, nullptr, 0);
+    if (days_override)
+        scenario.days = static_cast<float>(atof(days_override));
+    if (scenario.days <= 0.0f)
+    {
+        fprintf(stderr, "--days must be above 0\n");
+        return 2;
+    }
+
+    if (out_dir && mkdir(out_dir, 0755) != 0 && errno != EEXIST)
+    {
+        fprintf(stderr, "Cannot create %s: %s\n", out_dir, strerror(errno));
+        return 1;
+    }
+
+    threads = std::min(threads, traces);
+    printf("[trace_gen] %u traces of %.1f days from '%s' (seed %llu), %u threads%s%s\n", traces, scenario.days,
+           scenario.name.c_str(), static_cast<unsigned long long>(scenario.seed), threads, out_dir ? " -> " : "",
+           out_dir ? out_dir : "");
+
+    // Traces are independent: each one has its own generator and derived seed
+    std::atomic<uint32_t> next{0};
+    std::mutex summary_mutex;
+    Summary summary;
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (uint32_t t = 0; t < threads; ++t)
+    {
+        workers.emplace_back(
+            [&]()
+            {
+                Summary local;
+                TraceGen::Trace trace;
+                for (uint32_t n = next++; n < traces; n = next++)
+                {
+                    const uint32_t index = first + n;
+                    TraceGen::TraceGenerator generator(scenario, TraceGen::TraceSeed(scenario.seed, index));
+                    generator.Generate(&trace);
+                    trace.scenario_hash = scenario_hash;
+                    local.Add(trace);
+
+                    if (!out_dir)
+                        continue;
+                    char stem[256];
+                    snprintf(stem, sizeof(stem), "%s/%s-%05u", out_dir, scenario.name.c_str(), index);
+                    bool written = TraceGen::WriteTrace(std::string(stem) + ".trace", trace);
+                    if (csv)
+                        written = written && TraceGen::WriteTraceCsv(std::string(stem) + ".samples.csv",
+                                                                     std::string(stem) + ".labels.csv", trace);
+                    if (!written)
+                    {
+                        fprintf(stderr, "Failed to write %s\n", stem);
+                        local.failed++;
+                    }
+                }
+
+                std::lock_guard<std::mutex> lock(summary_mutex);
+                summary.Merge(local);
+            });
+    }
+    for (std::thread &worker : workers)
+        worker.join();
+
+    const double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    using TraceGen::ItemKind;
+    using TraceGen::LabelType;
+    printf("[trace_gen] %llu samples in %.2f s: %.1f M samples/s\n", static_cast<unsigned long long>(summary.samples),
+           elapsed_s, summary.samples / elapsed_s / 1e6);
+    printf("[trace_gen] invalid readings %.2f %%\n",
+           summary.samples ? 100.0 * summary.invalid / summary.samples : 0.0);
+    printf("[trace_gen] labels: %llu drops (%llu envelopes, %llu magazines, %llu parcels), "
+           "%llu collections (%llu partial), %llu insect visits\n",
+           static_cast<unsigned long long>(summary.labels[static_cast<size_t>(LabelType::DROP)]),
+           static_cast<unsigned long long>(summary.items[static_cast<size_t>(ItemKind::ENVELOPE)]),
+           static_cast<unsigned long long>(summary.items[static_cast<size_t>(ItemKind::MAGAZINE)]),
+           static_cast<unsigned long long>(summary.items[static_cast<size_t>(ItemKind::PARCEL)]),
+           static_cast<unsigned long long>(summary.labels[static_cast<size_t>(LabelType::COLLECTION)]),
+           static_cast<unsigned long long>(summary.partial),
+           static_cast<unsigned long long>(summary.labels[static_cast<size_t>(LabelType::INSECT)]));
+
+    return summary.failed ? 1 : 0;
+}
@@ -0,0 +1,211 @@
+#include "scenario.hpp"
+
+#include "trace_file.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace TraceGen
+{
+    namespace
+    {
+        enum class Range : uint8_t
+        {
+            ANY,         ///< Any finite number
+            NON_NEGATIVE,
+            POSITIVE,
+            PROBABILITY, ///< 0..1
+            HOUR         ///< 0..24
+        };
+
+        struct Field
+        {
+            const char *key;
+            float Scenario::*member;
+            Range range;
+        };
+
+        constexpr Field FIELDS[] = {
+            {"days", &Scenario::days, Range::POSITIVE},
+            {"sample_interval_s", &Scenario::sample_interval_s, Range::POSITIVE},
+            {"wake_ms", &Scenario::wake_ms, Range::NON_NEGATIVE},
+            {"wake_jitter_ms", &Scenario::wake_jitter_ms, Range::NON_NEGATIVE},
+            {"baseline_cm", &Scenario::baseline_cm, Range::POSITIVE},
+            {"temp_mean_c", &Scenario::temp_mean_c, Range::ANY},
+            {"temp_daily_c", &Scenario::temp_daily_c, Range::NON_NEGATIVE},
+            {"temp_peak_hour", &Scenario::temp_peak_hour, Range::HOUR},
+            {"temp_walk_c", &Scenario::temp_walk_c, Range::NON_NEGATIVE},
+            {"noise_sigma_cm", &Scenario::noise_sigma_cm, Range::NON_NEGATIVE},
+            {"spike_prob", &Scenario::spike_prob, Range::PROBABILITY},
+            {"spike_min_cm", &Scenario::spike_min_cm, Range::NON_NEGATIVE},
+            {"spike_max_cm", &Scenario::spike_max_cm, Range::NON_NEGATIVE},
+            {"dropout_prob", &Scenario::dropout_prob, Range::PROBABILITY},
+            {"dropout_burst", &Scenario::dropout_burst, Range::POSITIVE},
+            {"insects_per_day", &Scenario::insects_per_day, Range::NON_NEGATIVE},
+            {"insect_min_s", &Scenario::insect_min_s, Range::NON_NEGATIVE},
+            {"insect_max_s", &Scenario::insect_max_s, Range::NON_NEGATIVE},
+            {"insect_min_cm", &Scenario::insect_min_cm, Range::NON_NEGATIVE},
+            {"insect_max_cm", &Scenario::insect_max_cm, Range::NON_NEGATIVE},
+            {"insect_visible", &Scenario::insect_visible, Range::PROBABILITY},
+            {"drops_per_day", &Scenario::drops_per_day, Range::NON_NEGATIVE},
+            {"envelope_weight", &Scenario::envelope_weight, Range::NON_NEGATIVE},
+            {"magazine_weight", &Scenario::magazine_weight, Range::NON_NEGATIVE},
+            {"parcel_weight", &Scenario::parcel_weight, Range::NON_NEGATIVE},
+            {"envelope_min_cm", &Scenario::envelope_min_cm, Range::NON_NEGATIVE},
+            {"envelope_max_cm", &Scenario::envelope_max_cm, Range::NON_NEGATIVE},
+            {"envelope_tilt_cm", &Scenario::envelope_tilt_cm, Range::NON_NEGATIVE},
+            {"magazine_min_cm", &Scenario::magazine_min_cm, Range::NON_NEGATIVE},
+            {"magazine_max_cm", &Scenario::magazine_max_cm, Range::NON_NEGATIVE},
+            {"magazine_tilt_cm", &Scenario::magazine_tilt_cm, Range::NON_NEGATIVE},
+            {"parcel_min_cm", &Scenario::parcel_min_cm, Range::NON_NEGATIVE},
+            {"parcel_max_cm", &Scenario::parcel_max_cm, Range::NON_NEGATIVE},
+            {"parcel_tilt_cm", &Scenario::parcel_tilt_cm, Range::NON_NEGATIVE},
+            {"settle_tau_s", &Scenario::settle_tau_s, Range::POSITIVE},
+            {"collections_per_day", &Scenario::collections_per_day, Range::NON_NEGATIVE},
+            {"partial_prob", &Scenario::partial_prob, Range::PROBABILITY},
+        };
+
+        // Lower and upper bounds that have to be in order
+        struct Bounds
+        {
+            const char *name;
+            float Scenario::*min;
+            float Scenario::*max;
+        };
+
+        constexpr Bounds BOUNDS[] = {
+            {"spike", &Scenario::spike_min_cm, &Scenario::spike_max_cm},
+            {"insect_*_s", &Scenario::insect_min_s, &Scenario::insect_max_s},
+            {"insect_*_cm", &Scenario::insect_min_cm, &Scenario::insect_max_cm},
+            {"envelope", &Scenario::envelope_min_cm, &Scenario::envelope_max_cm},
+            {"magazine", &Scenario::magazine_min_cm, &Scenario::magazine_max_cm},
+            {"parcel", &Scenario::parcel_min_cm, &Scenario::parcel_max_cm},
+        };
+
+        bool inRange(float value, Range range)
+        {
+            switch (range)
+            {
+            case Range::NON_NEGATIVE:
+                return value >= 0.0f;
+            case Range::POSITIVE:
+                return value > 0.0f;
+            case Range::PROBABILITY:
+                return value >= 0.0f && value <= 1.0f;
+            case Range::HOUR:
+                return value >= 0.0f && value < 24.0f;
+            default:
+                return true;
+            }
+        }
+
+        std::string trim(const std::string &s)
+        {
+            const size_t begin = s.find_first_not_of(" \t\r");
+            if (begin == std::string::npos)
+                return "";
+            const size_t end = s.find_last_not_of(" \t\r");
+            return s.substr(begin, end - begin + 1);
+        }
+    }
+
+    bool ParseScenario(const std::string &text, Scenario *scenario, std::string *error)
+    {
+        std::istringstream lines(text);
+        std::string line;
+        for (int number = 1; std::getline(lines, line); ++number)
+        {
+            const size_t comment = line.find('#');
+            if (comment != std::string::npos)
+                line.resize(comment);
+            line = trim(line);
+            if (line.empty())
+                continue;
+
+            const size_t eq = line.find('=');
+            if (eq == std::string::npos)
+            {
+                *error = "line " + std::to_string(number) + ": expected key = value";
+                return false;
+            }
+            const std::string key = trim(line.substr(0, eq));
+            const std::string value = trim(line.substr(eq + 1));
+
+            if (key == "name")
+            {
+                scenario->name = value;
+                continue;
+            }
+            if (key == "seed")
+            {
+                char *end = nullptr;
+                errno = 0;
+                scenario->seed = strtoull(value.c_str(), &end, 0);
+                if (errno != 0 || value.empty() || *end != '\0')
+                {
+                    *error = "line " + std::to_string(number) + ": bad seed '" + value + "'";
+                    return false;
+                }
+                continue;
+            }
+
+            const Field *field = nullptr;
+            for (const Field &f : FIELDS)
+                if (key == f.key)
+                    field = &f;
+            if (!field)
+            {
+                *error = "line " + std::to_string(number) + ": unknown key '" + key + "'";
+                return false;
+            }
+
+            char *end = nullptr;
+            const float parsed = strtof(value.c_str(), &end);
+            if (value.empty() || *end != '\0' || !inRange(parsed, field->range))
+            {
+                *error = "line " + std::to_string(number) + ": bad value '" + value + "' for " + key;
+                return false;
+            }
+            scenario->*(field->member) = parsed;
+        }
+
+        for (const Bounds &bounds : BOUNDS)
+        {
+            if (scenario->*(bounds.min) > scenario->*(bounds.max))
+            {
+                *error = std::string(bounds.name) + ": minimum above maximum";
+                return false;
+            }
+        }
+        if (scenario->drops_per_day > 0.0f &&
+            scenario->envelope_weight + scenario->magazine_weight + scenario->parcel_weight <= 0.0f)
+        {
+            *error = "drops need at least one item kind with a weight above 0";
+            return false;
+        }
+        return true;
+    }
+
+    bool LoadScenario(const std::string &path, Scenario *scenario, uint64_t *hash, std::string *error)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            *error = "cannot read " + path;
+            return false;
+        }
+        std::ostringstream text;
+        text << file.rdbuf();
+
+        const std::string content = text.str();
+        *hash = Fnv1a64(content.data(), content.size());
+        if (!ParseScenario(content, scenario, error))
+        {
+            *error = path + ": " + *error;
+            return false;
+        }
+        return true;
+    }
+}
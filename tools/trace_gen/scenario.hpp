@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace TraceGen
+{
+    /**
+     * Everything a trace is generated from
+     *
+     * Read from a scenario file of "key = value" lines ('#' starts a
+     * comment); keys that are left out keep the defaults below. The same
+     * scenario text and seed always give the same trace.
+     */
+    struct Scenario
+    {
+        std::string name = "default"; ///< File name prefix of the generated traces
+        uint64_t seed = 1;            ///< Trace i is generated from a seed derived from this and i
+
+        // Timing
+        float days = 7.0f;              ///< Virtual length of a trace
+        float sample_interval_s = 5.0f; ///< Deep sleep between wakes (DEEP_SLEEP_US)
+        float wake_ms = 60.0f;          ///< Mean time awake, added to every interval
+        float wake_jitter_ms = 20.0f;   ///< Wake time varies uniformly by +/- this
+
+        // Geometry and temperature: the firmware assumes 343 m/s, the air does not
+        float baseline_cm = 40.0f;    ///< Distance from the sensor to the floor of the empty mailbox
+        float temp_mean_c = 15.0f;    ///< Mean air temperature in the box
+        float temp_daily_c = 6.0f;    ///< Amplitude of the daily temperature cycle
+        float temp_peak_hour = 15.0f; ///< Hour of the day of the warmest air
+        float temp_walk_c = 3.0f;     ///< Spread of the slow weather drift (day-scale random walk)
+
+        // Measurement noise
+        float noise_sigma_cm = 0.3f; ///< Gaussian noise on every reading
+        float spike_prob = 0.002f;   ///< Probability that a reading is a multipath echo (longer path)
+        float spike_min_cm = 5.0f;   ///< Extra path of a multipath echo, lower bound
+        float spike_max_cm = 40.0f;  ///< Extra path of a multipath echo, upper bound
+        float dropout_prob = 0.002f; ///< Probability per reading that a dropout burst starts
+        float dropout_burst = 3.0f;  ///< Mean readings per dropout burst (geometric), all -1
+
+        // Insects crawling over the sensor or flying through the beam
+        float insects_per_day = 0.5f; ///< Mean visits per day (Poisson)
+        float insect_min_s = 10.0f;   ///< Length of a visit, lower bound
+        float insect_max_s = 600.0f;  ///< Length of a visit, upper bound
+        float insect_min_cm = 1.0f;   ///< Distance of the insect from the sensor, lower bound (< 2 cm reads as -1)
+        float insect_max_cm = 15.0f;  ///< Distance of the insect from the sensor, upper bound
+        float insect_visible = 0.6f;  ///< Probability that a reading during a visit sees the insect
+
+        // Mail drops: an item lands tilted by up to *_tilt_cm and settles to its thickness
+        float drops_per_day = 2.0f;    ///< Mean drops per day (Poisson)
+        float envelope_weight = 0.6f;  ///< Relative frequency of envelopes
+        float magazine_weight = 0.3f;  ///< Relative frequency of magazines
+        float parcel_weight = 0.1f;    ///< Relative frequency of parcels
+        float envelope_min_cm = 0.3f;  ///< Envelope thickness, lower bound
+        float envelope_max_cm = 1.5f;  ///< Envelope thickness, upper bound
+        float envelope_tilt_cm = 6.0f; ///< Envelope extra height on landing, upper bound
+        float magazine_min_cm = 1.0f;  ///< Magazine thickness, lower bound
+        float magazine_max_cm = 3.0f;  ///< Magazine thickness, upper bound
+        float magazine_tilt_cm = 2.0f; ///< Magazine extra height on landing, upper bound
+        float parcel_min_cm = 5.0f;    ///< Parcel height, lower bound
+        float parcel_max_cm = 20.0f;   ///< Parcel height, upper bound
+        float parcel_tilt_cm = 1.0f;   ///< Parcel extra height on landing, upper bound
+        float settle_tau_s = 90.0f;    ///< Time constant of the settling (exponential)
+
+        // Collections
+        float collections_per_day = 1.0f; ///< Mean collections per day while there is mail (Poisson)
+        float partial_prob = 0.15f;       ///< Probability that some items stay behind
+    };
+
+    // false with a message naming the line for unknown keys, bad numbers or values out of range
+    bool ParseScenario(const std::string &text, Scenario *scenario, std::string *error);
+
+    // ParseScenario on a file; *hash receives the FNV-1a of its text
+    bool LoadScenario(const std::string &path, Scenario *scenario, uint64_t *hash, std::string *error);
+}
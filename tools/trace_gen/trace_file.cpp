@@ -0,0 +1,125 @@
+#include "trace_file.hpp"
+
+#include <cstdio>
+#include <memory>
+
+namespace TraceGen
+{
+    namespace
+    {
+        using File = std::unique_ptr<FILE, int (*)(FILE *)>;
+
+        File open(const std::string &path, const char *mode)
+        {
+            return File(fopen(path.c_str(), mode), fclose);
+        }
+    }
+
+    const char *LabelTypeToString(LabelType type)
+    {
+        switch (type)
+        {
+        case LabelType::DROP:
+            return "drop";
+        case LabelType::COLLECTION:
+            return "collection";
+        case LabelType::INSECT:
+            return "insect";
+        default:
+            return "unknown";
+        }
+    }
+
+    const char *ItemKindToString(ItemKind item)
+    {
+        switch (item)
+        {
+        case ItemKind::NONE:
+            return "-";
+        case ItemKind::ENVELOPE:
+            return "envelope";
+        case ItemKind::MAGAZINE:
+            return "magazine";
+        case ItemKind::PARCEL:
+            return "parcel";
+        default:
+            return "unknown";
+        }
+    }
+
+    bool WriteTrace(const std::string &path, const Trace &trace)
+    {
+        File file = open(path, "wb");
+        if (!file)
+            return false;
+
+        TraceHeader header = {};
+        header.magic = TRACE_MAGIC;
+        header.version = TRACE_VERSION;
+        header.header_bytes = sizeof(TraceHeader);
+        header.seed = trace.seed;
+        header.scenario_hash = trace.scenario_hash;
+        header.sample_count = trace.samples.size();
+        header.label_count = static_cast<uint32_t>(trace.labels.size());
+
+        return fwrite(&header, sizeof(header), 1, file.get()) == 1 &&
+               fwrite(trace.samples.data(), sizeof(TraceSample), trace.samples.size(), file.get()) ==
+                   trace.samples.size() &&
+               fwrite(trace.labels.data(), sizeof(TraceLabel), trace.labels.size(), file.get()) ==
+                   trace.labels.size();
+    }
+
+    bool ReadTrace(const std::string &path, Trace *trace)
+    {
+        File file = open(path, "rb");
+        if (!file)
+            return false;
+
+        TraceHeader header = {};
+        if (fread(&header, sizeof(header), 1, file.get()) != 1 || header.magic != TRACE_MAGIC ||
+            header.version != TRACE_VERSION || header.header_bytes != sizeof(TraceHeader))
+            return false;
+
+        trace->seed = header.seed;
+        trace->scenario_hash = header.scenario_hash;
+        trace->samples.resize(header.sample_count);
+        trace->labels.resize(header.label_count);
+        return fread(trace->samples.data(), sizeof(TraceSample), trace->samples.size(), file.get()) ==
+                   trace->samples.size() &&
+               fread(trace->labels.data(), sizeof(TraceLabel), trace->labels.size(), file.get()) ==
+                   trace->labels.size();
+    }
+
+    bool WriteTraceCsv(const std::string &samples_path, const std::string &labels_path, const Trace &trace)
+    {
+        File samples = open(samples_path, "w");
+        File labels = open(labels_path, "w");
+        if (!samples || !labels)
+            return false;
+
+        fprintf(samples.get(), "time_us,distance_cm,truth_cm\n");
+        for (const TraceSample &sample : trace.samples)
+            fprintf(samples.get(), "%llu,%.2f,%.2f\n", static_cast<unsigned long long>(sample.time_us),
+                    sample.distance_cm, sample.truth_cm);
+
+        fprintf(labels.get(), "time_us,end_us,type,item,partial,height_cm\n");
+        for (const TraceLabel &label : trace.labels)
+            fprintf(labels.get(), "%llu,%llu,%s,%s,%u,%.2f\n", static_cast<unsigned long long>(label.time_us),
+                    static_cast<unsigned long long>(label.end_us), LabelTypeToString(label.type),
+                    ItemKindToString(label.item), label.partial, label.height_cm);
+
+        return !ferror(samples.get()) && !ferror(labels.get());
+    }
+
+    uint64_t Fnv1a64(const void *data, size_t len)
+    {
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (size_t i = 0; i < len; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace TraceGen
+{
+    // One wake: what HCSR04::MeasureDistance returned, and what it should have
+    struct TraceSample
+    {
+        uint64_t time_us;  ///< Virtual time of the wake, as app_main passes it to Processor::Process
+        float distance_cm; ///< Reading fed to the processor (-1: timeout or below range)
+        float truth_cm;    ///< Noise-free distance to the top of the pile at the firmware's speed of sound (-1: unknown, recorded traces)
+    };
+
+    enum class LabelType : uint8_t
+    {
+        DROP,       ///< Item put into the mailbox
+        COLLECTION, ///< Items taken out; partial if some stay
+        INSECT,     ///< Insect on or in front of the sensor (no event expected)
+        COUNT
+    };
+
+    enum class ItemKind : uint8_t
+    {
+        NONE,
+        ENVELOPE,
+        MAGAZINE,
+        PARCEL,
+        COUNT
+    };
+
+    // Ground truth of the trace, in time order
+    struct TraceLabel
+    {
+        uint64_t time_us;  ///< When it happened
+        uint64_t end_us;   ///< Insects: when it left; drops: when the item has settled; collections: time_us
+        LabelType type;
+        ItemKind item;     ///< Drops: what was dropped
+        uint8_t partial;   ///< Collections: 1 if items stayed in the box
+        uint8_t reserved;
+        float height_cm;   ///< Drops: item thickness; collections: pile left behind; insects: distance to the sensor
+    };
+
+    /**
+     * Header of a trace file (little-endian host layout)
+     *
+     * A trace file is the header, sample_count TraceSample records, then
+     * label_count TraceLabel records. scenario_hash identifies the scenario
+     * text the trace was generated from, so a replay can tell a stale trace.
+     */
+    struct TraceHeader
+    {
+        uint32_t magic;         ///< TRACE_MAGIC
+        uint16_t version;       ///< TRACE_VERSION
+        uint16_t header_bytes;  ///< sizeof(TraceHeader)
+        uint64_t seed;          ///< Seed of this trace
+        uint64_t scenario_hash; ///< FNV-1a of the scenario text
+        uint64_t sample_count;
+        uint32_t label_count;
+        uint32_t reserved;
+    };
+
+    static constexpr uint32_t TRACE_MAGIC = 0x4352544d; ///< "MTRC"
+    static constexpr uint16_t TRACE_VERSION = 1;
+
+    static_assert(sizeof(TraceSample) == 16, "TraceSample is stored as is");
+    static_assert(sizeof(TraceLabel) == 24, "TraceLabel is stored as is");
+    static_assert(sizeof(TraceHeader) == 40, "TraceHeader is stored as is");
+
+    struct Trace
+    {
+        uint64_t seed;
+        uint64_t scenario_hash;
+        std::vector<TraceSample> samples;
+        std::vector<TraceLabel> labels;
+    };
+
+    // "drop", "collection", "insect"
+    const char *LabelTypeToString(LabelType type);
+
+    // "-", "envelope", "magazine", "parcel"
+    const char *ItemKindToString(ItemKind item);
+
+    bool WriteTrace(const std::string &path, const Trace &trace);
+
+    // false if the file is missing, truncated or of another format or version
+    bool ReadTrace(const std::string &path, Trace *trace);
+
+    // Samples as "time_us,distance_cm,truth_cm" and labels as "time_us,end_us,type,item,partial,height_cm"
+    bool WriteTraceCsv(const std::string &samples_path, const std::string &labels_path, const Trace &trace);
+
+    uint64_t Fnv1a64(const void *data, size_t len);
+}
@@ -0,0 +1,269 @@
+#include "column_codec.hpp"
+
+#include <cstring>
+
+namespace Tsdb
+{
+    void ByteWriter::PutVarint(uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out_.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out_.push_back(static_cast<uint8_t>(value));
+    }
+
+    void ByteWriter::PutBytes(const void *data, size_t len)
+    {
+        const auto *bytes = static_cast<const uint8_t *>(data);
+        out_.insert(out_.end(), bytes, bytes + len);
+    }
+
+    uint64_t ByteReader::Varint()
+    {
+        uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7)
+        {
+            if (p_ >= end_)
+                break;
+            const uint8_t byte = *p_++;
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return value;
+        }
+        ok_ = false;
+        return 0;
+    }
+
+    const uint8_t *ByteReader::Bytes(size_t len)
+    {
+        if (static_cast<size_t>(end_ - p_) < len)
+        {
+            ok_ = false;
+            return nullptr;
+        }
+        const uint8_t *start = p_;
+        p_ += len;
+        return start;
+    }
+
+    void BitWriter::Put(uint64_t bits, unsigned count)
+    {
+        // Split wide writes so the 64-bit accumulator never overflows
+        if (count > 32)
+        {
+            Put(bits >> 32, count - 32);
+            count = 32;
+        }
+
+        acc_ = (acc_ << count) | (bits & ((count == 64) ? ~0ULL : ((1ULL << count) - 1)));
+        used_ += count;
+        while (used_ >= 8)
+        {
+            used_ -= 8;
+            out_.push_back(static_cast<uint8_t>(acc_ >> used_));
+        }
+    }
+
+    void BitWriter::Finish()
+    {
+        if (used_ > 0)
+            out_.push_back(static_cast<uint8_t>(acc_ << (8 - used_)));
+        acc_ = 0;
+        used_ = 0;
+    }
+
+    uint64_t BitReader::Get(unsigned count)
+    {
+        if (count > 32)
+        {
+            const uint64_t high = Get(count - 32);
+            return (high << 32) | Get(32);
+        }
+
+        while (avail_ < count)
+        {
+            if (p_ >= end_)
+            {
+                ok_ = false;
+                return 0;
+            }
+            acc_ = (acc_ << 8) | *p_++;
+            avail_ += 8;
+        }
+        avail_ -= count;
+        return (acc_ >> avail_) & ((1ULL << count) - 1);
+    }
+
+    void EncodeTimes(const int64_t *values, size_t count, std::vector<uint8_t> &out)
+    {
+        ByteWriter writer(out);
+        int64_t prev = 0;
+        int64_t prev_delta = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (i == 0)
+                writer.PutZigzag(values[0]);
+            else
+            {
+                const int64_t delta = values[i] - prev;
+                writer.PutZigzag(i == 1 ? delta : delta - prev_delta);
+                prev_delta = delta;
+            }
+            prev = values[i];
+        }
+    }
+
+    bool DecodeTimes(const uint8_t *data, size_t len, size_t count, int64_t *out)
+    {
+        ByteReader reader(data, len);
+        int64_t delta = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (i == 0)
+                out[0] = reader.Zigzag();
+            else
+            {
+                delta = (i == 1) ? reader.Zigzag() : delta + reader.Zigzag();
+                out[i] = out[i - 1] + delta;
+            }
+        }
+        return reader.Ok();
+    }
+
+    void EncodeFloats(const float *values, size_t count, std::vector<uint8_t> &out)
+    {
+        BitWriter writer(out);
+        uint32_t prev = 0;
+        unsigned prev_leading = 33; // No window yet
+        unsigned prev_trailing = 0;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint32_t bits;
+            memcpy(&bits, &values[i], sizeof(bits));
+
+            if (i == 0)
+            {
+                writer.Put(bits, 32);
+                prev = bits;
+                continue;
+            }
+
+            const uint32_t x = bits ^ prev;
+            prev = bits;
+            if (x == 0)
+            {
+                writer.Put(0, 1);
+                continue;
+            }
+
+            const unsigned leading = __builtin_clz(x);
+            const unsigned trailing = __builtin_ctz(x);
+            if (prev_leading <= 32 && leading >= prev_leading && trailing >= prev_trailing)
+            {
+                // Fits the previous meaningful-bit window
+                writer.Put(0b10, 2);
+                writer.Put(x >> prev_trailing, 32 - prev_leading - prev_trailing);
+            }
+            else
+            {
+                const unsigned meaningful = 32 - leading - trailing;
+                writer.Put(0b11, 2);
+                writer.Put(leading, 5);
+                writer.Put(meaningful - 1, 5);
+                writer.Put(x >> trailing, meaningful);
+                prev_leading = leading;
+                prev_trailing = trailing;
+            }
+        }
+        writer.Finish();
+    }
+
+    bool DecodeFloats(const uint8_t *data, size_t len, size_t count, float *out)
+    {
+        BitReader reader(data, len);
+        uint32_t prev = 0;
+        unsigned leading = 0;
+        unsigned trailing = 0;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint32_t bits;
+            if (i == 0)
+                bits = static_cast<uint32_t>(reader.Get(32));
+            else if (reader.Get(1) == 0)
+                bits = prev;
+            else
+            {
+                if (reader.Get(1) == 1)
+                {
+                    leading = static_cast<unsigned>(reader.Get(5));
+                    const unsigned meaningful = static_cast<unsigned>(reader.Get(5)) + 1;
+                    if (leading + meaningful > 32)
+                        return false;
+                    trailing = 32 - leading - meaningful;
+                }
+                const unsigned meaningful = 32 - leading - trailing;
+                bits = prev ^ (static_cast<uint32_t>(reader.Get(meaningful)) << trailing);
+            }
+
+            memcpy(&out[i], &bits, sizeof(bits));
+            prev = bits;
+        }
+        return reader.Ok();
+    }
+
+    void EncodeRle(const uint8_t *values, size_t count, std::vector<uint8_t> &out)
+    {
+        ByteWriter writer(out);
+        for (size_t i = 0; i < count;)
+        {
+            size_t run = 1;
+            while (i + run < count && values[i + run] == values[i])
+                ++run;
+            writer.PutBytes(&values[i], 1);
+            writer.PutVarint(run);
+            i += run;
+        }
+    }
+
+    bool DecodeRle(const uint8_t *data, size_t len, size_t count, uint8_t *out)
+    {
+        ByteReader reader(data, len);
+        for (size_t i = 0; i < count;)
+        {
+            const uint8_t *value = reader.Bytes(1);
+            const uint64_t run = reader.Varint();
+            if (!reader.Ok() || run == 0 || run > count - i)
+                return false;
+            memset(out + i, *value, run);
+            i += run;
+        }
+        return reader.Ok();
+    }
+
+    void EncodeDeltas(const uint32_t *values, size_t count, std::vector<uint8_t> &out)
+    {
+        ByteWriter writer(out);
+        uint32_t prev = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            writer.PutZigzag(static_cast<int64_t>(values[i]) - static_cast<int64_t>(prev));
+            prev = values[i];
+        }
+    }
+
+    bool DecodeDeltas(const uint8_t *data, size_t len, size_t count, uint32_t *out)
+    {
+        ByteReader reader(data, len);
+        int64_t prev = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            prev += reader.Zigzag();
+            out[i] = static_cast<uint32_t>(prev);
+        }
+        return reader.Ok();
+    }
+}
\ No newline at end of file
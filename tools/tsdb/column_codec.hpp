@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Tsdb
+{
+    // Append-only byte buffer with LEB128 varints
+    class ByteWriter
+    {
+    public:
+        explicit ByteWriter(std::vector<uint8_t> &out) : out_(out) {}
+
+        void PutVarint(uint64_t value);
+        void PutZigzag(int64_t value) { PutVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63)); }
+        void PutBytes(const void *data, size_t len);
+
+    private:
+        std::vector<uint8_t> &out_;
+    };
+
+    // Bounds-checked reader for ByteWriter output; Ok() turns false on truncation
+    class ByteReader
+    {
+    public:
+        ByteReader(const uint8_t *data, size_t len) : p_(data), end_(data + len) {}
+
+        uint64_t Varint();
+        int64_t Zigzag()
+        {
+            const uint64_t v = Varint();
+            return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+        }
+        const uint8_t *Bytes(size_t len);
+
+        bool Ok() const { return ok_; }
+        bool AtEnd() const { return p_ == end_; }
+
+    private:
+        const uint8_t *p_;
+        const uint8_t *end_;
+        bool ok_ = true;
+    };
+
+    // MSB-first bit packing for the float column
+    class BitWriter
+    {
+    public:
+        explicit BitWriter(std::vector<uint8_t> &out) : out_(out) {}
+
+        void Put(uint64_t bits, unsigned count);
+
+        // Flush the last partial byte (zero padded)
+        void Finish();
+
+    private:
+        std::vector<uint8_t> &out_;
+        uint64_t acc_ = 0;
+        unsigned used_ = 0;
+    };
+
+    class BitReader
+    {
+    public:
+        BitReader(const uint8_t *data, size_t len) : p_(data), end_(data + len) {}
+
+        uint64_t Get(unsigned count);
+
+        bool Ok() const { return ok_; }
+
+    private:
+        const uint8_t *p_;
+        const uint8_t *end_;
+        uint64_t acc_ = 0;
+        unsigned avail_ = 0;
+        bool ok_ = true;
+    };
+
+    /**
+     * Column encodings
+     *
+     * - Timestamps: first value, first delta, then zigzag delta-of-delta varints
+     *   (regular heartbeats cost one byte per row).
+     * - Floats: Gorilla XOR against the previous value; repeats cost one bit,
+     *   slowly drifting readings only store their changing mantissa bits.
+     * - Small enums: run-length encoded (value, run) pairs.
+     * - Integers: zigzag delta varints.
+     *
+     * Decoders return false on malformed or truncated input.
+     */
+    void EncodeTimes(const int64_t *values, size_t count, std::vector<uint8_t> &out);
+    bool DecodeTimes(const uint8_t *data, size_t len, size_t count, int64_t *out);
+
+    void EncodeFloats(const float *values, size_t count, std::vector<uint8_t> &out);
+    bool DecodeFloats(const uint8_t *data, size_t len, size_t count, float *out);
+
+    void EncodeRle(const uint8_t *values, size_t count, std::vector<uint8_t> &out);
+    bool DecodeRle(const uint8_t *data, size_t len, size_t count, uint8_t *out);
+
+    void EncodeDeltas(const uint32_t *values, size_t count, std::vector<uint8_t> &out);
+    bool DecodeDeltas(const uint8_t *data, size_t len, size_t count, uint32_t *out);
+}
\ No newline at end of file
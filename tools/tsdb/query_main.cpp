@@ -0,0 +1,253 @@
+#include "store.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    void usage(const char *argv0)
+    {
+        printf("Usage: %s --dir DIR [query] [options]\n"
+               "Queries:\n"
+               "  --device NAME         all rows of one device (topic prefix, e.g. sim/mailbox/mailbox-0001)\n"
+               "  --aggregate COLUMN    per-device count/mean/min/max/last of distance, baseline,\n"
+               "                        threshold, success, confidence or duration\n"
+               "  --stats               segment, block, row and byte totals (default)\n"
+               "Options:\n"
+               "  --from T --to T       time range: unix seconds, 'now' or relative ('-7d', '-12h', '-30m')\n"
+               "                        (default: everything)\n"
+               "  --kind K              aggregate only status, mail_drop or mail_collected rows\n"
+               "  --below X / --above X keep devices whose mean is below/above X\n"
+               "  --threads N           query threads (default hardware concurrency)\n",
+               argv0);
+    }
+
+    int64_t nowMs()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+    bool parseTime(const char *text, int64_t *out_ms)
+    {
+        if (!strcmp(text, "now"))
+        {
+            *out_ms = nowMs();
+            return true;
+        }
+
+        char *end = nullptr;
+        const double value = strtod(text, &end);
+        if (end == text)
+            return false;
+
+        if (text[0] == '-' && *end)
+        {
+            double unit_ms = 0;
+            switch (*end)
+            {
+            case 'd':
+                unit_ms = 86400e3;
+                break;
+            case 'h':
+                unit_ms = 3600e3;
+                break;
+            case 'm':
+                unit_ms = 60e3;
+                break;
+            case 's':
+                unit_ms = 1e3;
+                break;
+            default:
+                return false;
+            }
+            *out_ms = nowMs() + static_cast<int64_t>(value * unit_ms);
+            return true;
+        }
+
+        *out_ms = static_cast<int64_t>(value * 1e3);
+        return *end == '\0';
+    }
+
+    bool parseColumn(const char *name, Tsdb::Column *column)
+    {
+        static const struct
+        {
+            const char *name;
+            Tsdb::Column column;
+        } COLUMNS[] = {
+            {"distance", Tsdb::COL_DISTANCE},
+            {"baseline", Tsdb::COL_BASELINE},
+            {"threshold", Tsdb::COL_THRESHOLD},
+            {"success", Tsdb::COL_SUCCESS},
+            {"confidence", Tsdb::COL_CONFIDENCE},
+            {"duration", Tsdb::COL_DURATION},
+        };
+        for (const auto &entry : COLUMNS)
+        {
+            if (!strcmp(name, entry.name))
+            {
+                *column = entry.column;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Matches Ingest::MessageKind
+    const char *KINDS[] = {"status", "mail_drop", "mail_collected"};
+    const char *STATES[] = {"empty", "has_mail", "full", "emptied", "obstructed"};
+
+    void formatTime(int64_t time_ms, char *buf, size_t len)
+    {
+        const time_t seconds = static_cast<time_t>(time_ms / 1000);
+        struct tm tm_utc;
+        gmtime_r(&seconds, &tm_utc);
+        const size_t n = strftime(buf, len, "%Y-%m-%dT%H:%M:%S", &tm_utc);
+        snprintf(buf + n, len - n, ".%03dZ", static_cast<int>(time_ms % 1000));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *dir = nullptr;
+    const char *device = nullptr;
+    const char *aggregate = nullptr;
+    int kind = Tsdb::Store::ANY_KIND;
+    Tsdb::TimeRange range = {INT64_MIN, INT64_MAX};
+    double below = 0.0, above = 0.0;
+    bool has_below = false, has_above = false;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        const auto need = [&]()
+        {
+            if (!value)
+            {
+                fprintf(stderr, "Missing value for %s\n", arg);
+                exit(2);
+            }
+            ++i;
+            return value;
+        };
+
+        if (!strcmp(arg, "--dir"))
+            dir = need();
+        else if (!strcmp(arg, "--device"))
+            device = need();
+        else if (!strcmp(arg, "--aggregate"))
+            aggregate = need();
+        else if (!strcmp(arg, "--stats"))
+            ;
+        else if (!strcmp(arg, "--from") || !strcmp(arg, "--to"))
+        {
+            int64_t *target = !strcmp(arg, "--from") ? &range.from_ms : &range.to_ms;
+            if (!parseTime(need(), target))
+            {
+                fprintf(stderr, "Bad time for %s\n", arg);
+                return 2;
+            }
+        }
+        else if (!strcmp(arg, "--kind"))
+        {
+            const char *name = need();
+            kind = -2;
+            for (int k = 0; k < 3; ++k)
+                if (!strcmp(name, KINDS[k]))
+                    kind = k;
+            if (kind == -2)
+            {
+                fprintf(stderr, "Unknown kind %s\n", name);
+                return 2;
+            }
+        }
+        else if (!strcmp(arg, "--below"))
+            below = atof(need()), has_below = true;
+        else if (!strcmp(arg, "--above"))
+            above = atof(need()), has_above = true;
+        else if (!strcmp(arg, "--threads"))
+            threads = strtoul(need(), nullptr, 10);
+        else
+        {
+            usage(argv[0]);
+            return !strcmp(arg, "--help") ? 0 : 2;
+        }
+    }
+
+    if (!dir)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto elapsed_ms = [&start]()
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    Tsdb::Store store(dir);
+
+    if (device)
+    {
+        const std::vector<Tsdb::Row> rows = store.QueryDevice(device, range, threads);
+        for (const Tsdb::Row &row : rows)
+        {
+            char when[40];
+            formatTime(row.time_ms, when, sizeof(when));
+            const Tsdb::RowFields &f = row.fields;
+            printf("%s %-14s state=%-8s kf=%u distance=%.1f baseline=%.1f threshold=%.1f success=%.2f",
+                   when, f.kind < 3 ? KINDS[f.kind] : "?", f.mailbox_state < 5 ? STATES[f.mailbox_state] : "?",
+                   f.keyframe, f.distance_cm, f.baseline_cm, f.threshold_cm, f.success_rate);
+            if (f.kind != 0)
+                printf(" duration=%u confidence=%.2f", f.duration_ms, f.confidence);
+            printf("\n");
+        }
+        fprintf(stderr, "%zu rows in %.1f ms\n", rows.size(), elapsed_ms());
+        return 0;
+    }
+
+    if (aggregate)
+    {
+        Tsdb::Column column;
+        if (!parseColumn(aggregate, &column))
+        {
+            fprintf(stderr, "Unknown column %s\n", aggregate);
+            return 2;
+        }
+
+        const auto result = store.AggregateByDevice(column, range, kind, threads);
+
+        std::vector<std::pair<const std::string *, const Tsdb::Aggregate *>> selected;
+        for (const auto &[name, agg] : result)
+        {
+            if ((has_below && agg.Mean() >= below) || (has_above && agg.Mean() <= above))
+                continue;
+            selected.emplace_back(&name, &agg);
+        }
+        std::sort(selected.begin(), selected.end(), [](const auto &a, const auto &b)
+                  { return a.second->Mean() < b.second->Mean(); });
+
+        for (const auto &[name, agg] : selected)
+            printf("%s count=%llu mean=%.3f min=%.3f max=%.3f last=%.3f\n", name->c_str(),
+                   static_cast<unsigned long long>(agg->count), agg->Mean(), agg->min, agg->max, agg->last);
+        fprintf(stderr, "%zu of %zu devices in %.1f ms\n", selected.size(), result.size(), elapsed_ms());
+        return 0;
+    }
+
+    const Tsdb::StoreStats stats = store.Stats();
+    printf("segments=%zu blocks=%zu rows=%llu bytes=%llu (%.1f bytes/row)\n", stats.segments, stats.blocks,
+           static_cast<unsigned long long>(stats.rows), static_cast<unsigned long long>(stats.bytes),
+           stats.rows ? static_cast<double>(stats.bytes) / stats.rows : 0.0);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Tsdb
+{
+    // Columns of one block, in on-disk order
+    enum Column : uint32_t
+    {
+        COL_DEVICE_DICT, ///< Distinct device keys of the block (varint length + bytes each)
+        COL_DEVICE,      ///< Per-row index into the dictionary (varints)
+        COL_TIME,        ///< Receive wall time, milliseconds since the epoch (delta-of-delta)
+        COL_KIND,        ///< Ingest::MessageKind (RLE)
+        COL_STATE,       ///< Processor::MailboxState after the message (RLE)
+        COL_KEYFRAME,    ///< 1 once a full status was applied for the device (RLE)
+        COL_DISTANCE,    ///< distance_cm (XOR)
+        COL_BASELINE,    ///< baseline_cm (XOR)
+        COL_THRESHOLD,   ///< threshold_cm (XOR)
+        COL_SUCCESS,     ///< success_rate (XOR)
+        COL_CONFIDENCE,  ///< confidence, mail_drop only (XOR)
+        COL_DURATION,    ///< duration_ms, events only (delta varints)
+        COLUMN_COUNT
+    };
+
+    // Values of one stored message: the device state right after it was applied
+    struct RowFields
+    {
+        uint8_t kind;
+        uint8_t mailbox_state;
+        uint8_t keyframe;
+        float distance_cm;
+        float baseline_cm;
+        float threshold_cm;
+        float success_rate;
+        float confidence;
+        uint32_t duration_ms;
+    };
+
+    // A decoded row as returned by queries
+    struct Row
+    {
+        int64_t time_ms;
+        std::string device;
+        RowFields fields;
+    };
+
+    /**
+     * Fixed header in front of every block
+     *
+     * A segment file is nothing but a sequence of blocks, so it is valid after
+     * every completed append; a reader stops at the first block that is
+     * truncated or fails its checksum (torn write after a crash).
+     */
+    struct BlockHeader
+    {
+        uint32_t magic;                      ///< BLOCK_MAGIC
+        uint32_t rows;                       ///< Rows in the block
+        int64_t time_min_ms;                 ///< Smallest COL_TIME value
+        int64_t time_max_ms;                 ///< Largest COL_TIME value
+        uint32_t column_bytes[COLUMN_COUNT]; ///< Encoded size of each column
+        uint32_t checksum;                   ///< FNV-1a over the column data
+    };
+
+    static constexpr uint32_t BLOCK_MAGIC = 0x3158424d; ///< "MBX1"
+    static constexpr size_t BLOCK_ROWS = 4096;          ///< Rows buffered before a block is written
+
+    // Segment file name for a partition and writer ("<partition start ms>-<writer>.seg")
+    std::string SegmentFileName(int64_t partition_start_ms, uint32_t writer);
+
+    // Inverse of SegmentFileName; false for other files
+    bool ParseSegmentFileName(const char *name, int64_t *partition_start_ms, uint32_t *writer);
+
+    uint32_t Checksum(const uint8_t *data, size_t len);
+}
\ No newline at end of file
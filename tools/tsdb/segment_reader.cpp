@@ -0,0 +1,144 @@
+#include "segment_reader.hpp"
+#include "column_codec.hpp"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Tsdb
+{
+    std::unique_ptr<SegmentReader> SegmentReader::Open(const std::string &path)
+    {
+        const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return nullptr;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            close(fd);
+            return nullptr;
+        }
+
+        std::unique_ptr<SegmentReader> reader(new SegmentReader());
+        reader->size_ = static_cast<size_t>(st.st_size);
+        if (reader->size_ > 0)
+        {
+            void *map = mmap(nullptr, reader->size_, PROT_READ, MAP_SHARED, fd, 0);
+            if (map == MAP_FAILED)
+            {
+                close(fd);
+                return nullptr;
+            }
+            reader->data_ = static_cast<const uint8_t *>(map);
+        }
+        close(fd);
+
+        reader->valid_size_ = indexBlocks(reader->data_, reader->size_, &reader->blocks_);
+        return reader;
+    }
+
+    size_t SegmentReader::ValidLength(const std::string &path)
+    {
+        std::unique_ptr<SegmentReader> reader = Open(path);
+        return reader ? reader->valid_size_ : 0;
+    }
+
+    SegmentReader::~SegmentReader()
+    {
+        if (data_)
+            munmap(const_cast<uint8_t *>(data_), size_);
+    }
+
+    size_t SegmentReader::indexBlocks(const uint8_t *data, size_t size, std::vector<Block> *blocks)
+    {
+        size_t offset = 0;
+        while (size - offset >= sizeof(BlockHeader))
+        {
+            Block block;
+            memcpy(&block.header, data + offset, sizeof(BlockHeader));
+            if (block.header.magic != BLOCK_MAGIC || block.header.rows == 0 || block.header.rows > BLOCK_ROWS)
+                break;
+
+            size_t payload = 0;
+            for (uint32_t bytes : block.header.column_bytes)
+                payload += bytes;
+            if (size - offset - sizeof(BlockHeader) < payload)
+                break; // Torn append
+
+            const uint8_t *column = data + offset + sizeof(BlockHeader);
+            if (Checksum(column, payload) != block.header.checksum)
+                break;
+
+            for (uint32_t c = 0; c < COLUMN_COUNT; ++c)
+            {
+                block.columns[c] = column;
+                column += block.header.column_bytes[c];
+            }
+            blocks->push_back(block);
+            offset += sizeof(BlockHeader) + payload;
+        }
+        return offset;
+    }
+
+    bool SegmentReader::DecodeDictionary(size_t block, std::vector<std::string_view> &names) const
+    {
+        const Block &b = blocks_[block];
+        ByteReader reader(b.columns[COL_DEVICE_DICT], b.header.column_bytes[COL_DEVICE_DICT]);
+        const uint64_t count = reader.Varint();
+        if (!reader.Ok() || count > b.header.rows)
+            return false;
+
+        names.clear();
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            const uint64_t len = reader.Varint();
+            const uint8_t *text = reader.Bytes(len);
+            if (!reader.Ok())
+                return false;
+            names.emplace_back(reinterpret_cast<const char *>(text), len);
+        }
+        return true;
+    }
+
+    bool SegmentReader::DecodeDevices(size_t block, std::vector<uint32_t> &indices) const
+    {
+        const Block &b = blocks_[block];
+        ByteReader reader(b.columns[COL_DEVICE], b.header.column_bytes[COL_DEVICE]);
+        indices.resize(b.header.rows);
+        for (uint32_t &index : indices)
+            index = static_cast<uint32_t>(reader.Varint());
+        return reader.Ok();
+    }
+
+    bool SegmentReader::DecodeTimes(size_t block, std::vector<int64_t> &times) const
+    {
+        const Block &b = blocks_[block];
+        times.resize(b.header.rows);
+        return Tsdb::DecodeTimes(b.columns[COL_TIME], b.header.column_bytes[COL_TIME], b.header.rows, times.data());
+    }
+
+    bool SegmentReader::DecodeBytes(size_t block, Column column, std::vector<uint8_t> &values) const
+    {
+        const Block &b = blocks_[block];
+        values.resize(b.header.rows);
+        return DecodeRle(b.columns[column], b.header.column_bytes[column], b.header.rows, values.data());
+    }
+
+    bool SegmentReader::DecodeFloats(size_t block, Column column, std::vector<float> &values) const
+    {
+        const Block &b = blocks_[block];
+        values.resize(b.header.rows);
+        return Tsdb::DecodeFloats(b.columns[column], b.header.column_bytes[column], b.header.rows, values.data());
+    }
+
+    bool SegmentReader::DecodeDurations(size_t block, std::vector<uint32_t> &values) const
+    {
+        const Block &b = blocks_[block];
+        values.resize(b.header.rows);
+        return DecodeDeltas(b.columns[COL_DURATION], b.header.column_bytes[COL_DURATION], b.header.rows,
+                            values.data());
+    }
+}
\ No newline at end of file
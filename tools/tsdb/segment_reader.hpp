@@ -0,0 +1,69 @@
+#pragma once
+
+#include "segment_format.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Tsdb
+{
+    /**
+     * Read-only, memory-mapped view of one segment file
+     *
+     * Open() maps the file, indexes the block headers and verifies the block
+     * checksums. Queries then decode only the columns they ask for. The
+     * mapping covers the file as it was at Open().
+     */
+    class SegmentReader
+    {
+    public:
+        // Map a segment file; NULL if it cannot be opened
+        static std::unique_ptr<SegmentReader> Open(const std::string &path);
+
+        /**
+         * Length of the valid prefix of a segment file
+         *
+         * Walks the block chain and stops at the first truncated or corrupt
+         * block. Writers truncate to this length before appending again.
+         */
+        static size_t ValidLength(const std::string &path);
+
+        ~SegmentReader();
+
+        SegmentReader(const SegmentReader &) = delete;
+        SegmentReader &operator=(const SegmentReader &) = delete;
+
+        size_t BlockCount() const { return blocks_.size(); }
+        const BlockHeader &Header(size_t block) const { return blocks_[block].header; }
+        size_t MappedBytes() const { return size_; }
+
+        // Column decoders (false if the column data is malformed)
+        bool DecodeDictionary(size_t block, std::vector<std::string_view> &names) const;
+        bool DecodeDevices(size_t block, std::vector<uint32_t> &indices) const;
+        bool DecodeTimes(size_t block, std::vector<int64_t> &times) const;
+        bool DecodeBytes(size_t block, Column column, std::vector<uint8_t> &values) const;
+        bool DecodeFloats(size_t block, Column column, std::vector<float> &values) const;
+        bool DecodeDurations(size_t block, std::vector<uint32_t> &values) const;
+
+    private:
+        struct Block
+        {
+            BlockHeader header;
+            const uint8_t *columns[COLUMN_COUNT];
+        };
+
+        const uint8_t *data_ = nullptr;
+        size_t size_ = 0;
+        size_t valid_size_ = 0; ///< Bytes covered by intact blocks
+        std::vector<Block> blocks_;
+
+        SegmentReader() = default;
+
+        // Index blocks of a buffer; returns the length of the valid prefix
+        static size_t indexBlocks(const uint8_t *data, size_t size, std::vector<Block> *blocks);
+    };
+}
\ No newline at end of file
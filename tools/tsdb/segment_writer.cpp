@@ -0,0 +1,222 @@
+#include "segment_writer.hpp"
+#include "column_codec.hpp"
+#include "segment_reader.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Tsdb
+{
+    std::string SegmentFileName(int64_t partition_start_ms, uint32_t writer)
+    {
+        char name[64];
+        snprintf(name, sizeof(name), "%lld-%u.seg", static_cast<long long>(partition_start_ms), writer);
+        return name;
+    }
+
+    bool ParseSegmentFileName(const char *name, int64_t *partition_start_ms, uint32_t *writer)
+    {
+        long long start = 0;
+        unsigned id = 0;
+        int consumed = 0;
+        if (sscanf(name, "%lld-%u.seg%n", &start, &id, &consumed) != 2 || name[consumed] != '\0' || consumed == 0)
+            return false;
+        *partition_start_ms = start;
+        *writer = id;
+        return true;
+    }
+
+    uint32_t Checksum(const uint8_t *data, size_t len)
+    {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < len; ++i)
+            hash = (hash ^ data[i]) * 16777619u;
+        return hash;
+    }
+
+    SegmentWriter::SegmentWriter(const std::string &dir, uint32_t writer_id, int64_t partition_ms)
+        : dir_(dir), writer_id_(writer_id), partition_ms_(std::max<int64_t>(1, partition_ms)),
+          fd_(-1), partition_start_ms_(INT64_MIN), bytes_written_(0)
+    {
+    }
+
+    SegmentWriter::~SegmentWriter() { Close(); }
+
+    bool SegmentWriter::Append(int64_t time_ms, const char *device, size_t device_len, const RowFields &fields)
+    {
+        // Floor division so negative times still partition correctly
+        const int64_t partition = (time_ms >= 0 ? time_ms : time_ms - partition_ms_ + 1) / partition_ms_ * partition_ms_;
+        if (partition != partition_start_ms_)
+        {
+            Close();
+            if (!openPartition(partition))
+                return false;
+        }
+
+        std::string key(device, device_len);
+        auto it = dictionary_.find(key);
+        if (it == dictionary_.end())
+        {
+            it = dictionary_.emplace(key, static_cast<uint32_t>(dictionary_order_.size())).first;
+            dictionary_order_.push_back(std::move(key));
+        }
+
+        device_.push_back(it->second);
+        time_.push_back(time_ms);
+        kind_.push_back(fields.kind);
+        state_.push_back(fields.mailbox_state);
+        keyframe_.push_back(fields.keyframe);
+        distance_.push_back(fields.distance_cm);
+        baseline_.push_back(fields.baseline_cm);
+        threshold_.push_back(fields.threshold_cm);
+        success_.push_back(fields.success_rate);
+        confidence_.push_back(fields.confidence);
+        duration_.push_back(fields.duration_ms);
+
+        return time_.size() < BLOCK_ROWS || Flush();
+    }
+
+    bool SegmentWriter::Flush()
+    {
+        const size_t rows = time_.size();
+        if (rows == 0 || fd_ < 0)
+            return true;
+
+        BlockHeader header = {};
+        header.magic = BLOCK_MAGIC;
+        header.rows = static_cast<uint32_t>(rows);
+        header.time_min_ms = *std::min_element(time_.begin(), time_.end());
+        header.time_max_ms = *std::max_element(time_.begin(), time_.end());
+
+        block_.assign(sizeof(BlockHeader), 0);
+        const auto encode = [&](Column column, auto &&fn)
+        {
+            const size_t before = block_.size();
+            fn();
+            header.column_bytes[column] = static_cast<uint32_t>(block_.size() - before);
+        };
+
+        encode(COL_DEVICE_DICT, [&]
+               {
+                   ByteWriter writer(block_);
+                   writer.PutVarint(dictionary_order_.size());
+                   for (const std::string &name : dictionary_order_)
+                   {
+                       writer.PutVarint(name.size());
+                       writer.PutBytes(name.data(), name.size());
+                   } });
+        encode(COL_DEVICE, [&]
+               {
+                   ByteWriter writer(block_);
+                   for (uint32_t index : device_)
+                       writer.PutVarint(index); });
+        encode(COL_TIME, [&]
+               { EncodeTimes(time_.data(), rows, block_); });
+        encode(COL_KIND, [&]
+               { EncodeRle(kind_.data(), rows, block_); });
+        encode(COL_STATE, [&]
+               { EncodeRle(state_.data(), rows, block_); });
+        encode(COL_KEYFRAME, [&]
+               { EncodeRle(keyframe_.data(), rows, block_); });
+        encode(COL_DISTANCE, [&]
+               { EncodeFloats(distance_.data(), rows, block_); });
+        encode(COL_BASELINE, [&]
+               { EncodeFloats(baseline_.data(), rows, block_); });
+        encode(COL_THRESHOLD, [&]
+               { EncodeFloats(threshold_.data(), rows, block_); });
+        encode(COL_SUCCESS, [&]
+               { EncodeFloats(success_.data(), rows, block_); });
+        encode(COL_CONFIDENCE, [&]
+               { EncodeFloats(confidence_.data(), rows, block_); });
+        encode(COL_DURATION, [&]
+               { EncodeDeltas(duration_.data(), rows, block_); });
+
+        header.checksum = Checksum(block_.data() + sizeof(BlockHeader), block_.size() - sizeof(BlockHeader));
+        memcpy(block_.data(), &header, sizeof(header));
+
+        clearColumns();
+
+        // A single write per block; a short write leaves a torn block readers will skip
+        size_t written = 0;
+        while (written < block_.size())
+        {
+            const ssize_t n = write(fd_, block_.data() + written, block_.size() - written);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+            {
+                fprintf(stderr, "[tsdb] write failed: %s\n", strerror(errno));
+                return false;
+            }
+            written += static_cast<size_t>(n);
+        }
+        bytes_written_ += written;
+        return true;
+    }
+
+    void SegmentWriter::Close()
+    {
+        if (fd_ < 0)
+            return;
+
+        Flush();
+        fsync(fd_);
+        close(fd_);
+        fd_ = -1;
+        partition_start_ms_ = INT64_MIN;
+    }
+
+    bool SegmentWriter::openPartition(int64_t partition_start_ms)
+    {
+        const std::string path = dir_ + "/" + SegmentFileName(partition_start_ms, writer_id_);
+        fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd_ < 0)
+        {
+            fprintf(stderr, "[tsdb] cannot open %s: %s\n", path.c_str(), strerror(errno));
+            return false;
+        }
+
+        // Reopening after a crash: drop a torn tail block so new blocks stay reachable
+        struct stat st;
+        if (fstat(fd_, &st) == 0 && st.st_size > 0)
+        {
+            const size_t valid = SegmentReader::ValidLength(path);
+            if (valid < static_cast<size_t>(st.st_size))
+            {
+                fprintf(stderr, "[tsdb] %s: dropping %lld bytes of torn data\n", path.c_str(),
+                        static_cast<long long>(st.st_size - valid));
+                if (ftruncate(fd_, static_cast<off_t>(valid)) != 0)
+                {
+                    close(fd_);
+                    fd_ = -1;
+                    return false;
+                }
+            }
+        }
+        partition_start_ms_ = partition_start_ms;
+        return true;
+    }
+
+    void SegmentWriter::clearColumns()
+    {
+        dictionary_.clear();
+        dictionary_order_.clear();
+        device_.clear();
+        time_.clear();
+        kind_.clear();
+        state_.clear();
+        keyframe_.clear();
+        distance_.clear();
+        baseline_.clear();
+        threshold_.clear();
+        success_.clear();
+        confidence_.clear();
+        duration_.clear();
+    }
+}
\ No newline at end of file
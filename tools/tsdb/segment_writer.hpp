@@ -0,0 +1,70 @@
+#pragma once
+
+#include "segment_format.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Tsdb
+{
+    /**
+     * Single-threaded appender for one writer's time-partitioned segments
+     *
+     * Rows are buffered per column and written as one compressed block when
+     * BLOCK_ROWS are collected, on Flush(), or when a row falls into a new
+     * partition (which also closes the current segment file). Files are only
+     * ever appended to, so readers can map them while they grow.
+     */
+    class SegmentWriter
+    {
+    public:
+        SegmentWriter(const std::string &dir, uint32_t writer_id, int64_t partition_ms);
+        ~SegmentWriter();
+
+        SegmentWriter(const SegmentWriter &) = delete;
+        SegmentWriter &operator=(const SegmentWriter &) = delete;
+
+        // Buffer one row; returns false if a block could not be written
+        bool Append(int64_t time_ms, const char *device, size_t device_len, const RowFields &fields);
+
+        // Write buffered rows as a block (no-op when empty)
+        bool Flush();
+
+        // Flush and close the current segment file
+        void Close();
+
+        // Bytes written so far (compressed, including headers)
+        uint64_t BytesWritten() const { return bytes_written_; }
+
+    private:
+        std::string dir_;
+        uint32_t writer_id_;
+        int64_t partition_ms_;
+
+        int fd_;
+        int64_t partition_start_ms_; ///< Partition of the open segment (INT64_MIN if none)
+        uint64_t bytes_written_;
+
+        // Column buffers of the pending block
+        std::unordered_map<std::string, uint32_t> dictionary_;
+        std::vector<std::string> dictionary_order_;
+        std::vector<uint32_t> device_;
+        std::vector<int64_t> time_;
+        std::vector<uint8_t> kind_;
+        std::vector<uint8_t> state_;
+        std::vector<uint8_t> keyframe_;
+        std::vector<float> distance_;
+        std::vector<float> baseline_;
+        std::vector<float> threshold_;
+        std::vector<float> success_;
+        std::vector<float> confidence_;
+        std::vector<uint32_t> duration_;
+
+        std::vector<uint8_t> block_; ///< Reused encode buffer
+
+        bool openPartition(int64_t partition_start_ms);
+        void clearColumns();
+    };
+}
\ No newline at end of file
@@ -0,0 +1,290 @@
+#include "store.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <thread>
+
+namespace Tsdb
+{
+    namespace
+    {
+        constexpr const char *META_FILE = "tsdb.meta";
+
+        bool overlaps(const BlockHeader &header, TimeRange range)
+        {
+            return header.time_max_ms >= range.from_ms && header.time_min_ms < range.to_ms;
+        }
+
+        void accumulate(Aggregate &agg, float value, int64_t time_ms)
+        {
+            if (agg.count == 0)
+            {
+                agg.min = agg.max = value;
+                agg.last_time_ms = INT64_MIN;
+            }
+            agg.count++;
+            agg.sum += value;
+            agg.min = std::min(agg.min, value);
+            agg.max = std::max(agg.max, value);
+            if (time_ms >= agg.last_time_ms)
+            {
+                agg.last_time_ms = time_ms;
+                agg.last = value;
+            }
+        }
+
+        void merge(Aggregate &into, const Aggregate &from)
+        {
+            if (from.count == 0)
+                return;
+            if (into.count == 0)
+            {
+                into = from;
+                return;
+            }
+            into.count += from.count;
+            into.sum += from.sum;
+            into.min = std::min(into.min, from.min);
+            into.max = std::max(into.max, from.max);
+            if (from.last_time_ms >= into.last_time_ms)
+            {
+                into.last_time_ms = from.last_time_ms;
+                into.last = from.last;
+            }
+        }
+    }
+
+    bool Store::Create(const std::string &dir, int64_t partition_ms)
+    {
+        if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST)
+        {
+            fprintf(stderr, "[tsdb] cannot create %s\n", dir.c_str());
+            return false;
+        }
+
+        const std::string meta = dir + "/" + META_FILE;
+        if (FILE *existing = fopen(meta.c_str(), "r"))
+        {
+            long long stored = 0;
+            const bool ok = fscanf(existing, "partition_ms=%lld", &stored) == 1;
+            fclose(existing);
+            if (ok && stored != partition_ms)
+            {
+                fprintf(stderr, "[tsdb] %s uses %lld ms partitions, not %lld\n", dir.c_str(), stored,
+                        static_cast<long long>(partition_ms));
+                return false;
+            }
+            return ok;
+        }
+
+        FILE *f = fopen(meta.c_str(), "w");
+        if (!f)
+            return false;
+        fprintf(f, "partition_ms=%lld\n", static_cast<long long>(partition_ms));
+        fclose(f);
+        return true;
+    }
+
+    Store::Store(const std::string &dir)
+        : dir_(dir), partition_ms_(0)
+    {
+        if (FILE *meta = fopen((dir + "/" + META_FILE).c_str(), "r"))
+        {
+            long long partition_ms = 0;
+            if (fscanf(meta, "partition_ms=%lld", &partition_ms) == 1 && partition_ms > 0)
+                partition_ms_ = partition_ms;
+            fclose(meta);
+        }
+
+        if (DIR *d = opendir(dir.c_str()))
+        {
+            while (const dirent *entry = readdir(d))
+            {
+                int64_t start = 0;
+                uint32_t writer = 0;
+                if (ParseSegmentFileName(entry->d_name, &start, &writer))
+                    files_.push_back({dir + "/" + entry->d_name, start});
+            }
+            closedir(d);
+        }
+
+        std::sort(files_.begin(), files_.end(), [](const SegmentFile &a, const SegmentFile &b)
+                  { return a.partition_start_ms < b.partition_start_ms; });
+    }
+
+    std::vector<const Store::SegmentFile *> Store::candidates(TimeRange range) const
+    {
+        std::vector<const SegmentFile *> result;
+        for (const SegmentFile &file : files_)
+        {
+            if (partition_ms_ > 0 && (file.partition_start_ms >= range.to_ms ||
+                                      file.partition_start_ms + partition_ms_ <= range.from_ms))
+                continue;
+            result.push_back(&file);
+        }
+        return result;
+    }
+
+    template <typename Fn>
+    void Store::forEachSegment(const std::vector<const SegmentFile *> &segments, unsigned threads, Fn &&fn) const
+    {
+        std::atomic<size_t> next{0};
+        const auto worker = [&](unsigned worker_index)
+        {
+            for (size_t i = next++; i < segments.size(); i = next++)
+            {
+                std::unique_ptr<SegmentReader> reader = SegmentReader::Open(segments[i]->path);
+                if (reader)
+                    fn(worker_index, *reader);
+            }
+        };
+
+        threads = std::max(1u, std::min<unsigned>(threads, static_cast<unsigned>(segments.size())));
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < threads; ++t)
+            pool.emplace_back(worker, t);
+        worker(0);
+        for (auto &thread : pool)
+            thread.join();
+    }
+
+    std::vector<Row> Store::QueryDevice(const std::string &device, TimeRange range, unsigned threads) const
+    {
+        const auto segments = candidates(range);
+        threads = std::max(1u, threads);
+        std::vector<std::vector<Row>> partial(threads);
+
+        const auto scan = [&](unsigned worker, const SegmentReader &reader)
+        {
+            std::vector<std::string_view> names;
+            std::vector<uint32_t> devices;
+            std::vector<int64_t> times;
+            std::vector<uint8_t> kind, state, keyframe;
+            std::vector<float> distance, baseline, threshold, success, confidence;
+            std::vector<uint32_t> duration;
+
+            for (size_t b = 0; b < reader.BlockCount(); ++b)
+            {
+                if (!overlaps(reader.Header(b), range) || !reader.DecodeDictionary(b, names))
+                    continue;
+
+                // Skip blocks the device does not appear in before touching any row data
+                const auto it = std::find(names.begin(), names.end(), device);
+                if (it == names.end())
+                    continue;
+                const uint32_t wanted = static_cast<uint32_t>(it - names.begin());
+
+                if (!reader.DecodeDevices(b, devices) || !reader.DecodeTimes(b, times) ||
+                    !reader.DecodeBytes(b, COL_KIND, kind) || !reader.DecodeBytes(b, COL_STATE, state) ||
+                    !reader.DecodeBytes(b, COL_KEYFRAME, keyframe) ||
+                    !reader.DecodeFloats(b, COL_DISTANCE, distance) ||
+                    !reader.DecodeFloats(b, COL_BASELINE, baseline) ||
+                    !reader.DecodeFloats(b, COL_THRESHOLD, threshold) ||
+                    !reader.DecodeFloats(b, COL_SUCCESS, success) ||
+                    !reader.DecodeFloats(b, COL_CONFIDENCE, confidence) || !reader.DecodeDurations(b, duration))
+                    continue;
+
+                for (size_t r = 0; r < devices.size(); ++r)
+                {
+                    if (devices[r] != wanted || times[r] < range.from_ms || times[r] >= range.to_ms)
+                        continue;
+                    partial[worker].push_back({times[r], device,
+                                               {kind[r], state[r], keyframe[r], distance[r], baseline[r],
+                                                threshold[r], success[r], confidence[r], duration[r]}});
+                }
+            }
+        };
+        forEachSegment(segments, threads, scan);
+
+        std::vector<Row> rows;
+        for (auto &part : partial)
+            rows.insert(rows.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+        std::stable_sort(rows.begin(), rows.end(), [](const Row &a, const Row &b)
+                         { return a.time_ms < b.time_ms; });
+        return rows;
+    }
+
+    std::map<std::string, Aggregate> Store::AggregateByDevice(Column column, TimeRange range, int kind,
+                                                              unsigned threads) const
+    {
+        const auto segments = candidates(range);
+        threads = std::max(1u, threads);
+        std::vector<std::map<std::string, Aggregate>> partial(threads);
+
+        const auto scan = [&](unsigned worker, const SegmentReader &reader)
+        {
+            std::vector<std::string_view> names;
+            std::vector<uint32_t> devices;
+            std::vector<int64_t> times;
+            std::vector<uint8_t> kinds;
+            std::vector<float> values;
+            std::vector<uint32_t> durations;
+            std::vector<Aggregate> block_aggs;
+
+            for (size_t b = 0; b < reader.BlockCount(); ++b)
+            {
+                if (!overlaps(reader.Header(b), range))
+                    continue;
+
+                // Only the columns this query needs are decoded
+                if (!reader.DecodeDictionary(b, names) || !reader.DecodeDevices(b, devices) ||
+                    !reader.DecodeTimes(b, times) || (kind != ANY_KIND && !reader.DecodeBytes(b, COL_KIND, kinds)))
+                    continue;
+                if (column == COL_DURATION)
+                {
+                    if (!reader.DecodeDurations(b, durations))
+                        continue;
+                    values.assign(durations.begin(), durations.end());
+                }
+                else if (!reader.DecodeFloats(b, column, values))
+                    continue;
+
+                // Aggregate by dictionary index first, then fold into the per-thread map once per device
+                block_aggs.assign(names.size(), Aggregate{});
+                for (size_t r = 0; r < devices.size(); ++r)
+                {
+                    if (devices[r] >= names.size() || times[r] < range.from_ms || times[r] >= range.to_ms)
+                        continue;
+                    if (kind != ANY_KIND && kinds[r] != kind)
+                        continue;
+                    accumulate(block_aggs[devices[r]], values[r], times[r]);
+                }
+                for (size_t d = 0; d < names.size(); ++d)
+                {
+                    if (block_aggs[d].count)
+                        merge(partial[worker][std::string(names[d])], block_aggs[d]);
+                }
+            }
+        };
+        forEachSegment(segments, threads, scan);
+
+        std::map<std::string, Aggregate> result;
+        for (auto &part : partial)
+        {
+            for (auto &[device, agg] : part)
+                merge(result[device], agg);
+        }
+        return result;
+    }
+
+    StoreStats Store::Stats() const
+    {
+        StoreStats stats = {};
+        for (const SegmentFile &file : files_)
+        {
+            std::unique_ptr<SegmentReader> reader = SegmentReader::Open(file.path);
+            if (!reader)
+                continue;
+            stats.segments++;
+            stats.blocks += reader->BlockCount();
+            stats.bytes += reader->MappedBytes();
+            for (size_t b = 0; b < reader->BlockCount(); ++b)
+                stats.rows += reader->Header(b).rows;
+        }
+        return stats;
+    }
+}
\ No newline at end of file
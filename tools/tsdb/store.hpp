@@ -0,0 +1,92 @@
+#pragma once
+
+#include "segment_format.hpp"
+#include "segment_reader.hpp"
+#include "segment_writer.hpp"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Tsdb
+{
+    // Half-open time range [from_ms, to_ms) in milliseconds since the epoch
+    struct TimeRange
+    {
+        int64_t from_ms;
+        int64_t to_ms;
+    };
+
+    // Running aggregate of one column for one device
+    struct Aggregate
+    {
+        uint64_t count;
+        double sum;
+        float min;
+        float max;
+        int64_t last_time_ms;
+        float last;
+
+        double Mean() const { return count ? sum / count : 0.0; }
+    };
+
+    // Totals reported by Store::Stats
+    struct StoreStats
+    {
+        size_t segments;
+        size_t blocks;
+        uint64_t rows;
+        uint64_t bytes;
+    };
+
+    /**
+     * Directory of segment files written by one or more SegmentWriters
+     *
+     * Segment files are named after their partition, so queries skip files
+     * outside the requested range without opening them, then skip blocks by
+     * their header time bounds, and finally decode only the columns they
+     * need. Each query spreads the remaining segments over worker threads and
+     * merges the per-thread results.
+     */
+    class Store
+    {
+    public:
+        // Value a kind filter takes to match every message kind
+        static constexpr int ANY_KIND = -1;
+
+        explicit Store(const std::string &dir);
+
+        // Create the directory and record the partition length (used for pruning by file name)
+        static bool Create(const std::string &dir, int64_t partition_ms);
+
+        // All rows of one device within the range, in time order
+        std::vector<Row> QueryDevice(const std::string &device, TimeRange range, unsigned threads) const;
+
+        // Per-device aggregate of a float (or duration) column within the range, optionally for one kind only
+        std::map<std::string, Aggregate> AggregateByDevice(Column column, TimeRange range, int kind,
+                                                           unsigned threads) const;
+
+        // Segment, block, row and byte counts of the whole store
+        StoreStats Stats() const;
+
+    private:
+        struct SegmentFile
+        {
+            std::string path;
+            int64_t partition_start_ms;
+        };
+
+        std::string dir_;
+        int64_t partition_ms_; ///< 0 if unknown (no pruning by file name)
+        std::vector<SegmentFile> files_;
+
+        // Segment files that may hold rows in the range
+        std::vector<const SegmentFile *> candidates(TimeRange range) const;
+
+        // Run fn(segment_index, reader) for every candidate on `threads` workers
+        template <typename Fn>
+        void forEachSegment(const std::vector<const SegmentFile *> &segments, unsigned threads, Fn &&fn) const;
+    };
+}
\ No newline at end of file
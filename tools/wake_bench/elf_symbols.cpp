@@ -0,0 +1,131 @@
+#include "elf_symbols.hpp"
+
+#include <cxxabi.h>
+#include <elf.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace WakeBench
+{
+    namespace
+    {
+        std::string demangle(const char *name)
+        {
+            int status = 0;
+            char *demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+            if (status != 0 || !demangled)
+                return name;
+            std::string result(demangled);
+            free(demangled);
+            return result;
+        }
+    }
+
+    bool ElfSymbols::Load(const char *path)
+    {
+        FILE *f = fopen(path, "rb");
+        if (!f)
+            return false;
+        std::vector<uint8_t> image;
+        uint8_t buf[65536];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+            image.insert(image.end(), buf, buf + n);
+        fclose(f);
+
+        if (image.size() < sizeof(Elf32_Ehdr) || memcmp(image.data(), ELFMAG, SELFMAG) != 0 ||
+            image[EI_CLASS] != ELFCLASS32 || image[EI_DATA] != ELFDATA2LSB)
+            return false;
+
+        Elf32_Ehdr header;
+        memcpy(&header, image.data(), sizeof(header));
+        if (header.e_shentsize != sizeof(Elf32_Shdr) ||
+            header.e_shoff + static_cast<uint64_t>(header.e_shnum) * sizeof(Elf32_Shdr) > image.size())
+            return false;
+
+        std::vector<Elf32_Shdr> sections(header.e_shnum);
+        memcpy(sections.data(), image.data() + header.e_shoff, sections.size() * sizeof(Elf32_Shdr));
+
+        functions_.clear();
+        objects_.clear();
+        for (const Elf32_Shdr &section : sections)
+        {
+            if (section.sh_type != SHT_SYMTAB || section.sh_link >= sections.size())
+                continue;
+            const Elf32_Shdr &strtab = sections[section.sh_link];
+            if (section.sh_offset + static_cast<uint64_t>(section.sh_size) > image.size() ||
+                strtab.sh_offset + static_cast<uint64_t>(strtab.sh_size) > image.size())
+                return false;
+
+            const char *names = reinterpret_cast<const char *>(image.data() + strtab.sh_offset);
+            for (size_t offset = 0; offset + sizeof(Elf32_Sym) <= section.sh_size; offset += sizeof(Elf32_Sym))
+            {
+                Elf32_Sym sym;
+                memcpy(&sym, image.data() + section.sh_offset + offset, sizeof(sym));
+                if (sym.st_name >= strtab.sh_size || sym.st_value == 0)
+                    continue;
+
+                const uint8_t type = ELF32_ST_TYPE(sym.st_info);
+                const Symbol symbol = {sym.st_value, sym.st_size, demangle(names + sym.st_name)};
+                if (type == STT_FUNC)
+                    functions_.push_back(symbol);
+                else if (type == STT_NOTYPE && sym.st_shndx == SHN_ABS)
+                    functions_.push_back({sym.st_value, 0, symbol.name}); // ROM function from the linker scripts
+                else if (type == STT_OBJECT)
+                    objects_.push_back(symbol);
+            }
+        }
+
+        // Sized symbols before ROM aliases at the same address
+        std::sort(functions_.begin(), functions_.end(), [](const Symbol &a, const Symbol &b)
+                  { return a.address != b.address ? a.address < b.address : a.size > b.size; });
+        return !functions_.empty();
+    }
+
+    uint32_t ElfSymbols::Find(const char *name) const
+    {
+        // "f(" matches every overload of f, "f" only f itself
+        const size_t len = strlen(name);
+        const bool prefix = len > 0 && name[len - 1] == '(';
+        for (const Symbol &symbol : functions_)
+        {
+            if (prefix ? symbol.name.compare(0, len, name) == 0 : symbol.name == name)
+                return symbol.address;
+        }
+        return 0;
+    }
+
+    bool ElfSymbols::FindObject(const char *name, uint32_t *address, uint32_t *size) const
+    {
+        for (const Symbol &symbol : objects_)
+        {
+            if (symbol.name == name)
+            {
+                *address = symbol.address;
+                *size = symbol.size;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const Symbol *ElfSymbols::At(uint32_t address) const
+    {
+        auto it = std::upper_bound(functions_.begin(), functions_.end(), address,
+                                   [](uint32_t a, const Symbol &symbol) { return a < symbol.address; });
+        if (it == functions_.begin())
+            return nullptr;
+        const uint32_t start = std::prev(it)->address;
+
+        // First symbol at that address: the sized one, if any
+        while (it != functions_.begin() && std::prev(it)->address == start)
+            --it;
+        const Symbol &symbol = *it;
+        if (symbol.size != 0 && address >= symbol.address + symbol.size)
+            return nullptr;
+        return &symbol;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace WakeBench
+{
+    // Function symbol of the firmware ELF
+    struct Symbol
+    {
+        uint32_t address;
+        uint32_t size;    ///< 0 for ROM functions, which the linker scripts only give an address
+        std::string name; ///< Demangled
+    };
+
+    /**
+     * Function symbols of a 32-bit little-endian ELF (the firmware's iot_test.elf)
+     *
+     * Reads .symtab: the functions of the image, and the ROM functions the
+     * ESP-IDF linker scripts provide as absolute symbols. C++ names are
+     * demangled, so lookups use the source names ("app_main",
+     * "Hardware::Ultrasonic::HCSR04::MeasureDistance(unsigned long)").
+     */
+    class ElfSymbols
+    {
+    public:
+        // Load the symbols of an ELF file; false if it cannot be read or is not a 32-bit ELF
+        bool Load(const char *path);
+
+        // Address of a function by name, or by signature prefix ending in '(' (0: none)
+        uint32_t Find(const char *name) const;
+
+        // Symbol of a data object (size and address) by exact name; false if there is none
+        bool FindObject(const char *name, uint32_t *address, uint32_t *size) const;
+
+        // Function containing address, or nullptr
+        const Symbol *At(uint32_t address) const;
+
+    private:
+        std::vector<Symbol> functions_; ///< Sorted by address
+        std::vector<Symbol> objects_;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,251 @@
+#include "gdb_remote.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+namespace WakeBench
+{
+    namespace
+    {
+        const char HEX[] = "0123456789abcdef";
+
+        std::string toHex(const void *data, size_t len)
+        {
+            const uint8_t *bytes = static_cast<const uint8_t *>(data);
+            std::string hex;
+            hex.reserve(len * 2);
+            for (size_t i = 0; i < len; ++i)
+            {
+                hex += HEX[bytes[i] >> 4];
+                hex += HEX[bytes[i] & 0xF];
+            }
+            return hex;
+        }
+
+        bool fromHex(const std::string &hex, void *out, size_t len)
+        {
+            if (hex.size() < len * 2)
+                return false;
+            uint8_t *bytes = static_cast<uint8_t *>(out);
+            for (size_t i = 0; i < len; ++i)
+            {
+                char pair[3] = {hex[2 * i], hex[2 * i + 1], 0};
+                char *end;
+                bytes[i] = static_cast<uint8_t>(strtoul(pair, &end, 16));
+                if (*end)
+                    return false;
+            }
+            return true;
+        }
+
+        std::string addressArg(uint32_t address)
+        {
+            char buf[16];
+            snprintf(buf, sizeof(buf), "%lx", static_cast<unsigned long>(address));
+            return buf;
+        }
+    }
+
+    GdbRemote::~GdbRemote()
+    {
+        if (fd_ >= 0)
+            close(fd_);
+    }
+
+    bool GdbRemote::Connect(const char *host, uint16_t port, int timeout_ms)
+    {
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        if (inet_pton(AF_INET, host, &addr.sin_addr) != 1)
+            return false;
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        while (std::chrono::steady_clock::now() < deadline)
+        {
+            fd_ = socket(AF_INET, SOCK_STREAM, 0);
+            if (fd_ < 0)
+                return false;
+            if (connect(fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0)
+            {
+                const int one = 1;
+                setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                std::string reply;
+                return command("?", &reply); // Stop reason; the target is halted (-S)
+            }
+            close(fd_);
+            fd_ = -1;
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        return false;
+    }
+
+    bool GdbRemote::SetBreakpoint(uint32_t address)
+    {
+        std::string reply;
+        return command("Z0," + addressArg(address) + ",4", &reply) && reply == "OK";
+    }
+
+    bool GdbRemote::ClearBreakpoint(uint32_t address)
+    {
+        std::string reply;
+        return command("z0," + addressArg(address) + ",4", &reply) && reply == "OK";
+    }
+
+    bool GdbRemote::Continue(uint32_t *pc, int timeout_ms)
+    {
+        std::string reply;
+        if (!send("c") || !receive(&reply, timeout_ms))
+            return false;
+        // Stop replies: "S05" or "T05...", "W.."/"X.." when the target is gone
+        if (reply.empty() || (reply[0] != 'S' && reply[0] != 'T'))
+            return false;
+        return ReadRegister(REG_PC, pc);
+    }
+
+    bool GdbRemote::Resume()
+    {
+        return send("c");
+    }
+
+    bool GdbRemote::ReadRegister(int reg, uint32_t *value)
+    {
+        char packet[16];
+        snprintf(packet, sizeof(packet), "p%x", reg);
+        std::string reply;
+        return command(packet, &reply) && fromHex(reply, value, sizeof(*value)); // Target byte order (little endian)
+    }
+
+    bool GdbRemote::WriteRegister(int reg, uint32_t value)
+    {
+        char packet[16];
+        snprintf(packet, sizeof(packet), "P%x=", reg);
+        std::string reply;
+        return command(packet + toHex(&value, sizeof(value)), &reply) && reply == "OK";
+    }
+
+    bool GdbRemote::ReadMemory(uint32_t address, void *out, size_t len)
+    {
+        uint8_t *bytes = static_cast<uint8_t *>(out);
+        for (size_t done = 0; done < len;)
+        {
+            const size_t chunk = std::min(MAX_CHUNK, len - done);
+            char packet[32];
+            snprintf(packet, sizeof(packet), "m%lx,%lx", static_cast<unsigned long>(address + done),
+                     static_cast<unsigned long>(chunk));
+            std::string reply;
+            if (!command(packet, &reply) || !fromHex(reply, bytes + done, chunk))
+                return false;
+            done += chunk;
+        }
+        return true;
+    }
+
+    bool GdbRemote::WriteMemory(uint32_t address, const void *data, size_t len)
+    {
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        for (size_t done = 0; done < len;)
+        {
+            const size_t chunk = std::min(MAX_CHUNK, len - done);
+            char packet[32];
+            snprintf(packet, sizeof(packet), "M%lx,%lx:", static_cast<unsigned long>(address + done),
+                     static_cast<unsigned long>(chunk));
+            std::string reply;
+            if (!command(packet + toHex(bytes + done, chunk), &reply) || reply != "OK")
+                return false;
+            done += chunk;
+        }
+        return true;
+    }
+
+    bool GdbRemote::ReturnWith(uint32_t value)
+    {
+        uint32_t ra;
+        return ReadRegister(REG_RA, &ra) && WriteRegister(REG_A0, value) && WriteRegister(REG_PC, ra);
+    }
+
+    void GdbRemote::Kill()
+    {
+        if (fd_ < 0)
+            return;
+        send("k");
+        close(fd_);
+        fd_ = -1;
+    }
+
+    bool GdbRemote::send(const std::string &payload)
+    {
+        if (fd_ < 0)
+            return false;
+        uint8_t checksum = 0;
+        for (char c : payload)
+            checksum = static_cast<uint8_t>(checksum + static_cast<uint8_t>(c));
+        const std::string packet = "$" + payload + "#" + HEX[checksum >> 4] + HEX[checksum & 0xF];
+
+        for (size_t sent = 0; sent < packet.size();)
+        {
+            const ssize_t n = ::send(fd_, packet.data() + sent, packet.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0)
+                return false;
+            sent += static_cast<size_t>(n);
+        }
+
+        // QEMU acknowledges every packet; a '-' asks for it again
+        while (true)
+        {
+            if (rx_.empty() && !fill(REPLY_TIMEOUT_MS))
+                return false;
+            const char ack = rx_[0];
+            rx_.erase(0, 1);
+            if (ack == '+')
+                return true;
+            if (ack == '-')
+                return send(payload);
+        }
+    }
+
+    bool GdbRemote::receive(std::string *payload, int timeout_ms)
+    {
+        while (true)
+        {
+            const size_t start = rx_.find('$');
+            const size_t end = start == std::string::npos ? std::string::npos : rx_.find('#', start);
+            if (end != std::string::npos && rx_.size() >= end + 3)
+            {
+                *payload = rx_.substr(start + 1, end - start - 1);
+                rx_.erase(0, end + 3);
+                return ::send(fd_, "+", 1, MSG_NOSIGNAL) == 1;
+            }
+            if (!fill(timeout_ms))
+                return false;
+        }
+    }
+
+    bool GdbRemote::command(const std::string &payload, std::string *reply)
+    {
+        return send(payload) && receive(reply, REPLY_TIMEOUT_MS);
+    }
+
+    bool GdbRemote::fill(int timeout_ms)
+    {
+        pollfd pfd = {fd_, POLLIN, 0};
+        if (poll(&pfd, 1, timeout_ms) <= 0)
+            return false;
+        char buf[4096];
+        const ssize_t n = recv(fd_, buf, sizeof(buf), 0);
+        if (n <= 0)
+            return false;
+        rx_.append(buf, static_cast<size_t>(n));
+        return true;
+    }
+}
\ No newline at end of file
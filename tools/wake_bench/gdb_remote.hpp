@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace WakeBench
+{
+    /**
+     * Minimal GDB remote protocol client for QEMU's gdbstub (RISC-V, 32 bit)
+     *
+     * Enough to script a firmware run: software breakpoints, continue,
+     * registers and memory. Registers use the GDB numbering: x0..x31 are
+     * 0..31, pc is 32. Every call blocks until QEMU answers or the timeout
+     * passes.
+     */
+    class GdbRemote
+    {
+    public:
+        static constexpr int REG_RA = 1;
+        static constexpr int REG_A0 = 10;
+        static constexpr int REG_PC = 32;
+
+        ~GdbRemote();
+
+        // Connect to host:port, retrying until timeout_ms (QEMU may still be starting)
+        bool Connect(const char *host, uint16_t port, int timeout_ms);
+
+        bool SetBreakpoint(uint32_t address);
+        bool ClearBreakpoint(uint32_t address);
+
+        // Resume and wait for the next stop; *pc is where it stopped. False if the target exited or timed out
+        bool Continue(uint32_t *pc, int timeout_ms);
+
+        // Resume without waiting for a stop
+        bool Resume();
+
+        bool ReadRegister(int reg, uint32_t *value);
+        bool WriteRegister(int reg, uint32_t value);
+        bool ReadMemory(uint32_t address, void *out, size_t len);
+        bool WriteMemory(uint32_t address, const void *data, size_t len);
+
+        // Return from the current function with a0 = value (at the entry breakpoint of a replaced function)
+        bool ReturnWith(uint32_t value);
+
+        // Ask QEMU to quit, and close the connection
+        void Kill();
+
+    private:
+        static constexpr int REPLY_TIMEOUT_MS = 5000;
+        static constexpr size_t MAX_CHUNK = 1024; ///< Memory bytes per m/M packet
+
+        int fd_ = -1;
+        std::string rx_; ///< Received bytes not consumed yet
+
+        bool send(const std::string &payload);
+        bool receive(std::string *payload, int timeout_ms);
+        bool command(const std::string &payload, std::string *reply);
+        bool fill(int timeout_ms);
+    };
+}
\ No newline at end of file
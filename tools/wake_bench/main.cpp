@@ -0,0 +1,497 @@
+#include "elf_symbols.hpp"
+#include "gdb_remote.hpp"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr uint32_t ESP_SLEEP_WAKEUP_TIMER = 4; // esp_sleep_source_t
+    constexpr double CPU_MHZ = 160.0;              // Config::PM_MAX_CPU_FREQ_MHZ
+
+    enum class WakeKind
+    {
+        FRESH,   ///< Power-on boot
+        QUIET,   ///< Timer wake that went back to sleep without a session
+        SESSION, ///< Timer wake that opened a session (event, heartbeat or flap report)
+        COUNT
+    };
+
+    const char *kindName(WakeKind kind)
+    {
+        switch (kind)
+        {
+        case WakeKind::FRESH:
+            return "fresh";
+        case WakeKind::QUIET:
+            return "quiet";
+        default:
+            return "session";
+        }
+    }
+
+    // Firmware functions the harness stops at
+    struct Hooks
+    {
+        uint32_t app_main;
+        uint32_t wakeup_cause;  ///< Returns a timer wake after the first boot
+        uint32_t measure;       ///< Returns the scripted echo distance
+        uint32_t connect_wifi;  ///< Returns "not connected": QEMU has no Wi-Fi
+        uint32_t deep_sleep;    ///< End of the wake
+        uint32_t restart;       ///< esp_restart: end of the wake as well
+        uint32_t abort;         ///< Panic: the run is broken
+        uint32_t rtc_store;     ///< RtcStore carried from wake to wake
+        uint32_t rtc_size;
+    };
+
+    struct Wake
+    {
+        WakeKind kind;
+        float echo_cm;
+        uint64_t instructions;
+        uint64_t cycles;
+        std::map<std::string, std::pair<uint64_t, uint64_t>> functions; ///< Name -> {instructions, cycles}
+    };
+
+    void usage(const char *argv0)
+    {
+        printf("Usage: %s --flash FILE --elf FILE [options]\n"
+               "Boots the firmware image in Espressif's QEMU once per wake and counts the instructions from reset\n"
+               "to esp_deep_sleep_start. RTC memory is carried from wake to wake, the wakeup cause is a timer after\n"
+               "the first boot, the HC-SR04 returns the scripted distances, and Wi-Fi never connects.\n"
+               "  --flash FILE          merged flash image (esptool.py merge_bin); a copy is used, NVS persists in it\n"
+               "  --elf FILE            build/iot_test.elf of the same build\n"
+               "  --qemu PATH           QEMU binary (default qemu-system-riscv32)\n"
+               "  --plugin FILE         the wake_profile QEMU plugin (default libwake_profile.so next to this tool)\n"
+               "  --wakes N             wakes to run, the first one a fresh boot (default 12)\n"
+               "  --echo CM,CM,...      distance measured on each wake, the last one repeats (default 40 x4, 30 x4, 40)\n"
+               "  --top N               functions listed per wake kind (default 20)\n"
+               "  --csv FILE            write one line per wake and function\n"
+               "  --uart FILE           append the firmware console output here\n"
+               "  --gdb-port PORT       QEMU gdbstub port (default 3333)\n"
+               "  --timeout S           wall-clock limit per wake (default 300)\n",
+               argv0);
+    }
+
+    std::vector<float> parseEcho(const char *list)
+    {
+        std::vector<float> echo;
+        for (const char *p = list; *p;)
+        {
+            char *end;
+            echo.push_back(strtof(p, &end));
+            if (end == p)
+                break;
+            p = *end == ',' ? end + 1 : end;
+        }
+        return echo;
+    }
+
+    bool copyFile(const char *from, const char *to)
+    {
+        FILE *in = fopen(from, "rb");
+        FILE *out = in ? fopen(to, "wb") : nullptr;
+        bool ok = in && out;
+        char buf[65536];
+        size_t n;
+        while (ok && (n = fread(buf, 1, sizeof(buf), in)) > 0)
+            ok = fwrite(buf, 1, n, out) == n;
+        if (in)
+            fclose(in);
+        if (out)
+            ok = fclose(out) == 0 && ok;
+        return ok;
+    }
+
+    pid_t startQemu(const std::vector<std::string> &args, const char *uart_path)
+    {
+        const pid_t pid = fork();
+        if (pid != 0)
+            return pid;
+
+        const int out = uart_path ? open(uart_path, O_WRONLY | O_CREAT | O_APPEND, 0644) : open("/dev/null", O_WRONLY);
+        if (out >= 0)
+        {
+            dup2(out, STDOUT_FILENO);
+            close(out);
+        }
+        std::vector<char *> argv;
+        for (const std::string &arg : args)
+            argv.push_back(const_cast<char *>(arg.c_str()));
+        argv.push_back(nullptr);
+        execvp(argv[0], argv.data());
+        perror(argv[0]);
+        _exit(127);
+    }
+
+    void stopQemu(pid_t pid)
+    {
+        int status;
+        for (int i = 0; i < 40; ++i)
+        {
+            if (waitpid(pid, &status, WNOHANG) == pid)
+                return;
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        kill(pid, SIGKILL);
+        waitpid(pid, &status, 0);
+    }
+
+    // Wait for the plugin to finish its profile ("end" line)
+    bool waitProfile(const std::string &path, int timeout_ms)
+    {
+        for (int waited = 0; waited < timeout_ms; waited += 50)
+        {
+            FILE *f = fopen(path.c_str(), "r");
+            if (f)
+            {
+                char line[128], last[128] = {};
+                while (fgets(line, sizeof(line), f))
+                    strcpy(last, line);
+                fclose(f);
+                if (!strcmp(last, "end\n"))
+                    return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        return false;
+    }
+
+    // Add the plugin's block counts to the wake, by function
+    bool readProfile(const std::string &path, const WakeBench::ElfSymbols &symbols, Wake *wake)
+    {
+        FILE *f = fopen(path.c_str(), "r");
+        if (!f)
+            return false;
+        unsigned long long address, executions;
+        unsigned instructions, cycles;
+        while (fscanf(f, "%llx %u %u %llu", &address, &instructions, &cycles, &executions) == 4)
+        {
+            const WakeBench::Symbol *symbol = symbols.At(static_cast<uint32_t>(address));
+            auto &function = wake->functions[symbol ? symbol->name : "[unknown]"];
+            function.first += instructions * executions;
+            function.second += cycles * executions;
+            wake->instructions += instructions * executions;
+            wake->cycles += cycles * executions;
+        }
+        fclose(f);
+        return true;
+    }
+
+    /**
+     * Run one wake from reset to esp_deep_sleep_start
+     *
+     * rtc holds the RtcStore of the previous wake and receives the one this
+     * wake leaves behind; empty on the first (fresh) wake.
+     */
+    bool runWake(const std::vector<std::string> &qemu_args, const char *uart_path, uint16_t port, int timeout_s,
+                 const Hooks &hooks, const std::string &profile_path, std::vector<uint8_t> *rtc, Wake *wake)
+    {
+        remove(profile_path.c_str());
+        const pid_t pid = startQemu(qemu_args, uart_path);
+        if (pid < 0)
+            return false;
+
+        WakeBench::GdbRemote gdb;
+        if (!gdb.Connect("127.0.0.1", port, 10000))
+        {
+            fprintf(stderr, "[wake_bench] cannot reach the QEMU gdbstub on port %u\n", port);
+            kill(pid, SIGKILL);
+            stopQemu(pid);
+            return false;
+        }
+
+        const uint32_t breakpoints[] = {hooks.app_main, hooks.wakeup_cause, hooks.measure, hooks.connect_wifi,
+                                        hooks.deep_sleep, hooks.restart, hooks.abort};
+        for (uint32_t address : breakpoints)
+        {
+            if (address)
+                gdb.SetBreakpoint(address);
+        }
+
+        const bool timer_wake = !rtc->empty();
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeout_s);
+        bool done = false, ok = true;
+        while (!done && ok)
+        {
+            const int left_ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                                     deadline - std::chrono::steady_clock::now())
+                                                     .count());
+            uint32_t pc;
+            if (left_ms <= 0 || !gdb.Continue(&pc, left_ms))
+            {
+                fprintf(stderr, "[wake_bench] the wake did not reach deep sleep\n");
+                ok = false;
+                break;
+            }
+
+            if (pc == hooks.app_main)
+            {
+                // Startup initialized .rtc.data as after power-on; put back what the previous wake left
+                if (timer_wake)
+                    ok = gdb.WriteMemory(hooks.rtc_store, rtc->data(), rtc->size());
+            }
+            else if (pc == hooks.wakeup_cause)
+            {
+                if (timer_wake)
+                    ok = gdb.ReturnWith(ESP_SLEEP_WAKEUP_TIMER);
+            }
+            else if (pc == hooks.measure)
+            {
+                uint32_t bits; // Soft-float ABI: the float comes back in a0
+                memcpy(&bits, &wake->echo_cm, sizeof(bits));
+                ok = gdb.ReturnWith(bits);
+            }
+            else if (pc == hooks.connect_wifi)
+            {
+                wake->kind = WakeKind::SESSION;
+                ok = gdb.ReturnWith(0);
+            }
+            else if (pc == hooks.deep_sleep || pc == hooks.restart)
+            {
+                rtc->resize(hooks.rtc_size);
+                ok = gdb.ReadMemory(hooks.rtc_store, rtc->data(), rtc->size());
+                gdb.ClearBreakpoint(pc);
+                done = true;
+            }
+            else if (pc == hooks.abort)
+            {
+                fprintf(stderr, "[wake_bench] the firmware aborted (see --uart)\n");
+                ok = false;
+            }
+        }
+
+        // The plugin writes the profile when the block at esp_deep_sleep_start runs
+        if (ok)
+            ok = gdb.Resume() && waitProfile(profile_path, 10000);
+        gdb.Kill();
+        stopQemu(pid);
+        return ok;
+    }
+
+    void printSummary(const std::vector<Wake> &wakes, size_t top)
+    {
+        for (size_t k = 0; k < static_cast<size_t>(WakeKind::COUNT); ++k)
+        {
+            const WakeKind kind = static_cast<WakeKind>(k);
+            std::map<std::string, std::pair<uint64_t, uint64_t>> functions;
+            uint64_t instructions = 0, cycles = 0, min = UINT64_MAX, max = 0;
+            size_t count = 0;
+            for (const Wake &wake : wakes)
+            {
+                if (wake.kind != kind)
+                    continue;
+                count++;
+                instructions += wake.instructions;
+                cycles += wake.cycles;
+                min = std::min(min, wake.instructions);
+                max = std::max(max, wake.instructions);
+                for (const auto &function : wake.functions)
+                {
+                    functions[function.first].first += function.second.first;
+                    functions[function.first].second += function.second.second;
+                }
+            }
+            if (count == 0)
+                continue;
+
+            printf("[%s] %zu wakes: instructions mean=%.0f min=%llu max=%llu | cycles~ mean=%.0f (%.2f ms at %.0f MHz)\n",
+                   kindName(kind), count, static_cast<double>(instructions) / count, static_cast<unsigned long long>(min),
+                   static_cast<unsigned long long>(max), static_cast<double>(cycles) / count,
+                   cycles / count / CPU_MHZ / 1000.0, CPU_MHZ);
+
+            std::vector<std::pair<std::string, std::pair<uint64_t, uint64_t>>> sorted(functions.begin(), functions.end());
+            std::sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b)
+                      { return a.second.first > b.second.first; });
+            for (size_t i = 0; i < sorted.size() && i < top; ++i)
+            {
+                printf("  %12.0f insns/wake %5.1f%% %12.0f cycles~  %s\n",
+                       static_cast<double>(sorted[i].second.first) / count,
+                       100.0 * sorted[i].second.first / std::max<uint64_t>(instructions, 1),
+                       static_cast<double>(sorted[i].second.second) / count, sorted[i].first.c_str());
+            }
+        }
+    }
+
+    bool writeCsv(const char *path, const std::vector<Wake> &wakes)
+    {
+        FILE *out = fopen(path, "w");
+        if (!out)
+            return false;
+        fprintf(out, "wake,kind,echo_cm,function,instructions,cycles\n");
+        for (size_t i = 0; i < wakes.size(); ++i)
+        {
+            for (const auto &function : wakes[i].functions)
+            {
+                // Names with commas (C++ signatures) are quoted
+                fprintf(out, "%zu,%s,%.1f,\"%s\",%llu,%llu\n", i, kindName(wakes[i].kind), wakes[i].echo_cm,
+                        function.first.c_str(), static_cast<unsigned long long>(function.second.first),
+                        static_cast<unsigned long long>(function.second.second));
+            }
+        }
+        return fclose(out) == 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *flash_path = nullptr;
+    const char *elf_path = nullptr;
+    const char *qemu = "qemu-system-riscv32";
+    std::string plugin_path;
+    uint32_t wake_count = 12;
+    std::vector<float> echo = {40, 40, 40, 40, 30, 30, 30, 30, 40};
+    size_t top = 20;
+    const char *csv_path = nullptr;
+    const char *uart_path = nullptr;
+    uint16_t port = 3333;
+    int timeout_s = 300;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        const auto need = [&]()
+        {
+            if (!value)
+            {
+                fprintf(stderr, "Missing value for %s\n", arg);
+                exit(2);
+            }
+            ++i;
+            return value;
+        };
+
+        if (!strcmp(arg, "--flash"))
+            flash_path = need();
+        else if (!strcmp(arg, "--elf"))
+            elf_path = need();
+        else if (!strcmp(arg, "--qemu"))
+            qemu = need();
+        else if (!strcmp(arg, "--plugin"))
+            plugin_path = need();
+        else if (!strcmp(arg, "--wakes"))
+            wake_count = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--echo"))
+            echo = parseEcho(need());
+        else if (!strcmp(arg, "--top"))
+            top = strtoul(need(), nullptr, 10);
+        else if (!strcmp(arg, "--csv"))
+            csv_path = need();
+        else if (!strcmp(arg, "--uart"))
+            uart_path = need();
+        else if (!strcmp(arg, "--gdb-port"))
+            port = static_cast<uint16_t>(strtoul(need(), nullptr, 10));
+        else if (!strcmp(arg, "--timeout"))
+            timeout_s = atoi(need());
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (!flash_path || !elf_path || echo.empty() || wake_count == 0)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    if (plugin_path.empty())
+    {
+        const std::string self(argv[0]);
+        const size_t slash = self.rfind('/');
+        plugin_path = (slash == std::string::npos ? std::string(".") : self.substr(0, slash)) + "/libwake_profile.so";
+    }
+
+    WakeBench::ElfSymbols symbols;
+    if (!symbols.Load(elf_path))
+    {
+        fprintf(stderr, "[wake_bench] cannot read the symbols of %s\n", elf_path);
+        return 1;
+    }
+
+    Hooks hooks = {};
+    hooks.app_main = symbols.Find("app_main");
+    hooks.wakeup_cause = symbols.Find("esp_sleep_get_wakeup_cause");
+    hooks.measure = symbols.Find("Hardware::Ultrasonic::HCSR04::MeasureDistance(");
+    hooks.connect_wifi = symbols.Find("connect_wifi_blocking(");
+    hooks.deep_sleep = symbols.Find("esp_deep_sleep_start");
+    hooks.restart = symbols.Find("esp_restart");
+    hooks.abort = symbols.Find("esp_system_abort");
+    const bool have_rtc = symbols.FindObject("rtc_store", &hooks.rtc_store, &hooks.rtc_size);
+    if (!hooks.app_main || !hooks.wakeup_cause || !hooks.measure || !hooks.connect_wifi || !hooks.deep_sleep ||
+        !have_rtc)
+    {
+        fprintf(stderr, "[wake_bench] %s lacks app_main, esp_sleep_get_wakeup_cause, HCSR04::MeasureDistance, "
+                        "connect_wifi_blocking, esp_deep_sleep_start or rtc_store (inlined?)\n",
+                elf_path);
+        return 1;
+    }
+
+    // QEMU writes NVS and the diagnostic log back into the image; keep the original
+    const std::string work = "/tmp/wake_bench." + std::to_string(getpid());
+    const std::string flash_copy = work + ".flash.bin";
+    const std::string profile_path = work + ".profile";
+    if (!copyFile(flash_path, flash_copy.c_str()))
+    {
+        fprintf(stderr, "[wake_bench] cannot copy %s\n", flash_path);
+        return 1;
+    }
+
+    char stop_arg[32];
+    snprintf(stop_arg, sizeof(stop_arg), "0x%lx", static_cast<unsigned long>(hooks.deep_sleep));
+    const std::vector<std::string> qemu_args = {
+        qemu, "-nographic", "-machine", "esp32c3",
+        "-drive", "file=" + flash_copy + ",if=mtd,format=raw",
+        "-global", "driver=timer.esp32c3.timg,property=wdt_disable,value=true",
+        "-icount", "shift=0",                                            // One instruction per ns: deterministic timing
+        "-plugin", plugin_path + ",out=" + profile_path + ",stop=" + stop_arg,
+        "-gdb", "tcp::" + std::to_string(port), "-S"};
+
+    printf("[wake_bench] %s: %u wakes, echo script of %zu distances\n", elf_path, wake_count, echo.size());
+    std::vector<Wake> wakes;
+    std::vector<uint8_t> rtc;
+    int rc = 0;
+    for (uint32_t i = 0; i < wake_count; ++i)
+    {
+        Wake wake = {};
+        wake.kind = i == 0 ? WakeKind::FRESH : WakeKind::QUIET;
+        wake.echo_cm = echo[std::min<size_t>(i, echo.size() - 1)];
+        const WakeKind fresh_or_quiet = wake.kind;
+        if (!runWake(qemu_args, uart_path, port, timeout_s, hooks, profile_path, &rtc, &wake) ||
+            !readProfile(profile_path, symbols, &wake))
+        {
+            fprintf(stderr, "[wake_bench] wake %u failed\n", i);
+            rc = 1;
+            break;
+        }
+        if (i == 0)
+            wake.kind = fresh_or_quiet; // The first boot counts as fresh even with a session
+        printf("[wake] %-3u %-8s echo %5.1f cm  instructions %10llu  cycles~ %10llu\n", i, kindName(wake.kind),
+               wake.echo_cm, static_cast<unsigned long long>(wake.instructions),
+               static_cast<unsigned long long>(wake.cycles));
+        fflush(stdout);
+        wakes.push_back(std::move(wake));
+    }
+
+    printSummary(wakes, top);
+    if (csv_path && !writeCsv(csv_path, wakes))
+    {
+        fprintf(stderr, "[wake_bench] cannot write %s\n", csv_path);
+        rc = 1;
+    }
+    remove(flash_copy.c_str());
+    remove(profile_path.c_str());
+    return rc;
+}
\ No newline at end of file
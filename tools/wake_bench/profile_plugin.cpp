@@ -0,0 +1,155 @@
+// QEMU TCG plugin: instruction counts of every translation block, for wake_bench
+//
+//   -plugin libwake_profile.so,out=FILE,stop=ADDR
+//
+// Counts the executions of each translation block from reset. The first time
+// the block at stop (esp_deep_sleep_start) runs, and otherwise when QEMU
+// exits, writes one line per executed block to out:
+//
+//   <start address> <instructions> <estimated cycles> <executions>
+//
+// followed by "end". QEMU does not model the pipeline (under -icount the
+// cycle counter is the instruction count), so cycles are estimated from the
+// instruction mix with the costs below.
+
+#include <qemu-plugin.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+
+extern "C"
+{
+    QEMU_PLUGIN_EXPORT int qemu_plugin_version = QEMU_PLUGIN_VERSION;
+}
+
+namespace
+{
+    // Cycles per instruction class on the ESP32-C3 core (in-order, 4 stages), flash cache hits assumed
+    constexpr uint32_t CYCLES_ALU = 1;
+    constexpr uint32_t CYCLES_LOAD = 2;   // Load-use stall
+    constexpr uint32_t CYCLES_STORE = 1;
+    constexpr uint32_t CYCLES_BRANCH = 2; // Taken 3, not taken 1
+    constexpr uint32_t CYCLES_JUMP = 2;
+    constexpr uint32_t CYCLES_MUL = 1;
+    constexpr uint32_t CYCLES_DIV = 17;
+
+    struct Block
+    {
+        uint64_t address;
+        uint32_t instructions;
+        uint32_t cycles;     ///< Estimated cycles of one execution
+        uint64_t executions;
+    };
+
+    std::mutex g_mutex;
+    std::deque<Block> g_blocks; ///< Stable addresses: the exec callbacks point into it
+    std::string g_out_path;
+    uint64_t g_stop = 0;
+    bool g_written = false;
+
+    uint32_t cycles(const char *disassembly)
+    {
+        // Mnemonics as QEMU prints them; compressed forms may carry a "c." prefix
+        char mnemonic[16] = {};
+        sscanf(disassembly, "%15s", mnemonic);
+        const char *m = strncmp(mnemonic, "c.", 2) == 0 ? mnemonic + 2 : mnemonic;
+
+        if (!strcmp(m, "lb") || !strcmp(m, "lh") || !strcmp(m, "lw") || !strcmp(m, "lbu") || !strcmp(m, "lhu") ||
+            !strcmp(m, "lwsp"))
+            return CYCLES_LOAD;
+        if (!strcmp(m, "sb") || !strcmp(m, "sh") || !strcmp(m, "sw") || !strcmp(m, "swsp"))
+            return CYCLES_STORE;
+        if (m[0] == 'b')
+            return CYCLES_BRANCH; // beq, bne, blt, bge, bltu, bgeu, beqz, bnez
+        if (m[0] == 'j' || !strcmp(m, "ret"))
+            return CYCLES_JUMP;   // jal, jalr, j, jr
+        if (!strncmp(m, "mul", 3))
+            return CYCLES_MUL;
+        if (!strncmp(m, "div", 3) || !strncmp(m, "rem", 3))
+            return CYCLES_DIV;
+        return CYCLES_ALU;
+    }
+
+    void write()
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        if (g_written)
+            return;
+        g_written = true;
+
+        FILE *out = fopen(g_out_path.c_str(), "w");
+        if (!out)
+            return;
+        for (const Block &block : g_blocks)
+        {
+            if (block.executions)
+                fprintf(out, "%llx %u %u %llu\n", static_cast<unsigned long long>(block.address), block.instructions,
+                        block.cycles, static_cast<unsigned long long>(block.executions));
+        }
+        fprintf(out, "end\n");
+        fclose(out);
+    }
+
+    void onExec(unsigned int vcpu, void *udata)
+    {
+        static_cast<Block *>(udata)->executions++;
+    }
+
+    void onStop(unsigned int vcpu, void *udata)
+    {
+        write();
+    }
+
+    void onTranslate(qemu_plugin_id_t id, qemu_plugin_tb *tb)
+    {
+        Block block = {qemu_plugin_tb_vaddr(tb), static_cast<uint32_t>(qemu_plugin_tb_n_insns(tb)), 0, 0};
+        for (size_t i = 0; i < block.instructions; ++i)
+        {
+            char *disassembly = qemu_plugin_insn_disas(qemu_plugin_tb_get_insn(tb, i));
+            block.cycles += cycles(disassembly);
+            free(disassembly);
+        }
+
+        Block *stored;
+        {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            g_blocks.push_back(block);
+            stored = &g_blocks.back();
+        }
+        if (block.address == g_stop)
+            qemu_plugin_register_vcpu_tb_exec_cb(tb, onStop, QEMU_PLUGIN_CB_NO_REGS, nullptr);
+        else
+            qemu_plugin_register_vcpu_tb_exec_cb(tb, onExec, QEMU_PLUGIN_CB_NO_REGS, stored);
+    }
+
+    void onExit(qemu_plugin_id_t id, void *userdata)
+    {
+        write();
+    }
+}
+
+extern "C" QEMU_PLUGIN_EXPORT int qemu_plugin_install(qemu_plugin_id_t id, const qemu_info_t *info, int argc,
+                                                      char **argv)
+{
+    for (int i = 0; i < argc; ++i)
+    {
+        if (!strncmp(argv[i], "out=", 4))
+            g_out_path = argv[i] + 4;
+        else if (!strncmp(argv[i], "stop=", 5))
+            g_stop = strtoull(argv[i] + 5, nullptr, 0);
+    }
+    if (g_out_path.empty())
+    {
+        fprintf(stderr, "wake_profile: out=FILE is required\n");
+        return -1;
+    }
+
+    qemu_plugin_register_vcpu_tb_trans_cb(id, onTranslate);
+    qemu_plugin_register_atexit_cb(id, onExit, nullptr);
+    return 0;
+}
\ No newline at end of file